@@ -64,6 +64,14 @@ if (OPTION_BUILD_EXAMPLES)
     set(CPACK_COMPONENTS_ALL ${CPACK_COMPONENTS_ALL} examples)
 endif()
 
+if (OPTION_BUILD_TOOLS)
+    set(CPACK_COMPONENT_TOOLS_DISPLAY_NAME "Tools")
+    set(CPACK_COMPONENT_TOOLS_DESCRIPTION "Command line tools of ${META_PROJECT_NAME} library")
+    set(CPACK_COMPONENT_TOOLS_DEPENDS runtime)
+
+    set(CPACK_COMPONENTS_ALL ${CPACK_COMPONENTS_ALL} tools)
+endif()
+
 if (OPTION_BUILD_DOCS)
     set(CPACK_COMPONENT_DOCS_DISPLAY_NAME "Documentation")
     set(CPACK_COMPONENT_DOCS_DESCRIPTION "Documentation of ${META_PROJECT_NAME} library")
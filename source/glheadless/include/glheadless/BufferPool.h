@@ -0,0 +1,201 @@
+#pragma once
+
+/*!
+ * \file BufferPool.h
+ * \brief Declares class BufferPool and struct BufferRange.
+ */
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include <glheadless/glheadless_api.h>
+
+
+namespace glheadless {
+
+
+class Context;
+
+
+/*!
+ * \brief Location of an allocation of a BufferPool.
+ */
+struct BufferRange {
+    unsigned int buffer = 0; //!< OpenGL buffer object containing the range, 0 for an unknown handle
+    std::size_t  offset = 0; //!< byte offset of the range in the buffer object
+    std::size_t  size   = 0; //!< size of the range in bytes
+};
+
+
+/*!
+ * \brief Sub-allocates long-lived data, such as the vertices and indices of many small meshes, from a few large buffer
+ * objects shared by all contexts of a share group.
+ *
+ * Allocations are carved out of fixed-size blocks, each one buffer object, using a first-fit free list that coalesces
+ * neighboring free ranges. Allocations larger than the block size get a dedicated block. Compared to one buffer object
+ * per mesh, this reduces driver overhead per object, binding changes and fragmentation of GPU memory.
+ *
+ * Allocations are identified by handles, as defragment() moves them: it packs all live allocations densely into new
+ * blocks by copying them on the GPU and releases the previous blocks. Afterwards, ranges must be queried again
+ * through range(); generation() tells when this is necessary.
+ *
+ * The pool may be used concurrently from threads whose current contexts share objects with the context passed to the
+ * constructor; calls are serialized internally and OpenGL calls are made in the calling thread's current context.
+ * The entry points are those of the constructor's context, so all contexts using the pool must have the same driver
+ * and pixel format; this matters on WGL, where entry points may differ per context.
+ *
+ * Changes are published in batches: after a batch of allocations, writes or a defragment(), the writing thread calls
+ * flush(), which places a single fence after them. Other contexts of the share group then call synchronize(), which
+ * makes their subsequent commands wait on the GPU for all flushed changes. defragment() must not run while other
+ * contexts still use ranges of the previous generation.
+ */
+class GLHEADLESS_API BufferPool {
+public:
+    /*!
+     * \brief Identifies an allocation, 0 is never used.
+     */
+    using Handle = std::uint64_t;
+
+    /*!
+     * \param context a context of the share group, current on the calling thread; must outlive this object.
+     * \param blockSize size of the buffer objects allocations are carved from, default: 16 MiB
+     */
+    explicit BufferPool(Context* context, std::size_t blockSize = 16 << 20);
+    BufferPool(const BufferPool&) = delete;
+
+    /*!
+     * \brief Releases all buffer objects; a context of the share group must be current on the calling thread.
+     */
+    ~BufferPool();
+
+    /*!
+     * \brief Reserves a range of uninitialized buffer memory.
+     *
+     * \param size size of the range in bytes
+     * \param alignment alignment of the offset in bytes, a power of two; 0 selects 16
+     * \param handle receives the handle of the allocation
+     *
+     * \return true on success, otherwise the error is available through lastErrorCode() and lastErrorMessage().
+     */
+    bool allocate(std::size_t size, std::size_t alignment, Handle& handle);
+
+    /*!
+     * \brief Reserves a range and initializes it with data, see allocate().
+     */
+    bool upload(const void* data, std::size_t size, std::size_t alignment, Handle& handle);
+
+    /*!
+     * \brief Writes data into an allocation, starting offset bytes into its range.
+     *
+     * \return true on success, false for an unknown handle or if the data exceeds the range.
+     */
+    bool write(Handle handle, std::size_t offset, const void* data, std::size_t size);
+
+    /*!
+     * \brief Returns an allocation to the pool; unknown handles are ignored.
+     *
+     * Blocks dedicated to a single large allocation are released immediately, regular blocks are kept for reuse.
+     */
+    void free(Handle handle);
+
+    /*!
+     * \return the current location of an allocation, or an empty BufferRange if the handle is unknown.
+     */
+    BufferRange range(Handle handle) const;
+
+    /*!
+     * \brief Packs all allocations densely into new blocks, see class description.
+     *
+     * The live data is copied on the GPU with glCopyBufferSubData() into new blocks, so this temporarily needs the
+     * memory of the live allocations in addition to the current blocks.
+     *
+     * \return true on success.
+     */
+    bool defragment();
+
+    /*!
+     * \brief Publishes the changes made since the last flush() for synchronize(), see class description.
+     *
+     * Places a fence in the calling thread's current context, which must be the one the changes were made in, and
+     * flushes it. Does nothing if nothing changed.
+     */
+    void flush();
+
+    /*!
+     * \brief Makes commands subsequently issued in the calling thread's current context wait for all flushed changes.
+     */
+    void synchronize();
+
+    /*!
+     * \return a counter increased by every defragment(), which invalidates all previously queried ranges.
+     */
+    unsigned int generation() const;
+
+    /*!
+     * \return the number of buffer objects.
+     */
+    std::size_t blockCount() const;
+
+    /*!
+     * \return the total size of all buffer objects in bytes.
+     */
+    std::size_t reservedSize() const;
+
+    /*!
+     * \return the total size of all live allocations in bytes, excluding alignment padding.
+     */
+    std::size_t allocatedSize() const;
+
+    /*!
+     * \return an std::error_code describing the error of the last failed call, 0 if none failed yet.
+     */
+    std::error_code lastErrorCode() const;
+
+    /*!
+     * \return a detailed message describing the error of the last failed call.
+     */
+    std::string lastErrorMessage() const;
+
+
+private:
+    struct Block;
+
+    struct Allocation {
+        Block*      block;
+        std::size_t offset;
+        std::size_t size;
+        std::size_t alignment;
+    };
+
+    std::unique_ptr<Block> createBlock(std::size_t size, bool dedicated);
+    void releaseBlock(Block* block);
+    void deallocate(const Allocation& allocation);
+    bool setError(const std::error_code& code, const std::string& message);
+
+
+private:
+    Context*          m_context;
+    const std::size_t m_blockSize;
+
+    mutable std::mutex                      m_mutex;
+    std::vector<std::unique_ptr<Block>>     m_blocks;
+    std::unordered_map<Handle, Allocation>  m_allocations;
+    Handle                                  m_nextHandle;
+    std::size_t                             m_allocatedSize;
+    unsigned int                            m_generation;
+    void*                                   m_fence; //!< GLsync of the latest flush(), waited on by synchronize()
+    bool                                    m_dirty; //!< changed since the latest flush()
+
+    std::error_code m_lastErrorCode;
+    std::string     m_lastErrorMessage;
+};
+
+
+}  // namespace glheadless
@@ -0,0 +1,139 @@
+#pragma once
+
+/*!
+ * \file CommandList.h
+ * \brief Declares class CommandList.
+ */
+
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <glheadless/glheadless_api.h>
+
+
+namespace glheadless {
+
+
+class Context;
+
+
+/*!
+ * \brief Records OpenGL commands on any thread, without a current context, for later replay by the context's thread.
+ *
+ * Only the thread a context is current on can issue its commands. A CommandList lets other threads, e.g., scene
+ * traversal workers, generate commands in parallel: each records into its own list, and the context's thread replays
+ * the lists in the desired order with execute().
+ *
+ * Commands are encoded into a compact binary stream: an opcode and size header, the arguments and, for commands
+ * passing client memory such as bufferSubData(), a copy of that data. The stream is stored in an arena of large blocks
+ * that reset() keeps for reuse, so recording a frame allocates no memory once the arena has grown to its size.
+ * Replaying decodes the stream and calls the entry points of the context's function table directly.
+ *
+ * Object names and uniform locations are recorded as passed, so they must be valid when the list is executed. Commands
+ * reading client memory are subject to the context's state at execution, e.g., the pixel unpack alignment.
+ *
+ * Recording into one list is not synchronized; use one list per thread. A recorded list may be executed any number of
+ * times, and concurrently with other lists being recorded.
+ */
+class GLHEADLESS_API CommandList {
+public:
+    /*!
+     * \param blockSize size of the arena blocks, default: 64 KiB; larger commands get a block of their own
+     */
+    explicit CommandList(std::size_t blockSize = 64 << 10);
+    CommandList(const CommandList&) = delete;
+    ~CommandList();
+
+    void activeTexture(unsigned int texture);
+    void bindBuffer(unsigned int target, unsigned int buffer);
+    void bindFramebuffer(unsigned int target, unsigned int framebuffer);
+    void bindTexture(unsigned int target, unsigned int texture);
+    void bindVertexArray(unsigned int array);
+    void blitFramebuffer(int srcX0, int srcY0, int srcX1, int srcY1, int dstX0, int dstY0, int dstX1, int dstY1, unsigned int mask, unsigned int filter);
+
+    /*!
+     * \brief Records glBufferSubData() with a copy of size bytes of data.
+     */
+    void bufferSubData(unsigned int target, std::size_t offset, std::size_t size, const void* data);
+
+    void clear(unsigned int mask);
+    void clearColor(float red, float green, float blue, float alpha);
+    void colorMask(bool red, bool green, bool blue, bool alpha);
+    void disable(unsigned int capability);
+    void drawArrays(unsigned int mode, int first, int count);
+
+    /*!
+     * \brief Records glDrawElements() with indices read from the bound element array buffer at the given byte offset.
+     */
+    void drawElements(unsigned int mode, int count, unsigned int type, std::size_t offset);
+
+    void enable(unsigned int capability);
+    void scissor(int x, int y, int width, int height);
+    void texParameteri(unsigned int target, unsigned int name, int value);
+
+    /*!
+     * \brief Records glTexSubImage2D() with a copy of size bytes of pixels.
+     *
+     * No pixel unpack buffer may be bound when the command is executed.
+     *
+     * \param size size of the pixel data in bytes, including any row padding required by the unpack alignment
+     */
+    void texSubImage2D(unsigned int target, int level, int x, int y, int width, int height, unsigned int format, unsigned int type, std::size_t size, const void* pixels);
+
+    void uniform1f(int location, float x);
+    void uniform1i(int location, int x);
+    void uniform4f(int location, float x, float y, float z, float w);
+    void useProgram(unsigned int program);
+    void viewport(int x, int y, int width, int height);
+
+    /*!
+     * \brief Replays the recorded commands in the context current on the calling thread.
+     *
+     * \return true on success, otherwise the list uses an entry point the context does not provide and the error is
+     *         available through the context's lastErrorCode() and lastErrorMessage(); no command was executed then.
+     */
+    bool execute(Context* context) const;
+
+    /*!
+     * \brief Discards the recorded commands, keeping the arena blocks for reuse.
+     */
+    void reset();
+
+    /*!
+     * \return the number of recorded commands.
+     */
+    std::size_t commandCount() const;
+
+    /*!
+     * \return the size of the recorded stream in bytes.
+     */
+    std::size_t size() const;
+
+    /*!
+     * \return the size of all arena blocks in bytes.
+     */
+    std::size_t capacity() const;
+
+    CommandList& operator=(const CommandList&) = delete;
+
+
+private:
+    struct Block;
+
+    template <typename Arguments>
+    void record(unsigned int opcode, const Arguments& arguments, const void* data = nullptr, std::size_t size = 0);
+
+
+private:
+    std::vector<std::unique_ptr<Block>> m_blocks;
+    std::size_t                         m_current;      //!< index of the block commands are appended to
+    std::size_t                         m_blockSize;
+    std::size_t                         m_commandCount;
+    std::size_t                         m_size;
+    unsigned int                        m_opcodes;      //!< bit set of the recorded opcodes, checked by execute()
+};
+
+
+}  // namespace glheadless
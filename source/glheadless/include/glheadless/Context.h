@@ -6,11 +6,16 @@
  */
 
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <glheadless/glheadless_api.h>
+#include <glheadless/DebugOutput.h>
 #include <glheadless/error.h>
+#include <glheadless/GpuProfiling.h>
 
 
 /*!
@@ -25,6 +30,81 @@ namespace glheadless {
 class AbstractImplementation;
 
 
+namespace gl {
+
+
+/*!
+ * \brief Opaque table of OpenGL entry points used internally.
+ */
+struct Functions;
+
+
+/*!
+ * \brief Opaque shadow copy of OpenGL state used internally.
+ */
+class StateCache;
+
+
+/*!
+ * \brief Opaque driver entry points used internally by filtering entry points once the state cache was disabled.
+ */
+struct StateCacheFallback;
+
+
+/*!
+ * \brief Opaque recorder of OpenGL calls used internally.
+ */
+class Tracer;
+
+
+/*!
+ * \brief Opaque driver entry points used internally by recording entry points once a trace was stopped.
+ */
+struct TraceFallback;
+
+
+/*!
+ * \brief Opaque per-thread call counters used internally.
+ */
+class CallCounter;
+
+
+/*!
+ * \brief Opaque debug output collector used internally.
+ */
+class DebugCollector;
+
+
+/*!
+ * \brief Opaque GPU timer query profiler used internally.
+ */
+class GpuProfiler;
+
+
+}  // namespace gl
+
+
+/*!
+ * \brief Counters of the state cache of a context, see Context::setStateCacheEnabled().
+ */
+struct StateCacheStatistics {
+    std::uint64_t forwardedCount = 0; //!< calls of filtered entry points passed on to the driver
+    std::uint64_t droppedCount   = 0; //!< calls dropped because they set the value already set
+};
+
+
+/*!
+ * \brief Calls of one entry point counted by a context, see Context::setCallCountingEnabled().
+ */
+struct CallStatistics {
+    std::string   name;                      //!< OpenGL function name, e.g., "glDrawArrays"
+    std::uint64_t callCount             = 0; //!< calls from all threads
+    std::uint64_t sampledCount          = 0; //!< calls whose wall time was measured
+    double        sampledMilliseconds   = 0; //!< wall time of the measured calls
+    double        estimatedMilliseconds = 0; //!< wall time of all calls, extrapolated from the measured ones
+};
+
+
 /*!
  * \brief Platform-independent headless OpenGL context representation.
  *
@@ -92,6 +172,212 @@ public:
      */
     void (*getProcAddress(const char * name) const)();
 
+    /*!
+     * \brief Enables or disables the filtering of redundant state changes; disabled by default.
+     *
+     * While enabled, getProcAddress() returns filtering entry points for common state: texture, buffer, framebuffer,
+     * vertex array and program bindings, the active texture unit, glEnable()/glDisable() of common capabilities, blend
+     * equation and function, depth function and mask, face culling, color mask, clear color, viewport and scissor box.
+     * They keep a shadow copy of that state and drop calls that set the value already set, before they reach the
+     * driver. The entry points used by the library itself are resolved again, so they are filtered as well.
+     *
+     * The filtering entry points find the shadow copy of the context made current through makeCurrent() on the calling
+     * thread; contexts without the cache are not affected by them. State changed through other entry points, e.g.,
+     * glBindTextureUnit(), glBindBufferBase() or glPopAttrib(), or by deleting a bound object in another context of the
+     * share group, requires invalidateStateCache().
+     *
+     * The context must be current on the calling thread.
+     */
+    void setStateCacheEnabled(bool enabled);
+
+    /*!
+     * \return true if the filtering of redundant state changes is enabled.
+     */
+    bool stateCacheEnabled() const;
+
+    /*!
+     * \brief Forgets the shadow copy, so the next call of each filtering entry point reaches the driver.
+     */
+    void invalidateStateCache();
+
+    /*!
+     * \return the counters of the state cache since it was enabled; may be called from any thread.
+     */
+    StateCacheStatistics stateCacheStatistics() const;
+
+    /*!
+     * \brief Starts recording the OpenGL calls of this context into a binary trace file, see TracePlayer.
+     *
+     * While recording, getProcAddress() returns recording entry points for the functions the library uses itself,
+     * including draw calls, buffer, texture, framebuffer, shader and program functions, state changes and syncs. They
+     * append each call and the client memory it reads, e.g., the data of glBufferSubData() or glTexImage2D(), to a
+     * file that grows at its end through a memory mapping, and pass the call on. The entry points used by the library
+     * itself are resolved again, so its own calls are recorded as well. With the state cache enabled, only the calls
+     * that pass the cache are recorded.
+     *
+     * The recording entry points find the trace of the context made current through makeCurrent() on the calling
+     * thread. Not recorded are calls of functions outside this set, data written through persistent mappings and
+     * client-side vertex arrays; pointers passed to glDrawElements() and glVertexAttribPointer() are recorded as buffer
+     * offsets.
+     *
+     * The context must be current on the calling thread.
+     *
+     * \param path the trace file, which is created or truncated
+     *
+     * \return true on success.
+     */
+    bool startTrace(const std::string& path);
+
+    /*!
+     * \brief Stops recording and completes the trace file.
+     *
+     * \return true if all calls since startTrace() were recorded, false if no trace was recorded or writing the file
+     *         failed, e.g., because the disk is full.
+     */
+    bool stopTrace();
+
+    /*!
+     * \return true while the calls of this context are recorded.
+     */
+    bool tracing() const;
+
+    /*!
+     * \brief Enables or disables counting the OpenGL calls of this context per entry point; disabled by default.
+     *
+     * While enabled, getProcAddress() returns counting entry points for the functions the library uses itself, see
+     * startTrace(). Each thread counts into its own counters, created when it makes the context current, so counting
+     * costs a thread-local lookup and an uncontended increment per call; every sampleInterval-th call of a thread
+     * additionally reads the clock twice to measure its wall time. The entry points used by the library itself are
+     * resolved again, so they are counted as well. The counters sit closest to the driver: calls dropped by the state
+     * cache are not counted, and the time of recording a trace is not included.
+     *
+     * Calling it again while enabled changes the interval and keeps the counts. The context must be current on the
+     * calling thread.
+     *
+     * \param sampleInterval measure the wall time of one in this many calls per thread, 0 disables timing, default: 64
+     */
+    void setCallCountingEnabled(bool enabled, unsigned int sampleInterval = 64);
+
+    /*!
+     * \return true if the calls of this context are counted.
+     */
+    bool callCountingEnabled() const;
+
+    /*!
+     * \return the entry points called since counting was enabled or last reset, by estimated time and count, most
+     *         expensive first; may be called from any thread, also while others are calling.
+     */
+    std::vector<CallStatistics> callStatistics() const;
+
+    /*!
+     * \brief Restarts the counts reported by callStatistics() from zero.
+     */
+    void resetCallStatistics();
+
+    /*!
+     * \brief Starts collecting the debug output of this context (GL_KHR_debug) into the sink.
+     *
+     * Installs a debug message callback that copies each message into a fixed-size ring of this context, without
+     * locking or allocating, and returns to the driver. A thread of the collector drains the ring into the sink every
+     * few milliseconds, so the sink may take its time, e.g., for logging. Messages arriving while the ring is full are
+     * dropped and counted, see debugOutputStatistics().
+     *
+     * The filter is applied through glDebugMessageControl(), so the driver does not generate messages that are not
+     * collected; this replaces the message control state of the context. Synchronous output is disabled, so drivers
+     * may report from their own threads. Most drivers report performance messages only for contexts created with
+     * ContextFormat::debug.
+     *
+     * The context must be current on the calling thread. Contexts from ContextFactory::getCurrent() are not supported,
+     * as the native context outlives this object and the driver could still call the callback.
+     *
+     * \param sink receives the messages on the draining thread
+     * \param filter sources, types and severities to collect, default: all of severity DebugSeverity::LOW and above
+     * \param capacity messages the ring holds, rounded up to a power of two, default: 256
+     *
+     * \return true on success, false if debug output is already collected, the context is not owned, or debug output is
+     *         not supported (OpenGL 4.3 or GL_KHR_debug is required).
+     */
+    bool startDebugOutput(const DebugSink& sink, const DebugFilter& filter = DebugFilter(), std::size_t capacity = 256);
+
+    /*!
+     * \brief Removes the callback and stops the draining thread after passing the remaining messages to the sink.
+     *
+     * The context must be current on the calling thread.
+     *
+     * \return true on success, false if no debug output is collected.
+     */
+    bool stopDebugOutput();
+
+    /*!
+     * \return true while the debug output of this context is collected.
+     */
+    bool debugOutputActive() const;
+
+    /*!
+     * \return the counters of the debug output since startDebugOutput(), zeros while none is collected; may be called
+     *         from any thread.
+     */
+    DebugOutputStatistics debugOutputStatistics() const;
+
+    /*!
+     * \brief Starts measuring the GPU time of scopes marked with beginGpuScope() and endGpuScope() or GpuScope.
+     *
+     * Each scope boundary issues a GL_TIMESTAMP query from a pool of query objects that are reused once their results
+     * were read. Results are read without waiting for the GPU: endGpuFrame() reads those of frames that ended at least
+     * frameLatency frames before and whose queries are complete, so profiling does not stall the pipeline. Timings of
+     * completed frames are available through takeGpuFrameTimings(); up to 256 are kept, older ones are dropped, as
+     * are frames whose results are still pending 16 frames later.
+     *
+     * The context must be current on the calling thread for all GPU profiling functions.
+     *
+     * \param frameLatency number of frames after which the results of a frame are read, default: 2
+     *
+     * \return true on success, false if already profiling or timer queries are not supported (OpenGL 3.3 or
+     *         GL_ARB_timer_query is required).
+     */
+    bool startGpuProfiling(std::size_t frameLatency = 2);
+
+    /*!
+     * \brief Stops profiling, waits for the results of the ended frames and deletes the query objects.
+     *
+     * The timings of a frame that was not ended are discarded; those of the others remain available through
+     * takeGpuFrameTimings().
+     *
+     * \return true on success, false if not profiling.
+     */
+    bool stopGpuProfiling();
+
+    /*!
+     * \return true between startGpuProfiling() and stopGpuProfiling().
+     */
+    bool gpuProfilingActive() const;
+
+    /*!
+     * \brief Starts a scope of the current frame; scopes nest.
+     *
+     * \return true on success, false if not profiling.
+     */
+    bool beginGpuScope(const char* name);
+
+    /*!
+     * \brief Ends the scope started last.
+     *
+     * \return true on success, false if not profiling or no scope is open.
+     */
+    bool endGpuScope();
+
+    /*!
+     * \brief Ends the current frame and reads the results of earlier frames that are available.
+     *
+     * \return true on success, false if not profiling or a scope is still open.
+     */
+    bool endGpuFrame();
+
+    /*!
+     * \return the timings of the frames completed since the last call, oldest first.
+     */
+    std::vector<GpuFrameTimings> takeGpuFrameTimings();
+
     /*!
      * \brief For internal use.
      *
@@ -130,13 +416,37 @@ public:
     */
     const AbstractImplementation* implementation() const;
 
+    /*!
+     * \brief For internal use.
+     *
+     * The entry points are resolved through getProcAddress() on first access, so the context must be current on the
+     * calling thread at that time.
+     *
+     * \return the table of OpenGL entry points used by the library (opaque).
+     */
+    const gl::Functions& functions() const;
+
     Context& operator=(const Context&) = delete;
     Context& operator=(Context&& other) = delete;
 
 
+private:
+    void (*countedProcAddress(const char* name) const)();
+    void (*uncachedProcAddress(const char* name) const)();
+    void resolveFunctions();
+
+
 private:
     std::unique_ptr<AbstractImplementation> m_implementation; //!< platform-dependent implementation
     std::thread::id                         m_owningThread;   //!< id of the thread that created this context
+    mutable std::unique_ptr<gl::Functions>  m_functions;      //!< lazily resolved OpenGL entry points
+    std::unique_ptr<gl::StateCache>         m_stateCache;     //!< shadow copy of state, if filtering is enabled
+    std::unique_ptr<gl::StateCacheFallback> m_cacheFallback;  //!< entry points passed on to, once caching was disabled
+    std::unique_ptr<gl::Tracer>             m_tracer;         //!< recorder of calls, if a trace is recorded
+    std::unique_ptr<gl::TraceFallback>      m_traceFallback;  //!< entry points passed on to, once a trace was stopped
+    std::unique_ptr<gl::CallCounter>        m_callCounter;    //!< per-thread call counters, if counting is enabled
+    std::unique_ptr<gl::DebugCollector>     m_debugCollector; //!< ring of debug messages, if debug output is collected
+    std::unique_ptr<gl::GpuProfiler>        m_gpuProfiler;    //!< timer queries and timings, once GPU profiling started
 
     std::error_code  m_lastErrorCode;     //!< last error code that occured, default: 0 (success)
     std::string      m_lastErrorMessage;  //!< detailed message of the last error, default: empty
@@ -0,0 +1,81 @@
+#pragma once
+
+/*!
+ * \file ContextObserver.h
+ * \brief Declares the context lifecycle events and the functions to observe them.
+ */
+
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <system_error>
+
+#include <glheadless/glheadless_api.h>
+
+
+namespace glheadless {
+
+
+class Context;
+
+
+/*!
+ * \brief Kinds of context lifecycle events.
+ */
+enum class ContextEventType : unsigned int {
+    CREATED,        //!< a context was created successfully or captured through ContextFactory::getCurrent()
+    DESTROYING,     //!< a context that was CREATED is about to be destroyed, its native handle is still valid
+    MADE_CURRENT,   //!< makeCurrent() succeeded
+    DONE_CURRENT,   //!< doneCurrent() succeeded
+    ERROR_OCCURRED  //!< an error was set on the context, including errors during its creation
+};
+
+
+/*!
+ * \brief A context lifecycle event.
+ *
+ * Events are delivered on the thread that caused them, in the order they happened on that thread.
+ */
+struct ContextEvent {
+    ContextEventType   type;         //!< kind of the event
+    Context*           context;      //!< context of the event, only valid during the call of the observer
+    std::error_code    errorCode;    //!< the error, ERROR_OCCURRED only
+    const std::string* errorMessage; //!< message of the error, ERROR_OCCURRED only, otherwise nullptr
+};
+
+
+/*!
+ * \brief Function receiving context lifecycle events.
+ *
+ * Observers may use the context, e.g., query its native handle, but must not destroy it, and must not throw, as some
+ * events are delivered from the destructor of Context.
+ */
+using ContextObserver = std::function<void(const ContextEvent& event)>;
+
+
+/*!
+ * \brief Registers an observer for the lifecycle events of all contexts of the process.
+ *
+ * Observers are called in the order of their registration. While no observer is registered, the events cost a single
+ * atomic load each.
+ *
+ * \param observer the function to call, an empty function is ignored
+ *
+ * \return an id for removeContextObserver(), 0 if observer is empty.
+ */
+GLHEADLESS_API std::size_t addContextObserver(ContextObserver observer);
+
+/*!
+ * \brief Unregisters an observer.
+ *
+ * Events being delivered concurrently on other threads may still reach the observer after this function returned.
+ *
+ * \param id the id returned by addContextObserver()
+ *
+ * \return true if an observer with the id was registered.
+ */
+GLHEADLESS_API bool removeContextObserver(std::size_t id);
+
+
+}  // namespace glheadless
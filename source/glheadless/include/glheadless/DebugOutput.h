@@ -0,0 +1,106 @@
+#pragma once
+
+/*!
+ * \file DebugOutput.h
+ * \brief Declares the enums and structs of debug output collection, see Context::startDebugOutput().
+ */
+
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+
+namespace glheadless {
+
+
+/*!
+ * \brief Origin of a debug message (GL_DEBUG_SOURCE_*).
+ */
+enum class DebugSource : unsigned int {
+    API,             //!< calls of the OpenGL API
+    WINDOW_SYSTEM,   //!< calls of the window system API, e.g., EGL
+    SHADER_COMPILER, //!< the GLSL compiler
+    THIRD_PARTY,     //!< tools and layers
+    APPLICATION,     //!< glDebugMessageInsert() with GL_DEBUG_SOURCE_APPLICATION
+    OTHER            //!< anything else
+};
+
+
+/*!
+ * \brief Kind of a debug message (GL_DEBUG_TYPE_*).
+ */
+enum class DebugType : unsigned int {
+    ERROR,               //!< an OpenGL error was generated
+    DEPRECATED_BEHAVIOR, //!< use of deprecated functionality
+    UNDEFINED_BEHAVIOR,  //!< use of undefined behavior
+    PORTABILITY,         //!< use of functionality that is not portable
+    PERFORMANCE,         //!< use of functionality that may be slow, e.g., synchronous readbacks or shader recompiles
+    OTHER,               //!< anything else
+    MARKER,              //!< annotation of the command stream
+    PUSH_GROUP,          //!< glPushDebugGroup()
+    POP_GROUP            //!< glPopDebugGroup()
+};
+
+
+/*!
+ * \brief Importance of a debug message (GL_DEBUG_SEVERITY_*), in increasing order.
+ */
+enum class DebugSeverity : unsigned int {
+    NOTIFICATION, //!< informational
+    LOW,          //!< minor performance issues, redundant state changes
+    MEDIUM,       //!< major performance issues, undefined behavior
+    HIGH          //!< errors and undefined behavior that may crash
+};
+
+
+/*!
+ * \brief Maximum length of the text of a DebugMessage; longer messages are truncated.
+ */
+const std::size_t k_maxDebugMessageLength = 511;
+
+
+/*!
+ * \brief A message reported by the driver.
+ *
+ * The text is stored inline, so collecting a message does not allocate.
+ */
+struct DebugMessage {
+    DebugSource                           source   = DebugSource::OTHER;           //!< origin
+    DebugType                             type     = DebugType::OTHER;             //!< kind
+    DebugSeverity                         severity = DebugSeverity::NOTIFICATION; //!< importance
+    unsigned int                          id       = 0;                            //!< driver-specific message id
+    std::chrono::steady_clock::time_point time;                                    //!< when the driver reported it
+    std::size_t                           length   = 0;                            //!< length of text
+    char                                  text[k_maxDebugMessageLength + 1] = {};  //!< null-terminated message
+};
+
+
+/*!
+ * \brief Selects the messages collected by Context::startDebugOutput().
+ */
+struct DebugFilter {
+    std::vector<DebugSource> sources;                               //!< sources to collect, empty: all
+    std::vector<DebugType>   types;                                 //!< types to collect, empty: all
+    DebugSeverity            minimumSeverity = DebugSeverity::LOW;  //!< least important severity to collect
+};
+
+
+/*!
+ * \brief Counters of the debug output of a context, see Context::debugOutputStatistics().
+ */
+struct DebugOutputStatistics {
+    std::uint64_t collectedCount = 0; //!< messages passed to the sink
+    std::uint64_t droppedCount   = 0; //!< messages lost because the ring was full
+};
+
+
+/*!
+ * \brief Receives collected messages on the draining thread of a context, in the order they were reported.
+ */
+using DebugSink = std::function<void(const DebugMessage& message)>;
+
+
+}  // namespace glheadless
@@ -0,0 +1,81 @@
+#pragma once
+
+/*!
+ * \file GpuProfiling.h
+ * \brief Declares the timings reported by GPU profiling, see Context::startGpuProfiling(), and class GpuScope.
+ */
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glheadless/glheadless_api.h>
+
+
+namespace glheadless {
+
+
+class Context;
+
+
+/*!
+ * \brief Value of GpuScopeTiming::parent for scopes not nested in another scope.
+ */
+const std::size_t k_noParentScope = ~std::size_t(0);
+
+
+/*!
+ * \brief GPU time of the scopes of one name in one frame.
+ *
+ * Scopes of the same name directly nested in the same parent, e.g., those opened in a loop, are merged.
+ */
+struct GpuScopeTiming {
+    std::string   name;                           //!< name passed to Context::beginGpuScope()
+    std::size_t   parent       = k_noParentScope; //!< index of the enclosing scope in GpuFrameTimings::scopes
+    unsigned int  depth        = 0;               //!< number of enclosing scopes
+    std::uint64_t count        = 0;               //!< number of merged scopes
+    double        milliseconds = 0;               //!< GPU time of the merged scopes
+};
+
+
+/*!
+ * \brief GPU timings of one frame, i.e., the scopes between two calls of Context::endGpuFrame().
+ */
+struct GpuFrameTimings {
+    std::uint64_t               frame        = 0; //!< number of the frame, counted from 0 at Context::startGpuProfiling()
+    double                      milliseconds = 0; //!< GPU time from the start of the first to the end of the last scope
+    std::vector<GpuScopeTiming> scopes;           //!< in pre-order, i.e., each scope is followed by its nested scopes
+};
+
+
+/*!
+ * \brief Marks the lifetime of a C++ scope as a GPU profiling scope of a context.
+ *
+ * Errors, e.g., if the context is not profiling, are reported through the context's lastErrorCode().
+ */
+class GLHEADLESS_API GpuScope {
+public:
+    /*!
+     * \brief Calls context.beginGpuScope(name).
+     */
+    GpuScope(Context& context, const char* name);
+
+    GpuScope(const GpuScope&) = delete;
+
+    /*!
+     * \brief Calls endGpuScope() of the context, if beginGpuScope() succeeded.
+     */
+    ~GpuScope();
+
+    GpuScope& operator=(const GpuScope&) = delete;
+
+
+private:
+    Context& m_context;
+    bool     m_begun;
+};
+
+
+}  // namespace glheadless
@@ -0,0 +1,65 @@
+#pragma once
+
+/*!
+ * \file MemoryFootprint.h
+ * \brief Declares the functions measuring the memory of the process and the approximate memory of a context.
+ */
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glheadless/glheadless_api.h>
+#include <glheadless/ContextFormat.h>
+
+
+namespace glheadless {
+
+
+/*!
+ * \brief Memory of the process.
+ */
+struct MemoryUsage {
+    std::uint64_t rssBytes = 0; //!< resident set size, i.e., memory in RAM, including pages shared with other processes
+    std::uint64_t pssBytes = 0; //!< proportional set size, i.e., RSS with shared pages divided among their processes
+};
+
+
+/*!
+ * \brief Memory that one additional context takes.
+ */
+struct ContextFootprint {
+    std::int64_t rssBytes    = 0; //!< growth of the resident set size per context
+    std::int64_t pssBytes    = 0; //!< growth of the proportional set size per context
+    std::size_t  sampleCount = 0; //!< number of contexts measured, 0 if the footprint could not be measured
+};
+
+
+/*!
+ * \brief Reads the memory of the process from /proc/self/smaps_rollup.
+ *
+ * Falls back to /proc/self/statm on kernels before 4.14, which report no PSS; pssBytes is 0 then.
+ *
+ * \return false if the memory could not be read, e.g., on platforms other than Linux.
+ */
+GLHEADLESS_API bool processMemoryUsage(MemoryUsage& usage);
+
+/*!
+ * \brief Estimates the memory of a context of a format.
+ *
+ * Measures the process memory before and after creating a few contexts of the format, standalone or shared with
+ * one context created before, and making each current once, as drivers allocate some memory on first use. One-time
+ * allocations of the driver, e.g., for the first context of the process, are not included. The measurement runs on a
+ * thread of its own, so the current context of the calling thread is not affected, and takes as long as creating the
+ * contexts; its result is kept for later calls with the same format. Memory that other threads allocate meanwhile
+ * distorts the result.
+ *
+ * \param format the format of the contexts
+ * \param shared true to measure contexts sharing objects with another context
+ *
+ * \return the footprint, sampleCount is 0 if the contexts could not be created or the memory could not be read.
+ */
+GLHEADLESS_API ContextFootprint approximateFootprint(const ContextFormat& format = ContextFormat(), bool shared = false);
+
+
+}  // namespace glheadless
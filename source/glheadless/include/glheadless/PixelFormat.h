@@ -0,0 +1,45 @@
+#pragma once
+
+/*!
+ * \file PixelFormat.h
+ * \brief Declares enum PixelFormat and helpers to compute image sizes.
+ */
+
+
+#include <cstddef>
+
+#include <glheadless/glheadless_api.h>
+
+
+namespace glheadless {
+
+
+/*!
+ * \brief Describes the memory layout of an 8 bit per channel image in client memory.
+ *
+ * All formats are tightly packed, i.e., rows are not padded. Planar formats store their planes consecutively.
+ */
+enum class PixelFormat : unsigned int {
+    RGBA8, //!< 4 bytes per pixel: red, green, blue, alpha
+    BGRA8, //!< 4 bytes per pixel: blue, green, red, alpha
+    RGB8,  //!< 3 bytes per pixel: red, green, blue
+    BGR8,  //!< 3 bytes per pixel: blue, green, red
+    R8,    //!< 1 byte per pixel: red channel only
+    LUMA8, //!< 1 byte per pixel: full range BT.601 luma (grayscale)
+    I420,  //!< planar YUV 4:2:0, BT.601 limited range: Y plane, then U plane, then V plane; requires even dimensions
+    NV12   //!< semi-planar YUV 4:2:0, BT.601 limited range: Y plane, then interleaved UV plane; requires even dimensions
+};
+
+
+/*!
+ * \return the number of bytes per pixel of a packed format, or 0 for planar formats.
+ */
+GLHEADLESS_API std::size_t bytesPerPixel(PixelFormat format);
+
+/*!
+ * \return the number of bytes required to store an image of the given format and size.
+ */
+GLHEADLESS_API std::size_t imageSize(PixelFormat format, unsigned int width, unsigned int height);
+
+
+}  // namespace glheadless
@@ -0,0 +1,88 @@
+#pragma once
+
+/*!
+ * \file PixelOperations.h
+ * \brief Declares CPU kernels for post-processing 8 bit readback buffers.
+ */
+
+
+#include <array>
+#include <cstddef>
+
+#include <glheadless/glheadless_api.h>
+
+
+namespace glheadless {
+
+
+/*!
+ * \brief Instruction sets the pixel kernels are implemented for.
+ */
+enum class InstructionSet : unsigned int {
+    SCALAR, //!< portable fallback
+    SSSE3,  //!< x86 SSSE3 (128 bit)
+    AVX2,   //!< x86 AVX2 (256 bit)
+    NEON    //!< AArch64 Advanced SIMD (128 bit)
+};
+
+
+/*!
+ * \return the best instruction set supported by both the build and the CPU, detected at runtime.
+ */
+GLHEADLESS_API InstructionSet bestInstructionSet();
+
+/*!
+ * \return the instruction set currently used by the pixel kernels, default: bestInstructionSet().
+ */
+GLHEADLESS_API InstructionSet instructionSet();
+
+/*!
+ * \brief Selects the instruction set used by the pixel kernels, e.g., to compare implementations.
+ *
+ * \return false if the instruction set is not supported by the build or the CPU; the selection is unchanged then.
+ */
+GLHEADLESS_API bool setInstructionSet(InstructionSet instructionSet);
+
+
+/*!
+ * \brief Reverses the row order of an image, e.g., to convert the bottom-up result of glReadPixels to top-down.
+ *
+ * \param source first row of the input image
+ * \param destination first row of the output image; may be equal to source for an in-place flip, but must not
+ *        overlap it otherwise
+ * \param rowSize size of a row in bytes, including any padding
+ * \param rows number of rows
+ */
+GLHEADLESS_API void flipRows(const void* source, void* destination, std::size_t rowSize, std::size_t rows);
+
+/*!
+ * \brief Reorders the channels of 4 channel pixels: destination channel i receives source channel order[i].
+ *
+ * For example, { 2, 1, 0, 3 } converts RGBA to BGRA and vice versa. Source and destination may be equal. Orders
+ * referring to channels beyond 3 are invalid and leave the destination unchanged.
+ */
+GLHEADLESS_API void swizzle(const void* source, void* destination, std::size_t pixels, const std::array<unsigned char, 4>& order);
+
+/*!
+ * \brief Converts RGBA pixels to RGB (or BGR if swapRedBlue is set) by dropping the alpha channel.
+ *
+ * The destination receives 3 bytes per pixel. Source and destination may be equal.
+ */
+GLHEADLESS_API void packRGB(const void* source, void* destination, std::size_t pixels, bool swapRedBlue = false);
+
+/*!
+ * \brief Multiplies the color channels of RGBA (or BGRA) pixels by alpha, rounding to nearest.
+ *
+ * Source and destination may be equal.
+ */
+GLHEADLESS_API void premultiplyAlpha(const void* source, void* destination, std::size_t pixels);
+
+/*!
+ * \brief Divides the color channels of premultiplied RGBA (or BGRA) pixels by alpha, rounding to nearest.
+ *
+ * Results are clamped to 255, pixels with an alpha of 0 become transparent black. Source and destination may be equal.
+ */
+GLHEADLESS_API void unpremultiplyAlpha(const void* source, void* destination, std::size_t pixels);
+
+
+}  // namespace glheadless
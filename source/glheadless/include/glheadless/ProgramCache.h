@@ -0,0 +1,117 @@
+#pragma once
+
+/*!
+ * \file ProgramCache.h
+ * \brief Declares class ProgramCache and struct ShaderSource.
+ */
+
+
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <glheadless/glheadless_api.h>
+
+
+namespace glheadless {
+
+
+class Context;
+
+
+/*!
+ * \brief Source code of one shader stage of a program.
+ */
+struct ShaderSource {
+    unsigned int type = 0; //!< OpenGL shader type, e.g., GL_VERTEX_SHADER
+    std::string  source;   //!< GLSL source code
+};
+
+
+/*!
+ * \brief Creates programs from a directory of program binaries, compiling shaders only on a cache miss.
+ *
+ * Each entry holds the result of glGetProgramBinary() for one combination of shader sources, named by a hash of the
+ * shader types and sources, in a subdirectory per fingerprint of the driver: GL_VENDOR, GL_RENDERER, GL_VERSION (which
+ * includes the driver build on common drivers), GL_SHADING_LANGUAGE_VERSION and the supported binary formats. An
+ * entry also stores the full fingerprint and sources, which must match to load it, so hash collisions only cause
+ * misses. Processes of different drivers may share the directory; entries of drivers no longer in use are kept
+ * until clear(). A binary rejected by glProgramBinary() is replaced by a freshly compiled one. Entries are written to
+ * a temporary file and renamed, so concurrent processes sharing the directory never read partially written entries.
+ *
+ * Failures to read or write the directory are not errors; the program is then compiled as if caching was disabled.
+ * If the driver supports no binary formats, every request is a miss. An instance is not thread-safe, but any number
+ * of instances, in any number of threads and processes, may share a directory.
+ */
+class GLHEADLESS_API ProgramCache {
+public:
+    /*!
+     * \param directory directory of the entries, created on first use if it does not exist; its parent must exist.
+     */
+    explicit ProgramCache(const std::string& directory);
+
+    /*!
+     * \return the directory of the entries.
+     */
+    const std::string& directory() const;
+
+    /*!
+     * \brief Creates a linked program in the context current on the calling thread, from the cache if possible.
+     *
+     * \param context the current context
+     * \param shaders the shader stages of the program
+     * \param program receives the new program object
+     *
+     * \return true on success, otherwise the error, e.g., a compile log, is available through lastErrorCode() and
+     *         lastErrorMessage().
+     */
+    bool createProgram(Context* context, const std::vector<ShaderSource>& shaders, unsigned int& program);
+
+    /*!
+     * \brief Creates a program from a vertex and a fragment shader, see above.
+     */
+    bool createProgram(Context* context, const std::string& vertexSource, const std::string& fragmentSource, unsigned int& program);
+
+    /*!
+     * \brief Deletes all entries of the directory, of all drivers.
+     *
+     * \return true if all entries could be deleted.
+     */
+    bool clear();
+
+    /*!
+     * \return the number of programs loaded from the cache by this instance.
+     */
+    unsigned int hitCount() const;
+
+    /*!
+     * \return the number of programs compiled by this instance.
+     */
+    unsigned int missCount() const;
+
+    /*!
+     * \return an std::error_code describing the error of the last failed call, 0 if none failed yet.
+     */
+    const std::error_code& lastErrorCode() const;
+
+    /*!
+     * \return a detailed message describing the error of the last failed call.
+     */
+    const std::string& lastErrorMessage() const;
+
+
+private:
+    bool setError(const std::error_code& code, const std::string& message);
+
+
+private:
+    std::string  m_directory;
+    unsigned int m_hitCount;
+    unsigned int m_missCount;
+
+    std::error_code m_lastErrorCode;
+    std::string     m_lastErrorMessage;
+};
+
+
+}  // namespace glheadless
@@ -0,0 +1,224 @@
+#pragma once
+
+/*!
+ * \file Readback.h
+ * \brief Declares class Readback and the structs describing its output layouts.
+ */
+
+
+#include <cstddef>
+#include <vector>
+
+#include <glheadless/glheadless_api.h>
+#include <glheadless/PixelFormat.h>
+
+
+namespace glheadless {
+
+
+class Context;
+
+
+/*!
+ * \brief Rectangle in window coordinates, with the origin in the lower left corner.
+ */
+struct GLHEADLESS_API Region {
+    Region();
+    Region(int x, int y, unsigned int width, unsigned int height);
+
+    int          x;      //!< left edge
+    int          y;      //!< bottom edge
+    unsigned int width;  //!< width in pixels
+    unsigned int height; //!< height in pixels
+};
+
+
+/*!
+ * \brief Describes where one region is stored in a compact readback buffer.
+ */
+struct ImageRegion {
+    Region      region;     //!< the rectangle that was read
+    std::size_t offset = 0; //!< byte offset of the region in the buffer
+    std::size_t size   = 0; //!< size of the region in bytes
+};
+
+
+/*!
+ * \brief Describes where one level of an image pyramid is stored in a contiguous readback buffer.
+ */
+struct ImageLevel {
+    unsigned int level  = 0; //!< mipmap level, 0 is the full resolution
+    unsigned int width  = 0; //!< width of the level in pixels
+    unsigned int height = 0; //!< height of the level in pixels
+    std::size_t  offset = 0; //!< byte offset of the level in the buffer
+    std::size_t  size   = 0; //!< size of the level in bytes
+};
+
+
+/*!
+ * \brief Reads pixels from the current read framebuffer of a Context into client memory.
+ *
+ * Formats other than PixelFormat::RGBA8 are converted on the GPU before the pixels are transferred: a small built-in
+ * shader pass writes the tightly packed target layout (e.g., planar YUV or packed BGR) into a pixel pack buffer, so
+ * only the bytes of the requested format cross the readback path and no conversion runs on the CPU.
+ *
+ * A Readback owns OpenGL objects of its Context. It must only be used, and destroyed, while that context is current
+ * on the calling thread. Any OpenGL state it modifies is restored before a call returns.
+ */
+class GLHEADLESS_API Readback {
+public:
+    /*!
+     * \param context the context whose read framebuffer is read; must outlive this object.
+     */
+    explicit Readback(Context* context);
+    Readback(const Readback&) = delete;
+    ~Readback();
+
+    /*!
+     * \brief Selects the row order of the output.
+     *
+     * OpenGL stores the bottom row first. If enabled, rows are written top row first instead. The flip is performed
+     * during the GPU conversion pass and is free except for PixelFormat::RGBA8, which then also takes the shader path.
+     */
+    void setFlipVertically(bool flip);
+
+    /*!
+     * \return true if rows are written top row first.
+     */
+    bool flipVertically() const;
+
+    /*!
+     * \brief Reads a rectangle of the current read framebuffer, converted to the requested format.
+     *
+     * \param x, y lower left corner of the rectangle in window coordinates
+     * \param width, height size of the rectangle; must be even for PixelFormat::I420 and PixelFormat::NV12
+     * \param format target layout of the pixels in client memory
+     * \param destination client memory of at least imageSize(format, width, height) bytes
+     *
+     * \return true on success, otherwise the error is available through the context's lastErrorCode().
+     */
+    bool read(int x, int y, unsigned int width, unsigned int height, PixelFormat format, void* destination);
+
+    /*!
+     * \brief Computes the buffer layout used by readPyramid().
+     *
+     * Level n has the size max(1, width >> n) x max(1, height >> n). The levels are stored consecutively and in the
+     * order given, without padding. The size of the whole buffer is offset + size of the last entry.
+     *
+     * \return one entry per requested level.
+     */
+    static std::vector<ImageLevel> pyramidLayout(PixelFormat format, unsigned int width, unsigned int height, const std::vector<unsigned int>& levels);
+
+    /*!
+     * \brief Reads selected levels of a downscaled pyramid of a rectangle of the current read framebuffer.
+     *
+     * The rectangle is copied once and the mipmap chain is built on the GPU (glGenerateMipmap, a box filter on common
+     * implementations). Only the requested levels are converted and transferred, e.g., { 0, 2, 4 } for the full
+     * resolution and two thumbnails. Levels must not exceed the mipmap chain of the rectangle; for I420 and NV12 every
+     * requested level must have even dimensions.
+     *
+     * \param x, y lower left corner of the rectangle in window coordinates
+     * \param width, height size of the rectangle
+     * \param format target layout of the pixels in client memory
+     * \param levels the levels to read, in the order they are stored
+     * \param destination client memory laid out as described by pyramidLayout()
+     *
+     * \return true on success, otherwise the error is available through the context's lastErrorCode().
+     */
+    bool readPyramid(int x, int y, unsigned int width, unsigned int height, PixelFormat format, const std::vector<unsigned int>& levels, void* destination);
+
+    /*!
+     * \brief Merges overlapping regions into their bounding rectangles until no two regions overlap.
+     *
+     * Empty regions are dropped. The result is sorted bottom to top, then left to right.
+     */
+    static std::vector<Region> mergeRegions(const std::vector<Region>& regions);
+
+    /*!
+     * \brief Computes the region table used by readRegions().
+     *
+     * The regions are merged with mergeRegions(); for PixelFormat::I420 and PixelFormat::NV12 they are first expanded
+     * to even coordinates and dimensions. Each merged region is stored tightly packed, one after another. The size of
+     * the whole buffer is offset + size of the last entry.
+     *
+     * \return one entry per merged region.
+     */
+    static std::vector<ImageRegion> regionLayout(PixelFormat format, const std::vector<Region>& regions);
+
+    /*!
+     * \brief Reads only the given regions of the current read framebuffer into a compact buffer.
+     *
+     * Readback cost scales with the area of the regions instead of the framebuffer size. Overlapping regions are read
+     * only once.
+     *
+     * \param regions rectangles to read, may overlap
+     * \param format target layout of the pixels in client memory
+     * \param destination client memory laid out as described by regionLayout()
+     *
+     * \return true on success, otherwise the error is available through the context's lastErrorCode().
+     */
+    bool readRegions(const std::vector<Region>& regions, PixelFormat format, void* destination);
+
+    /*!
+     * \brief Marks a rectangle as changed since the last call to readDirtyRegions().
+     */
+    void addDirtyRegion(const Region& region);
+
+    /*!
+     * \brief Marks the current scissor box (GL_SCISSOR_BOX) as changed.
+     *
+     * Call this after each draw call that is restricted by the scissor test to track dirty regions automatically.
+     */
+    void addDirtyScissor();
+
+    /*!
+     * \return the rectangles marked as changed, not merged.
+     */
+    const std::vector<Region>& dirtyRegions() const;
+
+    /*!
+     * \brief Discards all rectangles marked as changed.
+     */
+    void clearDirtyRegions();
+
+    /*!
+     * \brief Reads the regions marked as changed, as readRegions(dirtyRegions(), ...) does, and clears them on success.
+     *
+     * \param format target layout of the pixels in client memory
+     * \param destination client memory laid out as described by regionLayout(format, dirtyRegions())
+     *
+     * \return true on success, otherwise the error is available through the context's lastErrorCode().
+     */
+    bool readDirtyRegions(PixelFormat format, void* destination);
+
+    Readback& operator=(const Readback&) = delete;
+
+
+private:
+    void readDirect(const std::vector<ImageRegion>& layout, void* destination);
+    void copySource(int x, int y, unsigned int width, unsigned int height, unsigned int maxLevel);
+    void convert(unsigned int level, unsigned int width, unsigned int height, PixelFormat format, void* destination);
+    void transfer(std::size_t size, void* destination);
+    void prepareConversion();
+
+
+private:
+    Context* m_context;
+    bool     m_flipVertically;
+
+    unsigned int m_program;        //!< conversion program, created on first use
+    unsigned int m_vertexArray;    //!< empty vertex array for the attribute-less full-screen triangle
+    unsigned int m_sourceTexture;  //!< copy of the requested rectangle, including generated mipmap levels
+    unsigned int m_targetTexture;  //!< single channel byte image holding the converted output
+    unsigned int m_framebuffer;    //!< render target for the conversion pass
+    unsigned int m_packBuffer;     //!< pixel pack buffer receiving the output
+    unsigned int m_sourceWidth;
+    unsigned int m_sourceHeight;
+    unsigned int m_targetWidth;
+    unsigned int m_targetHeight;
+
+    std::vector<Region> m_dirtyRegions;
+};
+
+
+}  // namespace glheadless
@@ -0,0 +1,116 @@
+#pragma once
+
+/*!
+ * \file RuntimeStatistics.h
+ * \brief Declares the library-wide statistics of context operations and their Prometheus text format.
+ */
+
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <glheadless/glheadless_api.h>
+
+
+namespace glheadless {
+
+
+/*!
+ * \brief Number of buckets of a LatencyHistogram: upper bounds of 1 us to 2^24 us (about 17 s), doubling, and one
+ *        bucket for all longer latencies.
+ */
+const std::size_t k_latencyBucketCount = 26;
+
+/*!
+ * \brief Number of error counters of an OperationStatistics: one per glheadless::Error code and one, at index 0, for
+ *        errors of other categories.
+ */
+const std::size_t k_errorCounterCount = 6;
+
+
+/*!
+ * \brief Distribution of the latencies of an operation, in log-sized buckets.
+ */
+struct LatencyHistogram {
+    std::vector<std::uint64_t> bucketCounts = std::vector<std::uint64_t>(k_latencyBucketCount); //!< latencies per bucket, not cumulative
+    std::uint64_t              count        = 0;                                                //!< number of latencies
+    double                     totalSeconds = 0;                                                //!< sum of the latencies
+
+    /*!
+     * \return the largest latency in seconds counted by a bucket, infinity for the last one.
+     */
+    static double upperBound(std::size_t bucket) {
+        return bucket + 1 < k_latencyBucketCount ? 1.0e-6 * static_cast<double>(std::uint64_t(1) << bucket) : std::numeric_limits<double>::infinity();
+    }
+};
+
+
+/*!
+ * \brief Calls of one kind of context operation.
+ */
+struct OperationStatistics {
+    std::uint64_t              callCount   = 0;                                                //!< calls, including failed ones
+    std::vector<std::uint64_t> errorCounts = std::vector<std::uint64_t>(k_errorCounterCount); //!< failed calls by Error code
+    LatencyHistogram           latency;                                                        //!< latency of all calls
+};
+
+
+/*!
+ * \brief Acquisitions of one internal lock.
+ */
+struct LockStatistics {
+    std::uint64_t    acquisitionCount = 0; //!< acquisitions, including uncontended ones
+    std::uint64_t    contendedCount   = 0; //!< acquisitions that found the lock held by another thread
+    LatencyHistogram wait;                 //!< time the contended acquisitions waited
+};
+
+
+/*!
+ * \brief Snapshot of the library-wide statistics, see runtimeStatistics().
+ */
+struct RuntimeStatistics {
+    OperationStatistics create;          //!< ContextFactory::create()
+    OperationStatistics makeCurrent;     //!< Context::makeCurrent()
+    OperationStatistics doneCurrent;     //!< Context::doneCurrent()
+    OperationStatistics destroy;         //!< destruction of the native context when a Context is destroyed
+
+    LatencyHistogram    chooseConfig;    //!< creation phase: choosing the framebuffer configuration or pixel format
+    LatencyHistogram    createContext;   //!< creation phase: creating the native context
+    LatencyHistogram    createPbuffer;   //!< creation phase: creating the offscreen drawable (GLX pbuffer, WGL window)
+    LatencyHistogram    testMakeCurrent; //!< creation phase: making the context current on the drawable once (GLX)
+
+    LockStatistics      platformInstanceLock; //!< lock creating the platform's display connection or instance on first use
+    LockStatistics      errorHandlerSwap;     //!< GLX: installs of the X error handler, which is process-wide; contended
+                                              //!< if a handler of another thread was still installed, without wait
+};
+
+
+/*!
+ * \brief Sums the statistics of all threads since the start of the process or the last resetRuntimeStatistics().
+ *
+ * Each thread counts into its own counters without locking; this function may be called from any thread at any time.
+ * Phases the platform does not have, e.g., pbuffers with EGL, remain empty.
+ */
+GLHEADLESS_API RuntimeStatistics runtimeStatistics();
+
+/*!
+ * \brief Restarts all statistics from zero.
+ */
+GLHEADLESS_API void resetRuntimeStatistics();
+
+/*!
+ * \brief Formats statistics in the Prometheus text exposition format (version 0.0.4).
+ *
+ * Emits the counters glheadless_operations_total{operation} and glheadless_operation_errors_total{operation,error}
+ * and the histograms glheadless_operation_duration_seconds{operation} and
+ * glheadless_creation_phase_duration_seconds{phase}, and for the internal locks the counters
+ * glheadless_lock_acquisitions_total{lock} and glheadless_lock_contended_total{lock} and the histogram
+ * glheadless_lock_wait_seconds{lock}.
+ */
+GLHEADLESS_API std::string toPrometheusText(const RuntimeStatistics& statistics);
+
+
+}  // namespace glheadless
@@ -0,0 +1,127 @@
+#pragma once
+
+/*!
+ * \file ShaderCompiler.h
+ * \brief Declares class ShaderCompiler and struct CompileResult.
+ */
+
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <glheadless/glheadless_api.h>
+#include <glheadless/ContextFormat.h>
+#include <glheadless/ProgramCache.h>
+
+
+namespace glheadless {
+
+
+class Context;
+
+
+/*!
+ * \brief Outcome of a ShaderCompiler request.
+ */
+struct CompileResult {
+    unsigned int    program = 0;  //!< linked OpenGL program object, 0 if the request failed
+    std::error_code errorCode;    //!< error of a failed request, 0 on success
+    std::string     errorMessage; //!< detailed message of a failed request, e.g., the compile log
+};
+
+
+/*!
+ * \brief Compiles and links programs in the background, spread over several worker contexts.
+ *
+ * Each worker thread owns a context sharing objects with the context passed to the constructor, so the programs can
+ * be used from any context of that share group. Jobs are taken from a common queue in submission order. On drivers
+ * exposing GL_KHR_parallel_shader_compile, a worker hands the driver as many compiler threads as it wants and keeps
+ * several jobs in flight, polling GL_COMPLETION_STATUS_KHR instead of blocking on each one; otherwise it compiles one
+ * job at a time. Either way, warming up a large set of programs takes roughly the serial time divided by the number of
+ * workers, which defaults to the number of cores.
+ *
+ * A future becomes ready only after the worker's commands completed, so the program is complete when observed from
+ * another context. Programs of futures that are never read are not deleted; the share group owns them.
+ *
+ * compile() may be called concurrently from any thread; the calling thread does not need a current context.
+ */
+class GLHEADLESS_API ShaderCompiler {
+public:
+    /*!
+     * \brief Starts the worker threads, which create their contexts.
+     *
+     * Some platforms do not allow creating a shared context while the shared context is current on another thread;
+     * construct the compiler before making it current there.
+     *
+     * \param shared the context the worker contexts share objects with; must outlive this object.
+     * \param threadCount number of workers, 0 selects std::thread::hardware_concurrency()
+     * \param format format of the worker contexts, default: ContextFormat()
+     */
+    explicit ShaderCompiler(const Context* shared, unsigned int threadCount = 0, const ContextFormat& format = ContextFormat());
+    ShaderCompiler(const ShaderCompiler&) = delete;
+
+    /*!
+     * \brief Completes all queued jobs and stops the workers.
+     */
+    ~ShaderCompiler();
+
+    /*!
+     * \brief Queues a program.
+     *
+     * \param shaders the shader stages of the program
+     *
+     * \return a future receiving the program, or the error if compiling or linking failed or no worker context could
+     *         be created.
+     */
+    std::future<CompileResult> compile(const std::vector<ShaderSource>& shaders);
+
+    /*!
+     * \brief Queues a program from a vertex and a fragment shader, see above.
+     */
+    std::future<CompileResult> compile(const std::string& vertexSource, const std::string& fragmentSource);
+
+    /*!
+     * \return the number of worker threads.
+     */
+    unsigned int threadCount() const;
+
+    /*!
+     * \return the number of worker contexts using GL_KHR_parallel_shader_compile; a worker is counted once its context
+     *         was created.
+     */
+    unsigned int parallelWorkerCount() const;
+
+    ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+
+
+private:
+    struct Job;
+
+    void workerLoop(const Context* shared, ContextFormat format);
+    void failQueue(const std::error_code& code, const std::string& message);
+
+
+private:
+    mutable std::mutex                m_mutex;
+    std::condition_variable           m_queued;
+    std::deque<std::unique_ptr<Job>>  m_queue;
+    unsigned int                      m_threadCount;
+    unsigned int                      m_failedWorkerCount;
+    unsigned int                      m_parallelWorkerCount;
+    bool                              m_stopping;
+
+    std::error_code m_workerErrorCode;    //!< error of the last worker context that could not be created
+    std::string     m_workerErrorMessage;
+
+    std::vector<std::thread> m_threads;
+};
+
+
+}  // namespace glheadless
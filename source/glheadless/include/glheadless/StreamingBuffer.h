@@ -0,0 +1,164 @@
+#pragma once
+
+/*!
+ * \file StreamingBuffer.h
+ * \brief Declares class StreamingBuffer and struct StreamAllocation.
+ */
+
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <glheadless/glheadless_api.h>
+
+
+namespace glheadless {
+
+
+class Context;
+
+
+/*!
+ * \brief Describes a range of a StreamingBuffer handed out by StreamingBuffer::allocate().
+ */
+struct StreamAllocation {
+    void*        data   = nullptr; //!< client pointer to write the data to
+    unsigned int buffer = 0;       //!< OpenGL buffer object containing the range
+    std::size_t  offset = 0;       //!< byte offset of the range in the buffer object, e.g., for glBindBufferRange()
+    std::size_t  size   = 0;       //!< size of the range in bytes
+};
+
+
+/*!
+ * \brief Sub-allocates transient data, such as per-frame vertices, indices and uniforms, from one mapped buffer object.
+ *
+ * The buffer object is split into a ring of segments. Allocations are taken from the current segment by bumping an
+ * offset; when it is exhausted, the next segment is reused once the GPU finished the commands issued before its last
+ * fence. Uploading thus costs a memcpy instead of a driver allocation per glBufferData() call.
+ *
+ * If GL_ARB_buffer_storage is available, the buffer is mapped once, persistently and coherently. Otherwise the free part
+ * of the current segment is mapped with GL_MAP_UNSYNCHRONIZED_BIT on demand and unmapped by flush().
+ *
+ * Usage per frame: allocate() or upload() the data, flush(), issue the commands reading the allocations, then fence().
+ * Data must have been consumed before allocations made since then wrap around the whole ring, so choose a size holding
+ * a few frames of uploads.
+ *
+ * A StreamingBuffer owns OpenGL objects of its Context, one per context is intended. It must only be used, and
+ * destroyed, while that context is current on the calling thread. The buffer binding of GL_COPY_WRITE_BUFFER is restored
+ * before a call returns.
+ */
+class GLHEADLESS_API StreamingBuffer {
+public:
+    /*!
+     * \brief Selects how the buffer object is mapped.
+     */
+    enum class Mapping : unsigned int {
+        AUTOMATIC,     //!< PERSISTENT if supported, UNSYNCHRONIZED otherwise
+        PERSISTENT,    //!< persistent and coherent mapping, requires GL_ARB_buffer_storage
+        UNSYNCHRONIZED //!< unsynchronized glMapBufferRange() of the current segment
+    };
+
+    /*!
+     * \param context the context owning the buffer object; must outlive this object.
+     * \param size size of the buffer object in bytes, default: 4 MiB
+     * \param segments number of fenced segments the buffer is split into, default: 4; their size is rounded down to a
+     *        multiple of 256 bytes
+     * \param mapping requested mapping, default: Mapping::AUTOMATIC
+     */
+    explicit StreamingBuffer(Context* context, std::size_t size = 4 << 20, unsigned int segments = 4, Mapping mapping = Mapping::AUTOMATIC);
+    StreamingBuffer(const StreamingBuffer&) = delete;
+    ~StreamingBuffer();
+
+    /*!
+     * \return the size of the buffer object in bytes.
+     */
+    std::size_t size() const;
+
+    /*!
+     * \return the size of a segment in bytes, the upper bound for a single allocation.
+     */
+    std::size_t segmentSize() const;
+
+    /*!
+     * \return the mapping in use; Mapping::AUTOMATIC until the buffer object is created by the first allocation.
+     */
+    Mapping mapping() const;
+
+    /*!
+     * \return the OpenGL buffer object, 0 until it is created by the first allocation.
+     */
+    unsigned int buffer() const;
+
+    /*!
+     * \brief Reserves a range of the buffer for writing.
+     *
+     * Waits for the GPU if the next segment is still in use.
+     *
+     * \param size size of the range in bytes, at most segmentSize()
+     * \param alignment alignment of the offset in bytes, a power of two; 0 selects GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT,
+     *        which is valid for any buffer binding
+     * \param allocation receives the range
+     *
+     * \return true on success, otherwise the error is available through the context's lastErrorCode().
+     */
+    bool allocate(std::size_t size, std::size_t alignment, StreamAllocation& allocation);
+
+    /*!
+     * \brief Reserves a range and copies data into it, see allocate().
+     */
+    bool upload(const void* data, std::size_t size, std::size_t alignment, StreamAllocation& allocation);
+
+    /*!
+     * \brief Makes the data written to allocations visible to OpenGL commands.
+     *
+     * Required before issuing commands that read allocations. Unmaps the current segment for Mapping::UNSYNCHRONIZED,
+     * does nothing for Mapping::PERSISTENT.
+     */
+    void flush();
+
+    /*!
+     * \brief Marks the commands issued so far as the consumers of all previous allocations, typically once per frame.
+     *
+     * Implies flush().
+     */
+    bool fence();
+
+
+private:
+    void create();
+    void advance();
+    void waitFor(std::uint64_t serial);
+    void insertFence();
+    void map(std::size_t offset);
+    void unmap();
+
+
+private:
+    struct Fence {
+        void*         sync;   //!< GLsync
+        std::uint64_t serial;
+    };
+
+    Context*           m_context;
+    const std::size_t  m_size;
+    const unsigned int m_segments;
+    const std::size_t  m_segmentSize;
+    Mapping            m_mapping;
+    unsigned int       m_buffer;
+    std::size_t        m_defaultAlignment; //!< GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+
+    unsigned char* m_data;      //!< persistent: the whole buffer, unsynchronized: the mapped part of the current segment
+    std::size_t    m_mapOffset; //!< buffer offset m_data points to
+
+    unsigned int               m_segment;         //!< index of the current segment
+    std::size_t                m_offset;          //!< buffer offset of the next allocation
+    std::vector<std::uint64_t> m_segmentSerials;  //!< per segment, the serial of the first fence after its last use
+    std::deque<Fence>          m_fences;          //!< pending fences, oldest first
+    std::uint64_t              m_serial;          //!< serial of the next fence
+    std::uint64_t              m_completedSerial; //!< fences below this serial are known to be signaled
+};
+
+
+}  // namespace glheadless
@@ -0,0 +1,181 @@
+#pragma once
+
+/*!
+ * \file TextureFile.h
+ * \brief Declares class TextureFile and struct TextureLevel.
+ */
+
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <glheadless/glheadless_api.h>
+
+
+namespace glheadless {
+
+
+class Context;
+class MappedFile;
+
+
+/*!
+ * \brief One mipmap level of a TextureFile, pointing into the file mapping.
+ */
+struct TextureLevel {
+    unsigned int         width  = 0;       //!< width in pixels
+    unsigned int         height = 0;       //!< height in pixels
+    const unsigned char* data   = nullptr; //!< level data inside the mapping, valid while the file is open
+    std::size_t          size   = 0;       //!< size of the level data in bytes
+};
+
+
+/*!
+ * \brief Ingests 2D textures, typically precompressed, from KTX (version 1) and DDS container files.
+ *
+ * open() maps the file into memory and parses the header and level table in place, without reading the file into a
+ * heap buffer. upload() specifies a texture directly from the mapping, so the only copy is the one into memory owned
+ * by the driver; pages are read from the page cache on demand and dropped from the resident set after the upload.
+ * This keeps the peak memory use of loading even large texture atlases close to zero.
+ *
+ * Supported are KTX files with a single face and array element, compressed or with unsigned byte components, and DDS
+ * files with BC1 to BC7 (DXT1, DXT3, DXT5, ATI1, ATI2 or DX10 header) compression. Cube maps, arrays and volume
+ * textures are rejected.
+ */
+class GLHEADLESS_API TextureFile {
+public:
+    /*!
+     * \brief Container format of a file.
+     */
+    enum class Container : unsigned int {
+        NONE, //!< no file is open
+        KTX,  //!< Khronos KTX, version 1
+        DDS   //!< DirectDraw Surface, with or without DX10 header extension
+    };
+
+    /*!
+     * \brief Source of the texture data passed to OpenGL by upload().
+     */
+    enum class UploadPath : unsigned int {
+        AUTOMATIC,          //!< PIXEL_UNPACK_BUFFER for textures of at least 1 MiB, otherwise CLIENT_MEMORY
+        CLIENT_MEMORY,      //!< pass pointers into the mapping, the driver copies during each call
+        PIXEL_UNPACK_BUFFER //!< copy all levels into a mapped pixel unpack buffer once, the driver transfers from it
+    };
+
+    TextureFile();
+    TextureFile(const TextureFile&) = delete;
+    ~TextureFile();
+
+    /*!
+     * \brief Maps a file and parses its header and level table; closes a previously opened file.
+     *
+     * \return true on success, otherwise the error is available through lastErrorCode() and lastErrorMessage().
+     */
+    bool open(const std::string& path);
+
+    /*!
+     * \brief Unmaps the file; level data pointers become invalid.
+     */
+    void close();
+
+    /*!
+     * \return true if a file is open.
+     */
+    bool isOpen() const;
+
+    /*!
+     * \return the container format of the open file.
+     */
+    Container container() const;
+
+    /*!
+     * \return true if the levels are block compressed.
+     */
+    bool compressed() const;
+
+    /*!
+     * \return the OpenGL internal format of the texture, e.g., GL_COMPRESSED_RGBA_S3TC_DXT5_EXT.
+     */
+    unsigned int internalFormat() const;
+
+    /*!
+     * \return the OpenGL pixel format of uncompressed levels, 0 for compressed levels.
+     */
+    unsigned int format() const;
+
+    /*!
+     * \return the OpenGL component type of uncompressed levels, 0 for compressed levels.
+     */
+    unsigned int type() const;
+
+    /*!
+     * \return the width of level 0 in pixels.
+     */
+    unsigned int width() const;
+
+    /*!
+     * \return the height of level 0 in pixels.
+     */
+    unsigned int height() const;
+
+    /*!
+     * \return the number of mipmap levels stored in the file.
+     */
+    unsigned int levelCount() const;
+
+    /*!
+     * \return a mipmap level, or an empty TextureLevel if the index is out of range.
+     */
+    TextureLevel level(unsigned int index) const;
+
+    /*!
+     * \brief Creates a GL_TEXTURE_2D texture object with all levels of the file in the context current on the calling
+     * thread.
+     *
+     * The texture binding, pixel unpack buffer binding and unpack parameters of the context are restored afterwards.
+     *
+     * \param context the current context
+     * \param texture receives the new texture object
+     * \param path source of the data passed to OpenGL, default: UploadPath::AUTOMATIC
+     *
+     * \return true on success, otherwise the error is available through lastErrorCode() and lastErrorMessage().
+     */
+    bool upload(Context* context, unsigned int& texture, UploadPath path = UploadPath::AUTOMATIC);
+
+    /*!
+     * \return an std::error_code describing the error of the last failed call, 0 if none failed yet.
+     */
+    const std::error_code& lastErrorCode() const;
+
+    /*!
+     * \return a detailed message describing the error of the last failed call.
+     */
+    const std::string& lastErrorMessage() const;
+
+    TextureFile& operator=(const TextureFile&) = delete;
+
+
+private:
+    void parseKtx();
+    void parseDds();
+    bool setError(const std::error_code& code, const std::string& message);
+
+
+private:
+    std::unique_ptr<MappedFile> m_file;
+    Container                   m_container;
+    unsigned int                m_internalFormat;
+    unsigned int                m_format;
+    unsigned int                m_type;
+    unsigned int                m_alignment; //!< row alignment of uncompressed levels
+    std::vector<TextureLevel>   m_levels;
+
+    std::error_code m_lastErrorCode;
+    std::string     m_lastErrorMessage;
+};
+
+
+}  // namespace glheadless
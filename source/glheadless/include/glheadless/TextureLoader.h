@@ -0,0 +1,210 @@
+#pragma once
+
+/*!
+ * \file TextureLoader.h
+ * \brief Declares class TextureLoader and the structs TextureImage and LoadedTexture.
+ */
+
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glheadless/glheadless_api.h>
+#include <glheadless/ContextFormat.h>
+#include <glheadless/PixelFormat.h>
+
+
+namespace glheadless {
+
+
+class Context;
+
+
+/*!
+ * \brief A decoded image, filled in by the decode function of a TextureLoader request.
+ */
+struct TextureImage {
+    unsigned int               width   = 0;                  //!< width in pixels
+    unsigned int               height  = 0;                  //!< height in pixels
+    PixelFormat                format  = PixelFormat::RGBA8; //!< packed format of pixels; planar formats are not supported
+    std::vector<unsigned char> pixels;                       //!< tightly packed rows, the first row becomes texture row 0
+    bool                       mipmaps = false;              //!< generate the mipmap chain after the upload
+};
+
+
+/*!
+ * \brief A texture finished by a TextureLoader.
+ */
+struct LoadedTexture {
+    unsigned int texture = 0; //!< OpenGL texture object (GL_TEXTURE_2D), 0 if the request did not succeed
+    unsigned int width   = 0; //!< width of level 0 in pixels
+    unsigned int height  = 0; //!< height of level 0 in pixels
+};
+
+
+/*!
+ * \brief Loads textures in the background, so that render threads do not stall on decoding and uploading images.
+ *
+ * Requests are decoded on a pool of CPU threads by a user-supplied decode function, e.g., wrapping an image library.
+ * A single upload thread owns a context sharing objects with the context passed to the constructor. It copies the
+ * decoded pixels into pixel unpack buffers, specifies the textures from them and inserts a fence after each upload.
+ * A texture is reported as READY only after its fence has signaled, so render contexts never observe partially
+ * uploaded textures and need no synchronization of their own before sampling it.
+ *
+ * Both the decode and the upload queue are ordered by priority, then by submission order. cancel() withdraws a request
+ * in any state; work that already started is discarded when it finishes.
+ *
+ * All methods may be called concurrently from any thread; the calling thread does not need a current context.
+ */
+class GLHEADLESS_API TextureLoader {
+public:
+    /*!
+     * \brief Identifies a request, 0 is never used.
+     */
+    using Handle = std::uint64_t;
+
+    /*!
+     * \brief Decodes an image into the passed TextureImage, called on a decode thread.
+     *
+     * \return true on success, false marks the request as FAILED.
+     */
+    using DecodeFunction = std::function<bool(TextureImage& image)>;
+
+    /*!
+     * \brief Priority levels of requests, higher priorities are decoded and uploaded first.
+     */
+    enum class Priority : unsigned int {
+        LOW,
+        NORMAL,
+        HIGH
+    };
+
+    /*!
+     * \brief Progress of a request.
+     */
+    enum class State : unsigned int {
+        UNKNOWN,   //!< the handle was never issued, canceled, or taken
+        QUEUED,    //!< waiting for a decode thread
+        DECODING,  //!< the decode function is running
+        UPLOADING, //!< decoded, waiting for or in the upload
+        READY,     //!< the texture is complete and can be taken
+        FAILED     //!< decoding or uploading failed, see lastErrorCode() and lastErrorMessage()
+    };
+
+    /*!
+     * \brief Starts the decode threads and the upload thread, which creates the upload context.
+     *
+     * Some platforms do not allow creating a shared context while the shared context is current on another thread;
+     * construct the loader before making it current there.
+     *
+     * \param shared the context the upload context shares objects with; must outlive this object.
+     * \param decodeThreadCount number of decode threads, 0 selects std::thread::hardware_concurrency()
+     * \param format format of the upload context, default: ContextFormat()
+     */
+    explicit TextureLoader(const Context* shared, unsigned int decodeThreadCount = 0, const ContextFormat& format = ContextFormat());
+    TextureLoader(const TextureLoader&) = delete;
+
+    /*!
+     * \brief Abandons pending requests, deletes all textures that were not taken and stops the threads.
+     */
+    ~TextureLoader();
+
+    /*!
+     * \brief Queues a request.
+     *
+     * \param decode decodes the image, see DecodeFunction
+     * \param priority priority of the request, default: Priority::NORMAL
+     *
+     * \return the handle of the request.
+     */
+    Handle load(const DecodeFunction& decode, Priority priority = Priority::NORMAL);
+
+    /*!
+     * \brief Withdraws a request and forgets its handle. A texture that was already uploaded is deleted.
+     *
+     * \return true if the handle was known.
+     */
+    bool cancel(Handle handle);
+
+    /*!
+     * \return the current state of a request.
+     */
+    State state(Handle handle) const;
+
+    /*!
+     * \brief Blocks until a request is READY or FAILED, or until it is canceled by another thread.
+     *
+     * \return the resulting state.
+     */
+    State wait(Handle handle) const;
+
+    /*!
+     * \brief Transfers the texture of a READY request to the caller and forgets the handle; FAILED requests are
+     * forgotten as well.
+     *
+     * The texture belongs to the share group of the context passed to the constructor; the caller becomes responsible
+     * for deleting it.
+     *
+     * \return the texture of a READY request, otherwise an empty LoadedTexture.
+     */
+    LoadedTexture take(Handle handle);
+
+    /*!
+     * \return the number of requests that are neither READY nor FAILED.
+     */
+    std::size_t pendingCount() const;
+
+    /*!
+     * \return an std::error_code describing the last failed request or upload context creation, 0 if none failed yet.
+     */
+    std::error_code lastErrorCode() const;
+
+    /*!
+     * \return a detailed message describing the last failed request or upload context creation.
+     */
+    std::string lastErrorMessage() const;
+
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+
+private:
+    struct Request;
+    struct Upload;
+
+    void decodeLoop();
+    void uploadLoop(const Context* shared, ContextFormat format);
+    void upload(Context& context, const std::shared_ptr<Request>& request, Upload& upload);
+    bool retire(Context& context, Upload& upload, std::uint64_t timeout);
+    void fail(Request& request, const std::error_code& code, const std::string& message);
+
+
+private:
+    mutable std::mutex                                    m_mutex;
+    mutable std::condition_variable                       m_stateChanged;
+    std::condition_variable                               m_decodeQueued;
+    std::condition_variable                               m_uploadQueued;
+    std::unordered_map<Handle, std::shared_ptr<Request>>  m_requests;
+    std::vector<std::shared_ptr<Request>>                 m_decodeQueue; //!< heap ordered by priority, then handle
+    std::vector<std::shared_ptr<Request>>                 m_uploadQueue; //!< heap ordered by priority, then handle
+    std::vector<unsigned int>                             m_orphans;     //!< textures of canceled requests to delete
+    Handle                                                m_nextHandle;
+    bool                                                  m_uploadFailed;
+    bool                                                  m_stopping;
+
+    std::vector<std::thread> m_decodeThreads;
+    std::thread              m_uploadThread;
+
+    std::error_code m_lastErrorCode;
+    std::string     m_lastErrorMessage;
+};
+
+
+}  // namespace glheadless
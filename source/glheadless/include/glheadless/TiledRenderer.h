@@ -0,0 +1,152 @@
+#pragma once
+
+/*!
+ * \file TiledRenderer.h
+ * \brief Declares class TiledRenderer and struct Tile.
+ */
+
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <system_error>
+
+#include <glheadless/glheadless_api.h>
+#include <glheadless/ContextFormat.h>
+#include <glheadless/PixelFormat.h>
+
+
+namespace glheadless {
+
+
+class Context;
+
+
+/*!
+ * \brief Describes one tile of an image rendered by TiledRenderer.
+ */
+struct Tile {
+    unsigned int column      = 0; //!< tile column, counted from the left
+    unsigned int row         = 0; //!< tile row, counted from the top
+    unsigned int x           = 0; //!< left edge in image pixels
+    unsigned int y           = 0; //!< bottom edge in image pixels (OpenGL convention, origin in the lower left corner)
+    unsigned int width       = 0; //!< width of the tile in pixels, smaller than the tile size at the right border
+    unsigned int height      = 0; //!< height of the tile in pixels, smaller than the tile size at the bottom border
+    unsigned int imageWidth  = 0; //!< width of the whole image in pixels
+    unsigned int imageHeight = 0; //!< height of the whole image in pixels
+};
+
+
+/*!
+ * \brief Renders images larger than GL_MAX_VIEWPORT_DIMS or GL_MAX_RENDERBUFFER_SIZE as tiles in parallel.
+ *
+ * Each call to render() starts a number of worker threads. Every worker creates its own context sharing objects with
+ * the context passed to the constructor, renders tiles into an offscreen framebuffer of the tile size, reads them back
+ * and hands them to a sink. Tiles are dispatched row by row from the top, so finished tiles arrive roughly in scanline
+ * order. Memory use is bounded by one tile per worker, independent of the image size.
+ *
+ * The render function is called on the worker threads, concurrently. When it is called, the worker's context is
+ * current, a framebuffer with an RGBA8 color and a depth/stencil attachment is bound and the viewport covers the tile.
+ * It is expected to render the part of the image described by the Tile, e.g., by adjusting the projection. Objects of
+ * the share group (buffers, textures, programs) can be used directly; container objects such as vertex arrays and
+ * framebuffers are not shared and must be created per context.
+ */
+class GLHEADLESS_API TiledRenderer {
+public:
+    using RenderFunction = std::function<void(const Tile& tile)>;
+
+    /*!
+     * \brief Receives a finished tile, tightly packed in the requested format with the top row first.
+     *
+     * Calls are serialized, but may happen on any worker thread.
+     */
+    using TileSink = std::function<void(const Tile& tile, const unsigned char* pixels)>;
+
+    /*!
+     * \param shared the context the workers share objects with; must outlive this object.
+     */
+    explicit TiledRenderer(const Context* shared);
+
+    /*!
+     * \brief Sets the edge length of the tiles in pixels, default: 1024.
+     */
+    void setTileSize(unsigned int tileSize);
+
+    /*!
+     * \return the edge length of the tiles in pixels.
+     */
+    unsigned int tileSize() const;
+
+    /*!
+     * \brief Sets the number of worker threads and contexts, default: std::thread::hardware_concurrency().
+     */
+    void setThreadCount(unsigned int threadCount);
+
+    /*!
+     * \return the number of worker threads and contexts.
+     */
+    unsigned int threadCount() const;
+
+    /*!
+     * \brief Sets the format of the worker contexts, default: ContextFormat().
+     */
+    void setContextFormat(const ContextFormat& format);
+
+    /*!
+     * \return the format of the worker contexts.
+     */
+    const ContextFormat& contextFormat() const;
+
+    /*!
+     * \brief Renders an image as tiles and passes each finished tile to the sink.
+     *
+     * \param width, height size of the whole image in pixels
+     * \param format packed output format of the tiles; planar formats are not supported
+     * \param render renders one tile, see class description
+     * \param sink receives the finished tiles
+     *
+     * \return true on success. On failure the remaining tiles are skipped and the error of the first failing worker
+     *         is available through lastErrorCode() and lastErrorMessage(). An exception thrown by render or sink is
+     *         caught on the worker and fails the call with Error::INVALID_ARGUMENT.
+     */
+    bool render(unsigned int width, unsigned int height, PixelFormat format, const RenderFunction& render, const TileSink& sink);
+
+    /*!
+     * \brief Renders an image as tiles and stores it as raw pixels in a file.
+     *
+     * The file contains the tightly packed image in the requested format with the top row first, without any header.
+     * Tiles are written to their rows as soon as they are finished. An existing file is left untouched if the arguments
+     * are invalid.
+     *
+     * \return true on success, see render().
+     */
+    bool renderToFile(unsigned int width, unsigned int height, PixelFormat format, const RenderFunction& render, const std::string& path);
+
+    /*!
+     * \return an std::error_code describing the error of the last call to render() or renderToFile(), 0 on success.
+     */
+    const std::error_code& lastErrorCode() const;
+
+    /*!
+     * \return a detailed message describing the error of the last call to render() or renderToFile().
+     */
+    const std::string& lastErrorMessage() const;
+
+
+private:
+    bool validate(unsigned int width, unsigned int height, PixelFormat format);
+    bool setError(const std::error_code& code, const std::string& message);
+
+
+private:
+    const Context* m_shared;
+    unsigned int   m_tileSize;
+    unsigned int   m_threadCount;
+    ContextFormat  m_format;
+
+    std::error_code m_lastErrorCode;
+    std::string     m_lastErrorMessage;
+};
+
+
+}  // namespace glheadless
@@ -0,0 +1,133 @@
+#pragma once
+
+/*!
+ * \file Timeline.h
+ * \brief Declares class TimelineRecorder, the timeline span functions and class TimelineSpan.
+ */
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include <glheadless/glheadless_api.h>
+
+
+namespace glheadless {
+
+
+class TimelineWriter;
+
+
+/*!
+ * \brief Records a timeline of the contexts of all threads into a Chrome trace-event file.
+ *
+ * While recording, each thread shows the time spans in which it had a context current (from makeCurrent() to
+ * doneCurrent(), making another context current or destroying the context), the creation and destruction of contexts,
+ * and spans marked with beginTimelineSpan() and endTimelineSpan() or TimelineSpan. The file is in the JSON array
+ * format, which chrome://tracing and ui.perfetto.dev open even if the process ended before stop().
+ *
+ * Threads record into bounded buffers of their own without locking; a background thread writes them to the file.
+ * Events arriving while a thread's buffer is full are dropped and counted. When no timeline is recorded, each event
+ * costs a single atomic load.
+ *
+ * One timeline at a time can be recorded in a process.
+ */
+class GLHEADLESS_API TimelineRecorder {
+public:
+    TimelineRecorder();
+    TimelineRecorder(const TimelineRecorder&) = delete;
+
+    /*!
+     * \brief Stops recording, if still recording.
+     */
+    ~TimelineRecorder();
+
+    /*!
+     * \brief Creates the file and starts recording.
+     *
+     * \param path the file to write, an existing file is replaced
+     * \param capacity number of events each thread buffers until the background thread writes them, default: 4096
+     *
+     * \return true on success, otherwise the error is available through lastErrorCode() and lastErrorMessage().
+     */
+    bool start(const std::string& path, std::size_t capacity = 4096);
+
+    /*!
+     * \brief Writes the remaining events and closes the file.
+     *
+     * \return true on success, otherwise the error is available through lastErrorCode() and lastErrorMessage().
+     */
+    bool stop();
+
+    /*!
+     * \return true between start() and stop().
+     */
+    bool active() const;
+
+    /*!
+     * \return the number of events dropped because a thread's buffer was full, in the current or last recording.
+     */
+    std::uint64_t droppedCount() const;
+
+    /*!
+     * \return an std::error_code describing the error of the last failed call, 0 if none failed yet.
+     */
+    const std::error_code& lastErrorCode() const;
+
+    /*!
+     * \return a detailed message describing the error of the last failed call.
+     */
+    const std::string& lastErrorMessage() const;
+
+    TimelineRecorder& operator=(const TimelineRecorder&) = delete;
+
+
+private:
+    bool setError(const std::error_code& code, const std::string& message);
+
+
+private:
+    std::unique_ptr<TimelineWriter> m_writer;
+    std::uint64_t                   m_droppedCount;
+
+    std::error_code m_lastErrorCode;
+    std::string     m_lastErrorMessage;
+};
+
+
+/*!
+ * \brief Starts a span on the calling thread's timeline; spans of a thread must nest.
+ *
+ * \param name shown for the span, truncated to 47 characters
+ */
+GLHEADLESS_API void beginTimelineSpan(const char* name);
+
+/*!
+ * \brief Ends the span started last on the calling thread.
+ */
+GLHEADLESS_API void endTimelineSpan();
+
+
+/*!
+ * \brief Marks the lifetime of a scope as a span on the calling thread's timeline.
+ */
+class TimelineSpan {
+public:
+    explicit TimelineSpan(const char* name) {
+        beginTimelineSpan(name);
+    }
+
+    TimelineSpan(const TimelineSpan&) = delete;
+
+    ~TimelineSpan() {
+        endTimelineSpan();
+    }
+
+    TimelineSpan& operator=(const TimelineSpan&) = delete;
+};
+
+
+}  // namespace glheadless
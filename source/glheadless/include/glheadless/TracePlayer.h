@@ -0,0 +1,128 @@
+#pragma once
+
+/*!
+ * \file TracePlayer.h
+ * \brief Declares class TracePlayer and struct TraceTimings.
+ */
+
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <glheadless/glheadless_api.h>
+
+
+namespace glheadless {
+
+
+class Context;
+class MappedFile;
+
+
+/*!
+ * \brief Time spent in one entry point during TracePlayer::play().
+ */
+struct TraceFunctionTiming {
+    std::string   name;             //!< OpenGL function name, e.g., "glDrawArrays"
+    std::uint64_t callCount    = 0; //!< number of replayed calls
+    double        milliseconds = 0; //!< time spent in the calls, including decoding their records
+};
+
+
+/*!
+ * \brief Outcome of TracePlayer::play().
+ */
+struct TraceTimings {
+    std::uint64_t                    callCount    = 0; //!< number of replayed calls
+    double                           milliseconds = 0; //!< wall time of the replay, including a final glFinish()
+    std::vector<TraceFunctionTiming> functions;        //!< per entry point, if requested, slowest first
+};
+
+
+/*!
+ * \brief Replays traces recorded by Context::startTrace().
+ *
+ * open() maps the trace file and checks it; play() issues the recorded calls on a context as fast as possible. Objects
+ * created by the trace get new names in the replaying context, and later calls refer to them by these names, so a
+ * trace replays on a fresh context, typically in a new process. Uniform locations and sync objects are translated the
+ * same way; data the recorded calls read from client memory is passed from the mapping, data they wrote goes to
+ * scratch memory.
+ *
+ * Replaying a trace produces the same sequence of OpenGL commands on any context, which makes recorded workloads
+ * repeatable benchmarks; see the glheadless-replay tool.
+ */
+class GLHEADLESS_API TracePlayer {
+public:
+    TracePlayer();
+    TracePlayer(const TracePlayer&) = delete;
+    ~TracePlayer();
+
+    /*!
+     * \brief Maps a trace file and checks its records; closes a previously opened trace.
+     *
+     * \return true on success, otherwise the error is available through lastErrorCode() and lastErrorMessage().
+     */
+    bool open(const std::string& path);
+
+    /*!
+     * \brief Unmaps the trace file.
+     */
+    void close();
+
+    /*!
+     * \return true if a trace is open.
+     */
+    bool isOpen() const;
+
+    /*!
+     * \return the number of calls recorded in the open trace.
+     */
+    std::uint64_t callCount() const;
+
+    /*!
+     * \brief Replays the open trace on the context current on the calling thread.
+     *
+     * The context is left in the state the trace leaves it in; objects created by the trace are not deleted. Errors
+     * generated by the replayed calls are not checked, just as they were not at recording time.
+     *
+     * \param context the current context
+     * \param timings receives the number of calls and the time the replay took
+     * \param timeFunctions if true, each call is timed separately and the time per entry point is reported; this
+     *        adds overhead to each call, default: false
+     *
+     * \return true on success, otherwise the error is available through lastErrorCode() and lastErrorMessage().
+     */
+    bool play(Context* context, TraceTimings& timings, bool timeFunctions = false);
+
+    /*!
+     * \return an std::error_code describing the error of the last failed call, 0 if none failed yet.
+     */
+    const std::error_code& lastErrorCode() const;
+
+    /*!
+     * \return a detailed message describing the error of the last failed call.
+     */
+    const std::string& lastErrorMessage() const;
+
+    TracePlayer& operator=(const TracePlayer&) = delete;
+
+
+private:
+    bool setError(const std::error_code& code, const std::string& message);
+
+
+private:
+    std::unique_ptr<MappedFile> m_file;
+    std::vector<unsigned int>   m_functions;   //!< traced function index by function index of the file
+    std::size_t                 m_recordStart; //!< offset of the first record
+    std::uint64_t               m_callCount;
+
+    std::error_code m_lastErrorCode;
+    std::string     m_lastErrorMessage;
+};
+
+
+}  // namespace glheadless
@@ -19,8 +19,11 @@ namespace glheadless {
  * \brief Error codes that may originate from the glheadless library itself.
  */
 enum class Error : int {
-    INVALID_CONTEXT = 1,  //!< A context handle is invalid
-    INVALID_CONFIGURATION //!< The selected configuration is invalid or unsupported
+    INVALID_CONTEXT = 1,   //!< A context handle is invalid
+    INVALID_CONFIGURATION, //!< The selected configuration is invalid or unsupported
+    UNSUPPORTED_FEATURE,   //!< A required OpenGL feature is not available in the current context
+    INVALID_ARGUMENT,      //!< An argument passed to the library is invalid
+    OPENGL_ERROR           //!< An OpenGL call issued by the library failed
 };
 
 
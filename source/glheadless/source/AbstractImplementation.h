@@ -37,6 +37,8 @@ public:
 
     virtual long long nativeHandle() = 0;
     virtual bool valid() = 0;
+    virtual bool owning() = 0;
+    virtual bool isCurrent() = 0;
 
     virtual bool makeCurrent() = 0;
     virtual bool doneCurrent() = 0;
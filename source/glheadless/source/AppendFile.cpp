@@ -0,0 +1,175 @@
+#include "AppendFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+#include <glheadless/error.h>
+
+#include "InternalException.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+// a multiple of the page size and of the allocation granularity of Windows
+const std::uint64_t k_windowSize = 16u << 20;
+
+
+}  // unnamed namespace
+
+
+#ifdef _WIN32
+
+
+AppendFile::AppendFile(const std::string& path)
+: m_path(path)
+, m_window(nullptr)
+, m_windowOffset(0)
+, m_size(0)
+, m_file(INVALID_HANDLE_VALUE) {
+    m_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        throw InternalException(Error::INVALID_ARGUMENT, "Cannot create " + path);
+    }
+
+    try {
+        mapWindow(0);
+    } catch (...) {
+        CloseHandle(m_file);
+        throw;
+    }
+}
+
+
+AppendFile::~AppendFile() {
+    unmapWindow();
+
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(m_size);
+    SetFilePointerEx(m_file, size, nullptr, FILE_BEGIN);
+    SetEndOfFile(m_file);
+    CloseHandle(m_file);
+}
+
+
+void AppendFile::mapWindow(std::uint64_t offset) {
+    // creating the mapping object extends the file to the end of the window; the view keeps the object alive
+    const auto end = offset + k_windowSize;
+    const auto mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, static_cast<DWORD>(end >> 32), static_cast<DWORD>(end), nullptr);
+    const auto view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_WRITE, static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset), static_cast<SIZE_T>(k_windowSize)) : nullptr;
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+    }
+    if (view == nullptr) {
+        throw InternalException(Error::INVALID_ARGUMENT, "Cannot extend " + m_path);
+    }
+
+    m_window = static_cast<unsigned char*>(view);
+    m_windowOffset = offset;
+}
+
+
+void AppendFile::unmapWindow() {
+    if (m_window != nullptr) {
+        UnmapViewOfFile(m_window);
+        m_window = nullptr;
+    }
+}
+
+
+#else
+
+
+AppendFile::AppendFile(const std::string& path)
+: m_path(path)
+, m_window(nullptr)
+, m_windowOffset(0)
+, m_size(0)
+, m_file(-1) {
+    m_file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_file < 0) {
+        throw InternalException(Error::INVALID_ARGUMENT, "Cannot create " + path);
+    }
+
+    try {
+        mapWindow(0);
+    } catch (...) {
+        ::close(m_file);
+        throw;
+    }
+}
+
+
+AppendFile::~AppendFile() {
+    unmapWindow();
+
+    // the pages are written back by the kernel; the unused rest of the last window is cut off
+    // if this fails, the file merely keeps trailing zeros, which readers stop at
+    const auto result = ::ftruncate(m_file, static_cast<off_t>(m_size));
+    static_cast<void>(result);
+    ::close(m_file);
+}
+
+
+void AppendFile::mapWindow(std::uint64_t offset) {
+    if (::ftruncate(m_file, static_cast<off_t>(offset + k_windowSize)) != 0) {
+        throw InternalException(Error::INVALID_ARGUMENT, "Cannot extend " + m_path);
+    }
+
+    const auto window = ::mmap(nullptr, k_windowSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, static_cast<off_t>(offset));
+    if (window == MAP_FAILED) {
+        throw InternalException(Error::INVALID_ARGUMENT, "Cannot map " + m_path);
+    }
+
+    m_window = static_cast<unsigned char*>(window);
+    m_windowOffset = offset;
+}
+
+
+void AppendFile::unmapWindow() {
+    if (m_window != nullptr) {
+        ::munmap(m_window, k_windowSize);
+        m_window = nullptr;
+    }
+}
+
+
+#endif
+
+
+void AppendFile::append(const void* data, std::size_t size) {
+    auto source = static_cast<const unsigned char*>(data);
+    while (size > 0) {
+        const auto windowOffset = m_size - m_size % k_windowSize;
+        if (m_window == nullptr || m_windowOffset != windowOffset) {
+            unmapWindow();
+            mapWindow(windowOffset);
+        }
+
+        const auto offset = m_size - m_windowOffset;
+        const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(size, k_windowSize - offset));
+        std::memcpy(m_window + offset, source, count);
+        source += count;
+        size -= count;
+        m_size += count;
+    }
+}
+
+
+std::uint64_t AppendFile::size() const {
+    return m_size;
+}
+
+
+}  // namespace glheadless
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace glheadless {
+
+
+/*
+ * Write-only memory mapping of a file that only grows at its end. The file is extended and mapped in windows of a
+ * fixed size, so appending is a copy into the page cache without a system call per write. The destructor truncates the
+ * file to the appended size. Throws InternalException if the file cannot be created, extended or mapped.
+ */
+class AppendFile {
+public:
+    explicit AppendFile(const std::string& path);
+    AppendFile(const AppendFile&) = delete;
+    ~AppendFile();
+
+    void append(const void* data, std::size_t size);
+
+    // number of bytes appended so far
+    std::uint64_t size() const;
+
+    AppendFile& operator=(const AppendFile&) = delete;
+
+
+private:
+    void mapWindow(std::uint64_t offset);
+    void unmapWindow();
+
+
+private:
+    std::string    m_path;
+    unsigned char* m_window;
+    std::uint64_t  m_windowOffset;
+    std::uint64_t  m_size;
+#ifdef _WIN32
+    void*          m_file;
+#else
+    int            m_file;
+#endif
+};
+
+
+}  // namespace glheadless
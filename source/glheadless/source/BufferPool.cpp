@@ -0,0 +1,417 @@
+#include <glheadless/BufferPool.h>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+#include <glheadless/Context.h>
+#include <glheadless/error.h>
+
+#include "GLFunctions.h"
+#include "StateGuard.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+const std::size_t k_defaultAlignment = 16;
+
+
+std::size_t alignUp(std::size_t offset, std::size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+
+using FreeList = std::map<std::size_t, std::size_t>; // offset -> size, ordered by offset
+
+
+// first fit; the alignment padding in front of the range stays free
+bool allocateFrom(FreeList& freeList, std::size_t size, std::size_t alignment, std::size_t& offset) {
+    for (auto it = freeList.begin(); it != freeList.end(); ++it) {
+        const auto start = it->first;
+        const auto end = it->first + it->second;
+        const auto aligned = alignUp(start, alignment);
+        if (aligned + size > end) {
+            continue;
+        }
+
+        freeList.erase(it);
+        if (aligned > start) {
+            freeList[start] = aligned - start;
+        }
+        if (aligned + size < end) {
+            freeList[aligned + size] = end - aligned - size;
+        }
+
+        offset = aligned;
+        return true;
+    }
+
+    return false;
+}
+
+
+}  // unnamed namespace
+
+
+struct BufferPool::Block {
+    gl::GLuint  buffer;
+    std::size_t size;
+    bool        dedicated; //!< holds a single allocation larger than the block size
+    FreeList    freeList;
+};
+
+
+BufferPool::BufferPool(Context* context, std::size_t blockSize)
+: m_context(context)
+, m_blockSize(blockSize)
+, m_nextHandle(1)
+, m_allocatedSize(0)
+, m_generation(0)
+, m_fence(nullptr)
+, m_dirty(false) {
+    // resolve the entry points while the context is known to be current, the table is shared by all threads afterwards
+    m_context->functions();
+}
+
+
+BufferPool::~BufferPool() {
+    const auto& gl = m_context->functions();
+    if (m_fence != nullptr) {
+        gl.DeleteSync(static_cast<gl::GLsync>(m_fence));
+    }
+    for (const auto& block : m_blocks) {
+        gl.DeleteBuffers(1, &block->buffer);
+    }
+}
+
+
+bool BufferPool::allocate(std::size_t size, std::size_t alignment, Handle& handle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (size == 0 || (alignment & (alignment - 1)) != 0) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "Pool allocations require a non-empty size and a power of two alignment");
+    }
+
+    const auto& gl = m_context->functions();
+    if (gl.CopyBufferSubData == nullptr || gl.FenceSync == nullptr) {
+        return setError(make_error_code(Error::UNSUPPORTED_FEATURE), "Buffer pools require OpenGL 3.2");
+    }
+
+    if (alignment == 0) {
+        alignment = k_defaultAlignment;
+    }
+
+    Block* block = nullptr;
+    std::size_t offset = 0;
+    if (size <= m_blockSize) {
+        for (const auto& candidate : m_blocks) {
+            if (!candidate->dedicated && allocateFrom(candidate->freeList, size, alignment, offset)) {
+                block = candidate.get();
+                break;
+            }
+        }
+    }
+
+    if (block == nullptr) {
+        const auto dedicated = size > m_blockSize;
+        m_blocks.push_back(createBlock(dedicated ? size : m_blockSize, dedicated));
+        block = m_blocks.back().get();
+        allocateFrom(block->freeList, size, alignment, offset);
+        m_dirty = true;
+    }
+
+    handle = m_nextHandle++;
+    m_allocations[handle] = { block, offset, size, alignment };
+    m_allocatedSize += size;
+
+    return true;
+}
+
+
+bool BufferPool::upload(const void* data, std::size_t size, std::size_t alignment, Handle& handle) {
+    return allocate(size, alignment, handle) && write(handle, 0, data, size);
+}
+
+
+bool BufferPool::write(Handle handle, std::size_t offset, const void* data, std::size_t size) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto it = m_allocations.find(handle);
+    if (it == m_allocations.end() || offset + size > it->second.size) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "Pool write does not match a live allocation");
+    }
+
+    const auto& gl = m_context->functions();
+    const auto& allocation = it->second;
+    {
+        gl::BufferBinding binding(gl, gl::COPY_WRITE_BUFFER, allocation.block->buffer);
+        gl.BufferSubData(gl::COPY_WRITE_BUFFER, static_cast<gl::GLintptr>(allocation.offset + offset), static_cast<gl::GLsizeiptr>(size), data);
+    }
+    m_dirty = true;
+
+    return true;
+}
+
+
+void BufferPool::free(Handle handle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto it = m_allocations.find(handle);
+    if (it == m_allocations.end()) {
+        return;
+    }
+
+    deallocate(it->second);
+    m_allocatedSize -= it->second.size;
+    m_allocations.erase(it);
+}
+
+
+BufferRange BufferPool::range(Handle handle) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    BufferRange range;
+    const auto it = m_allocations.find(handle);
+    if (it != m_allocations.end()) {
+        range.buffer = it->second.block->buffer;
+        range.offset = it->second.offset;
+        range.size = it->second.size;
+    }
+
+    return range;
+}
+
+
+bool BufferPool::defragment() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto& gl = m_context->functions();
+    if (gl.CopyBufferSubData == nullptr || gl.FenceSync == nullptr) {
+        return setError(make_error_code(Error::UNSUPPORTED_FEATURE), "Buffer pools require OpenGL 3.2");
+    }
+
+    // keep the previous order, so data used together stays together
+    std::map<const Block*, std::size_t> blockOrder;
+    for (std::size_t i = 0; i < m_blocks.size(); ++i) {
+        blockOrder[m_blocks[i].get()] = i;
+    }
+
+    std::vector<Allocation*> allocations;
+    allocations.reserve(m_allocations.size());
+    for (auto& entry : m_allocations) {
+        allocations.push_back(&entry.second);
+    }
+    std::sort(allocations.begin(), allocations.end(), [&blockOrder] (const Allocation* a, const Allocation* b) {
+        const auto blockA = blockOrder[a->block];
+        const auto blockB = blockOrder[b->block];
+        return blockA != blockB ? blockA < blockB : a->offset < b->offset;
+    });
+
+    // lay out the new blocks, sequentially filling each one
+    std::vector<std::unique_ptr<Block>> blocks;
+    std::vector<Allocation> placements;
+    placements.reserve(allocations.size());
+    std::size_t cursor = 0;
+    Block* current = nullptr;
+
+    for (const auto allocation : allocations) {
+        if (allocation->size > m_blockSize) {
+            blocks.push_back(createBlock(allocation->size, true));
+            blocks.back()->freeList.clear();
+            placements.push_back({ blocks.back().get(), 0, allocation->size, allocation->alignment });
+            continue;
+        }
+
+        auto offset = alignUp(cursor, allocation->alignment);
+        if (current == nullptr || offset + allocation->size > m_blockSize) {
+            if (current != nullptr && cursor < m_blockSize) {
+                current->freeList[cursor] = m_blockSize - cursor;
+            }
+            blocks.push_back(createBlock(m_blockSize, false));
+            current = blocks.back().get();
+            current->freeList.clear();
+            cursor = 0;
+            offset = 0;
+        }
+
+        if (offset > cursor) {
+            current->freeList[cursor] = offset - cursor;
+        }
+        placements.push_back({ current, offset, allocation->size, allocation->alignment });
+        cursor = offset + allocation->size;
+    }
+    if (current != nullptr && cursor < m_blockSize) {
+        current->freeList[cursor] = m_blockSize - cursor;
+    }
+
+    {
+        gl::BufferBinding readBinding(gl, gl::COPY_READ_BUFFER, 0);
+        gl::BufferBinding writeBinding(gl, gl::COPY_WRITE_BUFFER, 0);
+
+        for (std::size_t i = 0; i < allocations.size(); ++i) {
+            const auto& source = *allocations[i];
+            const auto& target = placements[i];
+            gl.BindBuffer(gl::COPY_READ_BUFFER, source.block->buffer);
+            gl.BindBuffer(gl::COPY_WRITE_BUFFER, target.block->buffer);
+            gl.CopyBufferSubData(gl::COPY_READ_BUFFER, gl::COPY_WRITE_BUFFER,
+                static_cast<gl::GLintptr>(source.offset), static_cast<gl::GLintptr>(target.offset), static_cast<gl::GLsizeiptr>(source.size));
+        }
+    }
+
+    for (std::size_t i = 0; i < allocations.size(); ++i) {
+        *allocations[i] = placements[i];
+    }
+
+    // the copies are queued before the deletion, so the driver keeps the storage alive until they are done
+    for (const auto& block : m_blocks) {
+        gl.DeleteBuffers(1, &block->buffer);
+    }
+    m_blocks = std::move(blocks);
+
+    ++m_generation;
+    m_dirty = true;
+
+    return true;
+}
+
+
+void BufferPool::flush() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_dirty) {
+        return;
+    }
+
+    // the new fence follows the previous one, which may be of another context, so waiting on it covers both
+    const auto& gl = m_context->functions();
+    if (m_fence != nullptr) {
+        gl.WaitSync(static_cast<gl::GLsync>(m_fence), 0, gl::TIMEOUT_IGNORED);
+        gl.DeleteSync(static_cast<gl::GLsync>(m_fence));
+    }
+    m_fence = gl.FenceSync(gl::SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // flushing lets other contexts wait for the fence without deadlocking on unsubmitted commands
+    gl.Flush();
+    m_dirty = false;
+}
+
+
+void BufferPool::synchronize() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_fence != nullptr) {
+        m_context->functions().WaitSync(static_cast<gl::GLsync>(m_fence), 0, gl::TIMEOUT_IGNORED);
+    }
+}
+
+
+unsigned int BufferPool::generation() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_generation;
+}
+
+
+std::size_t BufferPool::blockCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_blocks.size();
+}
+
+
+std::size_t BufferPool::reservedSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::size_t size = 0;
+    for (const auto& block : m_blocks) {
+        size += block->size;
+    }
+    return size;
+}
+
+
+std::size_t BufferPool::allocatedSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocatedSize;
+}
+
+
+std::error_code BufferPool::lastErrorCode() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastErrorCode;
+}
+
+
+std::string BufferPool::lastErrorMessage() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastErrorMessage;
+}
+
+
+std::unique_ptr<BufferPool::Block> BufferPool::createBlock(std::size_t size, bool dedicated) {
+    const auto& gl = m_context->functions();
+
+    std::unique_ptr<Block> block(new Block);
+    block->buffer = 0;
+    block->size = size;
+    block->dedicated = dedicated;
+    block->freeList[0] = size;
+
+    gl.GenBuffers(1, &block->buffer);
+    gl::BufferBinding binding(gl, gl::COPY_WRITE_BUFFER, block->buffer);
+    gl.BufferData(gl::COPY_WRITE_BUFFER, static_cast<gl::GLsizeiptr>(size), nullptr, gl::STATIC_DRAW);
+
+    return block;
+}
+
+
+void BufferPool::releaseBlock(Block* block) {
+    m_context->functions().DeleteBuffers(1, &block->buffer);
+
+    const auto it = std::find_if(m_blocks.begin(), m_blocks.end(), [block] (const std::unique_ptr<Block>& candidate) {
+        return candidate.get() == block;
+    });
+    m_blocks.erase(it);
+}
+
+
+void BufferPool::deallocate(const Allocation& allocation) {
+    auto& block = *allocation.block;
+    if (block.dedicated) {
+        releaseBlock(&block);
+        return;
+    }
+
+    // coalesce with the free neighbors
+    auto& freeList = block.freeList;
+    auto start = allocation.offset;
+    auto end = allocation.offset + allocation.size;
+
+    auto next = freeList.lower_bound(start);
+    if (next != freeList.end() && next->first == end) {
+        end += next->second;
+        next = freeList.erase(next);
+    }
+    if (next != freeList.begin()) {
+        const auto previous = std::prev(next);
+        if (previous->first + previous->second == start) {
+            start = previous->first;
+            freeList.erase(previous);
+        }
+    }
+
+    freeList[start] = end - start;
+}
+
+
+bool BufferPool::setError(const std::error_code& code, const std::string& message) {
+    m_lastErrorCode = code;
+    m_lastErrorMessage = message;
+
+    return !m_lastErrorCode;
+}
+
+
+}  // namespace glheadless
@@ -0,0 +1,210 @@
+#include "CallCounter.h"
+
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+
+namespace glheadless {
+namespace gl {
+
+
+namespace {
+
+
+thread_local CallCounter::Counters* t_current = nullptr;
+
+
+// driver entry points for calls made while no counting context is current on the thread, e.g., after counting was
+// disabled but the application kept the counting entry points
+std::atomic<CallCounter::Address> g_fallback[FUNCTION_COUNT];
+
+
+// only the owning thread writes a counter, so a plain load and store suffice and readers see whole values
+void add(std::atomic<std::uint64_t>& counter, std::uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+
+unsigned int countdown(unsigned int sampleInterval) {
+    return sampleInterval != 0 ? sampleInterval : std::numeric_limits<unsigned int>::max();
+}
+
+
+// measures the wall time of a sampled call until the end of the enclosing scope, i.e., after the call returned
+class Timer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Timer(CallCounter::Counters& counters, std::size_t function)
+    : m_counters(counters)
+    , m_function(function)
+    , m_start(Clock::now()) {
+    }
+
+    ~Timer() {
+        const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count();
+        add(m_counters.timedCalls[m_function], 1);
+        add(m_counters.timedNanoseconds[m_function], static_cast<std::uint64_t>(nanoseconds));
+    }
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+
+private:
+    CallCounter::Counters& m_counters;
+    std::size_t            m_function;
+    Clock::time_point      m_start;
+};
+
+
+template <std::size_t F, typename Signature>
+struct Counted;
+
+template <std::size_t F, typename R, typename... A>
+struct Counted<F, R(A...)> {
+    using Function = typename Proc<R(A...)>::Type;
+
+    static R GLHEADLESS_APIENTRY call(A... arguments) {
+        const auto counters = t_current;
+        if (counters == nullptr) {
+            return reinterpret_cast<Function>(g_fallback[F].load(std::memory_order_relaxed))(arguments...);
+        }
+
+        const auto function = reinterpret_cast<Function>(counters->owner->driver[F]);
+        add(counters->calls[F], 1);
+        if (--counters->countdown != 0) {
+            return function(arguments...);
+        }
+
+        const auto sampleInterval = counters->owner->sampleInterval();
+        counters->countdown = countdown(sampleInterval);
+        if (sampleInterval == 0) {
+            return function(arguments...);
+        }
+        const Timer timer(*counters, F);
+        return function(arguments...);
+    }
+};
+
+
+}  // unnamed namespace
+
+
+CallCounter::Counters::Counters(const CallCounter* owner)
+: owner(owner)
+, thread(std::this_thread::get_id())
+, countdown(gl::countdown(owner->sampleInterval())) {
+    for (std::size_t i = 0; i < FUNCTION_COUNT; ++i) {
+        calls[i].store(0, std::memory_order_relaxed);
+        timedCalls[i].store(0, std::memory_order_relaxed);
+        timedNanoseconds[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+
+CallCounter::CallCounter(const Resolver& resolver, unsigned int sampleInterval)
+: m_sampleInterval(sampleInterval)
+, m_baseline() {
+    resolve(resolver);
+}
+
+
+CallCounter::~CallCounter() {
+    if (t_current != nullptr && t_current->owner == this) {
+        t_current = nullptr;
+    }
+}
+
+
+void CallCounter::resolve(const Resolver& resolver) {
+    for (std::size_t i = 0; i < FUNCTION_COUNT; ++i) {
+        driver[i] = resolver(functionName(i));
+        if (driver[i] != nullptr) {
+            g_fallback[i].store(driver[i], std::memory_order_relaxed);
+        }
+    }
+}
+
+
+CallCounter::Address CallCounter::wrap(const char* name, Address address) const {
+    if (address == nullptr || std::strncmp(name, "gl", 2) != 0) {
+        return address;
+    }
+
+#define GLHEADLESS_WRAP_COUNTED_GL_FUNCTION(function, signature) \
+    if (std::strcmp(name + 2, #function) == 0) { \
+        return driver[FUNCTION_##function] != nullptr ? reinterpret_cast<Address>(&Counted<FUNCTION_##function, signature>::call) : address; \
+    }
+    GLHEADLESS_GL_FUNCTIONS(GLHEADLESS_WRAP_COUNTED_GL_FUNCTION)
+#undef GLHEADLESS_WRAP_COUNTED_GL_FUNCTION
+
+    return address;
+}
+
+
+void CallCounter::setSampleInterval(unsigned int sampleInterval) {
+    m_sampleInterval.store(sampleInterval, std::memory_order_relaxed);
+}
+
+
+unsigned int CallCounter::sampleInterval() const {
+    return m_sampleInterval.load(std::memory_order_relaxed);
+}
+
+
+CallCounter::Totals CallCounter::totals() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Totals totals;
+    sum(totals);
+    for (std::size_t i = 0; i < FUNCTION_COUNT; ++i) {
+        totals.calls[i] -= m_baseline.calls[i];
+        totals.timedCalls[i] -= m_baseline.timedCalls[i];
+        totals.timedNanoseconds[i] -= m_baseline.timedNanoseconds[i];
+    }
+    return totals;
+}
+
+
+void CallCounter::reset() {
+    // the counters keep growing, as their threads may be counting; later totals subtract the current sums
+    std::lock_guard<std::mutex> lock(m_mutex);
+    sum(m_baseline);
+}
+
+
+void CallCounter::setCurrent(CallCounter* counter) {
+    t_current = counter != nullptr ? counter->countersOfThisThread() : nullptr;
+}
+
+
+CallCounter::Counters* CallCounter::countersOfThisThread() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto thread = std::this_thread::get_id();
+    for (const auto& counters : m_counters) {
+        if (counters->thread == thread) {
+            return counters.get();
+        }
+    }
+    m_counters.emplace_back(new Counters(this));
+    return m_counters.back().get();
+}
+
+
+void CallCounter::sum(Totals& totals) const {
+    totals = Totals();
+    for (const auto& counters : m_counters) {
+        for (std::size_t i = 0; i < FUNCTION_COUNT; ++i) {
+            totals.calls[i] += counters->calls[i].load(std::memory_order_relaxed);
+            totals.timedCalls[i] += counters->timedCalls[i].load(std::memory_order_relaxed);
+            totals.timedNanoseconds[i] += counters->timedNanoseconds[i].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+
+}  // namespace gl
+}  // namespace glheadless
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "GLFunctions.h"
+
+
+namespace glheadless {
+namespace gl {
+
+
+/*
+ * Counts the calls of one context per entry point. Context::getProcAddress() hands out the counting entry points of
+ * CallCounter.cpp instead of the driver's; they look up the counters the calling thread keeps for the context current
+ * on it, count the call and pass it on. Every sampleInterval-th call of a thread is timed.
+ *
+ * Each thread writes only its own counters, so counting needs no atomic read-modify-write; totals() adds them up from
+ * any thread.
+ */
+class CallCounter {
+public:
+    using Address = void (*)();
+    using Resolver = std::function<Address(const char*)>;
+
+    // the counters of one thread, written by that thread only
+    struct Counters {
+        explicit Counters(const CallCounter* owner);
+
+        const CallCounter*         owner;
+        std::thread::id            thread;
+        unsigned int               countdown;                        // calls until the next timed one
+        std::atomic<std::uint64_t> calls[FUNCTION_COUNT];
+        std::atomic<std::uint64_t> timedCalls[FUNCTION_COUNT];
+        std::atomic<std::uint64_t> timedNanoseconds[FUNCTION_COUNT];
+    };
+
+    struct Totals {
+        std::uint64_t calls[FUNCTION_COUNT];
+        std::uint64_t timedCalls[FUNCTION_COUNT];
+        std::uint64_t timedNanoseconds[FUNCTION_COUNT];
+    };
+
+    // resolves the entry points the counted calls are passed on to; 0 as interval disables timing
+    CallCounter(const Resolver& resolver, unsigned int sampleInterval);
+    ~CallCounter();
+
+    // resolves them again, e.g., after a trace was started or stopped
+    void resolve(const Resolver& resolver);
+
+    // the counting replacement of a driver entry point, or the entry point itself if it is not counted
+    Address wrap(const char* name, Address address) const;
+
+    void setSampleInterval(unsigned int sampleInterval);
+    unsigned int sampleInterval() const;
+
+    // the sums over all threads since construction or the last reset()
+    Totals totals() const;
+    void reset();
+
+    // the counters of the calling thread for the counter, created on first use; nullptr clears them
+    static void setCurrent(CallCounter* counter);
+
+    Address driver[FUNCTION_COUNT];
+
+
+private:
+    Counters* countersOfThisThread();
+    void sum(Totals& totals) const;
+
+
+private:
+    std::atomic<unsigned int>              m_sampleInterval;
+    mutable std::mutex                     m_mutex;
+    std::vector<std::unique_ptr<Counters>> m_counters; // one per thread that made the context current
+    Totals                                 m_baseline; // sums at the last reset()
+};
+
+
+}  // namespace gl
+}  // namespace glheadless
@@ -0,0 +1,517 @@
+#include <glheadless/CommandList.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <glheadless/Context.h>
+#include <glheadless/error.h>
+
+#include "GLFunctions.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+enum Opcode : unsigned int {
+    ACTIVE_TEXTURE,
+    BIND_BUFFER,
+    BIND_FRAMEBUFFER,
+    BIND_TEXTURE,
+    BIND_VERTEX_ARRAY,
+    BLIT_FRAMEBUFFER,
+    BUFFER_SUB_DATA,
+    CLEAR,
+    CLEAR_COLOR,
+    COLOR_MASK,
+    DISABLE,
+    DRAW_ARRAYS,
+    DRAW_ELEMENTS,
+    ENABLE,
+    SCISSOR,
+    TEX_PARAMETERI,
+    TEX_SUB_IMAGE_2D,
+    UNIFORM_1F,
+    UNIFORM_1I,
+    UNIFORM_4F,
+    USE_PROGRAM,
+    VIEWPORT,
+    OPCODE_COUNT
+};
+
+
+// commands start at multiples of this, so the arguments can be read in place
+const std::size_t k_alignment = 8;
+
+// a command starts with its size in bytes, including the header, shifted left by 8 and or'ed with its opcode
+using Header = std::uint64_t;
+
+
+struct Name {
+    gl::GLuint name;
+};
+
+struct Target {
+    gl::GLenum target;
+    gl::GLuint name;
+};
+
+struct Rectangle {
+    gl::GLint   x;
+    gl::GLint   y;
+    gl::GLsizei width;
+    gl::GLsizei height;
+};
+
+struct Blit {
+    gl::GLint      source[4];
+    gl::GLint      destination[4];
+    gl::GLbitfield mask;
+    gl::GLenum     filter;
+};
+
+struct BufferSubData {
+    gl::GLenum     target;
+    gl::GLintptr   offset;
+    gl::GLsizeiptr size;
+};
+
+struct Color {
+    gl::GLfloat value[4];
+};
+
+struct Mask {
+    gl::GLboolean value[4];
+};
+
+struct DrawArrays {
+    gl::GLenum  mode;
+    gl::GLint   first;
+    gl::GLsizei count;
+};
+
+struct DrawElements {
+    gl::GLenum   mode;
+    gl::GLsizei  count;
+    gl::GLenum   type;
+    std::size_t  offset;
+};
+
+struct TexParameter {
+    gl::GLenum target;
+    gl::GLenum name;
+    gl::GLint  value;
+};
+
+struct TexSubImage {
+    gl::GLenum  target;
+    gl::GLint   level;
+    gl::GLint   x;
+    gl::GLint   y;
+    gl::GLsizei width;
+    gl::GLsizei height;
+    gl::GLenum  format;
+    gl::GLenum  type;
+    std::size_t size;
+};
+
+struct UniformFloat {
+    gl::GLint   location;
+    gl::GLfloat value[4];
+};
+
+struct UniformInt {
+    gl::GLint location;
+    gl::GLint value;
+};
+
+
+std::size_t alignUp(std::size_t size) {
+    return (size + k_alignment - 1) & ~(k_alignment - 1);
+}
+
+
+// offset of the copied client data of a command
+template <typename Arguments>
+constexpr std::size_t dataOffset() {
+    return (sizeof(Header) + sizeof(Arguments) + k_alignment - 1) & ~(k_alignment - 1);
+}
+
+
+template <typename Arguments>
+const Arguments& arguments(const unsigned char* command) {
+    return *reinterpret_cast<const Arguments*>(command + sizeof(Header));
+}
+
+
+const char* missingFunction(const gl::Functions& gl, unsigned int opcode) {
+    switch (opcode) {
+    case ACTIVE_TEXTURE:    return gl.ActiveTexture == nullptr ? "glActiveTexture" : nullptr;
+    case BIND_BUFFER:       return gl.BindBuffer == nullptr ? "glBindBuffer" : nullptr;
+    case BIND_FRAMEBUFFER:  return gl.BindFramebuffer == nullptr ? "glBindFramebuffer" : nullptr;
+    case BIND_TEXTURE:      return gl.BindTexture == nullptr ? "glBindTexture" : nullptr;
+    case BIND_VERTEX_ARRAY: return gl.BindVertexArray == nullptr ? "glBindVertexArray" : nullptr;
+    case BLIT_FRAMEBUFFER:  return gl.BlitFramebuffer == nullptr ? "glBlitFramebuffer" : nullptr;
+    case BUFFER_SUB_DATA:   return gl.BufferSubData == nullptr ? "glBufferSubData" : nullptr;
+    case CLEAR:             return gl.Clear == nullptr ? "glClear" : nullptr;
+    case CLEAR_COLOR:       return gl.ClearColor == nullptr ? "glClearColor" : nullptr;
+    case COLOR_MASK:        return gl.ColorMask == nullptr ? "glColorMask" : nullptr;
+    case DISABLE:           return gl.Disable == nullptr ? "glDisable" : nullptr;
+    case DRAW_ARRAYS:       return gl.DrawArrays == nullptr ? "glDrawArrays" : nullptr;
+    case DRAW_ELEMENTS:     return gl.DrawElements == nullptr ? "glDrawElements" : nullptr;
+    case ENABLE:            return gl.Enable == nullptr ? "glEnable" : nullptr;
+    case SCISSOR:           return gl.Scissor == nullptr ? "glScissor" : nullptr;
+    case TEX_PARAMETERI:    return gl.TexParameteri == nullptr ? "glTexParameteri" : nullptr;
+    case TEX_SUB_IMAGE_2D:  return gl.TexSubImage2D == nullptr ? "glTexSubImage2D" : nullptr;
+    case UNIFORM_1F:        return gl.Uniform1f == nullptr ? "glUniform1f" : nullptr;
+    case UNIFORM_1I:        return gl.Uniform1i == nullptr ? "glUniform1i" : nullptr;
+    case UNIFORM_4F:        return gl.Uniform4f == nullptr ? "glUniform4f" : nullptr;
+    case USE_PROGRAM:       return gl.UseProgram == nullptr ? "glUseProgram" : nullptr;
+    case VIEWPORT:          return gl.Viewport == nullptr ? "glViewport" : nullptr;
+    default:                return nullptr;
+    }
+}
+
+
+}  // unnamed namespace
+
+
+struct CommandList::Block {
+    std::unique_ptr<std::uint64_t[]> data; // 64 bit elements keep the block aligned for all arguments
+    std::size_t                      capacity;
+    std::size_t                      used;
+
+    explicit Block(std::size_t size)
+    : data(new std::uint64_t[alignUp(size) / sizeof(std::uint64_t)])
+    , capacity(alignUp(size))
+    , used(0) {
+    }
+
+    unsigned char* bytes() const {
+        return reinterpret_cast<unsigned char*>(data.get());
+    }
+};
+
+
+CommandList::CommandList(std::size_t blockSize)
+: m_current(0)
+, m_blockSize(std::max(blockSize, std::size_t(256)))
+, m_commandCount(0)
+, m_size(0)
+, m_opcodes(0) {
+    static_assert(OPCODE_COUNT <= sizeof(m_opcodes) * 8, "opcodes must fit into the bit set");
+}
+
+
+CommandList::~CommandList() {
+}
+
+
+template <typename Arguments>
+void CommandList::record(unsigned int opcode, const Arguments& arguments, const void* data, std::size_t size) {
+    const auto commandSize = alignUp(dataOffset<Arguments>() + size);
+
+    // commands never span blocks; the blocks behind the current one are empty
+    if (m_blocks.empty() || m_blocks[m_current]->used + commandSize > m_blocks[m_current]->capacity) {
+        if (!m_blocks.empty() && m_blocks[m_current]->used > 0) {
+            ++m_current;
+        }
+        if (m_current == m_blocks.size() || m_blocks[m_current]->capacity < commandSize) {
+            m_blocks.emplace(m_blocks.begin() + static_cast<std::ptrdiff_t>(m_current), new Block(std::max(m_blockSize, commandSize)));
+        }
+    }
+
+    auto& block = *m_blocks[m_current];
+    const auto command = block.bytes() + block.used;
+    const auto header = static_cast<Header>(commandSize) << 8 | opcode;
+    std::memcpy(command, &header, sizeof(header));
+    std::memcpy(command + sizeof(Header), &arguments, sizeof(Arguments));
+    if (size > 0) {
+        std::memcpy(command + dataOffset<Arguments>(), data, size);
+    }
+
+    block.used += commandSize;
+    m_size += commandSize;
+    ++m_commandCount;
+    m_opcodes |= 1u << opcode;
+}
+
+
+void CommandList::activeTexture(unsigned int texture) {
+    record(ACTIVE_TEXTURE, Name{ texture });
+}
+
+
+void CommandList::bindBuffer(unsigned int target, unsigned int buffer) {
+    record(BIND_BUFFER, Target{ target, buffer });
+}
+
+
+void CommandList::bindFramebuffer(unsigned int target, unsigned int framebuffer) {
+    record(BIND_FRAMEBUFFER, Target{ target, framebuffer });
+}
+
+
+void CommandList::bindTexture(unsigned int target, unsigned int texture) {
+    record(BIND_TEXTURE, Target{ target, texture });
+}
+
+
+void CommandList::bindVertexArray(unsigned int array) {
+    record(BIND_VERTEX_ARRAY, Name{ array });
+}
+
+
+void CommandList::blitFramebuffer(int srcX0, int srcY0, int srcX1, int srcY1, int dstX0, int dstY0, int dstX1, int dstY1, unsigned int mask, unsigned int filter) {
+    record(BLIT_FRAMEBUFFER, Blit{ { srcX0, srcY0, srcX1, srcY1 }, { dstX0, dstY0, dstX1, dstY1 }, mask, filter });
+}
+
+
+void CommandList::bufferSubData(unsigned int target, std::size_t offset, std::size_t size, const void* data) {
+    record(BUFFER_SUB_DATA, BufferSubData{ target, static_cast<gl::GLintptr>(offset), static_cast<gl::GLsizeiptr>(size) }, data, size);
+}
+
+
+void CommandList::clear(unsigned int mask) {
+    record(CLEAR, Name{ mask });
+}
+
+
+void CommandList::clearColor(float red, float green, float blue, float alpha) {
+    record(CLEAR_COLOR, Color{ { red, green, blue, alpha } });
+}
+
+
+void CommandList::colorMask(bool red, bool green, bool blue, bool alpha) {
+    record(COLOR_MASK, Mask{ { red, green, blue, alpha } });
+}
+
+
+void CommandList::disable(unsigned int capability) {
+    record(DISABLE, Name{ capability });
+}
+
+
+void CommandList::drawArrays(unsigned int mode, int first, int count) {
+    record(DRAW_ARRAYS, DrawArrays{ mode, first, count });
+}
+
+
+void CommandList::drawElements(unsigned int mode, int count, unsigned int type, std::size_t offset) {
+    record(DRAW_ELEMENTS, DrawElements{ mode, count, type, offset });
+}
+
+
+void CommandList::enable(unsigned int capability) {
+    record(ENABLE, Name{ capability });
+}
+
+
+void CommandList::scissor(int x, int y, int width, int height) {
+    record(SCISSOR, Rectangle{ x, y, width, height });
+}
+
+
+void CommandList::texParameteri(unsigned int target, unsigned int name, int value) {
+    record(TEX_PARAMETERI, TexParameter{ target, name, value });
+}
+
+
+void CommandList::texSubImage2D(unsigned int target, int level, int x, int y, int width, int height, unsigned int format, unsigned int type, std::size_t size, const void* pixels) {
+    record(TEX_SUB_IMAGE_2D, TexSubImage{ target, level, x, y, width, height, format, type, size }, pixels, size);
+}
+
+
+void CommandList::uniform1f(int location, float x) {
+    record(UNIFORM_1F, UniformFloat{ location, { x, 0.0f, 0.0f, 0.0f } });
+}
+
+
+void CommandList::uniform1i(int location, int x) {
+    record(UNIFORM_1I, UniformInt{ location, x });
+}
+
+
+void CommandList::uniform4f(int location, float x, float y, float z, float w) {
+    record(UNIFORM_4F, UniformFloat{ location, { x, y, z, w } });
+}
+
+
+void CommandList::useProgram(unsigned int program) {
+    record(USE_PROGRAM, Name{ program });
+}
+
+
+void CommandList::viewport(int x, int y, int width, int height) {
+    record(VIEWPORT, Rectangle{ x, y, width, height });
+}
+
+
+bool CommandList::execute(Context* context) const {
+    const auto& gl = context->functions();
+
+    // checked once per list rather than per command, so a list is either executed completely or not at all
+    for (auto opcode = 0u; opcode < OPCODE_COUNT; ++opcode) {
+        if ((m_opcodes & (1u << opcode)) == 0) {
+            continue;
+        }
+        if (const auto name = missingFunction(gl, opcode)) {
+            return context->setError(Error::UNSUPPORTED_FEATURE, std::string("Command list uses unavailable ") + name);
+        }
+    }
+
+    for (std::size_t i = 0; i < m_blocks.size() && i <= m_current; ++i) {
+        const auto& block = *m_blocks[i];
+        const auto begin = block.bytes();
+        const auto end = begin + block.used;
+
+        for (auto command = begin; command < end; ) {
+            Header header;
+            std::memcpy(&header, command, sizeof(header));
+
+            switch (static_cast<unsigned int>(header & 0xFF)) {
+            case ACTIVE_TEXTURE:
+                gl.ActiveTexture(arguments<Name>(command).name);
+                break;
+            case BIND_BUFFER: {
+                const auto& a = arguments<Target>(command);
+                gl.BindBuffer(a.target, a.name);
+                break;
+            }
+            case BIND_FRAMEBUFFER: {
+                const auto& a = arguments<Target>(command);
+                gl.BindFramebuffer(a.target, a.name);
+                break;
+            }
+            case BIND_TEXTURE: {
+                const auto& a = arguments<Target>(command);
+                gl.BindTexture(a.target, a.name);
+                break;
+            }
+            case BIND_VERTEX_ARRAY:
+                gl.BindVertexArray(arguments<Name>(command).name);
+                break;
+            case BLIT_FRAMEBUFFER: {
+                const auto& a = arguments<Blit>(command);
+                gl.BlitFramebuffer(a.source[0], a.source[1], a.source[2], a.source[3], a.destination[0], a.destination[1], a.destination[2], a.destination[3], a.mask, a.filter);
+                break;
+            }
+            case BUFFER_SUB_DATA: {
+                const auto& a = arguments<BufferSubData>(command);
+                gl.BufferSubData(a.target, a.offset, a.size, command + dataOffset<BufferSubData>());
+                break;
+            }
+            case CLEAR:
+                gl.Clear(arguments<Name>(command).name);
+                break;
+            case CLEAR_COLOR: {
+                const auto& a = arguments<Color>(command);
+                gl.ClearColor(a.value[0], a.value[1], a.value[2], a.value[3]);
+                break;
+            }
+            case COLOR_MASK: {
+                const auto& a = arguments<Mask>(command);
+                gl.ColorMask(a.value[0], a.value[1], a.value[2], a.value[3]);
+                break;
+            }
+            case DISABLE:
+                gl.Disable(arguments<Name>(command).name);
+                break;
+            case DRAW_ARRAYS: {
+                const auto& a = arguments<DrawArrays>(command);
+                gl.DrawArrays(a.mode, a.first, a.count);
+                break;
+            }
+            case DRAW_ELEMENTS: {
+                const auto& a = arguments<DrawElements>(command);
+                gl.DrawElements(a.mode, a.count, a.type, reinterpret_cast<const void*>(a.offset));
+                break;
+            }
+            case ENABLE:
+                gl.Enable(arguments<Name>(command).name);
+                break;
+            case SCISSOR: {
+                const auto& a = arguments<Rectangle>(command);
+                gl.Scissor(a.x, a.y, a.width, a.height);
+                break;
+            }
+            case TEX_PARAMETERI: {
+                const auto& a = arguments<TexParameter>(command);
+                gl.TexParameteri(a.target, a.name, a.value);
+                break;
+            }
+            case TEX_SUB_IMAGE_2D: {
+                const auto& a = arguments<TexSubImage>(command);
+                gl.TexSubImage2D(a.target, a.level, a.x, a.y, a.width, a.height, a.format, a.type, a.size > 0 ? command + dataOffset<TexSubImage>() : nullptr);
+                break;
+            }
+            case UNIFORM_1F: {
+                const auto& a = arguments<UniformFloat>(command);
+                gl.Uniform1f(a.location, a.value[0]);
+                break;
+            }
+            case UNIFORM_1I: {
+                const auto& a = arguments<UniformInt>(command);
+                gl.Uniform1i(a.location, a.value);
+                break;
+            }
+            case UNIFORM_4F: {
+                const auto& a = arguments<UniformFloat>(command);
+                gl.Uniform4f(a.location, a.value[0], a.value[1], a.value[2], a.value[3]);
+                break;
+            }
+            case USE_PROGRAM:
+                gl.UseProgram(arguments<Name>(command).name);
+                break;
+            case VIEWPORT: {
+                const auto& a = arguments<Rectangle>(command);
+                gl.Viewport(a.x, a.y, a.width, a.height);
+                break;
+            }
+            default:
+                break;
+            }
+
+            command += static_cast<std::size_t>(header >> 8);
+        }
+    }
+
+    return true;
+}
+
+
+void CommandList::reset() {
+    for (auto& block : m_blocks) {
+        block->used = 0;
+    }
+    m_current = 0;
+    m_commandCount = 0;
+    m_size = 0;
+    m_opcodes = 0;
+}
+
+
+std::size_t CommandList::commandCount() const {
+    return m_commandCount;
+}
+
+
+std::size_t CommandList::size() const {
+    return m_size;
+}
+
+
+std::size_t CommandList::capacity() const {
+    std::size_t capacity = 0;
+    for (const auto& block : m_blocks) {
+        capacity += block->capacity;
+    }
+    return capacity;
+}
+
+
+}  // namespace glheadless
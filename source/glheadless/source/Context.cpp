@@ -1,8 +1,20 @@
 #include <glheadless/Context.h>
 
+#include <algorithm>
 #include <cassert>
 
 #include "AbstractImplementation.h"
+#include "CallCounter.h"
+#include "ContextObservers.h"
+#include "DebugCollector.h"
+#include "GLFunctions.h"
+#include "GpuProfiler.h"
+#include "InternalException.h"
+#include "Probes.h"
+#include "RuntimeCounters.h"
+#include "StateCache.h"
+#include "TimelineWriter.h"
+#include "Trace.h"
 
 
 namespace glheadless {
@@ -17,17 +29,80 @@ Context::Context(AbstractImplementation* implementation)
 
 Context::~Context() {
     assert(m_owningThread == std::this_thread::get_id() && "a context must be destroyed on the same thread that created it");
+    if (m_stateCache && gl::StateCache::current() == m_stateCache.get()) {
+        gl::StateCache::setCurrent(nullptr);
+    }
+    if (m_cacheFallback && gl::StateCache::fallback() == m_cacheFallback.get()) {
+        gl::StateCache::setFallback(nullptr);
+    }
+    if (m_traceFallback && gl::Tracer::fallback() == m_traceFallback.get()) {
+        gl::Tracer::setFallback(nullptr);
+    }
+    m_tracer.reset();
+    m_callCounter.reset();
+
+    if (ContextObservers::active() && valid()) {
+        ContextObservers::notify(ContextEventType::DESTROYING, this);
+    }
+
+    // the callback must be removed while the context is current; otherwise only owning contexts collect, and the
+    // driver cannot report messages once they are destroyed
+    if (m_debugCollector && m_implementation->isCurrent()) {
+        m_debugCollector->uninstall(functions());
+    }
+
+    const auto start = RuntimeCounters::Clock::now();
     m_implementation->destroy();
+    RuntimeCounters::record(RuntimeCounters::DESTROY, start, std::error_code());
+    TimelineWriter::contextDestroyed(this, start);
+
+    m_debugCollector.reset();
 }
 
 
 bool Context::makeCurrent() {
-    return m_implementation->makeCurrent();
+    GLHEADLESS_PROBE1(make_current_entry, nativeHandle());
+    const auto start = RuntimeCounters::Clock::now();
+    const auto success = m_implementation->makeCurrent();
+    RuntimeCounters::record(RuntimeCounters::MAKE_CURRENT, start, success ? std::error_code() : m_lastErrorCode);
+    GLHEADLESS_PROBE2(make_current_return, nativeHandle(), success ? 0 : m_lastErrorCode.value());
+    if (!success) {
+        return false;
+    }
+
+    gl::StateCache::setCurrent(m_stateCache.get());
+    gl::StateCache::setFallback(m_cacheFallback.get());
+    gl::Tracer::setCurrent(m_tracer.get());
+    gl::Tracer::setFallback(m_traceFallback.get());
+    gl::CallCounter::setCurrent(m_callCounter.get());
+    TimelineWriter::contextMadeCurrent(this);
+    if (ContextObservers::active()) {
+        ContextObservers::notify(ContextEventType::MADE_CURRENT, this);
+    }
+    return true;
 }
 
 
 bool Context::doneCurrent() {
-    return m_implementation->doneCurrent();
+    GLHEADLESS_PROBE1(done_current_entry, nativeHandle());
+    const auto start = RuntimeCounters::Clock::now();
+    const auto success = m_implementation->doneCurrent();
+    RuntimeCounters::record(RuntimeCounters::DONE_CURRENT, start, success ? std::error_code() : m_lastErrorCode);
+    GLHEADLESS_PROBE2(done_current_return, nativeHandle(), success ? 0 : m_lastErrorCode.value());
+    if (!success) {
+        return false;
+    }
+
+    gl::StateCache::setCurrent(nullptr);
+    gl::StateCache::setFallback(nullptr);
+    gl::Tracer::setCurrent(nullptr);
+    gl::Tracer::setFallback(nullptr);
+    gl::CallCounter::setCurrent(nullptr);
+    TimelineWriter::contextDoneCurrent(this);
+    if (ContextObservers::active()) {
+        ContextObservers::notify(ContextEventType::DONE_CURRENT, this);
+    }
+    return true;
 }
 
 
@@ -42,7 +117,333 @@ unsigned long long Context::nativeHandle() const {
 
 
 void (*Context::getProcAddress(const char * name) const)() {
-    return m_implementation->getProcAddress(name);
+    // calls pass the state cache first, so the trace records what reaches the driver, and are counted last, so the
+    // counters measure the driver alone
+    const auto address = uncachedProcAddress(name);
+    return m_stateCache ? m_stateCache->wrap(name, address) : address;
+}
+
+
+void (*Context::countedProcAddress(const char* name) const)() {
+    const auto address = m_implementation->getProcAddress(name);
+    return m_callCounter ? m_callCounter->wrap(name, address) : address;
+}
+
+
+void (*Context::uncachedProcAddress(const char* name) const)() {
+    const auto address = countedProcAddress(name);
+    return m_tracer ? m_tracer->wrap(name, address) : address;
+}
+
+
+void Context::setStateCacheEnabled(bool enabled) {
+    if (enabled == static_cast<bool>(m_stateCache)) {
+        return;
+    }
+
+    if (enabled) {
+        m_stateCache.reset(new gl::StateCache([this] (const char* name) {
+            return uncachedProcAddress(name);
+        }));
+        gl::StateCache::setCurrent(m_stateCache.get());
+    } else {
+        // the filtering entry points pass calls through to the entry points of this context once no cache is current
+        gl::StateCache::setCurrent(nullptr);
+        m_stateCache.reset();
+        if (!m_cacheFallback) {
+            m_cacheFallback.reset(new gl::StateCacheFallback);
+        }
+        m_cacheFallback->resolve([this] (const char* name) {
+            return uncachedProcAddress(name);
+        });
+        gl::StateCache::setFallback(m_cacheFallback.get());
+    }
+
+    // the table is updated in place, as internal objects keep references to it
+    if (m_functions) {
+        m_functions->resolve(*this);
+    }
+}
+
+
+bool Context::stateCacheEnabled() const {
+    return static_cast<bool>(m_stateCache);
+}
+
+
+void Context::invalidateStateCache() {
+    if (m_stateCache) {
+        m_stateCache->invalidate();
+    }
+}
+
+
+StateCacheStatistics Context::stateCacheStatistics() const {
+    StateCacheStatistics statistics;
+    if (m_stateCache) {
+        statistics.forwardedCount = m_stateCache->forwardedCount();
+        statistics.droppedCount = m_stateCache->droppedCount();
+    }
+    return statistics;
+}
+
+
+bool Context::startTrace(const std::string& path) {
+    if (m_tracer) {
+        return setError(Error::INVALID_ARGUMENT, "A trace is already being recorded");
+    }
+
+    try {
+        m_tracer.reset(new gl::Tracer(path, [this] (const char* name) {
+            return countedProcAddress(name);
+        }));
+    } catch (InternalException& e) {
+        return setError(e.code(), e.message());
+    }
+
+    gl::Tracer::setCurrent(m_tracer.get());
+    resolveFunctions();
+    return true;
+}
+
+
+bool Context::stopTrace() {
+    if (!m_tracer) {
+        return setError(Error::INVALID_ARGUMENT, "No trace is being recorded");
+    }
+
+    // the recording entry points pass calls through to the entry points of this context once no tracer is current
+    std::unique_ptr<gl::Tracer> tracer(std::move(m_tracer));
+    gl::Tracer::setCurrent(nullptr);
+    if (!m_traceFallback) {
+        m_traceFallback.reset(new gl::TraceFallback);
+    }
+    gl::Tracer::setFallback(m_traceFallback.get());
+    resolveFunctions();
+
+    if (tracer->failed()) {
+        return setError(tracer->errorCode(), tracer->errorMessage());
+    }
+    return true;
+}
+
+
+bool Context::tracing() const {
+    return static_cast<bool>(m_tracer);
+}
+
+
+void Context::setCallCountingEnabled(bool enabled, unsigned int sampleInterval) {
+    if (enabled && m_callCounter) {
+        m_callCounter->setSampleInterval(sampleInterval);
+        return;
+    }
+    if (enabled == static_cast<bool>(m_callCounter)) {
+        return;
+    }
+
+    if (enabled) {
+        m_callCounter.reset(new gl::CallCounter([this] (const char* name) {
+            return m_implementation->getProcAddress(name);
+        }, sampleInterval));
+        gl::CallCounter::setCurrent(m_callCounter.get());
+    } else {
+        gl::CallCounter::setCurrent(nullptr);
+        m_callCounter.reset();
+    }
+    resolveFunctions();
+}
+
+
+bool Context::callCountingEnabled() const {
+    return static_cast<bool>(m_callCounter);
+}
+
+
+std::vector<CallStatistics> Context::callStatistics() const {
+    std::vector<CallStatistics> statistics;
+    if (!m_callCounter) {
+        return statistics;
+    }
+
+    const auto totals = m_callCounter->totals();
+    for (std::size_t i = 0; i < gl::FUNCTION_COUNT; ++i) {
+        if (totals.calls[i] == 0) {
+            continue;
+        }
+
+        CallStatistics function;
+        function.name = gl::functionName(i);
+        function.callCount = totals.calls[i];
+        function.sampledCount = totals.timedCalls[i];
+        function.sampledMilliseconds = static_cast<double>(totals.timedNanoseconds[i]) / 1.0e6;
+        if (function.sampledCount > 0) {
+            function.estimatedMilliseconds = function.sampledMilliseconds / static_cast<double>(function.sampledCount) * static_cast<double>(function.callCount);
+        }
+        statistics.push_back(function);
+    }
+    std::sort(statistics.begin(), statistics.end(), [] (const CallStatistics& a, const CallStatistics& b) {
+        return a.estimatedMilliseconds != b.estimatedMilliseconds ? a.estimatedMilliseconds > b.estimatedMilliseconds : a.callCount > b.callCount;
+    });
+
+    return statistics;
+}
+
+
+void Context::resetCallStatistics() {
+    if (m_callCounter) {
+        m_callCounter->reset();
+    }
+}
+
+
+bool Context::startDebugOutput(const DebugSink& sink, const DebugFilter& filter, std::size_t capacity) {
+    if (m_debugCollector) {
+        return setError(Error::INVALID_ARGUMENT, "Debug output is already being collected");
+    }
+    // the native context of ContextFactory::getCurrent() outlives this object, and with it the callback
+    if (!m_implementation->owning()) {
+        return setError(Error::INVALID_ARGUMENT, "Debug output cannot be collected for contexts from ContextFactory::getCurrent()");
+    }
+
+    std::unique_ptr<gl::DebugCollector> collector(new gl::DebugCollector(sink, filter, capacity));
+    try {
+        collector->install(functions());
+    } catch (InternalException& e) {
+        return setError(e.code(), e.message());
+    }
+
+    m_debugCollector = std::move(collector);
+    return true;
+}
+
+
+bool Context::stopDebugOutput() {
+    if (!m_debugCollector) {
+        return setError(Error::INVALID_ARGUMENT, "No debug output is being collected");
+    }
+
+    m_debugCollector->uninstall(functions());
+    m_debugCollector.reset();
+    return true;
+}
+
+
+bool Context::debugOutputActive() const {
+    return static_cast<bool>(m_debugCollector);
+}
+
+
+DebugOutputStatistics Context::debugOutputStatistics() const {
+    DebugOutputStatistics statistics;
+    if (m_debugCollector) {
+        statistics.collectedCount = m_debugCollector->collectedCount();
+        statistics.droppedCount = m_debugCollector->droppedCount();
+    }
+    return statistics;
+}
+
+
+bool Context::startGpuProfiling(std::size_t frameLatency) {
+    if (gpuProfilingActive()) {
+        return setError(Error::INVALID_ARGUMENT, "GPU profiling is already active");
+    }
+
+    std::unique_ptr<gl::GpuProfiler> profiler(new gl::GpuProfiler(frameLatency));
+    try {
+        profiler->install(functions());
+    } catch (InternalException& e) {
+        return setError(e.code(), e.message());
+    }
+
+    m_gpuProfiler = std::move(profiler);
+    return true;
+}
+
+
+bool Context::stopGpuProfiling() {
+    if (!gpuProfilingActive()) {
+        return setError(Error::INVALID_ARGUMENT, "GPU profiling is not active");
+    }
+
+    // the profiler stays to hand out the remaining timings
+    m_gpuProfiler->finish(functions());
+    return true;
+}
+
+
+bool Context::gpuProfilingActive() const {
+    return m_gpuProfiler && m_gpuProfiler->active();
+}
+
+
+bool Context::beginGpuScope(const char* name) {
+    if (!gpuProfilingActive()) {
+        return setError(Error::INVALID_ARGUMENT, "GPU profiling is not active");
+    }
+
+    m_gpuProfiler->begin(functions(), name);
+    return true;
+}
+
+
+bool Context::endGpuScope() {
+    if (!gpuProfilingActive()) {
+        return setError(Error::INVALID_ARGUMENT, "GPU profiling is not active");
+    }
+
+    try {
+        m_gpuProfiler->end(functions());
+    } catch (InternalException& e) {
+        return setError(e.code(), e.message());
+    }
+    return true;
+}
+
+
+bool Context::endGpuFrame() {
+    if (!gpuProfilingActive()) {
+        return setError(Error::INVALID_ARGUMENT, "GPU profiling is not active");
+    }
+
+    try {
+        m_gpuProfiler->endFrame(functions());
+    } catch (InternalException& e) {
+        return setError(e.code(), e.message());
+    }
+    return true;
+}
+
+
+std::vector<GpuFrameTimings> Context::takeGpuFrameTimings() {
+    return m_gpuProfiler ? m_gpuProfiler->take() : std::vector<GpuFrameTimings>();
+}
+
+
+void Context::resolveFunctions() {
+    if (m_tracer) {
+        m_tracer->resolve([this] (const char* name) {
+            return countedProcAddress(name);
+        });
+    }
+    if (m_traceFallback) {
+        m_traceFallback->resolve([this] (const char* name) {
+            return countedProcAddress(name);
+        });
+    }
+    if (m_stateCache) {
+        m_stateCache->resolve([this] (const char* name) {
+            return uncachedProcAddress(name);
+        });
+    }
+    if (m_cacheFallback) {
+        m_cacheFallback->resolve([this] (const char* name) {
+            return uncachedProcAddress(name);
+        });
+    }
+    if (m_functions) {
+        m_functions->resolve(*this);
+    }
 }
 
 
@@ -55,6 +456,13 @@ bool Context::setError(const std::error_code& code, const std::string& message)
     m_lastErrorCode = code;
     m_lastErrorMessage = message;
 
+    if (m_lastErrorCode) {
+        GLHEADLESS_PROBE3(error, nativeHandle(), m_lastErrorCode.value(), m_lastErrorMessage.c_str());
+        if (ContextObservers::active()) {
+            ContextObservers::notifyError(this, m_lastErrorCode, m_lastErrorMessage);
+        }
+    }
+
     return !m_lastErrorCode;
 }
 
@@ -79,4 +487,13 @@ const AbstractImplementation* Context::implementation() const {
 }
 
 
+const gl::Functions& Context::functions() const {
+    if (!m_functions) {
+        m_functions.reset(new gl::Functions);
+        m_functions->resolve(*this);
+    }
+    return *m_functions;
+}
+
+
 }  // namespace glheadless
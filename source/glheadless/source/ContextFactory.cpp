@@ -1,6 +1,9 @@
 #include <glheadless/ContextFactory.h>
 
 #include "AbstractImplementation.h"
+#include "ContextObservers.h"
+#include "RuntimeCounters.h"
+#include "TimelineWriter.h"
 
 #include <glheadless/Context.h>
 
@@ -10,17 +13,35 @@ namespace glheadless {
 
 std::unique_ptr<Context> ContextFactory::getCurrent() {
     auto implementation = AbstractImplementation::create();
-    return implementation->getCurrent();
+    auto context = implementation->getCurrent();
+    if (ContextObservers::active() && context->valid()) {
+        ContextObservers::notify(ContextEventType::CREATED, context.get());
+    }
+    return context;
 }
 
 std::unique_ptr<Context> ContextFactory::create(const ContextFormat& format) {
+    const auto start = RuntimeCounters::Clock::now();
     auto implementation = AbstractImplementation::create();
-    return implementation->create(format);
+    auto context = implementation->create(format);
+    RuntimeCounters::record(RuntimeCounters::CREATE, start, context->valid() ? std::error_code() : context->lastErrorCode());
+    TimelineWriter::contextCreated(context.get(), start);
+    if (ContextObservers::active() && context->valid()) {
+        ContextObservers::notify(ContextEventType::CREATED, context.get());
+    }
+    return context;
 }
 
 std::unique_ptr<Context> ContextFactory::create(const Context* shared, const ContextFormat& format) {
+    const auto start = RuntimeCounters::Clock::now();
     auto implementation = AbstractImplementation::create();
-    return implementation->create(shared, format);
+    auto context = implementation->create(shared, format);
+    RuntimeCounters::record(RuntimeCounters::CREATE, start, context->valid() ? std::error_code() : context->lastErrorCode());
+    TimelineWriter::contextCreated(context.get(), start);
+    if (ContextObservers::active() && context->valid()) {
+        ContextObservers::notify(ContextEventType::CREATED, context.get());
+    }
+    return context;
 }
 
 
@@ -0,0 +1,120 @@
+#include "ContextObservers.h"
+
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+struct Entry {
+    std::size_t     id;
+    ContextObserver observer;
+};
+
+using List = std::vector<Entry>;
+
+
+struct Registry {
+    std::mutex                  mutex;
+    std::shared_ptr<const List> list;
+    std::size_t                 nextId = 1;
+};
+
+
+// leaked, so that contexts destroyed during static destruction may still notify
+Registry& registry() {
+    static auto instance = new Registry;
+    return *instance;
+}
+
+
+std::shared_ptr<const List> snapshot() {
+    auto& instance = registry();
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    return instance.list;
+}
+
+
+void deliver(const ContextEvent& event) {
+    const auto list = snapshot();
+    if (!list) {
+        return;
+    }
+
+    for (const auto& entry : *list) {
+        entry.observer(event);
+    }
+}
+
+
+}  // unnamed namespace
+
+
+std::atomic<bool> ContextObservers::s_active(false);
+
+
+void ContextObservers::notify(ContextEventType type, Context* context) {
+    ContextEvent event;
+    event.type = type;
+    event.context = context;
+    event.errorMessage = nullptr;
+    deliver(event);
+}
+
+
+void ContextObservers::notifyError(Context* context, const std::error_code& code, const std::string& message) {
+    ContextEvent event;
+    event.type = ContextEventType::ERROR_OCCURRED;
+    event.context = context;
+    event.errorCode = code;
+    event.errorMessage = &message;
+    deliver(event);
+}
+
+
+std::size_t addContextObserver(ContextObserver observer) {
+    if (!observer) {
+        return 0;
+    }
+
+    auto& instance = registry();
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    std::shared_ptr<List> list(instance.list ? new List(*instance.list) : new List);
+    const auto id = instance.nextId++;
+    list->push_back({ id, std::move(observer) });
+    instance.list = std::move(list);
+    ContextObservers::s_active.store(true, std::memory_order_relaxed);
+    return id;
+}
+
+
+bool removeContextObserver(std::size_t id) {
+    auto& instance = registry();
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    if (!instance.list) {
+        return false;
+    }
+
+    std::shared_ptr<List> list(new List);
+    for (const auto& entry : *instance.list) {
+        if (entry.id != id) {
+            list->push_back(entry);
+        }
+    }
+    if (list->size() == instance.list->size()) {
+        return false;
+    }
+
+    ContextObservers::s_active.store(!list->empty(), std::memory_order_relaxed);
+    instance.list = list->empty() ? nullptr : std::move(list);
+    return true;
+}
+
+
+}  // namespace glheadless
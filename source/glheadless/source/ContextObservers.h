@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <system_error>
+
+#include <glheadless/ContextObserver.h>
+
+
+namespace glheadless {
+
+
+/*
+ * Registry of the observers of addContextObserver(). Call sites check active() before notify(), so that the
+ * unobserved case is a single relaxed load. Observers are kept in an immutable list that is replaced on every change;
+ * notify() takes a reference to the current list and calls the observers without holding a lock, which allows
+ * observers to cause events themselves and to add or remove observers.
+ */
+class ContextObservers {
+public:
+    static bool active() {
+        return s_active.load(std::memory_order_relaxed);
+    }
+
+    static void notify(ContextEventType type, Context* context);
+    static void notifyError(Context* context, const std::error_code& code, const std::string& message);
+
+
+private:
+    friend std::size_t addContextObserver(ContextObserver observer);
+    friend bool removeContextObserver(std::size_t id);
+
+    static std::atomic<bool> s_active;
+};
+
+
+}  // namespace glheadless
@@ -0,0 +1,245 @@
+#include "DebugCollector.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <glheadless/error.h>
+
+#include "InternalException.h"
+
+
+namespace glheadless {
+namespace gl {
+
+
+namespace {
+
+
+const auto k_drainInterval = std::chrono::milliseconds(10);
+
+const GLenum k_sources[] = {
+    DEBUG_SOURCE_API, DEBUG_SOURCE_WINDOW_SYSTEM, DEBUG_SOURCE_SHADER_COMPILER, DEBUG_SOURCE_THIRD_PARTY,
+    DEBUG_SOURCE_APPLICATION, DEBUG_SOURCE_OTHER
+};
+
+const GLenum k_types[] = {
+    DEBUG_TYPE_ERROR, DEBUG_TYPE_DEPRECATED_BEHAVIOR, DEBUG_TYPE_UNDEFINED_BEHAVIOR, DEBUG_TYPE_PORTABILITY,
+    DEBUG_TYPE_PERFORMANCE, DEBUG_TYPE_OTHER, DEBUG_TYPE_MARKER, DEBUG_TYPE_PUSH_GROUP, DEBUG_TYPE_POP_GROUP
+};
+
+const GLenum k_severities[] = {
+    DEBUG_SEVERITY_NOTIFICATION, DEBUG_SEVERITY_LOW, DEBUG_SEVERITY_MEDIUM, DEBUG_SEVERITY_HIGH
+};
+
+
+// index of a value in one of the tables, the index passed as unknown if it is none of them
+template <std::size_t N>
+unsigned int indexOf(const GLenum (&values)[N], GLenum value, unsigned int unknown) {
+    const auto found = std::find(values, values + N, value);
+    return found != values + N ? static_cast<unsigned int>(found - values) : unknown;
+}
+
+
+template <typename T>
+std::uint32_t mask(const std::vector<T>& values) {
+    if (values.empty()) {
+        return ~std::uint32_t(0);
+    }
+
+    std::uint32_t bits = 0;
+    for (const auto value : values) {
+        bits |= std::uint32_t(1) << static_cast<unsigned int>(value);
+    }
+    return bits;
+}
+
+
+// the values whose bits are set, DONT_CARE alone if all are
+template <std::size_t N>
+std::vector<GLenum> selected(const GLenum (&values)[N], std::uint32_t bits) {
+    if (bits == ~std::uint32_t(0)) {
+        return std::vector<GLenum>(1, DONT_CARE);
+    }
+
+    std::vector<GLenum> result;
+    for (std::size_t i = 0; i < N; ++i) {
+        if ((bits & (std::uint32_t(1) << i)) != 0) {
+            result.push_back(values[i]);
+        }
+    }
+    return result;
+}
+
+
+}  // unnamed namespace
+
+
+DebugCollector::DebugCollector(const DebugSink& sink, const DebugFilter& filter, std::size_t capacity)
+: m_sink(sink)
+, m_sources(mask(filter.sources))
+, m_types(mask(filter.types))
+, m_minimumSeverity(filter.minimumSeverity)
+, m_mask(0)
+, m_pushPosition(0)
+, m_drainPosition(0)
+, m_collectedCount(0)
+, m_droppedCount(0)
+, m_stopping(false) {
+    auto size = std::size_t(2);
+    while (size < capacity) {
+        size *= 2;
+    }
+    m_slots.reset(new Slot[size]);
+    m_mask = size - 1;
+    for (std::size_t i = 0; i < size; ++i) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    m_thread = std::thread(&DebugCollector::drainLoop, this);
+}
+
+
+DebugCollector::~DebugCollector() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_stopRequested.notify_all();
+    m_thread.join();
+}
+
+
+void DebugCollector::install(const Functions& gl) {
+    GLint major = 0;
+    GLint minor = 0;
+    gl.GetIntegerv(MAJOR_VERSION, &major);
+    gl.GetIntegerv(MINOR_VERSION, &minor);
+    const auto core = major > 4 || (major == 4 && minor >= 3);
+    if (gl.DebugMessageCallback == nullptr || (!core && !gl.hasExtension("GL_KHR_debug"))) {
+        throw InternalException(Error::UNSUPPORTED_FEATURE, "Debug output requires OpenGL 4.3 or GL_KHR_debug");
+    }
+
+    gl.DebugMessageCallback(&DebugCollector::receive, this);
+
+    // messages filtered out are not even generated
+    gl.DebugMessageControl(DONT_CARE, DONT_CARE, DONT_CARE, 0, nullptr, 0);
+    const auto sources = selected(k_sources, m_sources);
+    const auto types = selected(k_types, m_types);
+    for (const auto source : sources) {
+        for (const auto type : types) {
+            for (auto severity = static_cast<std::size_t>(m_minimumSeverity); severity < sizeof(k_severities) / sizeof(k_severities[0]); ++severity) {
+                gl.DebugMessageControl(source, type, k_severities[severity], 0, nullptr, 1);
+            }
+        }
+    }
+
+    // asynchronous output lets the driver report from its own threads without serializing the calls
+    gl.Disable(DEBUG_OUTPUT_SYNCHRONOUS);
+    gl.Enable(DEBUG_OUTPUT);
+}
+
+
+void DebugCollector::uninstall(const Functions& gl) {
+    gl.Disable(DEBUG_OUTPUT);
+    gl.DebugMessageCallback(nullptr, nullptr);
+}
+
+
+std::uint64_t DebugCollector::collectedCount() const {
+    return m_collectedCount.load(std::memory_order_relaxed);
+}
+
+
+std::uint64_t DebugCollector::droppedCount() const {
+    return m_droppedCount.load(std::memory_order_relaxed);
+}
+
+
+void GLHEADLESS_APIENTRY DebugCollector::receive(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
+    const auto collector = const_cast<DebugCollector*>(static_cast<const DebugCollector*>(userParam));
+    const auto sourceIndex = indexOf(k_sources, source, static_cast<unsigned int>(DebugSource::OTHER));
+    const auto typeIndex = indexOf(k_types, type, static_cast<unsigned int>(DebugType::OTHER));
+    const auto severityIndex = indexOf(k_severities, severity, static_cast<unsigned int>(DebugSeverity::NOTIFICATION));
+
+    // drivers may report messages disabled through glDebugMessageControl(), e.g., of the window system
+    if ((collector->m_sources & (std::uint32_t(1) << sourceIndex)) == 0 || (collector->m_types & (std::uint32_t(1) << typeIndex)) == 0
+        || severityIndex < static_cast<unsigned int>(collector->m_minimumSeverity)) {
+        return;
+    }
+
+    collector->push(static_cast<DebugSource>(sourceIndex), static_cast<DebugType>(typeIndex), static_cast<DebugSeverity>(severityIndex), id, length, message);
+}
+
+
+void DebugCollector::push(DebugSource source, DebugType type, DebugSeverity severity, GLuint id, GLsizei length, const GLchar* text) {
+    // a slot is free for position p when its sequence is p; claiming the position makes it the pusher's
+    auto position = m_pushPosition.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    for (;;) {
+        slot = &m_slots[position & m_mask];
+        const auto difference = static_cast<std::ptrdiff_t>(slot->sequence.load(std::memory_order_acquire) - position);
+        if (difference == 0) {
+            if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            position = m_pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    auto& message = slot->message;
+    message.source = source;
+    message.type = type;
+    message.severity = severity;
+    message.id = id;
+    message.time = std::chrono::steady_clock::now();
+    const auto size = text == nullptr ? 0 : length >= 0 ? static_cast<std::size_t>(length) : std::strlen(text);
+    message.length = size < k_maxDebugMessageLength ? size : k_maxDebugMessageLength;
+    if (message.length > 0) {
+        std::memcpy(message.text, text, message.length);
+    }
+    message.text[message.length] = '\0';
+
+    // publishes the message to the draining thread
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+
+void DebugCollector::drain() {
+    for (;;) {
+        auto& slot = m_slots[m_drainPosition & m_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != m_drainPosition + 1) {
+            return;
+        }
+
+        // the copy frees the slot before the sink runs, however long it takes
+        const auto message = slot.message;
+        slot.sequence.store(m_drainPosition + m_mask + 1, std::memory_order_release);
+        ++m_drainPosition;
+
+        m_sink(message);
+        m_collectedCount.store(m_collectedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+
+void DebugCollector::drainLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        lock.unlock();
+        drain();
+        lock.lock();
+        m_stopRequested.wait_for(lock, k_drainInterval, [this] { return m_stopping; });
+    }
+    lock.unlock();
+
+    drain();
+}
+
+
+}  // namespace gl
+}  // namespace glheadless
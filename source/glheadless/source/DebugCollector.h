@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <glheadless/DebugOutput.h>
+
+#include "GLFunctions.h"
+
+
+namespace glheadless {
+namespace gl {
+
+
+/*
+ * Collects the debug output of one context. The driver's callback pushes each message into a bounded ring that any
+ * number of threads may push into without locking or allocating (one sequence number per slot); a thread of its own
+ * drains the ring into the sink. Messages arriving while the ring is full are dropped and counted.
+ */
+class DebugCollector {
+public:
+    // starts the draining thread
+    DebugCollector(const DebugSink& sink, const DebugFilter& filter, std::size_t capacity);
+
+    // stops the draining thread after passing the remaining messages to the sink
+    ~DebugCollector();
+
+    // installs the callback and enables the selected messages; the context must be current, throws InternalException
+    void install(const Functions& gl);
+
+    // removes the callback and disables debug output
+    void uninstall(const Functions& gl);
+
+    std::uint64_t collectedCount() const;
+    std::uint64_t droppedCount() const;
+
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        DebugMessage             message;
+    };
+
+    static void GLHEADLESS_APIENTRY receive(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+
+    void push(DebugSource source, DebugType type, DebugSeverity severity, GLuint id, GLsizei length, const GLchar* text);
+    void drain();
+    void drainLoop();
+
+
+private:
+    DebugSink                m_sink;
+    std::uint32_t            m_sources;   // bit per DebugSource
+    std::uint32_t            m_types;     // bit per DebugType
+    DebugSeverity            m_minimumSeverity;
+
+    std::unique_ptr<Slot[]>  m_slots;
+    std::size_t              m_mask;      // capacity - 1, the capacity is a power of two
+    std::atomic<std::size_t> m_pushPosition;
+    std::size_t              m_drainPosition;
+
+    std::atomic<std::uint64_t> m_collectedCount;
+    std::atomic<std::uint64_t> m_droppedCount;
+
+    std::mutex              m_mutex;
+    std::condition_variable m_stopRequested;
+    bool                    m_stopping;
+    std::thread             m_thread;
+};
+
+
+}  // namespace gl
+}  // namespace glheadless
@@ -0,0 +1,57 @@
+#include "GLFunctions.h"
+
+#include <cstring>
+
+#include <glheadless/Context.h>
+
+
+namespace glheadless {
+namespace gl {
+
+
+namespace {
+
+
+const char* const k_functionNames[FUNCTION_COUNT] = {
+#define GLHEADLESS_GL_FUNCTION_NAME(name, signature) "gl" #name,
+    GLHEADLESS_GL_FUNCTIONS(GLHEADLESS_GL_FUNCTION_NAME)
+#undef GLHEADLESS_GL_FUNCTION_NAME
+};
+
+
+}  // unnamed namespace
+
+
+const char* functionName(std::size_t function) {
+    return function < FUNCTION_COUNT ? k_functionNames[function] : nullptr;
+}
+
+
+void Functions::resolve(const Context& context) {
+#define GLHEADLESS_RESOLVE_GL_FUNCTION(name, signature) \
+    name = reinterpret_cast<Proc<signature>::Type>(context.getProcAddress("gl" #name));
+    GLHEADLESS_GL_FUNCTIONS(GLHEADLESS_RESOLVE_GL_FUNCTION)
+#undef GLHEADLESS_RESOLVE_GL_FUNCTION
+}
+
+
+bool Functions::hasExtension(const char* name) const {
+    if (GetStringi == nullptr) {
+        return false;
+    }
+
+    GLint count = 0;
+    GetIntegerv(NUM_EXTENSIONS, &count);
+    for (auto i = 0; i < count; ++i) {
+        const auto extension = reinterpret_cast<const char*>(GetStringi(EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension != nullptr && std::strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+}  // namespace gl
+}  // namespace glheadless
@@ -0,0 +1,386 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+#if defined(_WIN32) && !defined(_WIN64)
+#define GLHEADLESS_APIENTRY __stdcall
+#else
+#define GLHEADLESS_APIENTRY
+#endif
+
+
+namespace glheadless {
+
+
+class Context;
+
+
+namespace gl {
+
+
+using GLenum     = unsigned int;
+using GLboolean  = unsigned char;
+using GLbitfield = unsigned int;
+using GLbyte     = signed char;
+using GLubyte    = unsigned char;
+using GLint      = int;
+using GLuint     = unsigned int;
+using GLsizei    = int;
+using GLfloat    = float;
+using GLdouble   = double;
+using GLchar     = char;
+using GLintptr   = std::ptrdiff_t;
+using GLsizeiptr = std::ptrdiff_t;
+using GLint64    = std::int64_t;
+using GLuint64   = std::uint64_t;
+using GLsync     = struct Sync*;
+
+using GLDEBUGPROC = void (GLHEADLESS_APIENTRY*)(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+
+
+const GLenum TRIANGLES                    = 0x0004;
+const GLenum CULL_FACE                    = 0x0B44;
+const GLenum DEPTH_TEST                   = 0x0B71;
+const GLenum STENCIL_TEST                 = 0x0B90;
+const GLenum VIEWPORT                     = 0x0BA2;
+const GLenum DITHER                       = 0x0BD0;
+const GLenum BLEND                        = 0x0BE2;
+const GLenum SCISSOR_BOX                  = 0x0C10;
+const GLenum SCISSOR_TEST                 = 0x0C11;
+const GLenum COLOR_WRITEMASK              = 0x0C23;
+const GLenum UNPACK_ROW_LENGTH            = 0x0CF2;
+const GLenum UNPACK_SKIP_ROWS             = 0x0CF3;
+const GLenum UNPACK_SKIP_PIXELS           = 0x0CF4;
+const GLenum UNPACK_ALIGNMENT             = 0x0CF5;
+const GLenum PACK_ROW_LENGTH              = 0x0D02;
+const GLenum PACK_SKIP_ROWS               = 0x0D03;
+const GLenum PACK_SKIP_PIXELS             = 0x0D04;
+const GLenum PACK_ALIGNMENT               = 0x0D05;
+const GLenum MAX_TEXTURE_SIZE             = 0x0D33;
+const GLenum TEXTURE_2D                   = 0x0DE1;
+const GLenum TEXTURE_WIDTH                = 0x1000;
+const GLenum TEXTURE_HEIGHT               = 0x1001;
+const GLenum DONT_CARE                    = 0x1100;
+const GLenum BYTE                         = 0x1400;
+const GLenum UNSIGNED_BYTE                = 0x1401;
+const GLenum SHORT                        = 0x1402;
+const GLenum UNSIGNED_SHORT               = 0x1403;
+const GLenum INT                          = 0x1404;
+const GLenum UNSIGNED_INT                 = 0x1405;
+const GLenum FLOAT                        = 0x1406;
+const GLenum HALF_FLOAT                   = 0x140B;
+const GLenum STENCIL_INDEX                = 0x1901;
+const GLenum DEPTH_COMPONENT              = 0x1902;
+const GLenum RED                          = 0x1903;
+const GLenum GREEN                        = 0x1904;
+const GLenum BLUE                         = 0x1905;
+const GLenum ALPHA                        = 0x1906;
+const GLenum RGB                          = 0x1907;
+const GLenum RGBA                         = 0x1908;
+const GLenum VENDOR                       = 0x1F00;
+const GLenum RENDERER                     = 0x1F01;
+const GLenum VERSION                      = 0x1F02;
+const GLenum EXTENSIONS                   = 0x1F03;
+const GLenum NEAREST                      = 0x2600;
+const GLenum LINEAR                       = 0x2601;
+const GLenum NEAREST_MIPMAP_NEAREST       = 0x2700;
+const GLenum LINEAR_MIPMAP_LINEAR         = 0x2703;
+const GLenum TEXTURE_MAG_FILTER           = 0x2800;
+const GLenum TEXTURE_MIN_FILTER           = 0x2801;
+const GLenum COLOR_BUFFER_BIT             = 0x00004000;
+const GLenum UNSIGNED_BYTE_3_3_2          = 0x8032;
+const GLenum UNSIGNED_SHORT_4_4_4_4       = 0x8033;
+const GLenum UNSIGNED_SHORT_5_5_5_1       = 0x8034;
+const GLenum UNSIGNED_INT_8_8_8_8         = 0x8035;
+const GLenum UNSIGNED_INT_10_10_10_2      = 0x8036;
+const GLenum POLYGON_OFFSET_FILL          = 0x8037;
+const GLenum RGB8                         = 0x8051;
+const GLenum RGBA8                        = 0x8058;
+const GLenum TEXTURE_BINDING_2D           = 0x8069;
+const GLenum TEXTURE_3D                   = 0x806F;
+const GLenum TEXTURE_DEPTH                = 0x8071;
+const GLenum MULTISAMPLE                  = 0x809D;
+const GLenum SAMPLE_ALPHA_TO_COVERAGE     = 0x809E;
+const GLenum BGR                          = 0x80E0;
+const GLenum BGRA                         = 0x80E1;
+const GLenum TEXTURE_BASE_LEVEL           = 0x813C;
+const GLenum TEXTURE_MAX_LEVEL            = 0x813D;
+const GLenum DEPTH_STENCIL_ATTACHMENT     = 0x821A;
+const GLenum MAJOR_VERSION                = 0x821B;
+const GLenum MINOR_VERSION                = 0x821C;
+const GLenum NUM_EXTENSIONS               = 0x821D;
+const GLenum CONTEXT_FLAGS                = 0x821E;
+const GLenum RG                           = 0x8227;
+const GLenum RG_INTEGER                   = 0x8228;
+const GLenum R8                           = 0x8229;
+const GLenum DEBUG_OUTPUT_SYNCHRONOUS     = 0x8242;
+const GLenum DEBUG_SOURCE_API             = 0x8246;
+const GLenum DEBUG_SOURCE_WINDOW_SYSTEM   = 0x8247;
+const GLenum DEBUG_SOURCE_SHADER_COMPILER = 0x8248;
+const GLenum DEBUG_SOURCE_THIRD_PARTY     = 0x8249;
+const GLenum DEBUG_SOURCE_APPLICATION     = 0x824A;
+const GLenum DEBUG_SOURCE_OTHER           = 0x824B;
+const GLenum DEBUG_TYPE_ERROR             = 0x824C;
+const GLenum DEBUG_TYPE_DEPRECATED_BEHAVIOR = 0x824D;
+const GLenum DEBUG_TYPE_UNDEFINED_BEHAVIOR = 0x824E;
+const GLenum DEBUG_TYPE_PORTABILITY       = 0x824F;
+const GLenum DEBUG_TYPE_PERFORMANCE       = 0x8250;
+const GLenum DEBUG_TYPE_OTHER             = 0x8251;
+const GLenum PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+const GLenum DEBUG_TYPE_MARKER            = 0x8268;
+const GLenum DEBUG_TYPE_PUSH_GROUP        = 0x8269;
+const GLenum DEBUG_TYPE_POP_GROUP         = 0x826A;
+const GLenum DEBUG_SEVERITY_NOTIFICATION  = 0x826B;
+const GLenum UNSIGNED_BYTE_2_3_3_REV      = 0x8362;
+const GLenum UNSIGNED_SHORT_5_6_5         = 0x8363;
+const GLenum UNSIGNED_SHORT_5_6_5_REV     = 0x8364;
+const GLenum UNSIGNED_SHORT_4_4_4_4_REV   = 0x8365;
+const GLenum UNSIGNED_SHORT_1_5_5_5_REV   = 0x8366;
+const GLenum UNSIGNED_INT_8_8_8_8_REV     = 0x8367;
+const GLenum UNSIGNED_INT_2_10_10_10_REV  = 0x8368;
+const GLenum COMPRESSED_RGB_S3TC_DXT1     = 0x83F0;
+const GLenum COMPRESSED_RGBA_S3TC_DXT1    = 0x83F1;
+const GLenum COMPRESSED_RGBA_S3TC_DXT3    = 0x83F2;
+const GLenum COMPRESSED_RGBA_S3TC_DXT5    = 0x83F3;
+const GLenum TEXTURE0                     = 0x84C0;
+const GLenum ACTIVE_TEXTURE               = 0x84E0;
+const GLenum MAX_RENDERBUFFER_SIZE        = 0x84E8;
+const GLenum DEPTH_STENCIL                = 0x84F9;
+const GLenum UNSIGNED_INT_24_8            = 0x84FA;
+const GLenum TEXTURE_CUBE_MAP             = 0x8513;
+const GLenum VERTEX_ARRAY_BINDING         = 0x85B5;
+const GLenum TEXTURE_COMPRESSED_IMAGE_SIZE = 0x86A0;
+const GLenum PROGRAM_BINARY_LENGTH        = 0x8741;
+const GLenum NUM_PROGRAM_BINARY_FORMATS   = 0x87FE;
+const GLenum PROGRAM_BINARY_FORMATS       = 0x87FF;
+const GLenum RGBA32F                      = 0x8814;
+const GLenum QUERY_RESULT                 = 0x8866;
+const GLenum QUERY_RESULT_AVAILABLE       = 0x8867;
+const GLenum ARRAY_BUFFER                 = 0x8892;
+const GLenum ELEMENT_ARRAY_BUFFER         = 0x8893;
+const GLenum STREAM_DRAW                  = 0x88E0;
+const GLenum STREAM_READ                  = 0x88E1;
+const GLenum STATIC_DRAW                  = 0x88E4;
+const GLenum PIXEL_PACK_BUFFER            = 0x88EB;
+const GLenum PIXEL_UNPACK_BUFFER          = 0x88EC;
+const GLenum PIXEL_PACK_BUFFER_BINDING    = 0x88ED;
+const GLenum PIXEL_UNPACK_BUFFER_BINDING  = 0x88EF;
+const GLenum DEPTH24_STENCIL8             = 0x88F0;
+const GLenum UNIFORM_BUFFER               = 0x8A11;
+const GLenum UNIFORM_BUFFER_OFFSET_ALIGNMENT = 0x8A34;
+const GLenum FRAGMENT_SHADER              = 0x8B30;
+const GLenum VERTEX_SHADER                = 0x8B31;
+const GLenum COMPILE_STATUS               = 0x8B81;
+const GLenum LINK_STATUS                  = 0x8B82;
+const GLenum INFO_LOG_LENGTH              = 0x8B84;
+const GLenum SHADING_LANGUAGE_VERSION     = 0x8B8C;
+const GLenum CURRENT_PROGRAM              = 0x8B8D;
+const GLenum TEXTURE_2D_ARRAY             = 0x8C1A;
+const GLenum UNSIGNED_INT_10F_11F_11F_REV = 0x8C3B;
+const GLenum UNSIGNED_INT_5_9_9_9_REV     = 0x8C3E;
+const GLenum COMPRESSED_SRGB_ALPHA_S3TC_DXT1 = 0x8C4D;
+const GLenum COMPRESSED_SRGB_ALPHA_S3TC_DXT3 = 0x8C4E;
+const GLenum COMPRESSED_SRGB_ALPHA_S3TC_DXT5 = 0x8C4F;
+const GLenum RASTERIZER_DISCARD           = 0x8C89;
+const GLenum DRAW_FRAMEBUFFER_BINDING     = 0x8CA6;
+const GLenum READ_FRAMEBUFFER             = 0x8CA8;
+const GLenum DRAW_FRAMEBUFFER             = 0x8CA9;
+const GLenum READ_FRAMEBUFFER_BINDING     = 0x8CAA;
+const GLenum FRAMEBUFFER_COMPLETE         = 0x8CD5;
+const GLenum COLOR_ATTACHMENT0            = 0x8CE0;
+const GLenum FRAMEBUFFER                  = 0x8D40;
+const GLenum RENDERBUFFER                 = 0x8D41;
+const GLenum RED_INTEGER                  = 0x8D94;
+const GLenum RGB_INTEGER                  = 0x8D98;
+const GLenum RGBA_INTEGER                 = 0x8D99;
+const GLenum BGR_INTEGER                  = 0x8D9A;
+const GLenum BGRA_INTEGER                 = 0x8D9B;
+const GLenum FLOAT_32_UNSIGNED_INT_24_8_REV = 0x8DAD;
+const GLenum FRAMEBUFFER_SRGB             = 0x8DB9;
+const GLenum COMPRESSED_RED_RGTC1         = 0x8DBB;
+const GLenum COMPRESSED_SIGNED_RED_RGTC1  = 0x8DBC;
+const GLenum COMPRESSED_RG_RGTC2          = 0x8DBD;
+const GLenum COMPRESSED_SIGNED_RG_RGTC2   = 0x8DBE;
+const GLenum TIMESTAMP                    = 0x8E28;
+const GLenum COMPRESSED_RGBA_BPTC_UNORM   = 0x8E8C;
+const GLenum COMPRESSED_SRGB_ALPHA_BPTC_UNORM = 0x8E8D;
+const GLenum COMPRESSED_RGB_BPTC_SIGNED_FLOAT = 0x8E8E;
+const GLenum COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT = 0x8E8F;
+const GLenum COPY_READ_BUFFER             = 0x8F36;
+const GLenum COPY_WRITE_BUFFER            = 0x8F37;
+const GLenum DRAW_INDIRECT_BUFFER         = 0x8F3F;
+const GLenum PRIMITIVE_RESTART            = 0x8F9D;
+const GLenum SYNC_GPU_COMMANDS_COMPLETE   = 0x9117;
+const GLenum ALREADY_SIGNALED             = 0x911A;
+const GLenum TIMEOUT_EXPIRED              = 0x911B;
+const GLenum CONDITION_SATISFIED          = 0x911C;
+const GLenum WAIT_FAILED                  = 0x911D;
+const GLenum DEBUG_SEVERITY_HIGH          = 0x9146;
+const GLenum DEBUG_SEVERITY_MEDIUM        = 0x9147;
+const GLenum DEBUG_SEVERITY_LOW           = 0x9148;
+const GLenum MAX_SHADER_COMPILER_THREADS  = 0x91B0;
+const GLenum COMPLETION_STATUS            = 0x91B1;
+const GLenum DEBUG_OUTPUT                 = 0x92E0;
+const GLenum MAP_READ_BIT                 = 0x0001;
+const GLenum MAP_WRITE_BIT                = 0x0002;
+const GLenum MAP_INVALIDATE_RANGE_BIT     = 0x0004;
+const GLenum MAP_INVALIDATE_BUFFER_BIT    = 0x0008;
+const GLenum MAP_UNSYNCHRONIZED_BIT       = 0x0020;
+const GLenum MAP_PERSISTENT_BIT           = 0x0040;
+const GLenum MAP_COHERENT_BIT             = 0x0080;
+const GLenum SYNC_FLUSH_COMMANDS_BIT      = 0x0001;
+
+const GLuint64 TIMEOUT_IGNORED = 0xFFFFFFFFFFFFFFFFull;
+
+
+/*
+ * Entry points used by the library itself and recorded by traces, as F(name, signature). The name is the GL function
+ * name without the "gl" prefix. Extend this list instead of resolving functions ad hoc; each entry needs a codec in
+ * Trace.cpp.
+ */
+#define GLHEADLESS_GL_FUNCTIONS(F) \
+    F(ActiveTexture,            void(GLenum)) \
+    F(AttachShader,             void(GLuint, GLuint)) \
+    F(BindBuffer,               void(GLenum, GLuint)) \
+    F(BindBufferBase,           void(GLenum, GLuint, GLuint)) \
+    F(BindBufferRange,          void(GLenum, GLuint, GLuint, GLintptr, GLsizeiptr)) \
+    F(BindFramebuffer,          void(GLenum, GLuint)) \
+    F(BindRenderbuffer,         void(GLenum, GLuint)) \
+    F(BindTexture,              void(GLenum, GLuint)) \
+    F(BindVertexArray,          void(GLuint)) \
+    F(BlendEquation,            void(GLenum)) \
+    F(BlendEquationSeparate,    void(GLenum, GLenum)) \
+    F(BlendFunc,                void(GLenum, GLenum)) \
+    F(BlendFuncSeparate,        void(GLenum, GLenum, GLenum, GLenum)) \
+    F(BlitFramebuffer,          void(GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLbitfield, GLenum)) \
+    F(BufferData,               void(GLenum, GLsizeiptr, const void*, GLenum)) \
+    F(BufferStorage,            void(GLenum, GLsizeiptr, const void*, GLbitfield)) \
+    F(BufferSubData,            void(GLenum, GLintptr, GLsizeiptr, const void*)) \
+    F(CheckFramebufferStatus,   GLenum(GLenum)) \
+    F(Clear,                    void(GLbitfield)) \
+    F(ClearColor,               void(GLfloat, GLfloat, GLfloat, GLfloat)) \
+    F(ClientWaitSync,           GLenum(GLsync, GLbitfield, GLuint64)) \
+    F(ColorMask,                void(GLboolean, GLboolean, GLboolean, GLboolean)) \
+    F(CompileShader,            void(GLuint)) \
+    F(CompressedTexImage2D,     void(GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei, const void*)) \
+    F(CopyBufferSubData,        void(GLenum, GLenum, GLintptr, GLintptr, GLsizeiptr)) \
+    F(CopyTexSubImage2D,        void(GLenum, GLint, GLint, GLint, GLint, GLint, GLsizei, GLsizei)) \
+    F(CreateProgram,            GLuint()) \
+    F(CreateShader,             GLuint(GLenum)) \
+    F(CullFace,                 void(GLenum)) \
+    F(DebugMessageCallback,     void(GLDEBUGPROC, const void*)) \
+    F(DebugMessageControl,      void(GLenum, GLenum, GLenum, GLsizei, const GLuint*, GLboolean)) \
+    F(DebugMessageInsert,       void(GLenum, GLenum, GLuint, GLenum, GLsizei, const GLchar*)) \
+    F(DeleteBuffers,            void(GLsizei, const GLuint*)) \
+    F(DeleteFramebuffers,       void(GLsizei, const GLuint*)) \
+    F(DeleteProgram,            void(GLuint)) \
+    F(DeleteQueries,            void(GLsizei, const GLuint*)) \
+    F(DeleteRenderbuffers,      void(GLsizei, const GLuint*)) \
+    F(DeleteShader,             void(GLuint)) \
+    F(DeleteSync,               void(GLsync)) \
+    F(DeleteTextures,           void(GLsizei, const GLuint*)) \
+    F(DeleteVertexArrays,       void(GLsizei, const GLuint*)) \
+    F(DepthFunc,                void(GLenum)) \
+    F(DepthMask,                void(GLboolean)) \
+    F(Disable,                  void(GLenum)) \
+    F(DisableVertexAttribArray, void(GLuint)) \
+    F(DrawArrays,               void(GLenum, GLint, GLsizei)) \
+    F(DrawArraysInstanced,      void(GLenum, GLint, GLsizei, GLsizei)) \
+    F(DrawElements,             void(GLenum, GLsizei, GLenum, const void*)) \
+    F(DrawElementsInstanced,    void(GLenum, GLsizei, GLenum, const void*, GLsizei)) \
+    F(Enable,                   void(GLenum)) \
+    F(EnableVertexAttribArray,  void(GLuint)) \
+    F(FenceSync,                GLsync(GLenum, GLbitfield)) \
+    F(Finish,                   void()) \
+    F(Flush,                    void()) \
+    F(FramebufferRenderbuffer,  void(GLenum, GLenum, GLenum, GLuint)) \
+    F(FramebufferTexture2D,     void(GLenum, GLenum, GLenum, GLuint, GLint)) \
+    F(FrontFace,                void(GLenum)) \
+    F(GenBuffers,               void(GLsizei, GLuint*)) \
+    F(GenerateMipmap,           void(GLenum)) \
+    F(GenFramebuffers,          void(GLsizei, GLuint*)) \
+    F(GenQueries,               void(GLsizei, GLuint*)) \
+    F(GenRenderbuffers,         void(GLsizei, GLuint*)) \
+    F(GenTextures,              void(GLsizei, GLuint*)) \
+    F(GenVertexArrays,          void(GLsizei, GLuint*)) \
+    F(GetBooleanv,              void(GLenum, GLboolean*)) \
+    F(GetBufferSubData,         void(GLenum, GLintptr, GLsizeiptr, void*)) \
+    F(GetCompressedTexImage,    void(GLenum, GLint, void*)) \
+    F(GetError,                 GLenum()) \
+    F(GetIntegerv,              void(GLenum, GLint*)) \
+    F(GetProgramBinary,         void(GLuint, GLsizei, GLsizei*, GLenum*, void*)) \
+    F(GetProgramInfoLog,        void(GLuint, GLsizei, GLsizei*, GLchar*)) \
+    F(GetProgramiv,             void(GLuint, GLenum, GLint*)) \
+    F(GetQueryObjectiv,         void(GLuint, GLenum, GLint*)) \
+    F(GetQueryObjectui64v,      void(GLuint, GLenum, GLuint64*)) \
+    F(GetShaderInfoLog,         void(GLuint, GLsizei, GLsizei*, GLchar*)) \
+    F(GetShaderiv,              void(GLuint, GLenum, GLint*)) \
+    F(GetString,                const GLubyte*(GLenum)) \
+    F(GetStringi,               const GLubyte*(GLenum, GLuint)) \
+    F(GetTexImage,              void(GLenum, GLint, GLenum, GLenum, void*)) \
+    F(GetTexLevelParameteriv,   void(GLenum, GLint, GLenum, GLint*)) \
+    F(GetUniformLocation,       GLint(GLuint, const GLchar*)) \
+    F(IsEnabled,                GLboolean(GLenum)) \
+    F(LinkProgram,              void(GLuint)) \
+    F(MapBufferRange,           void*(GLenum, GLintptr, GLsizeiptr, GLbitfield)) \
+    F(MaxShaderCompilerThreadsKHR, void(GLuint)) \
+    F(PixelStorei,              void(GLenum, GLint)) \
+    F(ProgramBinary,            void(GLuint, GLenum, const void*, GLsizei)) \
+    F(ProgramParameteri,        void(GLuint, GLenum, GLint)) \
+    F(QueryCounter,             void(GLuint, GLenum)) \
+    F(ReadPixels,               void(GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, void*)) \
+    F(RenderbufferStorage,      void(GLenum, GLenum, GLsizei, GLsizei)) \
+    F(Scissor,                  void(GLint, GLint, GLsizei, GLsizei)) \
+    F(ShaderSource,             void(GLuint, GLsizei, const GLchar* const*, const GLint*)) \
+    F(TexImage2D,               void(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const void*)) \
+    F(TexParameteri,            void(GLenum, GLenum, GLint)) \
+    F(TexSubImage2D,            void(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, const void*)) \
+    F(Uniform1f,                void(GLint, GLfloat)) \
+    F(Uniform1i,                void(GLint, GLint)) \
+    F(Uniform2i,                void(GLint, GLint, GLint)) \
+    F(Uniform4f,                void(GLint, GLfloat, GLfloat, GLfloat, GLfloat)) \
+    F(UnmapBuffer,              GLboolean(GLenum)) \
+    F(UseProgram,               void(GLuint)) \
+    F(VertexAttribPointer,      void(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*)) \
+    F(Viewport,                 void(GLint, GLint, GLsizei, GLsizei)) \
+    F(WaitSync,                 void(GLsync, GLbitfield, GLuint64))
+
+
+// index of each entry point of GLHEADLESS_GL_FUNCTIONS, e.g., into per-function tables
+enum Function : std::uint16_t {
+#define GLHEADLESS_DECLARE_GL_FUNCTION_INDEX(name, signature) FUNCTION_##name,
+    GLHEADLESS_GL_FUNCTIONS(GLHEADLESS_DECLARE_GL_FUNCTION_INDEX)
+#undef GLHEADLESS_DECLARE_GL_FUNCTION_INDEX
+    FUNCTION_COUNT
+};
+
+
+// the name of a function including the "gl" prefix, nullptr if the index is out of range
+const char* functionName(std::size_t function);
+
+
+template <typename Signature>
+struct Proc;
+
+template <typename Result, typename... Arguments>
+struct Proc<Result(Arguments...)> {
+    using Type = Result (GLHEADLESS_APIENTRY*)(Arguments...);
+};
+
+
+struct Functions {
+#define GLHEADLESS_DECLARE_GL_FUNCTION(name, signature) Proc<signature>::Type name = nullptr;
+    GLHEADLESS_GL_FUNCTIONS(GLHEADLESS_DECLARE_GL_FUNCTION)
+#undef GLHEADLESS_DECLARE_GL_FUNCTION
+
+    void resolve(const Context& context);
+
+    // checks the extension list of the current context (OpenGL 3.0 and later)
+    bool hasExtension(const char* name) const;
+};
+
+
+}  // namespace gl
+}  // namespace glheadless
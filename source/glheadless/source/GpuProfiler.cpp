@@ -0,0 +1,278 @@
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+#include <glheadless/Context.h>
+#include <glheadless/error.h>
+
+#include "InternalException.h"
+
+
+namespace glheadless {
+namespace gl {
+
+
+namespace {
+
+
+const GLsizei     k_queryBatch         = 32;
+const std::size_t k_maxPendingFrames   = 16;
+const std::size_t k_maxCompletedFrames = 256;
+
+
+// merged scopes of a frame while resolving
+struct Node {
+    std::string              name;
+    std::uint64_t            count;
+    GLuint64                 nanoseconds;
+    std::vector<std::size_t> children;
+};
+
+
+// the node of a name among the children of a node or the roots, created if there is none yet
+std::size_t child(std::vector<Node>& nodes, std::vector<std::size_t>& roots, std::size_t parent, const std::string& name) {
+    auto& siblings = parent == k_noParentScope ? roots : nodes[parent].children;
+    for (const auto sibling : siblings) {
+        if (nodes[sibling].name == name) {
+            return sibling;
+        }
+    }
+
+    // siblings refers into nodes, so it is extended first
+    const auto index = nodes.size();
+    siblings.push_back(index);
+
+    Node node;
+    node.name = name;
+    node.count = 0;
+    node.nanoseconds = 0;
+    nodes.push_back(std::move(node));
+    return index;
+}
+
+
+void flatten(const std::vector<Node>& nodes, const std::vector<std::size_t>& siblings, std::size_t parent, unsigned int depth, std::vector<GpuScopeTiming>& scopes) {
+    for (const auto index : siblings) {
+        const auto& node = nodes[index];
+        GpuScopeTiming scope;
+        scope.name = node.name;
+        scope.parent = parent;
+        scope.depth = depth;
+        scope.count = node.count;
+        scope.milliseconds = static_cast<double>(node.nanoseconds) / 1.0e6;
+        scopes.push_back(std::move(scope));
+        flatten(nodes, node.children, scopes.size() - 1, depth + 1, scopes);
+    }
+}
+
+
+}  // unnamed namespace
+
+
+GpuProfiler::GpuProfiler(std::size_t frameLatency)
+: m_frameLatency(frameLatency)
+, m_active(false)
+, m_frameCount(0) {
+    m_frame.number = 0;
+    m_frame.last = 0;
+}
+
+
+void GpuProfiler::install(const Functions& gl) {
+    GLint major = 0;
+    GLint minor = 0;
+    gl.GetIntegerv(MAJOR_VERSION, &major);
+    gl.GetIntegerv(MINOR_VERSION, &minor);
+    const auto core = major > 3 || (major == 3 && minor >= 3);
+    if (gl.QueryCounter == nullptr || gl.GetQueryObjectui64v == nullptr || (!core && !gl.hasExtension("GL_ARB_timer_query"))) {
+        throw InternalException(Error::UNSUPPORTED_FEATURE, "GPU profiling requires OpenGL 3.3 or GL_ARB_timer_query");
+    }
+    m_active = true;
+}
+
+
+void GpuProfiler::finish(const Functions& gl) {
+    m_active = false;
+    m_open.clear();
+    recycle(m_frame);
+
+    // reading the results waits for the GPU
+    while (!m_pending.empty()) {
+        resolve(gl, m_pending.front());
+        m_pending.pop_front();
+    }
+
+    if (!m_freeQueries.empty()) {
+        gl.DeleteQueries(static_cast<GLsizei>(m_freeQueries.size()), m_freeQueries.data());
+    }
+    m_freeQueries.clear();
+    m_spareFrames.clear();
+}
+
+
+bool GpuProfiler::active() const {
+    return m_active;
+}
+
+
+void GpuProfiler::begin(const Functions& gl, const char* name) {
+    Scope scope;
+    scope.name = name != nullptr ? name : "";
+    scope.parent = m_open.empty() ? k_noParentScope : m_open.back();
+    scope.begin = query(gl);
+    scope.end = 0;
+    gl.QueryCounter(scope.begin, TIMESTAMP);
+
+    m_open.push_back(m_frame.scopes.size());
+    m_frame.scopes.push_back(std::move(scope));
+}
+
+
+void GpuProfiler::end(const Functions& gl) {
+    if (m_open.empty()) {
+        throw InternalException(Error::INVALID_ARGUMENT, "No GPU scope is open");
+    }
+
+    auto& scope = m_frame.scopes[m_open.back()];
+    m_open.pop_back();
+    scope.end = query(gl);
+    gl.QueryCounter(scope.end, TIMESTAMP);
+    m_frame.last = scope.end;
+}
+
+
+void GpuProfiler::endFrame(const Functions& gl) {
+    if (!m_open.empty()) {
+        throw InternalException(Error::INVALID_ARGUMENT, "GPU scope \"" + m_frame.scopes[m_open.back()].name + "\" is still open");
+    }
+
+    m_pending.push_back(std::move(m_frame));
+    ++m_frameCount;
+    if (!m_spareFrames.empty()) {
+        m_frame = std::move(m_spareFrames.back());
+        m_spareFrames.pop_back();
+    } else {
+        m_frame = Frame();
+    }
+    m_frame.number = m_frameCount;
+    m_frame.scopes.clear();
+    m_frame.last = 0;
+
+    // results arrive in order, so the first frame not available ends the reading
+    while (!m_pending.empty() && m_frameCount - m_pending.front().number > m_frameLatency && available(gl, m_pending.front())) {
+        resolve(gl, m_pending.front());
+        m_spareFrames.push_back(std::move(m_pending.front()));
+        m_pending.pop_front();
+    }
+
+    while (m_pending.size() > k_maxPendingFrames) {
+        recycle(m_pending.front());
+        m_pending.pop_front();
+    }
+}
+
+
+std::vector<GpuFrameTimings> GpuProfiler::take() {
+    std::vector<GpuFrameTimings> frames(std::make_move_iterator(m_completed.begin()), std::make_move_iterator(m_completed.end()));
+    m_completed.clear();
+    return frames;
+}
+
+
+GLuint GpuProfiler::query(const Functions& gl) {
+    if (m_freeQueries.empty()) {
+        m_freeQueries.resize(k_queryBatch);
+        gl.GenQueries(k_queryBatch, m_freeQueries.data());
+    }
+
+    const auto query = m_freeQueries.back();
+    m_freeQueries.pop_back();
+    return query;
+}
+
+
+bool GpuProfiler::available(const Functions& gl, const Frame& frame) const {
+    if (frame.last == 0) {
+        return true;
+    }
+
+    GLint available = 0;
+    gl.GetQueryObjectiv(frame.last, QUERY_RESULT_AVAILABLE, &available);
+    return available != 0;
+}
+
+
+void GpuProfiler::resolve(const Functions& gl, Frame& frame) {
+    GpuFrameTimings timings;
+    timings.frame = frame.number;
+
+    std::vector<Node> nodes;
+    std::vector<std::size_t> roots;
+    std::vector<std::size_t> nodeOfScope(frame.scopes.size());
+    auto first = std::numeric_limits<GLuint64>::max();
+    GLuint64 last = 0;
+    for (std::size_t i = 0; i < frame.scopes.size(); ++i) {
+        const auto& scope = frame.scopes[i];
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        gl.GetQueryObjectui64v(scope.begin, QUERY_RESULT, &begin);
+        gl.GetQueryObjectui64v(scope.end, QUERY_RESULT, &end);
+
+        // the parent's node exists, as scopes are in begin order
+        const auto node = child(nodes, roots, scope.parent == k_noParentScope ? k_noParentScope : nodeOfScope[scope.parent], scope.name);
+        nodeOfScope[i] = node;
+        nodes[node].count += 1;
+        nodes[node].nanoseconds += end > begin ? end - begin : 0;
+
+        if (scope.parent == k_noParentScope) {
+            first = std::min(first, begin);
+            last = std::max(last, end);
+        }
+    }
+
+    flatten(nodes, roots, k_noParentScope, 0, timings.scopes);
+    timings.milliseconds = last > first ? static_cast<double>(last - first) / 1.0e6 : 0.0;
+    complete(std::move(timings));
+    recycle(frame);
+}
+
+
+void GpuProfiler::recycle(Frame& frame) {
+    for (const auto& scope : frame.scopes) {
+        m_freeQueries.push_back(scope.begin);
+        if (scope.end != 0) {
+            m_freeQueries.push_back(scope.end);
+        }
+    }
+    frame.scopes.clear();
+    frame.last = 0;
+}
+
+
+void GpuProfiler::complete(GpuFrameTimings&& timings) {
+    m_completed.push_back(std::move(timings));
+    if (m_completed.size() > k_maxCompletedFrames) {
+        m_completed.pop_front();
+    }
+}
+
+
+}  // namespace gl
+
+
+GpuScope::GpuScope(Context& context, const char* name)
+: m_context(context)
+, m_begun(context.beginGpuScope(name)) {
+}
+
+
+GpuScope::~GpuScope() {
+    if (m_begun) {
+        m_context.endGpuScope();
+    }
+}
+
+
+}  // namespace glheadless
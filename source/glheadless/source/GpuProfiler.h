@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <glheadless/GpuProfiling.h>
+
+#include "GLFunctions.h"
+
+
+namespace glheadless {
+namespace gl {
+
+
+/*
+ * GPU profiling of one context. Both boundaries of a scope are GL_TIMESTAMP queries, which, unlike GL_TIME_ELAPSED
+ * queries, may nest. Query objects come from a free list that grows in batches and takes back the queries of a frame
+ * once its results were read. Ended frames wait in a queue until they are old enough and their last query, which
+ * completes after all others of the frame, reports its result as available. All functions require the context to be
+ * current and throw InternalException on misuse.
+ */
+class GpuProfiler {
+public:
+    explicit GpuProfiler(std::size_t frameLatency);
+
+    // checks for timer query support
+    void install(const Functions& gl);
+
+    // waits for the results of the ended frames, discards the current one and deletes all queries
+    void finish(const Functions& gl);
+
+    bool active() const;
+
+    void begin(const Functions& gl, const char* name);
+    void end(const Functions& gl);
+    void endFrame(const Functions& gl);
+
+    std::vector<GpuFrameTimings> take();
+
+
+private:
+    struct Scope {
+        std::string name;
+        std::size_t parent;  // index in Frame::scopes, k_noParentScope if none
+        GLuint      begin;
+        GLuint      end;     // 0 while open
+    };
+
+    struct Frame {
+        std::uint64_t      number;
+        std::vector<Scope> scopes;   // in begin order
+        GLuint             last;     // query issued last, 0 if none
+    };
+
+    GLuint query(const Functions& gl);
+    bool available(const Functions& gl, const Frame& frame) const;
+    void resolve(const Functions& gl, Frame& frame);
+    void recycle(Frame& frame);
+    void complete(GpuFrameTimings&& timings);
+
+
+private:
+    std::size_t                 m_frameLatency;
+    bool                        m_active;
+    std::vector<GLuint>         m_freeQueries;
+    Frame                       m_frame;       // being recorded
+    std::vector<std::size_t>    m_open;        // indices of the open scopes of m_frame
+    std::deque<Frame>           m_pending;     // ended, results not read yet
+    std::vector<Frame>          m_spareFrames; // recycled, to reuse their allocations
+    std::deque<GpuFrameTimings> m_completed;
+    std::uint64_t               m_frameCount;
+};
+
+
+}  // namespace gl
+}  // namespace glheadless
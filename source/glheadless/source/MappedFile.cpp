@@ -0,0 +1,123 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <glheadless/error.h>
+
+#include "InternalException.h"
+
+
+namespace glheadless {
+
+
+#ifdef _WIN32
+
+
+MappedFile::MappedFile(const std::string& path)
+: m_data(nullptr)
+, m_size(0)
+, m_file(INVALID_HANDLE_VALUE)
+, m_mapping(nullptr) {
+    m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        throw InternalException(Error::INVALID_ARGUMENT, "Cannot open " + path);
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+        CloseHandle(m_file);
+        throw InternalException(Error::INVALID_ARGUMENT, path + " is empty");
+    }
+
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const auto view = m_mapping != nullptr ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (view == nullptr) {
+        if (m_mapping != nullptr) {
+            CloseHandle(m_mapping);
+        }
+        CloseHandle(m_file);
+        throw InternalException(Error::INVALID_ARGUMENT, "Cannot map " + path);
+    }
+
+    m_data = static_cast<const unsigned char*>(view);
+    m_size = static_cast<std::size_t>(size.QuadPart);
+}
+
+
+MappedFile::~MappedFile() {
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+}
+
+
+void MappedFile::release() {
+    // views cannot drop their pages without unmapping; the working set manager trims them under memory pressure
+}
+
+
+#else
+
+
+MappedFile::MappedFile(const std::string& path)
+: m_data(nullptr)
+, m_size(0) {
+    const auto file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        throw InternalException(Error::INVALID_ARGUMENT, "Cannot open " + path);
+    }
+
+    struct stat status;
+    if (::fstat(file, &status) != 0 || status.st_size == 0) {
+        ::close(file);
+        throw InternalException(Error::INVALID_ARGUMENT, path + " is empty");
+    }
+
+    // the mapping keeps the file referenced, so the descriptor is not needed afterwards
+    const auto size = static_cast<std::size_t>(status.st_size);
+    const auto data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (data == MAP_FAILED) {
+        throw InternalException(Error::INVALID_ARGUMENT, "Cannot map " + path);
+    }
+
+    // levels are read front to back exactly once, so read ahead aggressively and let the kernel drop pages behind
+    ::madvise(data, size, MADV_SEQUENTIAL);
+
+    m_data = static_cast<const unsigned char*>(data);
+    m_size = size;
+}
+
+
+MappedFile::~MappedFile() {
+    ::munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+
+void MappedFile::release() {
+    // the pages are clean and file-backed, so they stay in the page cache and are not written anywhere
+    ::madvise(const_cast<unsigned char*>(m_data), m_size, MADV_DONTNEED);
+}
+
+
+#endif
+
+
+const unsigned char* MappedFile::data() const {
+    return m_data;
+}
+
+
+std::size_t MappedFile::size() const {
+    return m_size;
+}
+
+
+}  // namespace glheadless
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+
+namespace glheadless {
+
+
+/*
+ * Read-only memory mapping of a whole file. Pages are faulted in from the page cache on access, so no copy of the file
+ * is made in process memory. Throws InternalException if the file cannot be mapped.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const unsigned char* data() const;
+    std::size_t size() const;
+
+    // drops the mapped pages from the resident set; they are faulted in again if accessed later
+    void release();
+
+    MappedFile& operator=(const MappedFile&) = delete;
+
+
+private:
+    const unsigned char* m_data;
+    std::size_t          m_size;
+#ifdef _WIN32
+    void*                m_file;
+    void*                m_mapping;
+#endif
+};
+
+
+}  // namespace glheadless
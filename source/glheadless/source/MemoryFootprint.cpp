@@ -0,0 +1,168 @@
+#include <glheadless/MemoryFootprint.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+// contexts per measurement; the growth is averaged over them, as drivers allocate in chunks
+const std::size_t k_footprintSampleCount = 8;
+
+
+using FootprintKey = std::tuple<unsigned int, unsigned int, ContextProfile, bool, bool>;
+
+
+#ifdef __linux__
+
+
+bool readSmapsRollup(MemoryUsage& usage) {
+    std::ifstream file("/proc/self/smaps_rollup");
+    if (!file) {
+        return false;
+    }
+
+    auto found = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::string key;
+        std::uint64_t kilobytes = 0;
+        if (!(stream >> key >> kilobytes)) {
+            continue;
+        }
+        if (key == "Rss:") {
+            usage.rssBytes = kilobytes * 1024;
+            ++found;
+        } else if (key == "Pss:") {
+            usage.pssBytes = kilobytes * 1024;
+            ++found;
+        }
+    }
+    return found == 2;
+}
+
+
+bool readStatm(MemoryUsage& usage) {
+    std::ifstream file("/proc/self/statm");
+    std::uint64_t size = 0;
+    std::uint64_t resident = 0;
+    if (!(file >> size >> resident)) {
+        return false;
+    }
+
+    usage.rssBytes = resident * static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+    usage.pssBytes = 0;
+    return true;
+}
+
+
+#endif
+
+
+ContextFootprint measure(const ContextFormat& format, bool shared) {
+    ContextFootprint footprint;
+
+    // the first context on the thread takes the one-time allocations, and shared contexts share with it
+    auto first = ContextFactory::create(format);
+    if (!first->valid() || !first->makeCurrent()) {
+        return footprint;
+    }
+    first->doneCurrent();
+
+#ifdef __GLIBC__
+    // otherwise the contexts may reuse memory freed before, e.g., by destroyed contexts, without growing the process
+    malloc_trim(0);
+#endif
+
+    MemoryUsage before;
+    if (!processMemoryUsage(before)) {
+        return footprint;
+    }
+
+    std::vector<std::unique_ptr<Context>> contexts;
+    for (std::size_t i = 0; i < k_footprintSampleCount; ++i) {
+        auto context = shared ? ContextFactory::create(first.get(), format) : ContextFactory::create(format);
+        if (!context->valid() || !context->makeCurrent()) {
+            return footprint;
+        }
+        context->doneCurrent();
+        contexts.push_back(std::move(context));
+    }
+
+    MemoryUsage after;
+    if (!processMemoryUsage(after)) {
+        return footprint;
+    }
+
+    const auto count = static_cast<std::int64_t>(k_footprintSampleCount);
+    footprint.rssBytes = (static_cast<std::int64_t>(after.rssBytes) - static_cast<std::int64_t>(before.rssBytes)) / count;
+    footprint.pssBytes = (static_cast<std::int64_t>(after.pssBytes) - static_cast<std::int64_t>(before.pssBytes)) / count;
+    footprint.sampleCount = k_footprintSampleCount;
+    return footprint;
+}
+
+
+}  // unnamed namespace
+
+
+bool processMemoryUsage(MemoryUsage& usage) {
+#ifdef __linux__
+    return readSmapsRollup(usage) || readStatm(usage);
+#else
+    (void)usage;
+    return false;
+#endif
+}
+
+
+ContextFootprint approximateFootprint(const ContextFormat& format, bool shared) {
+    static std::mutex s_mutex;
+    static std::map<FootprintKey, ContextFootprint> s_footprints;
+
+    const auto key = FootprintKey(format.versionMajor, format.versionMinor, format.profile, format.debug, shared);
+
+    // measurements run one at a time, so that they do not distort each other
+    std::lock_guard<std::mutex> lock(s_mutex);
+    const auto cached = s_footprints.find(key);
+    if (cached != s_footprints.end()) {
+        return cached->second;
+    }
+
+    // contexts are destroyed on the thread that created them, so the whole measurement runs on its own thread
+    ContextFootprint footprint;
+    std::thread thread([&footprint, &format, shared] {
+        footprint = measure(format, shared);
+    });
+    thread.join();
+
+    if (footprint.sampleCount > 0) {
+        s_footprints[key] = footprint;
+    }
+    return footprint;
+}
+
+
+}  // namespace glheadless
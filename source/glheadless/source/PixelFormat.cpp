@@ -0,0 +1,37 @@
+#include <glheadless/PixelFormat.h>
+
+
+namespace glheadless {
+
+
+std::size_t bytesPerPixel(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::RGBA8:
+        case PixelFormat::BGRA8:
+            return 4;
+        case PixelFormat::RGB8:
+        case PixelFormat::BGR8:
+            return 3;
+        case PixelFormat::R8:
+        case PixelFormat::LUMA8:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+
+std::size_t imageSize(PixelFormat format, unsigned int width, unsigned int height) {
+    const auto pixels = static_cast<std::size_t>(width) * height;
+
+    switch (format) {
+        case PixelFormat::I420:
+        case PixelFormat::NV12:
+            return pixels + 2 * ((width / 2) * static_cast<std::size_t>(height / 2));
+        default:
+            return pixels * bytesPerPixel(format);
+    }
+}
+
+
+}  // namespace glheadless
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+
+namespace glheadless {
+namespace pixel {
+
+
+/*
+ * Kernel table of one instruction set. All kernels support source == destination; packRGB additionally relies on
+ * writing strictly behind the read position.
+ */
+struct Kernels {
+    void (*swizzle)(const unsigned char* source, unsigned char* destination, std::size_t pixels, const unsigned char* order);
+    void (*packRGB)(const unsigned char* source, unsigned char* destination, std::size_t pixels, bool swapRedBlue);
+    void (*premultiplyAlpha)(const unsigned char* source, unsigned char* destination, std::size_t pixels);
+    void (*unpremultiplyAlpha)(const unsigned char* source, unsigned char* destination, std::size_t pixels);
+};
+
+
+// scalar kernels, also used for the tails of the vectorized kernels
+void swizzleScalar(const unsigned char* source, unsigned char* destination, std::size_t pixels, const unsigned char* order);
+void packRGBScalar(const unsigned char* source, unsigned char* destination, std::size_t pixels, bool swapRedBlue);
+void premultiplyAlphaScalar(const unsigned char* source, unsigned char* destination, std::size_t pixels);
+void unpremultiplyAlphaScalar(const unsigned char* source, unsigned char* destination, std::size_t pixels);
+
+
+// kernel tables, nullptr if the instruction set is not available in this build
+const Kernels* scalarKernels();
+const Kernels* ssse3Kernels();
+const Kernels* avx2Kernels();
+const Kernels* neonKernels();
+
+
+}  // namespace pixel
+}  // namespace glheadless
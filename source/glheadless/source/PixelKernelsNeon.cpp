@@ -0,0 +1,137 @@
+#include "PixelKernels.h"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define GLHEADLESS_PIXEL_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+
+namespace glheadless {
+namespace pixel {
+
+
+#ifdef GLHEADLESS_PIXEL_KERNELS_NEON
+
+
+namespace {
+
+
+/*
+ * The kernels process 16 pixels per iteration. Loads and stores (de-)interleave the channels, so the arithmetic
+ * works on one channel per register.
+ */
+
+// round(color * alpha / 255), see divide255() of the scalar kernels
+inline uint8x16_t premultiply(uint8x16_t color, uint8x16_t alpha) {
+    const auto low = vmull_u8(vget_low_u8(color), vget_low_u8(alpha));
+    const auto high = vmull_high_u8(color, alpha);
+    return vcombine_u8(vrshrn_n_u16(vrsraq_n_u16(low, low, 8), 8), vrshrn_n_u16(vrsraq_n_u16(high, high, 8), 8));
+}
+
+
+// (color * 255 + alpha / 2) / alpha for 4 pixels; the quotient is exact, as float division is correctly rounded
+inline uint32x4_t unpremultiply(uint32x4_t color, uint32x4_t alpha) {
+    const auto numerator = vcvtq_f32_u32(vmlaq_n_u32(vshrq_n_u32(alpha, 1), color, 255));
+    const auto divisor = vcvtq_f32_u32(vmaxq_u32(alpha, vdupq_n_u32(1)));
+    const auto quotient = vminq_u32(vcvtq_u32_f32(vdivq_f32(numerator, divisor)), vdupq_n_u32(255));
+    return vbicq_u32(quotient, vceqq_u32(alpha, vdupq_n_u32(0)));
+}
+
+
+inline uint8x16_t unpremultiply(uint8x16_t color, uint8x16_t alpha) {
+    const auto color16Low = vmovl_u8(vget_low_u8(color));
+    const auto color16High = vmovl_high_u8(color);
+    const auto alpha16Low = vmovl_u8(vget_low_u8(alpha));
+    const auto alpha16High = vmovl_high_u8(alpha);
+
+    const auto low = vcombine_u16(
+        vmovn_u32(unpremultiply(vmovl_u16(vget_low_u16(color16Low)), vmovl_u16(vget_low_u16(alpha16Low)))),
+        vmovn_u32(unpremultiply(vmovl_high_u16(color16Low), vmovl_high_u16(alpha16Low))));
+    const auto high = vcombine_u16(
+        vmovn_u32(unpremultiply(vmovl_u16(vget_low_u16(color16High)), vmovl_u16(vget_low_u16(alpha16High)))),
+        vmovn_u32(unpremultiply(vmovl_high_u16(color16High), vmovl_high_u16(alpha16High))));
+    return vcombine_u8(vmovn_u16(low), vmovn_u16(high));
+}
+
+
+void swizzleNEON(const unsigned char* source, unsigned char* destination, std::size_t pixels, const unsigned char* order) {
+    unsigned char indices[16];
+    for (auto i = 0; i < 16; ++i) {
+        indices[i] = static_cast<unsigned char>((i & ~3) + order[i & 3]);
+    }
+    const auto mask = vld1q_u8(indices);
+
+    std::size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        vst1q_u8(destination + i * 4, vqtbl1q_u8(vld1q_u8(source + i * 4), mask));
+    }
+
+    swizzleScalar(source + i * 4, destination + i * 4, pixels - i, order);
+}
+
+
+void packRGBNEON(const unsigned char* source, unsigned char* destination, std::size_t pixels, bool swapRedBlue) {
+    std::size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        const auto rgba = vld4q_u8(source + i * 4);
+        uint8x16x3_t rgb;
+        rgb.val[0] = swapRedBlue ? rgba.val[2] : rgba.val[0];
+        rgb.val[1] = rgba.val[1];
+        rgb.val[2] = swapRedBlue ? rgba.val[0] : rgba.val[2];
+        vst3q_u8(destination + i * 3, rgb);
+    }
+
+    packRGBScalar(source + i * 4, destination + i * 3, pixels - i, swapRedBlue);
+}
+
+
+void premultiplyAlphaNEON(const unsigned char* source, unsigned char* destination, std::size_t pixels) {
+    std::size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        auto rgba = vld4q_u8(source + i * 4);
+        rgba.val[0] = premultiply(rgba.val[0], rgba.val[3]);
+        rgba.val[1] = premultiply(rgba.val[1], rgba.val[3]);
+        rgba.val[2] = premultiply(rgba.val[2], rgba.val[3]);
+        vst4q_u8(destination + i * 4, rgba);
+    }
+
+    premultiplyAlphaScalar(source + i * 4, destination + i * 4, pixels - i);
+}
+
+
+void unpremultiplyAlphaNEON(const unsigned char* source, unsigned char* destination, std::size_t pixels) {
+    std::size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        auto rgba = vld4q_u8(source + i * 4);
+        rgba.val[0] = unpremultiply(rgba.val[0], rgba.val[3]);
+        rgba.val[1] = unpremultiply(rgba.val[1], rgba.val[3]);
+        rgba.val[2] = unpremultiply(rgba.val[2], rgba.val[3]);
+        vst4q_u8(destination + i * 4, rgba);
+    }
+
+    unpremultiplyAlphaScalar(source + i * 4, destination + i * 4, pixels - i);
+}
+
+
+}  // unnamed namespace
+
+
+const Kernels* neonKernels() {
+    static const Kernels kernels = { &swizzleNEON, &packRGBNEON, &premultiplyAlphaNEON, &unpremultiplyAlphaNEON };
+    return &kernels;
+}
+
+
+#else
+
+
+const Kernels* neonKernels() {
+    return nullptr;
+}
+
+
+#endif
+
+
+}  // namespace pixel
+}  // namespace glheadless
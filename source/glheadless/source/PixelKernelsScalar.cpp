@@ -0,0 +1,79 @@
+#include "PixelKernels.h"
+
+
+namespace glheadless {
+namespace pixel {
+
+
+namespace {
+
+
+// round(value / 255) for value in [0, 255 * 255]
+inline unsigned char divide255(unsigned int value) {
+    value += 128;
+    return static_cast<unsigned char>((value + (value >> 8)) >> 8);
+}
+
+
+}  // unnamed namespace
+
+
+void swizzleScalar(const unsigned char* source, unsigned char* destination, std::size_t pixels, const unsigned char* order) {
+    for (std::size_t i = 0; i < pixels; ++i, source += 4, destination += 4) {
+        const unsigned char pixel[4] = { source[0], source[1], source[2], source[3] };
+        destination[0] = pixel[order[0]];
+        destination[1] = pixel[order[1]];
+        destination[2] = pixel[order[2]];
+        destination[3] = pixel[order[3]];
+    }
+}
+
+
+void packRGBScalar(const unsigned char* source, unsigned char* destination, std::size_t pixels, bool swapRedBlue) {
+    for (std::size_t i = 0; i < pixels; ++i, source += 4, destination += 3) {
+        const auto red = source[0];
+        const auto green = source[1];
+        const auto blue = source[2];
+        destination[0] = swapRedBlue ? blue : red;
+        destination[1] = green;
+        destination[2] = swapRedBlue ? red : blue;
+    }
+}
+
+
+void premultiplyAlphaScalar(const unsigned char* source, unsigned char* destination, std::size_t pixels) {
+    for (std::size_t i = 0; i < pixels; ++i, source += 4, destination += 4) {
+        const unsigned int alpha = source[3];
+        destination[0] = divide255(source[0] * alpha);
+        destination[1] = divide255(source[1] * alpha);
+        destination[2] = divide255(source[2] * alpha);
+        destination[3] = static_cast<unsigned char>(alpha);
+    }
+}
+
+
+void unpremultiplyAlphaScalar(const unsigned char* source, unsigned char* destination, std::size_t pixels) {
+    for (std::size_t i = 0; i < pixels; ++i, source += 4, destination += 4) {
+        const unsigned int alpha = source[3];
+        if (alpha == 0) {
+            destination[0] = destination[1] = destination[2] = destination[3] = 0;
+            continue;
+        }
+
+        for (auto channel = 0; channel < 3; ++channel) {
+            const auto value = (source[channel] * 255u + alpha / 2) / alpha;
+            destination[channel] = static_cast<unsigned char>(value < 255u ? value : 255u);
+        }
+        destination[3] = static_cast<unsigned char>(alpha);
+    }
+}
+
+
+const Kernels* scalarKernels() {
+    static const Kernels kernels = { &swizzleScalar, &packRGBScalar, &premultiplyAlphaScalar, &unpremultiplyAlphaScalar };
+    return &kernels;
+}
+
+
+}  // namespace pixel
+}  // namespace glheadless
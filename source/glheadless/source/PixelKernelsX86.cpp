@@ -0,0 +1,283 @@
+#include "PixelKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define GLHEADLESS_PIXEL_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+// MSVC allows intrinsics of any instruction set, GCC and Clang require them to be enabled per function
+#if defined(GLHEADLESS_PIXEL_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define GLHEADLESS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define GLHEADLESS_TARGET(isa)
+#endif
+
+
+namespace glheadless {
+namespace pixel {
+
+
+#ifdef GLHEADLESS_PIXEL_KERNELS_X86
+
+
+namespace {
+
+
+/*
+ * The 128 bit kernels process 4 pixels per iteration, the 256 bit kernels 8. Shuffle masks are identical in both
+ * 128 bit lanes, as AVX2 byte shuffles do not cross lanes.
+ */
+
+GLHEADLESS_TARGET("ssse3")
+__m128i swizzleMask(const unsigned char* order) {
+    alignas(16) unsigned char mask[16];
+    for (auto i = 0; i < 16; ++i) {
+        mask[i] = static_cast<unsigned char>((i & ~3) + order[i & 3]);
+    }
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+}
+
+
+// packs 4 pixels to the first 12 bytes, zeroes the last 4
+GLHEADLESS_TARGET("ssse3")
+__m128i packMask(bool swapRedBlue) {
+    alignas(16) unsigned char mask[16];
+    for (auto i = 0; i < 12; ++i) {
+        const auto channel = i % 3;
+        mask[i] = static_cast<unsigned char>((i / 3) * 4 + (swapRedBlue ? 2 - channel : channel));
+    }
+    for (auto i = 12; i < 16; ++i) {
+        mask[i] = 0x80;
+    }
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+}
+
+
+// broadcasts the alpha of 2 pixels to the 16 bit color lanes of the low (or high) half, alpha lanes are zeroed
+GLHEADLESS_TARGET("ssse3")
+__m128i alphaMask(bool high) {
+    alignas(16) unsigned char mask[16];
+    for (auto i = 0; i < 16; ++i) {
+        const auto lane = i / 2;
+        const auto pixel = lane / 4 + (high ? 2 : 0);
+        mask[i] = (i % 2 == 0 && lane % 4 != 3) ? static_cast<unsigned char>(pixel * 4 + 3) : 0x80;
+    }
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+}
+
+
+// round(value / 255) per 16 bit lane, see divide255() of the scalar kernels
+GLHEADLESS_TARGET("ssse3")
+__m128i divide255(__m128i value) {
+    value = _mm_add_epi16(value, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), 8);
+}
+
+
+GLHEADLESS_TARGET("avx2")
+__m256i divide255(__m256i value) {
+    value = _mm256_add_epi16(value, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(value, _mm256_srli_epi16(value, 8)), 8);
+}
+
+
+// unpremultiplies one pixel per 32 bit lane group; the quotient is exact, as float division is correctly rounded
+GLHEADLESS_TARGET("ssse3")
+__m128i unpremultiplyPixel(__m128i pixel) {
+    const auto alpha = _mm_shuffle_epi32(pixel, _MM_SHUFFLE(3, 3, 3, 3));
+    const auto numerator = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(pixel), _mm_set1_ps(255.0f)), _mm_cvtepi32_ps(_mm_srli_epi32(alpha, 1)));
+    // alpha fits into 16 bits, so the 16 bit maximum replaces the 32 bit one of SSE4.1
+    const auto divisor = _mm_cvtepi32_ps(_mm_max_epi16(alpha, _mm_set1_epi32(1)));
+    const auto quotient = _mm_cvttps_epi32(_mm_div_ps(numerator, divisor));
+
+    const auto alphaLane = _mm_setr_epi32(0, 0, 0, -1);
+    const auto result = _mm_or_si128(_mm_andnot_si128(alphaLane, quotient), _mm_and_si128(alphaLane, pixel));
+    return _mm_andnot_si128(_mm_cmpeq_epi32(alpha, _mm_setzero_si128()), result);
+}
+
+
+GLHEADLESS_TARGET("avx2")
+__m256i unpremultiplyPixel(__m256i pixel) {
+    const auto alpha = _mm256_shuffle_epi32(pixel, _MM_SHUFFLE(3, 3, 3, 3));
+    const auto numerator = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(pixel), _mm256_set1_ps(255.0f)), _mm256_cvtepi32_ps(_mm256_srli_epi32(alpha, 1)));
+    const auto divisor = _mm256_cvtepi32_ps(_mm256_max_epi32(alpha, _mm256_set1_epi32(1)));
+    const auto quotient = _mm256_cvttps_epi32(_mm256_div_ps(numerator, divisor));
+
+    const auto alphaLane = _mm256_setr_epi32(0, 0, 0, -1, 0, 0, 0, -1);
+    const auto result = _mm256_blendv_epi8(quotient, pixel, alphaLane);
+    return _mm256_andnot_si256(_mm256_cmpeq_epi32(alpha, _mm256_setzero_si256()), result);
+}
+
+
+GLHEADLESS_TARGET("ssse3")
+void swizzleSSSE3(const unsigned char* source, unsigned char* destination, std::size_t pixels, const unsigned char* order) {
+    const auto mask = swizzleMask(order);
+
+    std::size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), _mm_shuffle_epi8(value, mask));
+    }
+
+    swizzleScalar(source + i * 4, destination + i * 4, pixels - i, order);
+}
+
+
+GLHEADLESS_TARGET("ssse3")
+void packRGBSSSE3(const unsigned char* source, unsigned char* destination, std::size_t pixels, bool swapRedBlue) {
+    const auto mask = packMask(swapRedBlue);
+
+    // each store writes 4 bytes past its 12 bytes of output, so stop while they still belong to later pixels
+    std::size_t i = 0;
+    for (; i + 6 <= pixels; i += 4) {
+        const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 3), _mm_shuffle_epi8(value, mask));
+    }
+
+    packRGBScalar(source + i * 4, destination + i * 3, pixels - i, swapRedBlue);
+}
+
+
+GLHEADLESS_TARGET("ssse3")
+void premultiplyAlphaSSSE3(const unsigned char* source, unsigned char* destination, std::size_t pixels) {
+    const auto zero = _mm_setzero_si128();
+    const auto alphaLow = alphaMask(false);
+    const auto alphaHigh = alphaMask(true);
+    const auto opaque = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+
+    std::size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        const auto low = _mm_mullo_epi16(_mm_unpacklo_epi8(value, zero), _mm_or_si128(_mm_shuffle_epi8(value, alphaLow), opaque));
+        const auto high = _mm_mullo_epi16(_mm_unpackhi_epi8(value, zero), _mm_or_si128(_mm_shuffle_epi8(value, alphaHigh), opaque));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), _mm_packus_epi16(divide255(low), divide255(high)));
+    }
+
+    premultiplyAlphaScalar(source + i * 4, destination + i * 4, pixels - i);
+}
+
+
+GLHEADLESS_TARGET("ssse3")
+void unpremultiplyAlphaSSSE3(const unsigned char* source, unsigned char* destination, std::size_t pixels) {
+    const auto zero = _mm_setzero_si128();
+
+    std::size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        const auto low = _mm_unpacklo_epi8(value, zero);
+        const auto high = _mm_unpackhi_epi8(value, zero);
+
+        // the signed 32 bit pack saturates quotients above 255 to 32767, the unsigned 16 bit pack then to 255
+        const auto pixels01 = _mm_packs_epi32(unpremultiplyPixel(_mm_unpacklo_epi16(low, zero)), unpremultiplyPixel(_mm_unpackhi_epi16(low, zero)));
+        const auto pixels23 = _mm_packs_epi32(unpremultiplyPixel(_mm_unpacklo_epi16(high, zero)), unpremultiplyPixel(_mm_unpackhi_epi16(high, zero)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), _mm_packus_epi16(pixels01, pixels23));
+    }
+
+    unpremultiplyAlphaScalar(source + i * 4, destination + i * 4, pixels - i);
+}
+
+
+GLHEADLESS_TARGET("avx2")
+void swizzleAVX2(const unsigned char* source, unsigned char* destination, std::size_t pixels, const unsigned char* order) {
+    const auto mask = _mm256_broadcastsi128_si256(swizzleMask(order));
+
+    std::size_t i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        const auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4), _mm256_shuffle_epi8(value, mask));
+    }
+
+    swizzleSSSE3(source + i * 4, destination + i * 4, pixels - i, order);
+}
+
+
+GLHEADLESS_TARGET("avx2")
+void packRGBAVX2(const unsigned char* source, unsigned char* destination, std::size_t pixels, bool swapRedBlue) {
+    const auto mask = _mm256_broadcastsi128_si256(packMask(swapRedBlue));
+    // moves the 12 bytes of the upper lane next to those of the lower lane
+    const auto compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+    // each store writes 8 bytes past its 24 bytes of output, see packRGBSSSE3()
+    std::size_t i = 0;
+    for (; i + 11 <= pixels; i += 8) {
+        const auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 4));
+        const auto packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(value, mask), compact);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 3), packed);
+    }
+
+    packRGBSSSE3(source + i * 4, destination + i * 3, pixels - i, swapRedBlue);
+}
+
+
+GLHEADLESS_TARGET("avx2")
+void premultiplyAlphaAVX2(const unsigned char* source, unsigned char* destination, std::size_t pixels) {
+    const auto zero = _mm256_setzero_si256();
+    const auto alphaLow = _mm256_broadcastsi128_si256(alphaMask(false));
+    const auto alphaHigh = _mm256_broadcastsi128_si256(alphaMask(true));
+    const auto opaque = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+
+    std::size_t i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        const auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 4));
+        const auto low = _mm256_mullo_epi16(_mm256_unpacklo_epi8(value, zero), _mm256_or_si256(_mm256_shuffle_epi8(value, alphaLow), opaque));
+        const auto high = _mm256_mullo_epi16(_mm256_unpackhi_epi8(value, zero), _mm256_or_si256(_mm256_shuffle_epi8(value, alphaHigh), opaque));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4), _mm256_packus_epi16(divide255(low), divide255(high)));
+    }
+
+    premultiplyAlphaSSSE3(source + i * 4, destination + i * 4, pixels - i);
+}
+
+
+GLHEADLESS_TARGET("avx2")
+void unpremultiplyAlphaAVX2(const unsigned char* source, unsigned char* destination, std::size_t pixels) {
+    const auto zero = _mm256_setzero_si256();
+
+    // unpacking and packing operate per 128 bit lane, so the pixel order is preserved
+    std::size_t i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        const auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 4));
+        const auto low = _mm256_unpacklo_epi8(value, zero);
+        const auto high = _mm256_unpackhi_epi8(value, zero);
+
+        const auto pixels01 = _mm256_packs_epi32(unpremultiplyPixel(_mm256_unpacklo_epi16(low, zero)), unpremultiplyPixel(_mm256_unpackhi_epi16(low, zero)));
+        const auto pixels23 = _mm256_packs_epi32(unpremultiplyPixel(_mm256_unpacklo_epi16(high, zero)), unpremultiplyPixel(_mm256_unpackhi_epi16(high, zero)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4), _mm256_packus_epi16(pixels01, pixels23));
+    }
+
+    unpremultiplyAlphaSSSE3(source + i * 4, destination + i * 4, pixels - i);
+}
+
+
+}  // unnamed namespace
+
+
+const Kernels* ssse3Kernels() {
+    static const Kernels kernels = { &swizzleSSSE3, &packRGBSSSE3, &premultiplyAlphaSSSE3, &unpremultiplyAlphaSSSE3 };
+    return &kernels;
+}
+
+
+const Kernels* avx2Kernels() {
+    static const Kernels kernels = { &swizzleAVX2, &packRGBAVX2, &premultiplyAlphaAVX2, &unpremultiplyAlphaAVX2 };
+    return &kernels;
+}
+
+
+#else
+
+
+const Kernels* ssse3Kernels() {
+    return nullptr;
+}
+
+
+const Kernels* avx2Kernels() {
+    return nullptr;
+}
+
+
+#endif
+
+
+}  // namespace pixel
+}  // namespace glheadless
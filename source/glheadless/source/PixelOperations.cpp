@@ -0,0 +1,190 @@
+#include <glheadless/PixelOperations.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+#include "PixelKernels.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+bool cpuSupports(InstructionSet instructionSet) {
+    switch (instructionSet) {
+    case InstructionSet::SCALAR:
+        return true;
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    case InstructionSet::SSSE3:
+        return __builtin_cpu_supports("ssse3");
+    case InstructionSet::AVX2:
+        // also checks that the OS saves the AVX registers
+        return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    case InstructionSet::SSSE3: {
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+    }
+    case InstructionSet::AVX2: {
+        int info[4];
+        __cpuid(info, 1);
+        const auto osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+#endif
+
+    case InstructionSet::NEON:
+        // Advanced SIMD is mandatory on AArch64
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
+const pixel::Kernels* kernels(InstructionSet instructionSet) {
+    const pixel::Kernels* kernels = nullptr;
+    switch (instructionSet) {
+    case InstructionSet::SCALAR:
+        kernels = pixel::scalarKernels();
+        break;
+    case InstructionSet::SSSE3:
+        kernels = pixel::ssse3Kernels();
+        break;
+    case InstructionSet::AVX2:
+        kernels = pixel::avx2Kernels();
+        break;
+    case InstructionSet::NEON:
+        kernels = pixel::neonKernels();
+        break;
+    default:
+        break;
+    }
+
+    return kernels != nullptr && cpuSupports(instructionSet) ? kernels : nullptr;
+}
+
+
+struct Dispatch {
+    Dispatch()
+    : best(InstructionSet::SCALAR) {
+        for (auto candidate : { InstructionSet::SSSE3, InstructionSet::AVX2, InstructionSet::NEON }) {
+            if (kernels(candidate) != nullptr) {
+                best = candidate;
+            }
+        }
+        current = best;
+        table = kernels(best);
+    }
+
+    InstructionSet                     best;
+    std::atomic<InstructionSet>        current;
+    std::atomic<const pixel::Kernels*> table;
+};
+
+
+Dispatch& dispatch() {
+    static Dispatch dispatch;
+    return dispatch;
+}
+
+
+const pixel::Kernels& activeKernels() {
+    return *dispatch().table.load(std::memory_order_relaxed);
+}
+
+
+}  // unnamed namespace
+
+
+InstructionSet bestInstructionSet() {
+    return dispatch().best;
+}
+
+
+InstructionSet instructionSet() {
+    return dispatch().current.load();
+}
+
+
+bool setInstructionSet(InstructionSet instructionSet) {
+    const auto table = kernels(instructionSet);
+    if (table == nullptr) {
+        return false;
+    }
+
+    dispatch().current = instructionSet;
+    dispatch().table = table;
+    return true;
+}
+
+
+void flipRows(const void* source, void* destination, std::size_t rowSize, std::size_t rows) {
+    const auto input = static_cast<const unsigned char*>(source);
+    const auto output = static_cast<unsigned char*>(destination);
+
+    // row copies are plain memory moves, which memcpy already vectorizes for the running CPU
+    if (input != output) {
+        for (std::size_t row = 0; row < rows; ++row) {
+            std::memcpy(output + (rows - 1 - row) * rowSize, input + row * rowSize, rowSize);
+        }
+        return;
+    }
+
+    // swap pairs of rows through a cache resident buffer
+    unsigned char buffer[4096];
+    for (std::size_t row = 0; row < rows / 2; ++row) {
+        const auto top = output + row * rowSize;
+        const auto bottom = output + (rows - 1 - row) * rowSize;
+
+        for (std::size_t offset = 0; offset < rowSize; offset += sizeof(buffer)) {
+            const auto size = std::min(sizeof(buffer), rowSize - offset);
+            std::memcpy(buffer, top + offset, size);
+            std::memcpy(top + offset, bottom + offset, size);
+            std::memcpy(bottom + offset, buffer, size);
+        }
+    }
+}
+
+
+void swizzle(const void* source, void* destination, std::size_t pixels, const std::array<unsigned char, 4>& order) {
+    for (auto channel : order) {
+        if (channel > 3) {
+            return;
+        }
+    }
+
+    activeKernels().swizzle(static_cast<const unsigned char*>(source), static_cast<unsigned char*>(destination), pixels, order.data());
+}
+
+
+void packRGB(const void* source, void* destination, std::size_t pixels, bool swapRedBlue) {
+    activeKernels().packRGB(static_cast<const unsigned char*>(source), static_cast<unsigned char*>(destination), pixels, swapRedBlue);
+}
+
+
+void premultiplyAlpha(const void* source, void* destination, std::size_t pixels) {
+    activeKernels().premultiplyAlpha(static_cast<const unsigned char*>(source), static_cast<unsigned char*>(destination), pixels);
+}
+
+
+void unpremultiplyAlpha(const void* source, void* destination, std::size_t pixels) {
+    activeKernels().unpremultiplyAlpha(static_cast<const unsigned char*>(source), static_cast<unsigned char*>(destination), pixels);
+}
+
+
+}  // namespace glheadless
@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+ * USDT probes of provider glheadless, compiled in with the CMake option OPTION_USDT_PROBES. A probe that no tool is
+ * attached to is a single nop; perf, bpftrace and SystemTap find them in the library's .note.stapsdt section, e.g.,
+ * bpftrace -e 'usdt:libglheadless.so:glheadless:make_current_return { @[arg1] = count(); }'.
+ *
+ *   create_entry()                             Implementation::create(), before any native call
+ *   create_return(handle, error)               Implementation::create(), handle 0 if creation failed
+ *   destroy_entry(handle)                      Implementation::destroy()
+ *   destroy_return()
+ *   make_current_entry(handle)                 Context::makeCurrent()
+ *   make_current_return(handle, error)
+ *   done_current_entry(handle)                 Context::doneCurrent()
+ *   done_current_return(handle, error)
+ *   error(handle, error, message)              Context::setError() with an error
+ *
+ * handle is the native context handle (64-bit integer), error the value of the std::error_code (int, 0 on success)
+ * and message a null-terminated string.
+ */
+
+#ifdef GLHEADLESS_USDT_PROBES
+
+#include <sys/sdt.h>
+
+#define GLHEADLESS_PROBE0(name)             DTRACE_PROBE(glheadless, name)
+#define GLHEADLESS_PROBE1(name, a)          DTRACE_PROBE1(glheadless, name, a)
+#define GLHEADLESS_PROBE2(name, a, b)       DTRACE_PROBE2(glheadless, name, a, b)
+#define GLHEADLESS_PROBE3(name, a, b, c)    DTRACE_PROBE3(glheadless, name, a, b, c)
+
+#else
+
+#define GLHEADLESS_PROBE0(name)             ((void)0)
+#define GLHEADLESS_PROBE1(name, a)          ((void)0)
+#define GLHEADLESS_PROBE2(name, a, b)       ((void)0)
+#define GLHEADLESS_PROBE3(name, a, b, c)    ((void)0)
+
+#endif
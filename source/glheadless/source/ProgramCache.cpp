@@ -0,0 +1,406 @@
+#include <glheadless/ProgramCache.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <thread>
+
+#include <glheadless/Context.h>
+#include <glheadless/error.h>
+
+#include "GLFunctions.h"
+#include "InternalException.h"
+#include "ShaderProgram.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+const char k_magic[8] = { 'G', 'L', 'H', 'P', 'B', 'I', 'N', '2' };
+const std::string k_extension = ".glbin";
+
+const std::uint64_t k_fnvOffsetBasis = 14695981039346656037ull;
+const std::uint64_t k_fnvPrime = 1099511628211ull;
+
+
+std::uint64_t hash(std::uint64_t value, const void* data, std::size_t size) {
+    const auto bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        value = (value ^ bytes[i]) * k_fnvPrime;
+    }
+    return value;
+}
+
+
+std::string hex(std::uint64_t value) {
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+    return buffer;
+}
+
+
+std::string glString(const gl::Functions& gl, gl::GLenum name) {
+    const auto value = reinterpret_cast<const char*>(gl.GetString(name));
+    return value != nullptr ? value : "";
+}
+
+
+// identifies the driver build; binaries are only valid for the exact driver that produced them
+std::string fingerprint(const gl::Functions& gl, gl::GLint formatCount) {
+    std::vector<gl::GLint> formats(static_cast<std::size_t>(formatCount));
+    gl.GetIntegerv(gl::PROGRAM_BINARY_FORMATS, formats.data());
+
+    auto result = glString(gl, gl::VENDOR) + '\n' + glString(gl, gl::RENDERER) + '\n' + glString(gl, gl::VERSION) + '\n' + glString(gl, gl::SHADING_LANGUAGE_VERSION);
+    for (const auto format : formats) {
+        result += '\n' + std::to_string(format);
+    }
+    return result;
+}
+
+
+std::uint64_t sourceHash(const std::vector<ShaderSource>& shaders) {
+    auto value = k_fnvOffsetBasis;
+    for (const auto& shader : shaders) {
+        const std::uint64_t header[] = { shader.type, shader.source.size() };
+        value = hash(value, header, sizeof(header));
+        value = hash(value, shader.source.data(), shader.source.size());
+    }
+    return value;
+}
+
+
+void append(std::string& data, std::uint64_t value, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+        data.push_back(static_cast<char>(value >> (i * 8)));
+    }
+}
+
+
+std::uint64_t read(const std::string& data, std::size_t& offset, std::size_t size) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[offset + i])) << (i * 8);
+    }
+    offset += size;
+    return value;
+}
+
+
+#ifdef _WIN32
+
+
+bool makeDirectory(const std::string& path) {
+    return CreateDirectoryA(path.c_str(), nullptr) != 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+
+bool removeDirectory(const std::string& path) {
+    return RemoveDirectoryA(path.c_str()) != 0;
+}
+
+
+std::vector<std::string> listDirectory(const std::string& path) {
+    std::vector<std::string> names;
+    WIN32_FIND_DATAA entry;
+    const auto search = FindFirstFileA((path + "\\*").c_str(), &entry);
+    if (search == INVALID_HANDLE_VALUE) {
+        return names;
+    }
+    do {
+        names.push_back(entry.cFileName);
+    } while (FindNextFileA(search, &entry));
+    FindClose(search);
+    return names;
+}
+
+
+bool replaceFile(const std::string& source, const std::string& target) {
+    return MoveFileExA(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+
+#else
+
+
+bool makeDirectory(const std::string& path) {
+    struct stat status;
+    return ::mkdir(path.c_str(), 0755) == 0 || (::stat(path.c_str(), &status) == 0 && S_ISDIR(status.st_mode));
+}
+
+
+bool removeDirectory(const std::string& path) {
+    return ::rmdir(path.c_str()) == 0;
+}
+
+
+std::vector<std::string> listDirectory(const std::string& path) {
+    std::vector<std::string> names;
+    const auto directory = ::opendir(path.c_str());
+    if (directory == nullptr) {
+        return names;
+    }
+    while (const auto entry = ::readdir(directory)) {
+        names.push_back(entry->d_name);
+    }
+    ::closedir(directory);
+    return names;
+}
+
+
+bool replaceFile(const std::string& source, const std::string& target) {
+    // atomic on POSIX: readers see either the previous or the complete new entry
+    return std::rename(source.c_str(), target.c_str()) == 0;
+}
+
+
+#endif
+
+
+bool isEntry(const std::string& name) {
+    return name.size() > k_extension.size() && name.compare(name.size() - k_extension.size(), k_extension.size(), k_extension) == 0;
+}
+
+
+// the subdirectories of the drivers are named by the hash of their fingerprint
+bool isDriverDirectory(const std::string& name) {
+    return name.size() == 16 && name.find_first_not_of("0123456789abcdef") == std::string::npos;
+}
+
+
+// the shader types and sources as stored in an entry, compared in full when it is read
+std::string serialize(const std::vector<ShaderSource>& shaders) {
+    std::string data;
+    append(data, shaders.size(), 4);
+    for (const auto& shader : shaders) {
+        append(data, shader.type, 4);
+        append(data, shader.source.size(), 4);
+        data += shader.source;
+    }
+    return data;
+}
+
+
+bool readEntry(const std::string& path, const std::string& fingerprint, const std::string& sources, gl::GLenum& format, std::string& binary) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // the fingerprint and sources are compared in full, so hash collisions of the path cannot load a wrong binary
+    std::size_t offset = sizeof(k_magic);
+    if (data.size() < offset + 4 || std::memcmp(data.data(), k_magic, sizeof(k_magic)) != 0) {
+        return false;
+    }
+    const auto fingerprintSize = static_cast<std::size_t>(read(data, offset, 4));
+    if (data.size() < offset + fingerprintSize + sources.size() + 8 || data.compare(offset, fingerprintSize, fingerprint) != 0) {
+        return false;
+    }
+    offset += fingerprintSize;
+    if (data.compare(offset, sources.size(), sources) != 0) {
+        return false;
+    }
+    offset += sources.size();
+    format = static_cast<gl::GLenum>(read(data, offset, 4));
+    const auto binarySize = static_cast<std::size_t>(read(data, offset, 4));
+    if (binarySize == 0 || data.size() != offset + binarySize) {
+        return false;
+    }
+
+    binary = data.substr(offset);
+    return true;
+}
+
+
+bool writeEntry(const std::string& path, const std::string& fingerprint, const std::string& sources, gl::GLenum format, const std::string& binary) {
+    std::string data(k_magic, sizeof(k_magic));
+    append(data, fingerprint.size(), 4);
+    data += fingerprint;
+    data += sources;
+    append(data, format, 4);
+    append(data, binary.size(), 4);
+    data += binary;
+
+    // unique per thread and attempt, so concurrent writers of the same entry do not interfere
+    const auto unique = std::hash<std::thread::id>()(std::this_thread::get_id()) ^ static_cast<std::size_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    const auto temporary = path + ".tmp" + hex(unique);
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(data.data(), static_cast<std::streamsize>(data.size())) || !file.flush()) {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+
+    if (!replaceFile(temporary, path)) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+}  // unnamed namespace
+
+
+ProgramCache::ProgramCache(const std::string& directory)
+: m_directory(directory)
+, m_hitCount(0)
+, m_missCount(0) {
+}
+
+
+const std::string& ProgramCache::directory() const {
+    return m_directory;
+}
+
+
+bool ProgramCache::createProgram(Context* context, const std::vector<ShaderSource>& shaders, unsigned int& program) {
+    if (shaders.empty()) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "Programs require at least one shader");
+    }
+
+    const auto& gl = context->functions();
+    gl::GLint formatCount = 0;
+    if (gl.GetProgramBinary != nullptr && gl.ProgramBinary != nullptr && gl.ProgramParameteri != nullptr) {
+        gl.GetIntegerv(gl::NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    }
+
+    // each driver has a subdirectory of its own, so processes of different drivers sharing the directory do not
+    // invalidate each other's entries
+    const auto caching = formatCount > 0;
+    const auto driver = caching ? fingerprint(gl, formatCount) : std::string();
+    const auto driverDirectory = m_directory + "/" + hex(hash(k_fnvOffsetBasis, driver.data(), driver.size()));
+    const auto sources = caching ? serialize(shaders) : std::string();
+    const auto path = driverDirectory + "/" + hex(sourceHash(shaders)) + k_extension;
+
+    gl::GLenum format = 0;
+    std::string binary;
+    if (caching && readEntry(path, driver, sources, format, binary)) {
+        const auto name = gl.CreateProgram();
+        gl.ProgramBinary(name, format, binary.data(), static_cast<gl::GLsizei>(binary.size()));
+
+        gl::GLint status = 0;
+        gl.GetProgramiv(name, gl::LINK_STATUS, &status);
+        if (status != 0) {
+            ++m_hitCount;
+            program = name;
+            return true;
+        }
+
+        // rejected by the driver despite a matching fingerprint; clear the error raised by glProgramBinary()
+        gl.DeleteProgram(name);
+        gl.GetError();
+        std::remove(path.c_str());
+    }
+
+    std::vector<gl::ShaderStage> stages;
+    stages.reserve(shaders.size());
+    for (const auto& shader : shaders) {
+        stages.push_back({ shader.type, shader.source.c_str() });
+    }
+
+    gl::GLuint name = 0;
+    try {
+        name = gl::createProgram(gl, stages.data(), stages.size(), caching);
+    } catch (InternalException& e) {
+        return setError(e.code(), e.message());
+    }
+    ++m_missCount;
+
+    if (caching) {
+        gl::GLint length = 0;
+        gl.GetProgramiv(name, gl::PROGRAM_BINARY_LENGTH, &length);
+        if (length > 0) {
+            binary.resize(static_cast<std::size_t>(length));
+            gl.GetProgramBinary(name, length, &length, &format, &binary[0]);
+            binary.resize(static_cast<std::size_t>(length));
+            if (makeDirectory(m_directory) && makeDirectory(driverDirectory)) {
+                writeEntry(path, driver, sources, format, binary);
+            }
+        }
+    }
+
+    program = name;
+    return true;
+}
+
+
+bool ProgramCache::createProgram(Context* context, const std::string& vertexSource, const std::string& fragmentSource, unsigned int& program) {
+    std::vector<ShaderSource> shaders(2);
+    shaders[0].type = gl::VERTEX_SHADER;
+    shaders[0].source = vertexSource;
+    shaders[1].type = gl::FRAGMENT_SHADER;
+    shaders[1].source = fragmentSource;
+
+    return createProgram(context, shaders, program);
+}
+
+
+bool ProgramCache::clear() {
+    auto success = true;
+    for (const auto& name : listDirectory(m_directory)) {
+        if (!isDriverDirectory(name)) {
+            continue;
+        }
+        const auto driverDirectory = m_directory + "/" + name;
+        for (const auto& entry : listDirectory(driverDirectory)) {
+            if (isEntry(entry)) {
+                success = std::remove((driverDirectory + "/" + entry).c_str()) == 0 && success;
+            }
+        }
+        success = removeDirectory(driverDirectory) && success;
+    }
+
+    if (!success) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "Cannot delete all entries of " + m_directory);
+    }
+    return true;
+}
+
+
+unsigned int ProgramCache::hitCount() const {
+    return m_hitCount;
+}
+
+
+unsigned int ProgramCache::missCount() const {
+    return m_missCount;
+}
+
+
+const std::error_code& ProgramCache::lastErrorCode() const {
+    return m_lastErrorCode;
+}
+
+
+const std::string& ProgramCache::lastErrorMessage() const {
+    return m_lastErrorMessage;
+}
+
+
+bool ProgramCache::setError(const std::error_code& code, const std::string& message) {
+    m_lastErrorCode = code;
+    m_lastErrorMessage = message;
+
+    return !m_lastErrorCode;
+}
+
+
+}  // namespace glheadless
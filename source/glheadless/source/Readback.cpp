@@ -0,0 +1,556 @@
+#include <glheadless/Readback.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <glheadless/Context.h>
+
+#include "GLFunctions.h"
+#include "InternalException.h"
+#include "ShaderProgram.h"
+#include "StateGuard.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+const char* const k_vertexShader = R"(
+#version 150
+
+void main() {
+    // full-screen triangle without vertex attributes
+    vec2 position = vec2((gl_VertexID & 1) * 4 - 1, (gl_VertexID & 2) * 2 - 1);
+    gl_Position = vec4(position, 0.0, 1.0);
+}
+)";
+
+
+// Every fragment of the single channel target computes one output byte. Fragments are enumerated row by row, so the
+// linear fragment index equals the byte offset in the tightly packed output. u_format uses the PixelFormat values.
+const char* const k_fragmentShader = R"(
+#version 150
+
+uniform sampler2D u_source;
+uniform ivec2 u_size;
+uniform int u_level;
+uniform int u_format;
+uniform int u_flip;
+uniform int u_pitch;
+uniform int u_total;
+
+out vec4 fragColor;
+
+vec4 fetch(int x, int y) {
+    if (u_flip != 0) {
+        y = u_size.y - 1 - y;
+    }
+    return texelFetch(u_source, ivec2(x, y), u_level);
+}
+
+vec3 average(int cx, int cy) {
+    int x = 2 * cx;
+    int y = 2 * cy;
+    return 0.25 * (fetch(x, y).rgb + fetch(x + 1, y).rgb + fetch(x, y + 1).rgb + fetch(x + 1, y + 1).rgb);
+}
+
+float lumaLimited(vec3 c) { return 16.0 + dot(c, vec3(65.481, 128.553, 24.966)); }
+float cbLimited(vec3 c)   { return 128.0 + dot(c, vec3(-37.797, -74.203, 112.0)); }
+float crLimited(vec3 c)   { return 128.0 + dot(c, vec3(112.0, -93.786, -18.214)); }
+
+void main() {
+    int index = int(gl_FragCoord.y) * u_pitch + int(gl_FragCoord.x);
+    if (index >= u_total) {
+        fragColor = vec4(0.0);
+        return;
+    }
+
+    float value = 0.0;
+    if (u_format <= 5) {
+        int channels = u_format <= 1 ? 4 : (u_format <= 3 ? 3 : 1);
+        int pixel = index / channels;
+        int channel = index - pixel * channels;
+        vec4 color = fetch(pixel - (pixel / u_size.x) * u_size.x, pixel / u_size.x);
+
+        if (u_format == 5) {
+            value = 255.0 * dot(color.rgb, vec3(0.299, 0.587, 0.114));
+        } else {
+            if ((u_format == 1 || u_format == 3) && channel < 3) {
+                channel = 2 - channel;
+            }
+            value = 255.0 * color[channel];
+        }
+    } else {
+        int lumaSize = u_size.x * u_size.y;
+        int chromaWidth = u_size.x / 2;
+        int chromaSize = chromaWidth * (u_size.y / 2);
+
+        if (index < lumaSize) {
+            int y = index / u_size.x;
+            value = lumaLimited(fetch(index - y * u_size.x, y).rgb);
+        } else {
+            int offset = index - lumaSize;
+            int position;
+            bool v;
+            if (u_format == 6) {
+                v = offset >= chromaSize;
+                position = v ? offset - chromaSize : offset;
+            } else {
+                position = offset / 2;
+                v = (offset - position * 2) == 1;
+            }
+
+            int cy = position / chromaWidth;
+            vec3 color = average(position - cy * chromaWidth, cy);
+            value = v ? crLimited(color) : cbLimited(color);
+        }
+    }
+
+    fragColor = vec4(floor(clamp(value, 0.0, 255.0) + 0.5) / 255.0, 0.0, 0.0, 1.0);
+}
+)";
+
+
+bool overlap(const Region& lhs, const Region& rhs) {
+    return lhs.x < rhs.x + static_cast<int>(rhs.width) && rhs.x < lhs.x + static_cast<int>(lhs.width)
+        && lhs.y < rhs.y + static_cast<int>(rhs.height) && rhs.y < lhs.y + static_cast<int>(lhs.height);
+}
+
+
+Region bounds(const Region& lhs, const Region& rhs) {
+    const auto left = std::min(lhs.x, rhs.x);
+    const auto bottom = std::min(lhs.y, rhs.y);
+    const auto right = std::max(lhs.x + static_cast<int>(lhs.width), rhs.x + static_cast<int>(rhs.width));
+    const auto top = std::max(lhs.y + static_cast<int>(lhs.height), rhs.y + static_cast<int>(rhs.height));
+
+    return Region(left, bottom, static_cast<unsigned int>(right - left), static_cast<unsigned int>(top - bottom));
+}
+
+
+Region alignToEven(const Region& region) {
+    const auto left = region.x & ~1;
+    const auto bottom = region.y & ~1;
+    const auto right = (region.x + static_cast<int>(region.width) + 1) & ~1;
+    const auto top = (region.y + static_cast<int>(region.height) + 1) & ~1;
+
+    return Region(left, bottom, static_cast<unsigned int>(right - left), static_cast<unsigned int>(top - bottom));
+}
+
+
+}  // unnamed namespace
+
+
+Region::Region()
+: x(0)
+, y(0)
+, width(0)
+, height(0) {
+}
+
+
+Region::Region(int x, int y, unsigned int width, unsigned int height)
+: x(x)
+, y(y)
+, width(width)
+, height(height) {
+}
+
+
+Readback::Readback(Context* context)
+: m_context(context)
+, m_flipVertically(false)
+, m_program(0)
+, m_vertexArray(0)
+, m_sourceTexture(0)
+, m_targetTexture(0)
+, m_framebuffer(0)
+, m_packBuffer(0)
+, m_sourceWidth(0)
+, m_sourceHeight(0)
+, m_targetWidth(0)
+, m_targetHeight(0) {
+}
+
+
+Readback::~Readback() {
+    if (m_program == 0 && m_packBuffer == 0) {
+        return;
+    }
+
+    const auto& gl = m_context->functions();
+    gl.DeleteProgram(m_program);
+    gl.DeleteVertexArrays(1, &m_vertexArray);
+    gl.DeleteTextures(1, &m_sourceTexture);
+    gl.DeleteTextures(1, &m_targetTexture);
+    gl.DeleteFramebuffers(1, &m_framebuffer);
+    gl.DeleteBuffers(1, &m_packBuffer);
+}
+
+
+void Readback::setFlipVertically(bool flip) {
+    m_flipVertically = flip;
+}
+
+
+bool Readback::flipVertically() const {
+    return m_flipVertically;
+}
+
+
+bool Readback::read(int x, int y, unsigned int width, unsigned int height, PixelFormat format, void* destination) {
+    if (width == 0 || height == 0 || destination == nullptr) {
+        return m_context->setError(Error::INVALID_ARGUMENT, "Readback requires a non-empty rectangle and a destination");
+    }
+
+    if (bytesPerPixel(format) == 0 && (width % 2 != 0 || height % 2 != 0)) {
+        return m_context->setError(Error::INVALID_ARGUMENT, "Chroma subsampled formats require even dimensions");
+    }
+
+    const auto& gl = m_context->functions();
+    if (gl.MapBufferRange == nullptr || gl.GenFramebuffers == nullptr || gl.GenVertexArrays == nullptr) {
+        return m_context->setError(Error::UNSUPPORTED_FEATURE, "Readback requires OpenGL 3.2");
+    }
+
+    try {
+        gl::StateGuard stateGuard(gl);
+
+        if (format == PixelFormat::RGBA8 && !m_flipVertically) {
+            readDirect(regionLayout(format, { Region(x, y, width, height) }), destination);
+        } else {
+            copySource(x, y, width, height, 0);
+            convert(0, width, height, format, destination);
+        }
+    } catch (InternalException& e) {
+        return m_context->setError(e.code(), e.message());
+    }
+
+    return true;
+}
+
+
+std::vector<ImageLevel> Readback::pyramidLayout(PixelFormat format, unsigned int width, unsigned int height, const std::vector<unsigned int>& levels) {
+    std::vector<ImageLevel> layout;
+    layout.reserve(levels.size());
+
+    std::size_t offset = 0;
+    for (const auto level : levels) {
+        ImageLevel imageLevel;
+        imageLevel.level = level;
+        imageLevel.width = level < 32 ? std::max(width >> level, 1u) : 1u;
+        imageLevel.height = level < 32 ? std::max(height >> level, 1u) : 1u;
+        imageLevel.offset = offset;
+        imageLevel.size = imageSize(format, imageLevel.width, imageLevel.height);
+
+        offset += imageLevel.size;
+        layout.push_back(imageLevel);
+    }
+
+    return layout;
+}
+
+
+bool Readback::readPyramid(int x, int y, unsigned int width, unsigned int height, PixelFormat format, const std::vector<unsigned int>& levels, void* destination) {
+    if (width == 0 || height == 0 || levels.empty() || destination == nullptr) {
+        return m_context->setError(Error::INVALID_ARGUMENT, "Readback requires a non-empty rectangle, levels and a destination");
+    }
+
+    auto maxLevel = 0u;
+    while ((std::max(width, height) >> (maxLevel + 1)) > 0) {
+        ++maxLevel;
+    }
+
+    const auto layout = pyramidLayout(format, width, height, levels);
+    auto requiredLevel = 0u;
+    for (const auto& imageLevel : layout) {
+        if (imageLevel.level > maxLevel) {
+            return m_context->setError(Error::INVALID_ARGUMENT, "Pyramid level " + std::to_string(imageLevel.level) + " exceeds the mipmap chain");
+        }
+        if (bytesPerPixel(format) == 0 && (imageLevel.width % 2 != 0 || imageLevel.height % 2 != 0)) {
+            return m_context->setError(Error::INVALID_ARGUMENT, "Chroma subsampled formats require even dimensions on every level");
+        }
+        requiredLevel = std::max(requiredLevel, imageLevel.level);
+    }
+
+    const auto& gl = m_context->functions();
+    if (gl.MapBufferRange == nullptr || gl.GenFramebuffers == nullptr || gl.GenVertexArrays == nullptr || gl.GenerateMipmap == nullptr) {
+        return m_context->setError(Error::UNSUPPORTED_FEATURE, "Readback requires OpenGL 3.2");
+    }
+
+    try {
+        gl::StateGuard stateGuard(gl);
+
+        copySource(x, y, width, height, requiredLevel);
+        for (const auto& imageLevel : layout) {
+            convert(imageLevel.level, imageLevel.width, imageLevel.height, format, static_cast<unsigned char*>(destination) + imageLevel.offset);
+        }
+    } catch (InternalException& e) {
+        return m_context->setError(e.code(), e.message());
+    }
+
+    return true;
+}
+
+
+std::vector<Region> Readback::mergeRegions(const std::vector<Region>& regions) {
+    std::vector<Region> merged;
+    merged.reserve(regions.size());
+    for (const auto& region : regions) {
+        if (region.width > 0 && region.height > 0) {
+            merged.push_back(region);
+        }
+    }
+
+    auto changed = true;
+    while (changed) {
+        changed = false;
+        for (auto i = std::size_t(0); i < merged.size(); ++i) {
+            for (auto j = i + 1; j < merged.size(); ++j) {
+                if (!overlap(merged[i], merged[j])) {
+                    continue;
+                }
+
+                merged[i] = bounds(merged[i], merged[j]);
+                merged.erase(merged.begin() + static_cast<std::ptrdiff_t>(j));
+                changed = true;
+                --j;
+            }
+        }
+    }
+
+    std::sort(merged.begin(), merged.end(), [] (const Region& lhs, const Region& rhs) {
+        return lhs.y != rhs.y ? lhs.y < rhs.y : lhs.x < rhs.x;
+    });
+
+    return merged;
+}
+
+
+std::vector<ImageRegion> Readback::regionLayout(PixelFormat format, const std::vector<Region>& regions) {
+    auto aligned = regions;
+    if (bytesPerPixel(format) == 0) {
+        for (auto& region : aligned) {
+            if (region.width > 0 && region.height > 0) {
+                region = alignToEven(region);
+            }
+        }
+    }
+
+    std::vector<ImageRegion> layout;
+    std::size_t offset = 0;
+    for (const auto& region : mergeRegions(aligned)) {
+        ImageRegion imageRegion;
+        imageRegion.region = region;
+        imageRegion.offset = offset;
+        imageRegion.size = imageSize(format, region.width, region.height);
+
+        offset += imageRegion.size;
+        layout.push_back(imageRegion);
+    }
+
+    return layout;
+}
+
+
+bool Readback::readRegions(const std::vector<Region>& regions, PixelFormat format, void* destination) {
+    const auto layout = regionLayout(format, regions);
+    if (layout.empty() || destination == nullptr) {
+        return m_context->setError(Error::INVALID_ARGUMENT, "Readback requires a non-empty region and a destination");
+    }
+
+    const auto& gl = m_context->functions();
+    if (gl.MapBufferRange == nullptr || gl.GenFramebuffers == nullptr || gl.GenVertexArrays == nullptr) {
+        return m_context->setError(Error::UNSUPPORTED_FEATURE, "Readback requires OpenGL 3.2");
+    }
+
+    try {
+        gl::StateGuard stateGuard(gl);
+
+        if (format == PixelFormat::RGBA8 && !m_flipVertically) {
+            readDirect(layout, destination);
+        } else {
+            for (const auto& imageRegion : layout) {
+                const auto& region = imageRegion.region;
+                copySource(region.x, region.y, region.width, region.height, 0);
+                convert(0, region.width, region.height, format, static_cast<unsigned char*>(destination) + imageRegion.offset);
+            }
+        }
+    } catch (InternalException& e) {
+        return m_context->setError(e.code(), e.message());
+    }
+
+    return true;
+}
+
+
+void Readback::addDirtyRegion(const Region& region) {
+    m_dirtyRegions.push_back(region);
+}
+
+
+void Readback::addDirtyScissor() {
+    gl::GLint box[4] = { 0, 0, 0, 0 };
+    m_context->functions().GetIntegerv(gl::SCISSOR_BOX, box);
+    addDirtyRegion(Region(box[0], box[1], static_cast<unsigned int>(box[2]), static_cast<unsigned int>(box[3])));
+}
+
+
+const std::vector<Region>& Readback::dirtyRegions() const {
+    return m_dirtyRegions;
+}
+
+
+void Readback::clearDirtyRegions() {
+    m_dirtyRegions.clear();
+}
+
+
+bool Readback::readDirtyRegions(PixelFormat format, void* destination) {
+    if (!readRegions(m_dirtyRegions, format, destination)) {
+        return false;
+    }
+
+    clearDirtyRegions();
+    return true;
+}
+
+
+void Readback::readDirect(const std::vector<ImageRegion>& layout, void* destination) {
+    const auto& gl = m_context->functions();
+
+    if (m_packBuffer == 0) {
+        gl.GenBuffers(1, &m_packBuffer);
+    }
+
+    const auto size = layout.back().offset + layout.back().size;
+    gl.BindBuffer(gl::PIXEL_PACK_BUFFER, m_packBuffer);
+    gl.BufferData(gl::PIXEL_PACK_BUFFER, static_cast<gl::GLsizeiptr>(size), nullptr, gl::STREAM_READ);
+    for (const auto& imageRegion : layout) {
+        const auto& region = imageRegion.region;
+        gl.ReadPixels(region.x, region.y, static_cast<gl::GLsizei>(region.width), static_cast<gl::GLsizei>(region.height), gl::RGBA, gl::UNSIGNED_BYTE,
+            reinterpret_cast<void*>(imageRegion.offset));
+    }
+
+    transfer(size, destination);
+}
+
+
+void Readback::copySource(int x, int y, unsigned int width, unsigned int height, unsigned int maxLevel) {
+    const auto& gl = m_context->functions();
+
+    prepareConversion();
+
+    // copy the requested rectangle of the caller's read framebuffer
+    gl.BindTexture(gl::TEXTURE_2D, m_sourceTexture);
+    if (width != m_sourceWidth || height != m_sourceHeight) {
+        gl.TexImage2D(gl::TEXTURE_2D, 0, gl::RGBA8, static_cast<gl::GLsizei>(width), static_cast<gl::GLsizei>(height), 0, gl::RGBA, gl::UNSIGNED_BYTE, nullptr);
+        m_sourceWidth = width;
+        m_sourceHeight = height;
+    }
+    gl.CopyTexSubImage2D(gl::TEXTURE_2D, 0, 0, 0, x, y, static_cast<gl::GLsizei>(width), static_cast<gl::GLsizei>(height));
+
+    // restrict the texture to the levels in use, so it is complete without generating the full chain
+    gl.TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MAX_LEVEL, static_cast<gl::GLint>(maxLevel));
+    if (maxLevel > 0) {
+        gl.GenerateMipmap(gl::TEXTURE_2D);
+    }
+}
+
+
+void Readback::convert(unsigned int level, unsigned int width, unsigned int height, PixelFormat format, void* destination) {
+    const auto& gl = m_context->functions();
+
+    // lay out the output bytes as rows of at most GL_MAX_TEXTURE_SIZE bytes
+    const auto size = imageSize(format, width, height);
+    gl::GLint maxTextureSize = 0;
+    gl.GetIntegerv(gl::MAX_TEXTURE_SIZE, &maxTextureSize);
+    const auto pitch = static_cast<unsigned int>(std::min<std::size_t>(size, static_cast<std::size_t>(maxTextureSize)));
+    const auto rows = static_cast<unsigned int>((size + pitch - 1) / pitch);
+    if (rows > static_cast<unsigned int>(maxTextureSize)) {
+        throw InternalException(Error::INVALID_ARGUMENT, "Readback rectangle exceeds the maximum texture size");
+    }
+
+    // keep the caller's read framebuffer for subsequent copies
+    gl::GLint readFramebuffer = 0;
+    gl.GetIntegerv(gl::READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+
+    gl.BindFramebuffer(gl::FRAMEBUFFER, m_framebuffer);
+    if (pitch != m_targetWidth || rows != m_targetHeight) {
+        gl.BindTexture(gl::TEXTURE_2D, m_targetTexture);
+        gl.TexImage2D(gl::TEXTURE_2D, 0, gl::R8, static_cast<gl::GLsizei>(pitch), static_cast<gl::GLsizei>(rows), 0, gl::RED, gl::UNSIGNED_BYTE, nullptr);
+        gl.FramebufferTexture2D(gl::FRAMEBUFFER, gl::COLOR_ATTACHMENT0, gl::TEXTURE_2D, m_targetTexture, 0);
+        m_targetWidth = pitch;
+        m_targetHeight = rows;
+
+        if (gl.CheckFramebufferStatus(gl::FRAMEBUFFER) != gl::FRAMEBUFFER_COMPLETE) {
+            m_targetWidth = m_targetHeight = 0;
+            throw InternalException(Error::UNSUPPORTED_FEATURE, "Readback conversion target is not renderable");
+        }
+    }
+
+    // run the conversion pass
+    gl.BindTexture(gl::TEXTURE_2D, m_sourceTexture);
+    gl.UseProgram(m_program);
+    gl.Uniform2i(gl.GetUniformLocation(m_program, "u_size"), static_cast<gl::GLint>(width), static_cast<gl::GLint>(height));
+    gl.Uniform1i(gl.GetUniformLocation(m_program, "u_level"), static_cast<gl::GLint>(level));
+    gl.Uniform1i(gl.GetUniformLocation(m_program, "u_format"), static_cast<gl::GLint>(format));
+    gl.Uniform1i(gl.GetUniformLocation(m_program, "u_flip"), m_flipVertically ? 1 : 0);
+    gl.Uniform1i(gl.GetUniformLocation(m_program, "u_pitch"), static_cast<gl::GLint>(pitch));
+    gl.Uniform1i(gl.GetUniformLocation(m_program, "u_total"), static_cast<gl::GLint>(size));
+    gl.Viewport(0, 0, static_cast<gl::GLsizei>(pitch), static_cast<gl::GLsizei>(rows));
+    gl.BindVertexArray(m_vertexArray);
+    gl.DrawArrays(gl::TRIANGLES, 0, 3);
+
+    // read the converted bytes through the pack buffer
+    gl.BindBuffer(gl::PIXEL_PACK_BUFFER, m_packBuffer);
+    gl.BufferData(gl::PIXEL_PACK_BUFFER, static_cast<gl::GLsizeiptr>(pitch) * rows, nullptr, gl::STREAM_READ);
+    gl.ReadPixels(0, 0, static_cast<gl::GLsizei>(pitch), static_cast<gl::GLsizei>(rows), gl::RED, gl::UNSIGNED_BYTE, nullptr);
+    gl.BindFramebuffer(gl::READ_FRAMEBUFFER, static_cast<gl::GLuint>(readFramebuffer));
+
+    transfer(size, destination);
+}
+
+
+void Readback::transfer(std::size_t size, void* destination) {
+    const auto& gl = m_context->functions();
+
+    const auto mapped = gl.MapBufferRange(gl::PIXEL_PACK_BUFFER, 0, static_cast<gl::GLsizeiptr>(size), gl::MAP_READ_BIT);
+    if (mapped == nullptr) {
+        throw InternalException(Error::OPENGL_ERROR, "glMapBufferRange failed on the pixel pack buffer");
+    }
+
+    std::memcpy(destination, mapped, size);
+    gl.UnmapBuffer(gl::PIXEL_PACK_BUFFER);
+}
+
+
+void Readback::prepareConversion() {
+    if (m_program != 0) {
+        return;
+    }
+
+    const auto& gl = m_context->functions();
+
+    m_program = gl::createProgram(gl, k_vertexShader, k_fragmentShader);
+    gl.UseProgram(m_program);
+    gl.Uniform1i(gl.GetUniformLocation(m_program, "u_source"), 0);
+
+    gl.GenVertexArrays(1, &m_vertexArray);
+    gl.GenFramebuffers(1, &m_framebuffer);
+    if (m_packBuffer == 0) {
+        gl.GenBuffers(1, &m_packBuffer);
+    }
+
+    gl.GenTextures(1, &m_sourceTexture);
+    gl.GenTextures(1, &m_targetTexture);
+    for (const auto texture : { m_sourceTexture, m_targetTexture }) {
+        gl.BindTexture(gl::TEXTURE_2D, texture);
+        gl.TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MIN_FILTER, texture == m_sourceTexture ? gl::NEAREST_MIPMAP_NEAREST : gl::NEAREST);
+        gl.TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MAG_FILTER, gl::NEAREST);
+    }
+}
+
+
+}  // namespace glheadless
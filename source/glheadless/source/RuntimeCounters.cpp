@@ -0,0 +1,296 @@
+#include "RuntimeCounters.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <glheadless/error.h>
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+struct Histogram {
+    std::atomic<std::uint64_t> buckets[k_latencyBucketCount];
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> nanoseconds;
+};
+
+
+struct Counters {
+    Histogram                  operations[RuntimeCounters::OPERATION_COUNT];
+    std::atomic<std::uint64_t> errors[RuntimeCounters::OPERATION_COUNT][k_errorCounterCount];
+    Histogram                  phases[RuntimeCounters::PHASE_COUNT];
+    Histogram                  lockWaits[RuntimeCounters::LOCK_COUNT];
+    std::atomic<std::uint64_t> lockAcquisitions[RuntimeCounters::LOCK_COUNT];
+    std::atomic<std::uint64_t> lockContentions[RuntimeCounters::LOCK_COUNT];
+};
+
+
+const std::size_t k_histogramCount = RuntimeCounters::OPERATION_COUNT + RuntimeCounters::PHASE_COUNT + RuntimeCounters::LOCK_COUNT;
+const std::size_t k_firstPhase     = RuntimeCounters::OPERATION_COUNT;
+const std::size_t k_firstLock      = RuntimeCounters::OPERATION_COUNT + RuntimeCounters::PHASE_COUNT;
+
+
+// plain sums, e.g., of exited threads
+struct Totals {
+    std::uint64_t buckets[k_histogramCount][k_latencyBucketCount];
+    std::uint64_t count[k_histogramCount];
+    std::uint64_t nanoseconds[k_histogramCount];
+    std::uint64_t errors[RuntimeCounters::OPERATION_COUNT][k_errorCounterCount];
+    std::uint64_t lockAcquisitions[RuntimeCounters::LOCK_COUNT];
+    std::uint64_t lockContentions[RuntimeCounters::LOCK_COUNT];
+};
+
+
+void zero(Counters& counters) {
+    const auto clear = [] (Histogram& histogram) {
+        for (auto& bucket : histogram.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        histogram.count.store(0, std::memory_order_relaxed);
+        histogram.nanoseconds.store(0, std::memory_order_relaxed);
+    };
+    for (auto& histogram : counters.operations) {
+        clear(histogram);
+    }
+    for (auto& histogram : counters.phases) {
+        clear(histogram);
+    }
+    for (auto& histogram : counters.lockWaits) {
+        clear(histogram);
+    }
+    for (auto& acquisitions : counters.lockAcquisitions) {
+        acquisitions.store(0, std::memory_order_relaxed);
+    }
+    for (auto& contentions : counters.lockContentions) {
+        contentions.store(0, std::memory_order_relaxed);
+    }
+    for (auto& errors : counters.errors) {
+        for (auto& error : errors) {
+            error.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+
+void add(Totals& totals, const Counters& counters) {
+    const auto addHistogram = [&totals] (std::size_t index, const Histogram& histogram) {
+        for (std::size_t i = 0; i < k_latencyBucketCount; ++i) {
+            totals.buckets[index][i] += histogram.buckets[i].load(std::memory_order_relaxed);
+        }
+        totals.count[index] += histogram.count.load(std::memory_order_relaxed);
+        totals.nanoseconds[index] += histogram.nanoseconds.load(std::memory_order_relaxed);
+    };
+    for (std::size_t i = 0; i < RuntimeCounters::OPERATION_COUNT; ++i) {
+        addHistogram(i, counters.operations[i]);
+        for (std::size_t j = 0; j < k_errorCounterCount; ++j) {
+            totals.errors[i][j] += counters.errors[i][j].load(std::memory_order_relaxed);
+        }
+    }
+    for (std::size_t i = 0; i < RuntimeCounters::PHASE_COUNT; ++i) {
+        addHistogram(k_firstPhase + i, counters.phases[i]);
+    }
+    for (std::size_t i = 0; i < RuntimeCounters::LOCK_COUNT; ++i) {
+        addHistogram(k_firstLock + i, counters.lockWaits[i]);
+        totals.lockAcquisitions[i] += counters.lockAcquisitions[i].load(std::memory_order_relaxed);
+        totals.lockContentions[i] += counters.lockContentions[i].load(std::memory_order_relaxed);
+    }
+}
+
+
+class Registry {
+public:
+    Counters* attach() {
+        std::unique_ptr<Counters> counters(new Counters);
+        zero(*counters);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_threads.push_back(counters.get());
+        return counters.release();
+    }
+
+    void detach(Counters* counters) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        add(m_exited, *counters);
+        m_threads.erase(std::find(m_threads.begin(), m_threads.end(), counters));
+        delete counters;
+    }
+
+    Totals totals() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto totals = sum();
+        subtract(totals);
+        return totals;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_baseline = sum();
+    }
+
+
+private:
+    Totals sum() const {
+        auto totals = m_exited;
+        for (const auto counters : m_threads) {
+            add(totals, *counters);
+        }
+        return totals;
+    }
+
+    void subtract(Totals& totals) const {
+        const auto count = sizeof(Totals) / sizeof(std::uint64_t);
+        const auto values = reinterpret_cast<std::uint64_t*>(&totals);
+        const auto baseline = reinterpret_cast<const std::uint64_t*>(&m_baseline);
+        for (std::size_t i = 0; i < count; ++i) {
+            values[i] -= baseline[i];
+        }
+    }
+
+
+private:
+    std::mutex             m_mutex;
+    std::vector<Counters*> m_threads;
+    Totals                 m_exited   = Totals();
+    Totals                 m_baseline = Totals(); // sums at the last reset
+};
+
+
+// never destroyed, as threads may exit after static destruction began
+Registry& registry() {
+    static const auto s_registry = new Registry;
+    return *s_registry;
+}
+
+
+class ThreadCounters {
+public:
+    ~ThreadCounters() {
+        if (m_counters != nullptr) {
+            registry().detach(m_counters);
+        }
+    }
+
+    Counters& get() {
+        if (m_counters == nullptr) {
+            m_counters = registry().attach();
+        }
+        return *m_counters;
+    }
+
+
+private:
+    Counters* m_counters = nullptr;
+};
+
+
+thread_local ThreadCounters t_counters;
+
+
+// only the owning thread writes its counters, so a plain load and store suffice and readers see whole values
+void increment(std::atomic<std::uint64_t>& counter, std::uint64_t value = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+
+void record(Histogram& histogram, RuntimeCounters::Clock::time_point start) {
+    const auto nanoseconds = static_cast<std::uint64_t>(std::max<std::int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(RuntimeCounters::Clock::now() - start).count()));
+
+    // bucket i holds latencies up to 2^i microseconds
+    std::size_t bucket = 0;
+    while (bucket + 1 < k_latencyBucketCount && nanoseconds > (std::uint64_t(1000) << bucket)) {
+        ++bucket;
+    }
+    increment(histogram.buckets[bucket]);
+    increment(histogram.count);
+    increment(histogram.nanoseconds, nanoseconds);
+}
+
+
+LatencyHistogram histogram(const Totals& totals, std::size_t index) {
+    LatencyHistogram histogram;
+    histogram.bucketCounts.assign(totals.buckets[index], totals.buckets[index] + k_latencyBucketCount);
+    histogram.count = totals.count[index];
+    histogram.totalSeconds = static_cast<double>(totals.nanoseconds[index]) / 1.0e9;
+    return histogram;
+}
+
+
+OperationStatistics operation(const Totals& totals, std::size_t index) {
+    OperationStatistics operation;
+    operation.callCount = totals.count[index];
+    operation.errorCounts.assign(totals.errors[index], totals.errors[index] + k_errorCounterCount);
+    operation.latency = histogram(totals, index);
+    return operation;
+}
+
+
+LockStatistics lock(const Totals& totals, std::size_t index) {
+    LockStatistics lock;
+    lock.acquisitionCount = totals.lockAcquisitions[index];
+    lock.wait = histogram(totals, k_firstLock + index);
+    lock.contendedCount = totals.lockContentions[index];
+    return lock;
+}
+
+
+}  // unnamed namespace
+
+
+void RuntimeCounters::record(Operation operation, Clock::time_point start, const std::error_code& error) {
+    auto& counters = t_counters.get();
+    glheadless::record(counters.operations[operation], start);
+    if (error) {
+        const auto known = error.category() == glheadless_category() && error.value() > 0 && static_cast<std::size_t>(error.value()) < k_errorCounterCount;
+        increment(counters.errors[operation][known ? error.value() : 0]);
+    }
+}
+
+
+void RuntimeCounters::record(Phase phase, Clock::time_point start) {
+    glheadless::record(t_counters.get().phases[phase], start);
+}
+
+
+void RuntimeCounters::record(Lock lock, bool contended, Clock::time_point start) {
+    auto& counters = t_counters.get();
+    increment(counters.lockAcquisitions[lock]);
+    if (contended) {
+        increment(counters.lockContentions[lock]);
+        if (start != Clock::time_point()) {
+            glheadless::record(counters.lockWaits[lock], start);
+        }
+    }
+}
+
+
+RuntimeStatistics RuntimeCounters::snapshot() {
+    const auto totals = registry().totals();
+
+    RuntimeStatistics statistics;
+    statistics.create = operation(totals, CREATE);
+    statistics.makeCurrent = operation(totals, MAKE_CURRENT);
+    statistics.doneCurrent = operation(totals, DONE_CURRENT);
+    statistics.destroy = operation(totals, DESTROY);
+    statistics.chooseConfig = histogram(totals, k_firstPhase + CHOOSE_CONFIG);
+    statistics.createContext = histogram(totals, k_firstPhase + CREATE_CONTEXT);
+    statistics.createPbuffer = histogram(totals, k_firstPhase + CREATE_PBUFFER);
+    statistics.testMakeCurrent = histogram(totals, k_firstPhase + TEST_MAKE_CURRENT);
+    statistics.platformInstanceLock = lock(totals, PLATFORM_INSTANCE);
+    statistics.errorHandlerSwap = lock(totals, ERROR_HANDLER);
+    return statistics;
+}
+
+
+void RuntimeCounters::reset() {
+    registry().reset();
+}
+
+
+}  // namespace glheadless
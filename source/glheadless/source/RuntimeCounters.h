@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <system_error>
+
+#include <glheadless/RuntimeStatistics.h>
+
+
+namespace glheadless {
+
+
+/*
+ * Per-thread counters behind runtimeStatistics(). Each thread records into counters of its own, registered on first
+ * use, so recording takes no lock; snapshot() sums them up under the registry lock. The counters of a thread that
+ * exits are folded into the registry's totals.
+ */
+class RuntimeCounters {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Operation {
+        CREATE,
+        MAKE_CURRENT,
+        DONE_CURRENT,
+        DESTROY,
+        OPERATION_COUNT
+    };
+
+    enum Phase {
+        CHOOSE_CONFIG,
+        CREATE_CONTEXT,
+        CREATE_PBUFFER,
+        TEST_MAKE_CURRENT,
+        PHASE_COUNT
+    };
+
+    enum Lock {
+        PLATFORM_INSTANCE,
+        ERROR_HANDLER,
+        LOCK_COUNT
+    };
+
+    // counts a call that started at start and ends now; a non-zero error counts it as failed
+    static void record(Operation operation, Clock::time_point start, const std::error_code& error);
+
+    // counts a creation phase that started at start and ends now
+    static void record(Phase phase, Clock::time_point start);
+
+    // counts an acquisition of an internal lock; a contended one waited from start until now, unless start is the
+    // default time point
+    static void record(Lock lock, bool contended, Clock::time_point start);
+
+    static RuntimeStatistics snapshot();
+    static void reset();
+};
+
+
+/*
+ * Locks a mutex for its lifetime like std::lock_guard and counts the acquisition as lock. Only if the mutex is held by
+ * another thread, the clock is read to measure the wait.
+ */
+class CountedLockGuard {
+public:
+    CountedLockGuard(std::mutex& mutex, RuntimeCounters::Lock lock)
+    : m_mutex(mutex) {
+        if (m_mutex.try_lock()) {
+            RuntimeCounters::record(lock, false, RuntimeCounters::Clock::time_point());
+            return;
+        }
+
+        const auto start = RuntimeCounters::Clock::now();
+        m_mutex.lock();
+        RuntimeCounters::record(lock, true, start);
+    }
+
+    CountedLockGuard(const CountedLockGuard&) = delete;
+
+    ~CountedLockGuard() {
+        m_mutex.unlock();
+    }
+
+    CountedLockGuard& operator=(const CountedLockGuard&) = delete;
+
+
+private:
+    std::mutex& m_mutex;
+};
+
+
+}  // namespace glheadless
@@ -0,0 +1,143 @@
+#include <glheadless/RuntimeStatistics.h>
+
+#include <locale>
+#include <sstream>
+
+#include "RuntimeCounters.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+const char* const k_errorLabels[k_errorCounterCount] = {
+    "other",
+    "invalid_context",
+    "invalid_configuration",
+    "unsupported_feature",
+    "invalid_argument",
+    "opengl_error"
+};
+
+
+struct NamedOperation {
+    const char*                name;
+    const OperationStatistics& statistics;
+};
+
+
+struct NamedPhase {
+    const char*             name;
+    const LatencyHistogram& histogram;
+};
+
+
+struct NamedLock {
+    const char*           name;
+    const LockStatistics& statistics;
+};
+
+
+void writeHistogram(std::ostream& stream, const char* metric, const char* label, const char* value, const LatencyHistogram& histogram) {
+    std::uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < k_latencyBucketCount; ++i) {
+        cumulative += histogram.bucketCounts[i];
+        stream << metric << "_bucket{" << label << "=\"" << value << "\",le=\"";
+        if (i + 1 < k_latencyBucketCount) {
+            stream << LatencyHistogram::upperBound(i);
+        } else {
+            stream << "+Inf";
+        }
+        stream << "\"} " << cumulative << "\n";
+    }
+    stream << metric << "_sum{" << label << "=\"" << value << "\"} " << histogram.totalSeconds << "\n";
+    stream << metric << "_count{" << label << "=\"" << value << "\"} " << histogram.count << "\n";
+}
+
+
+}  // unnamed namespace
+
+
+RuntimeStatistics runtimeStatistics() {
+    return RuntimeCounters::snapshot();
+}
+
+
+void resetRuntimeStatistics() {
+    RuntimeCounters::reset();
+}
+
+
+std::string toPrometheusText(const RuntimeStatistics& statistics) {
+    const NamedOperation operations[] = {
+        { "create", statistics.create },
+        { "make_current", statistics.makeCurrent },
+        { "done_current", statistics.doneCurrent },
+        { "destroy", statistics.destroy }
+    };
+    const NamedPhase phases[] = {
+        { "choose_config", statistics.chooseConfig },
+        { "create_context", statistics.createContext },
+        { "create_pbuffer", statistics.createPbuffer },
+        { "test_make_current", statistics.testMakeCurrent }
+    };
+    const NamedLock locks[] = {
+        { "platform_instance", statistics.platformInstanceLock },
+        { "error_handler", statistics.errorHandlerSwap }
+    };
+
+    // the format requires '.' as decimal separator, whatever the global locale
+    std::ostringstream stream;
+    stream.imbue(std::locale::classic());
+
+    stream << "# HELP glheadless_operations_total Context operations, including failed ones.\n";
+    stream << "# TYPE glheadless_operations_total counter\n";
+    for (const auto& operation : operations) {
+        stream << "glheadless_operations_total{operation=\"" << operation.name << "\"} " << operation.statistics.callCount << "\n";
+    }
+
+    stream << "# HELP glheadless_operation_errors_total Failed context operations by error.\n";
+    stream << "# TYPE glheadless_operation_errors_total counter\n";
+    for (const auto& operation : operations) {
+        for (std::size_t i = 0; i < k_errorCounterCount; ++i) {
+            stream << "glheadless_operation_errors_total{operation=\"" << operation.name << "\",error=\"" << k_errorLabels[i] << "\"} " << operation.statistics.errorCounts[i] << "\n";
+        }
+    }
+
+    stream << "# HELP glheadless_operation_duration_seconds Latency of context operations.\n";
+    stream << "# TYPE glheadless_operation_duration_seconds histogram\n";
+    for (const auto& operation : operations) {
+        writeHistogram(stream, "glheadless_operation_duration_seconds", "operation", operation.name, operation.statistics.latency);
+    }
+
+    stream << "# HELP glheadless_creation_phase_duration_seconds Latency of the phases of context creation.\n";
+    stream << "# TYPE glheadless_creation_phase_duration_seconds histogram\n";
+    for (const auto& phase : phases) {
+        writeHistogram(stream, "glheadless_creation_phase_duration_seconds", "phase", phase.name, phase.histogram);
+    }
+
+    stream << "# HELP glheadless_lock_acquisitions_total Acquisitions of internal locks.\n";
+    stream << "# TYPE glheadless_lock_acquisitions_total counter\n";
+    for (const auto& lock : locks) {
+        stream << "glheadless_lock_acquisitions_total{lock=\"" << lock.name << "\"} " << lock.statistics.acquisitionCount << "\n";
+    }
+
+    stream << "# HELP glheadless_lock_contended_total Acquisitions of internal locks held by another thread.\n";
+    stream << "# TYPE glheadless_lock_contended_total counter\n";
+    for (const auto& lock : locks) {
+        stream << "glheadless_lock_contended_total{lock=\"" << lock.name << "\"} " << lock.statistics.contendedCount << "\n";
+    }
+
+    stream << "# HELP glheadless_lock_wait_seconds Waiting time of contended acquisitions of internal locks.\n";
+    stream << "# TYPE glheadless_lock_wait_seconds histogram\n";
+    for (const auto& lock : locks) {
+        writeHistogram(stream, "glheadless_lock_wait_seconds", "lock", lock.name, lock.statistics.wait);
+    }
+
+    return stream.str();
+}
+
+
+}  // namespace glheadless
@@ -0,0 +1,225 @@
+#include <glheadless/ShaderCompiler.h>
+
+#include <algorithm>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/error.h>
+
+#include "GLFunctions.h"
+#include "InternalException.h"
+#include "ShaderProgram.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+// jobs a worker keeps submitted to a driver compiling in parallel; more only add to the time until the first result
+const std::size_t k_jobsInFlight = 16;
+
+// lets the driver choose the number of its compiler threads
+const gl::GLuint k_driverCompilerThreads = 0xFFFFFFFF;
+
+
+}  // unnamed namespace
+
+
+struct ShaderCompiler::Job {
+    std::vector<ShaderSource>   shaders;
+    std::promise<CompileResult> promise;
+    gl::PendingProgram          pending;
+    CompileResult               result;
+};
+
+
+ShaderCompiler::ShaderCompiler(const Context* shared, unsigned int threadCount, const ContextFormat& format)
+: m_threadCount(threadCount != 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u))
+, m_failedWorkerCount(0)
+, m_parallelWorkerCount(0)
+, m_stopping(false) {
+    m_threads.reserve(m_threadCount);
+    for (auto i = 0u; i < m_threadCount; ++i) {
+        m_threads.emplace_back(&ShaderCompiler::workerLoop, this, shared, format);
+    }
+}
+
+
+ShaderCompiler::~ShaderCompiler() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_queued.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+
+std::future<CompileResult> ShaderCompiler::compile(const std::vector<ShaderSource>& shaders) {
+    std::unique_ptr<Job> job(new Job);
+    job->shaders = shaders;
+    auto future = job->promise.get_future();
+
+    if (shaders.empty()) {
+        job->result.errorCode = make_error_code(Error::INVALID_ARGUMENT);
+        job->result.errorMessage = "Programs require at least one shader";
+        job->promise.set_value(std::move(job->result));
+        return future;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_failedWorkerCount == m_threadCount) {
+            job->result.errorCode = m_workerErrorCode;
+            job->result.errorMessage = m_workerErrorMessage;
+            job->promise.set_value(std::move(job->result));
+            return future;
+        }
+        m_queue.push_back(std::move(job));
+    }
+    m_queued.notify_one();
+
+    return future;
+}
+
+
+std::future<CompileResult> ShaderCompiler::compile(const std::string& vertexSource, const std::string& fragmentSource) {
+    std::vector<ShaderSource> shaders(2);
+    shaders[0].type = gl::VERTEX_SHADER;
+    shaders[0].source = vertexSource;
+    shaders[1].type = gl::FRAGMENT_SHADER;
+    shaders[1].source = fragmentSource;
+
+    return compile(shaders);
+}
+
+
+unsigned int ShaderCompiler::threadCount() const {
+    return m_threadCount;
+}
+
+
+unsigned int ShaderCompiler::parallelWorkerCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_parallelWorkerCount;
+}
+
+
+void ShaderCompiler::workerLoop(const Context* shared, ContextFormat format) {
+    // contexts must be destroyed on the thread that created them, so each worker owns its context
+    auto context = ContextFactory::create(shared, format);
+    if (!context->valid() || !context->makeCurrent()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_workerErrorCode = context->lastErrorCode();
+        m_workerErrorMessage = context->lastErrorMessage();
+        if (++m_failedWorkerCount == m_threadCount) {
+            failQueue(m_workerErrorCode, m_workerErrorMessage);
+        }
+        return;
+    }
+
+    const auto& gl = context->functions();
+    const auto parallel = gl.MaxShaderCompilerThreadsKHR != nullptr && gl.hasExtension("GL_KHR_parallel_shader_compile");
+    if (parallel) {
+        gl.MaxShaderCompilerThreadsKHR(k_driverCompilerThreads);
+    }
+    const auto fence = gl.FenceSync != nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_parallelWorkerCount += parallel ? 1 : 0;
+    }
+
+    std::deque<std::unique_ptr<Job>> inFlight;
+    std::vector<std::unique_ptr<Job>> finished;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        if (inFlight.empty()) {
+            m_queued.wait(lock, [this] {
+                return m_stopping || !m_queue.empty();
+            });
+            if (m_queue.empty()) {
+                break;
+            }
+        }
+
+        // with parallel compilation, submitting more jobs ahead keeps the driver's compiler threads busy
+        std::vector<std::unique_ptr<Job>> submitted;
+        const auto limit = parallel ? k_jobsInFlight : 1;
+        while (!m_queue.empty() && inFlight.size() + submitted.size() < limit) {
+            submitted.push_back(std::move(m_queue.front()));
+            m_queue.pop_front();
+        }
+        lock.unlock();
+
+        for (auto& job : submitted) {
+            std::vector<gl::ShaderStage> stages;
+            stages.reserve(job->shaders.size());
+            for (const auto& shader : job->shaders) {
+                stages.push_back({ shader.type, shader.source.c_str() });
+            }
+            job->pending = gl::beginProgram(gl, stages.data(), stages.size(), false);
+            inFlight.push_back(std::move(job));
+        }
+
+        // finish every completed job; if none completed yet, block on the oldest
+        for (auto it = inFlight.begin(); parallel && it != inFlight.end(); ) {
+            if (gl::programCompleted(gl, (*it)->pending)) {
+                finished.push_back(std::move(*it));
+                it = inFlight.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (finished.empty()) {
+            finished.push_back(std::move(inFlight.front()));
+            inFlight.pop_front();
+        }
+
+        for (auto& job : finished) {
+            try {
+                job->result.program = gl::finishProgram(gl, job->pending);
+            } catch (InternalException& e) {
+                job->result.errorCode = e.code();
+                job->result.errorMessage = e.message();
+            }
+        }
+
+        // the programs must be complete before other contexts of the share group observe them
+        if (fence) {
+            const auto sync = gl.FenceSync(gl::SYNC_GPU_COMMANDS_COMPLETE, 0);
+            gl.ClientWaitSync(sync, gl::SYNC_FLUSH_COMMANDS_BIT, gl::TIMEOUT_IGNORED);
+            gl.DeleteSync(sync);
+        } else {
+            gl.Finish();
+        }
+
+        for (auto& job : finished) {
+            job->promise.set_value(std::move(job->result));
+        }
+        finished.clear();
+
+        lock.lock();
+    }
+    lock.unlock();
+
+    context->doneCurrent();
+}
+
+
+void ShaderCompiler::failQueue(const std::error_code& code, const std::string& message) {
+    for (auto& job : m_queue) {
+        job->result.errorCode = code;
+        job->result.errorMessage = message;
+        job->promise.set_value(std::move(job->result));
+    }
+    m_queue.clear();
+}
+
+
+}  // namespace glheadless
@@ -0,0 +1,115 @@
+#include "ShaderProgram.h"
+
+#include <string>
+
+#include "InternalException.h"
+
+
+namespace glheadless {
+namespace gl {
+
+
+namespace {
+
+
+std::string shaderLog(const Functions& gl, GLuint shader) {
+    GLint length = 0;
+    gl.GetShaderiv(shader, INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> log(static_cast<std::size_t>(length) + 1, '\0');
+    gl.GetShaderInfoLog(shader, length, nullptr, log.data());
+    return log.data();
+}
+
+
+std::string programLog(const Functions& gl, GLuint program) {
+    GLint length = 0;
+    gl.GetProgramiv(program, INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> log(static_cast<std::size_t>(length) + 1, '\0');
+    gl.GetProgramInfoLog(program, length, nullptr, log.data());
+    return log.data();
+}
+
+
+}  // unnamed namespace
+
+
+GLuint createProgram(const Functions& gl, const char* vertexSource, const char* fragmentSource) {
+    const ShaderStage stages[] = {
+        { VERTEX_SHADER, vertexSource },
+        { FRAGMENT_SHADER, fragmentSource }
+    };
+
+    return createProgram(gl, stages, 2, false);
+}
+
+
+GLuint createProgram(const Functions& gl, const ShaderStage* stages, std::size_t count, bool retrievable) {
+    auto pending = beginProgram(gl, stages, count, retrievable);
+    return finishProgram(gl, pending);
+}
+
+
+PendingProgram beginProgram(const Functions& gl, const ShaderStage* stages, std::size_t count, bool retrievable) {
+    PendingProgram pending;
+    pending.program = gl.CreateProgram();
+    if (retrievable) {
+        gl.ProgramParameteri(pending.program, PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
+    }
+
+    pending.shaders.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto shader = gl.CreateShader(stages[i].type);
+        gl.ShaderSource(shader, 1, &stages[i].source, nullptr);
+        gl.CompileShader(shader);
+        gl.AttachShader(pending.program, shader);
+        pending.shaders.push_back(shader);
+    }
+    gl.LinkProgram(pending.program);
+
+    return pending;
+}
+
+
+bool programCompleted(const Functions& gl, const PendingProgram& pending) {
+    GLint completed = 0;
+    gl.GetProgramiv(pending.program, COMPLETION_STATUS, &completed);
+    return completed != 0;
+}
+
+
+GLuint finishProgram(const Functions& gl, PendingProgram& pending) {
+    // a failed compilation also fails the link, but its log is the useful one
+    std::string error;
+    for (const auto shader : pending.shaders) {
+        GLint status = 0;
+        gl.GetShaderiv(shader, COMPILE_STATUS, &status);
+        if (status == 0 && error.empty()) {
+            error = "shader compilation failed: " + shaderLog(gl, shader);
+        }
+    }
+
+    if (error.empty()) {
+        GLint status = 0;
+        gl.GetProgramiv(pending.program, LINK_STATUS, &status);
+        if (status == 0) {
+            error = "program linking failed: " + programLog(gl, pending.program);
+        }
+    }
+
+    // the shaders are released together with the program
+    for (const auto shader : pending.shaders) {
+        gl.DeleteShader(shader);
+    }
+    pending.shaders.clear();
+
+    if (!error.empty()) {
+        gl.DeleteProgram(pending.program);
+        throw InternalException(Error::OPENGL_ERROR, error);
+    }
+
+    return pending.program;
+}
+
+
+}  // namespace gl
+}  // namespace glheadless
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+#include "GLFunctions.h"
+
+
+namespace glheadless {
+namespace gl {
+
+
+struct ShaderStage {
+    GLenum      type;
+    const char* source;
+};
+
+
+/*
+ * A program whose shaders were submitted for compilation and linking, but whose status was not queried yet.
+ */
+struct PendingProgram {
+    GLuint              program;
+    std::vector<GLuint> shaders;
+};
+
+
+/*
+ * Compiles and links a program from vertex and fragment shader sources.
+ * Throws InternalException with Error::OPENGL_ERROR and the info log on failure.
+ */
+GLuint createProgram(const Functions& gl, const char* vertexSource, const char* fragmentSource);
+
+/*
+ * Compiles and links a program from any number of shader stages, see above. A retrievable program can be saved with
+ * glGetProgramBinary().
+ */
+GLuint createProgram(const Functions& gl, const ShaderStage* stages, std::size_t count, bool retrievable);
+
+/*
+ * Split form of createProgram(): beginProgram() submits all work without querying any status, so drivers supporting
+ * GL_KHR_parallel_shader_compile can compile in the background. programCompleted() polls GL_COMPLETION_STATUS_KHR and
+ * requires that extension. finishProgram() waits for the result, releases the shaders and throws like createProgram();
+ * the pending program must not be used afterwards.
+ */
+PendingProgram beginProgram(const Functions& gl, const ShaderStage* stages, std::size_t count, bool retrievable);
+bool programCompleted(const Functions& gl, const PendingProgram& pending);
+GLuint finishProgram(const Functions& gl, PendingProgram& pending);
+
+
+}  // namespace gl
+}  // namespace glheadless
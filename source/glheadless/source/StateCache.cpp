@@ -0,0 +1,510 @@
+#include "StateCache.h"
+
+#include <cstring>
+
+
+
+namespace glheadless {
+namespace gl {
+
+
+namespace {
+
+
+thread_local StateCache* t_current = nullptr;
+thread_local const StateCacheFallback* t_fallback = nullptr;
+
+
+// driver entry points last resolved by any cache, for calls made while no context that cached is current on the
+// thread; only valid where entry points do not depend on the context (GLX, EGL), not on WGL
+struct Fallback {
+#define GLHEADLESS_DECLARE_FALLBACK_GL_FUNCTION(name, signature) \
+    std::atomic<Proc<signature>::Type> name;
+    GLHEADLESS_CACHED_GL_FUNCTIONS(GLHEADLESS_DECLARE_FALLBACK_GL_FUNCTION)
+#undef GLHEADLESS_DECLARE_FALLBACK_GL_FUNCTION
+};
+
+Fallback g_fallback;
+
+
+#define GLHEADLESS_FALLBACK(name) \
+    (t_fallback != nullptr ? t_fallback->driver.name : g_fallback.name.load(std::memory_order_relaxed))
+
+
+const GLenum k_textureTargets[StateCache::k_textureTargets] = {
+    TEXTURE_2D, TEXTURE_3D, TEXTURE_2D_ARRAY, TEXTURE_CUBE_MAP
+};
+
+const GLenum k_bufferTargets[StateCache::k_bufferTargets] = {
+    ARRAY_BUFFER, ELEMENT_ARRAY_BUFFER, PIXEL_PACK_BUFFER, PIXEL_UNPACK_BUFFER, COPY_READ_BUFFER, COPY_WRITE_BUFFER,
+    DRAW_INDIRECT_BUFFER
+};
+
+const GLenum k_capabilities[StateCache::k_capabilities] = {
+    BLEND, CULL_FACE, DEPTH_TEST, DITHER, FRAMEBUFFER_SRGB, MULTISAMPLE, POLYGON_OFFSET_FILL, PRIMITIVE_RESTART,
+    RASTERIZER_DISCARD, SAMPLE_ALPHA_TO_COVERAGE, SCISSOR_TEST, STENCIL_TEST
+};
+
+
+template <std::size_t N>
+int indexOf(const GLenum (&values)[N], GLenum value) {
+    for (std::size_t i = 0; i < N; ++i) {
+        if (values[i] == value) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+
+std::uint32_t bits(GLfloat value) {
+    std::uint32_t result;
+    std::memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+
+// the texture binding of the active unit, nullptr if the unit is unknown or the target is not tracked
+StateCache::Shadow<1>* textureBinding(StateCache& cache, GLenum target) {
+    const auto& unit = cache.state.activeTexture;
+    const auto index = indexOf(k_textureTargets, target);
+    if (!unit.known || unit.value[0] >= StateCache::k_textureUnits || index < 0) {
+        return nullptr;
+    }
+    return &cache.state.textures[unit.value[0]][index];
+}
+
+
+// deleting objects resets the bindings referring to them to 0
+void unbind(StateCache::Shadow<1>& shadow, GLsizei count, const GLuint* names) {
+    for (GLsizei i = 0; shadow.known && shadow.value[0] != 0 && i < count; ++i) {
+        if (names[i] == shadow.value[0]) {
+            shadow.value[0] = 0;
+        }
+    }
+}
+
+
+void GLHEADLESS_APIENTRY ActiveTexture(GLenum texture) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(ActiveTexture)(texture);
+    }
+    const std::uint32_t value[] = { texture - TEXTURE0 };
+    if (cache->update(cache->state.activeTexture, value)) {
+        cache->driver.ActiveTexture(texture);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY BindBuffer(GLenum target, GLuint buffer) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(BindBuffer)(target, buffer);
+    }
+    const auto index = indexOf(k_bufferTargets, target);
+    const std::uint32_t value[] = { buffer };
+    if (index < 0) {
+        cache->forward();
+    } else if (!cache->update(cache->state.buffers[index], value)) {
+        return;
+    }
+    cache->driver.BindBuffer(target, buffer);
+}
+
+
+void GLHEADLESS_APIENTRY BindFramebuffer(GLenum target, GLuint framebuffer) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(BindFramebuffer)(target, framebuffer);
+    }
+    auto& state = cache->state;
+    const std::uint32_t value[] = { framebuffer };
+    if (target == DRAW_FRAMEBUFFER || target == READ_FRAMEBUFFER) {
+        if (!cache->update(target == DRAW_FRAMEBUFFER ? state.drawFramebuffer : state.readFramebuffer, value)) {
+            return;
+        }
+    } else if (target == FRAMEBUFFER) {
+        // binds both targets; redundant only if both are bound to the framebuffer already
+        if (state.readFramebuffer.known && state.readFramebuffer.value[0] == framebuffer) {
+            if (!cache->update(state.drawFramebuffer, value)) {
+                return;
+            }
+        } else {
+            state.drawFramebuffer.known = true;
+            state.drawFramebuffer.value[0] = framebuffer;
+            cache->forward();
+        }
+        state.readFramebuffer = state.drawFramebuffer;
+    } else {
+        cache->forward();
+    }
+    cache->driver.BindFramebuffer(target, framebuffer);
+}
+
+
+void GLHEADLESS_APIENTRY BindTexture(GLenum target, GLuint texture) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(BindTexture)(target, texture);
+    }
+    const auto binding = textureBinding(*cache, target);
+    const std::uint32_t value[] = { texture };
+    if (binding == nullptr) {
+        cache->forward();
+    } else if (!cache->update(*binding, value)) {
+        return;
+    }
+    cache->driver.BindTexture(target, texture);
+}
+
+
+void GLHEADLESS_APIENTRY BindVertexArray(GLuint array) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(BindVertexArray)(array);
+    }
+    const std::uint32_t value[] = { array };
+    if (cache->update(cache->state.vertexArray, value)) {
+        // the element array buffer binding is part of the vertex array
+        cache->state.buffers[indexOf(k_bufferTargets, ELEMENT_ARRAY_BUFFER)].known = false;
+        cache->driver.BindVertexArray(array);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY BlendEquation(GLenum mode) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(BlendEquation)(mode);
+    }
+    const std::uint32_t value[] = { mode, mode };
+    if (cache->update(cache->state.blendEquation, value)) {
+        cache->driver.BlendEquation(mode);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY BlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(BlendEquationSeparate)(modeRGB, modeAlpha);
+    }
+    const std::uint32_t value[] = { modeRGB, modeAlpha };
+    if (cache->update(cache->state.blendEquation, value)) {
+        cache->driver.BlendEquationSeparate(modeRGB, modeAlpha);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY BlendFunc(GLenum source, GLenum destination) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(BlendFunc)(source, destination);
+    }
+    const std::uint32_t value[] = { source, destination, source, destination };
+    if (cache->update(cache->state.blendFunc, value)) {
+        cache->driver.BlendFunc(source, destination);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY BlendFuncSeparate(GLenum sourceRGB, GLenum destinationRGB, GLenum sourceAlpha, GLenum destinationAlpha) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(BlendFuncSeparate)(sourceRGB, destinationRGB, sourceAlpha, destinationAlpha);
+    }
+    const std::uint32_t value[] = { sourceRGB, destinationRGB, sourceAlpha, destinationAlpha };
+    if (cache->update(cache->state.blendFunc, value)) {
+        cache->driver.BlendFuncSeparate(sourceRGB, destinationRGB, sourceAlpha, destinationAlpha);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(ClearColor)(red, green, blue, alpha);
+    }
+    const std::uint32_t value[] = { bits(red), bits(green), bits(blue), bits(alpha) };
+    if (cache->update(cache->state.clearColor, value)) {
+        cache->driver.ClearColor(red, green, blue, alpha);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY ColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(ColorMask)(red, green, blue, alpha);
+    }
+    const std::uint32_t value[] = { red != 0, green != 0, blue != 0, alpha != 0 };
+    if (cache->update(cache->state.colorMask, value)) {
+        cache->driver.ColorMask(red, green, blue, alpha);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY CullFace(GLenum mode) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(CullFace)(mode);
+    }
+    const std::uint32_t value[] = { mode };
+    if (cache->update(cache->state.cullFace, value)) {
+        cache->driver.CullFace(mode);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY DeleteBuffers(GLsizei count, const GLuint* buffers) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(DeleteBuffers)(count, buffers);
+    }
+    for (auto& binding : cache->state.buffers) {
+        unbind(binding, count, buffers);
+    }
+    cache->forward();
+    cache->driver.DeleteBuffers(count, buffers);
+}
+
+
+void GLHEADLESS_APIENTRY DeleteFramebuffers(GLsizei count, const GLuint* framebuffers) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(DeleteFramebuffers)(count, framebuffers);
+    }
+    unbind(cache->state.drawFramebuffer, count, framebuffers);
+    unbind(cache->state.readFramebuffer, count, framebuffers);
+    cache->forward();
+    cache->driver.DeleteFramebuffers(count, framebuffers);
+}
+
+
+void GLHEADLESS_APIENTRY DeleteTextures(GLsizei count, const GLuint* textures) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(DeleteTextures)(count, textures);
+    }
+    for (auto& unit : cache->state.textures) {
+        for (auto& binding : unit) {
+            unbind(binding, count, textures);
+        }
+    }
+    cache->forward();
+    cache->driver.DeleteTextures(count, textures);
+}
+
+
+void GLHEADLESS_APIENTRY DeleteVertexArrays(GLsizei count, const GLuint* arrays) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(DeleteVertexArrays)(count, arrays);
+    }
+    auto& vertexArray = cache->state.vertexArray;
+    const auto bound = vertexArray.known ? vertexArray.value[0] : 0;
+    unbind(vertexArray, count, arrays);
+    if (bound != vertexArray.value[0]) {
+        cache->state.buffers[indexOf(k_bufferTargets, ELEMENT_ARRAY_BUFFER)].known = false;
+    }
+    cache->forward();
+    cache->driver.DeleteVertexArrays(count, arrays);
+}
+
+
+void GLHEADLESS_APIENTRY DepthFunc(GLenum function) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(DepthFunc)(function);
+    }
+    const std::uint32_t value[] = { function };
+    if (cache->update(cache->state.depthFunc, value)) {
+        cache->driver.DepthFunc(function);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY DepthMask(GLboolean flag) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(DepthMask)(flag);
+    }
+    const std::uint32_t value[] = { flag != 0 };
+    if (cache->update(cache->state.depthMask, value)) {
+        cache->driver.DepthMask(flag);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY Disable(GLenum capability) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(Disable)(capability);
+    }
+    const auto index = indexOf(k_capabilities, capability);
+    const std::uint32_t value[] = { 0 };
+    if (index < 0) {
+        cache->forward();
+    } else if (!cache->update(cache->state.capabilities[index], value)) {
+        return;
+    }
+    cache->driver.Disable(capability);
+}
+
+
+void GLHEADLESS_APIENTRY Enable(GLenum capability) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(Enable)(capability);
+    }
+    const auto index = indexOf(k_capabilities, capability);
+    const std::uint32_t value[] = { 1 };
+    if (index < 0) {
+        cache->forward();
+    } else if (!cache->update(cache->state.capabilities[index], value)) {
+        return;
+    }
+    cache->driver.Enable(capability);
+}
+
+
+void GLHEADLESS_APIENTRY FrontFace(GLenum mode) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(FrontFace)(mode);
+    }
+    const std::uint32_t value[] = { mode };
+    if (cache->update(cache->state.frontFace, value)) {
+        cache->driver.FrontFace(mode);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY Scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(Scissor)(x, y, width, height);
+    }
+    const std::uint32_t value[] = { static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y), static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height) };
+    if (cache->update(cache->state.scissor, value)) {
+        cache->driver.Scissor(x, y, width, height);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY UseProgram(GLuint program) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(UseProgram)(program);
+    }
+    const std::uint32_t value[] = { program };
+    if (cache->update(cache->state.program, value)) {
+        cache->driver.UseProgram(program);
+    }
+}
+
+
+void GLHEADLESS_APIENTRY Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    const auto cache = t_current;
+    if (cache == nullptr) {
+        return GLHEADLESS_FALLBACK(Viewport)(x, y, width, height);
+    }
+    const std::uint32_t value[] = { static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y), static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height) };
+    if (cache->update(cache->state.viewport, value)) {
+        cache->driver.Viewport(x, y, width, height);
+    }
+}
+
+
+#undef GLHEADLESS_FALLBACK
+
+
+}  // unnamed namespace
+
+
+StateCache::StateCache(const Resolver& resolver)
+: m_forwardedCount(0)
+, m_droppedCount(0) {
+    resolve(resolver);
+}
+
+
+void StateCache::resolve(const Resolver& resolver) {
+#define GLHEADLESS_RESOLVE_CACHED_GL_FUNCTION(name, signature) \
+    driver.name = reinterpret_cast<Proc<signature>::Type>(resolver("gl" #name)); \
+    if (driver.name != nullptr) { \
+        g_fallback.name.store(driver.name, std::memory_order_relaxed); \
+    }
+    GLHEADLESS_CACHED_GL_FUNCTIONS(GLHEADLESS_RESOLVE_CACHED_GL_FUNCTION)
+#undef GLHEADLESS_RESOLVE_CACHED_GL_FUNCTION
+}
+
+
+StateCache::Address StateCache::wrap(const char* name, Address address) const {
+    if (address == nullptr || std::strncmp(name, "gl", 2) != 0) {
+        return address;
+    }
+
+    // the wrappers are named like the entry points
+#define GLHEADLESS_WRAP_CACHED_GL_FUNCTION(function, signature) \
+    if (std::strcmp(name + 2, #function) == 0) { \
+        return driver.function != nullptr ? reinterpret_cast<Address>(static_cast<Proc<signature>::Type>(&function)) : address; \
+    }
+    GLHEADLESS_CACHED_GL_FUNCTIONS(GLHEADLESS_WRAP_CACHED_GL_FUNCTION)
+#undef GLHEADLESS_WRAP_CACHED_GL_FUNCTION
+
+    return address;
+}
+
+
+void StateCache::invalidate() {
+    state = State();
+}
+
+
+void StateCache::forward() {
+    m_forwardedCount.store(m_forwardedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+
+std::uint64_t StateCache::forwardedCount() const {
+    return m_forwardedCount.load(std::memory_order_relaxed);
+}
+
+
+std::uint64_t StateCache::droppedCount() const {
+    return m_droppedCount.load(std::memory_order_relaxed);
+}
+
+
+StateCache* StateCache::current() {
+    return t_current;
+}
+
+
+void StateCache::setCurrent(StateCache* cache) {
+    t_current = cache;
+}
+
+
+const StateCacheFallback* StateCache::fallback() {
+    return t_fallback;
+}
+
+
+void StateCache::setFallback(const StateCacheFallback* fallback) {
+    t_fallback = fallback;
+}
+
+
+void StateCacheFallback::resolve(const StateCache::Resolver& resolver) {
+#define GLHEADLESS_RESOLVE_FALLBACK_GL_FUNCTION(name, signature) \
+    driver.name = reinterpret_cast<Proc<signature>::Type>(resolver("gl" #name));
+    GLHEADLESS_CACHED_GL_FUNCTIONS(GLHEADLESS_RESOLVE_FALLBACK_GL_FUNCTION)
+#undef GLHEADLESS_RESOLVE_FALLBACK_GL_FUNCTION
+}
+
+
+}  // namespace gl
+}  // namespace glheadless
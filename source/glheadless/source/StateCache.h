@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "GLFunctions.h"
+
+
+namespace glheadless {
+
+
+namespace gl {
+
+
+/*
+ * Entry points replaced by the state cache, as F(name, signature); see GLHEADLESS_GL_FUNCTIONS.
+ */
+#define GLHEADLESS_CACHED_GL_FUNCTIONS(F) \
+    F(ActiveTexture,            void(GLenum)) \
+    F(BindBuffer,               void(GLenum, GLuint)) \
+    F(BindFramebuffer,          void(GLenum, GLuint)) \
+    F(BindTexture,              void(GLenum, GLuint)) \
+    F(BindVertexArray,          void(GLuint)) \
+    F(BlendEquation,            void(GLenum)) \
+    F(BlendEquationSeparate,    void(GLenum, GLenum)) \
+    F(BlendFunc,                void(GLenum, GLenum)) \
+    F(BlendFuncSeparate,        void(GLenum, GLenum, GLenum, GLenum)) \
+    F(ClearColor,               void(GLfloat, GLfloat, GLfloat, GLfloat)) \
+    F(ColorMask,                void(GLboolean, GLboolean, GLboolean, GLboolean)) \
+    F(CullFace,                 void(GLenum)) \
+    F(DeleteBuffers,            void(GLsizei, const GLuint*)) \
+    F(DeleteFramebuffers,       void(GLsizei, const GLuint*)) \
+    F(DeleteTextures,           void(GLsizei, const GLuint*)) \
+    F(DeleteVertexArrays,       void(GLsizei, const GLuint*)) \
+    F(DepthFunc,                void(GLenum)) \
+    F(DepthMask,                void(GLboolean)) \
+    F(Disable,                  void(GLenum)) \
+    F(Enable,                   void(GLenum)) \
+    F(FrontFace,                void(GLenum)) \
+    F(Scissor,                  void(GLint, GLint, GLsizei, GLsizei)) \
+    F(UseProgram,               void(GLuint)) \
+    F(Viewport,                 void(GLint, GLint, GLsizei, GLsizei))
+
+
+struct StateCacheFallback;
+
+
+/*
+ * Shadow copy of the common state of one context. Context::getProcAddress() hands out the filtering entry points of
+ * this file instead of the driver's; they look up the cache of the context current on the calling thread, drop calls
+ * setting the value already set and pass all others on. Values start unknown, so the first call always passes.
+ *
+ * Deleting a bound object resets the binding to 0, as the driver does. State changed behind the cache's back, i.e.,
+ * through other entry points or by another context deleting a bound object, requires invalidate().
+ */
+class StateCache {
+public:
+    using Address = void (*)();
+    using Resolver = std::function<Address(const char*)>;
+
+    template <std::size_t N>
+    struct Shadow {
+        bool          known = false;
+        std::uint32_t value[N];
+    };
+
+    static const std::size_t k_textureUnits = 32;
+    static const std::size_t k_textureTargets = 4;
+    static const std::size_t k_bufferTargets = 7;
+    static const std::size_t k_capabilities = 12;
+
+    struct State {
+        Shadow<1> activeTexture;
+        Shadow<1> textures[k_textureUnits][k_textureTargets];
+        Shadow<1> buffers[k_bufferTargets];
+        Shadow<1> drawFramebuffer;
+        Shadow<1> readFramebuffer;
+        Shadow<1> vertexArray;
+        Shadow<1> program;
+        Shadow<1> capabilities[k_capabilities];
+        Shadow<2> blendEquation;
+        Shadow<4> blendFunc;
+        Shadow<4> clearColor;
+        Shadow<4> colorMask;
+        Shadow<1> cullFace;
+        Shadow<1> depthFunc;
+        Shadow<1> depthMask;
+        Shadow<1> frontFace;
+        Shadow<4> scissor;
+        Shadow<4> viewport;
+    };
+
+    struct DriverFunctions {
+#define GLHEADLESS_DECLARE_CACHED_GL_FUNCTION(name, signature) \
+        gl::Proc<signature>::Type name = nullptr;
+        GLHEADLESS_CACHED_GL_FUNCTIONS(GLHEADLESS_DECLARE_CACHED_GL_FUNCTION)
+#undef GLHEADLESS_DECLARE_CACHED_GL_FUNCTION
+    };
+
+    // resolves the entry points the filtered calls are passed on to; the context must be current on the calling thread
+    explicit StateCache(const Resolver& resolver);
+
+    // resolves them again, e.g., after a trace was started or stopped
+    void resolve(const Resolver& resolver);
+
+    // the filtering replacement of a driver entry point, or the entry point itself if it is not filtered
+    Address wrap(const char* name, Address address) const;
+
+    void invalidate();
+
+    // true if a call setting the value must be passed on; records the value and counts the call
+    template <std::size_t N>
+    bool update(Shadow<N>& shadow, const std::uint32_t (&value)[N]);
+
+    // counts a call passed on without looking at the shadow copy
+    void forward();
+
+    std::uint64_t forwardedCount() const;
+    std::uint64_t droppedCount() const;
+
+    static StateCache* current();
+    static void setCurrent(StateCache* cache);
+
+    // the entry points passed on to while no cache is current on the thread, set with the context they belong to
+    static const StateCacheFallback* fallback();
+    static void setFallback(const StateCacheFallback* fallback);
+
+    DriverFunctions driver;
+    State           state;
+
+
+private:
+    std::atomic<std::uint64_t> m_forwardedCount;
+    std::atomic<std::uint64_t> m_droppedCount;
+};
+
+
+/*
+ * The driver entry points the filtering entry points of a context pass calls on to once its cache was disabled. The
+ * context keeps them and makes them current with itself, as on WGL entry points are only valid for contexts of the
+ * pixel format they were resolved for.
+ */
+struct StateCacheFallback {
+    void resolve(const StateCache::Resolver& resolver);
+
+    StateCache::DriverFunctions driver;
+};
+
+
+template <std::size_t N>
+bool StateCache::update(Shadow<N>& shadow, const std::uint32_t (&value)[N]) {
+    auto equal = shadow.known;
+    for (std::size_t i = 0; i < N && equal; ++i) {
+        equal = shadow.value[i] == value[i];
+    }
+
+    // a single thread updates the counters of a context at a time, others only read them
+    if (equal) {
+        m_droppedCount.store(m_droppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    shadow.known = true;
+    for (std::size_t i = 0; i < N; ++i) {
+        shadow.value[i] = value[i];
+    }
+    forward();
+    return true;
+}
+
+
+}  // namespace gl
+}  // namespace glheadless
@@ -0,0 +1,133 @@
+#include "StateGuard.h"
+
+
+namespace glheadless {
+namespace gl {
+
+
+namespace {
+
+
+void setEnabled(const Functions& gl, GLenum capability, GLboolean enabled) {
+    if (enabled) {
+        gl.Enable(capability);
+    } else {
+        gl.Disable(capability);
+    }
+}
+
+
+}  // unnamed namespace
+
+
+StateGuard::StateGuard(const Functions& gl)
+: m_gl(gl) {
+    gl.GetIntegerv(READ_FRAMEBUFFER_BINDING, &m_readFramebuffer);
+    gl.GetIntegerv(DRAW_FRAMEBUFFER_BINDING, &m_drawFramebuffer);
+    gl.GetIntegerv(CURRENT_PROGRAM, &m_program);
+    gl.GetIntegerv(VERTEX_ARRAY_BINDING, &m_vertexArray);
+    gl.GetIntegerv(ACTIVE_TEXTURE, &m_activeTexture);
+    gl.GetIntegerv(PIXEL_PACK_BUFFER_BINDING, &m_packBuffer);
+    gl.GetIntegerv(PIXEL_UNPACK_BUFFER_BINDING, &m_unpackBuffer);
+    gl.GetIntegerv(PACK_ALIGNMENT, &m_packAlignment);
+    gl.GetIntegerv(PACK_ROW_LENGTH, &m_packRowLength);
+    gl.GetIntegerv(PACK_SKIP_ROWS, &m_packSkipRows);
+    gl.GetIntegerv(PACK_SKIP_PIXELS, &m_packSkipPixels);
+    gl.GetIntegerv(VIEWPORT, m_viewport);
+    gl.GetBooleanv(COLOR_WRITEMASK, m_colorMask);
+    m_blend = gl.IsEnabled(BLEND);
+    m_cullFace = gl.IsEnabled(CULL_FACE);
+    m_depthTest = gl.IsEnabled(DEPTH_TEST);
+    m_scissorTest = gl.IsEnabled(SCISSOR_TEST);
+    m_stencilTest = gl.IsEnabled(STENCIL_TEST);
+
+    // internal passes always use texture unit 0
+    gl.ActiveTexture(TEXTURE0);
+    gl.GetIntegerv(TEXTURE_BINDING_2D, &m_texture);
+
+    gl.Disable(BLEND);
+    gl.Disable(CULL_FACE);
+    gl.Disable(DEPTH_TEST);
+    gl.Disable(SCISSOR_TEST);
+    gl.Disable(STENCIL_TEST);
+    gl.ColorMask(1, 1, 1, 1);
+    // texture allocations pass nullptr, which would be an offset into a bound unpack buffer
+    gl.BindBuffer(PIXEL_UNPACK_BUFFER, 0);
+    gl.PixelStorei(PACK_ALIGNMENT, 1);
+    gl.PixelStorei(PACK_ROW_LENGTH, 0);
+    gl.PixelStorei(PACK_SKIP_ROWS, 0);
+    gl.PixelStorei(PACK_SKIP_PIXELS, 0);
+}
+
+
+StateGuard::~StateGuard() {
+    const auto& gl = m_gl;
+
+    gl.BindFramebuffer(READ_FRAMEBUFFER, static_cast<GLuint>(m_readFramebuffer));
+    gl.BindFramebuffer(DRAW_FRAMEBUFFER, static_cast<GLuint>(m_drawFramebuffer));
+    gl.UseProgram(static_cast<GLuint>(m_program));
+    gl.BindVertexArray(static_cast<GLuint>(m_vertexArray));
+    gl.BindTexture(TEXTURE_2D, static_cast<GLuint>(m_texture));
+    gl.ActiveTexture(static_cast<GLenum>(m_activeTexture));
+    gl.BindBuffer(PIXEL_PACK_BUFFER, static_cast<GLuint>(m_packBuffer));
+    gl.BindBuffer(PIXEL_UNPACK_BUFFER, static_cast<GLuint>(m_unpackBuffer));
+    gl.PixelStorei(PACK_ALIGNMENT, m_packAlignment);
+    gl.PixelStorei(PACK_ROW_LENGTH, m_packRowLength);
+    gl.PixelStorei(PACK_SKIP_ROWS, m_packSkipRows);
+    gl.PixelStorei(PACK_SKIP_PIXELS, m_packSkipPixels);
+    gl.Viewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+    gl.ColorMask(m_colorMask[0], m_colorMask[1], m_colorMask[2], m_colorMask[3]);
+    setEnabled(gl, BLEND, m_blend);
+    setEnabled(gl, CULL_FACE, m_cullFace);
+    setEnabled(gl, DEPTH_TEST, m_depthTest);
+    setEnabled(gl, SCISSOR_TEST, m_scissorTest);
+    setEnabled(gl, STENCIL_TEST, m_stencilTest);
+}
+
+
+BufferBinding::BufferBinding(const Functions& gl, GLenum target, GLuint buffer)
+: m_gl(gl)
+, m_target(target)
+, m_previous(0) {
+    // the copy targets double as their binding queries
+    m_gl.GetIntegerv(m_target, &m_previous);
+    m_gl.BindBuffer(m_target, buffer);
+}
+
+
+BufferBinding::~BufferBinding() {
+    m_gl.BindBuffer(m_target, static_cast<GLuint>(m_previous));
+}
+
+
+UnpackGuard::UnpackGuard(const Functions& gl, GLint alignment)
+: m_gl(gl) {
+    gl.GetIntegerv(TEXTURE_BINDING_2D, &m_texture);
+    gl.GetIntegerv(PIXEL_UNPACK_BUFFER_BINDING, &m_unpackBuffer);
+    gl.GetIntegerv(UNPACK_ALIGNMENT, &m_unpackAlignment);
+    gl.GetIntegerv(UNPACK_ROW_LENGTH, &m_unpackRowLength);
+    gl.GetIntegerv(UNPACK_SKIP_ROWS, &m_unpackSkipRows);
+    gl.GetIntegerv(UNPACK_SKIP_PIXELS, &m_unpackSkipPixels);
+
+    gl.BindBuffer(PIXEL_UNPACK_BUFFER, 0);
+    gl.PixelStorei(UNPACK_ALIGNMENT, alignment);
+    gl.PixelStorei(UNPACK_ROW_LENGTH, 0);
+    gl.PixelStorei(UNPACK_SKIP_ROWS, 0);
+    gl.PixelStorei(UNPACK_SKIP_PIXELS, 0);
+}
+
+
+UnpackGuard::~UnpackGuard() {
+    const auto& gl = m_gl;
+
+    gl.BindTexture(TEXTURE_2D, static_cast<GLuint>(m_texture));
+    gl.BindBuffer(PIXEL_UNPACK_BUFFER, static_cast<GLuint>(m_unpackBuffer));
+    gl.PixelStorei(UNPACK_ALIGNMENT, m_unpackAlignment);
+    gl.PixelStorei(UNPACK_ROW_LENGTH, m_unpackRowLength);
+    gl.PixelStorei(UNPACK_SKIP_ROWS, m_unpackSkipRows);
+    gl.PixelStorei(UNPACK_SKIP_PIXELS, m_unpackSkipPixels);
+}
+
+
+}  // namespace gl
+}  // namespace glheadless
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "GLFunctions.h"
+
+
+namespace glheadless {
+namespace gl {
+
+
+/*
+ * Saves the OpenGL state touched by internal render and readback passes and restores it at the end of its lifetime,
+ * so that library operations are transparent to the caller's state.
+ */
+class StateGuard {
+public:
+    explicit StateGuard(const Functions& gl);
+    StateGuard(const StateGuard&) = delete;
+    ~StateGuard();
+
+    StateGuard& operator=(const StateGuard&) = delete;
+
+
+private:
+    const Functions& m_gl;
+
+    GLint m_readFramebuffer;
+    GLint m_drawFramebuffer;
+    GLint m_program;
+    GLint m_vertexArray;
+    GLint m_activeTexture;
+    GLint m_texture;
+    GLint m_packBuffer;
+    GLint m_unpackBuffer;
+    GLint m_packAlignment;
+    GLint m_packRowLength;
+    GLint m_packSkipRows;
+    GLint m_packSkipPixels;
+    GLint m_viewport[4];
+    GLboolean m_colorMask[4];
+    GLboolean m_blend;
+    GLboolean m_cullFace;
+    GLboolean m_depthTest;
+    GLboolean m_scissorTest;
+    GLboolean m_stencilTest;
+};
+
+
+/*
+ * Binds a buffer object to GL_COPY_READ_BUFFER or GL_COPY_WRITE_BUFFER, which draw calls do not use, and restores the
+ * previous binding at the end of its lifetime.
+ */
+class BufferBinding {
+public:
+    BufferBinding(const Functions& gl, GLenum target, GLuint buffer);
+    BufferBinding(const BufferBinding&) = delete;
+    ~BufferBinding();
+
+    BufferBinding& operator=(const BufferBinding&) = delete;
+
+
+private:
+    const Functions& m_gl;
+    const GLenum     m_target;
+    GLint            m_previous;
+};
+
+
+/*
+ * Saves the GL_TEXTURE_2D binding of the active texture unit, the pixel unpack buffer binding and the unpack pixel
+ * store parameters for texture uploads, resets the parameters to tightly packed rows with the given alignment and
+ * restores everything at the end of its lifetime.
+ */
+class UnpackGuard {
+public:
+    UnpackGuard(const Functions& gl, GLint alignment);
+    UnpackGuard(const UnpackGuard&) = delete;
+    ~UnpackGuard();
+
+    UnpackGuard& operator=(const UnpackGuard&) = delete;
+
+
+private:
+    const Functions& m_gl;
+
+    GLint m_texture;
+    GLint m_unpackBuffer;
+    GLint m_unpackAlignment;
+    GLint m_unpackRowLength;
+    GLint m_unpackSkipRows;
+    GLint m_unpackSkipPixels;
+};
+
+
+}  // namespace gl
+}  // namespace glheadless
@@ -0,0 +1,306 @@
+#include <glheadless/StreamingBuffer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <glheadless/Context.h>
+#include <glheadless/error.h>
+
+#include "GLFunctions.h"
+#include "InternalException.h"
+#include "StateGuard.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+// segments start at multiples of the largest GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT of current hardware
+const std::size_t k_segmentGranularity = 256;
+
+// timeout of a single glClientWaitSync() call; waiting continues until the fence is signaled
+const gl::GLuint64 k_waitTimeout = 100000000;
+
+
+std::size_t alignUp(std::size_t offset, std::size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+
+}  // unnamed namespace
+
+
+StreamingBuffer::StreamingBuffer(Context* context, std::size_t size, unsigned int segments, Mapping mapping)
+: m_context(context)
+, m_size(size)
+, m_segments(std::max(segments, 1u))
+, m_segmentSize(size / m_segments / k_segmentGranularity * k_segmentGranularity)
+, m_mapping(mapping)
+, m_buffer(0)
+, m_defaultAlignment(1)
+, m_data(nullptr)
+, m_mapOffset(0)
+, m_segment(0)
+, m_offset(0)
+, m_segmentSerials(m_segments, 0)
+, m_serial(1)
+, m_completedSerial(1) {
+}
+
+
+StreamingBuffer::~StreamingBuffer() {
+    if (m_buffer == 0) {
+        return;
+    }
+
+    const auto& gl = m_context->functions();
+    unmap();
+    for (const auto& fence : m_fences) {
+        gl.DeleteSync(static_cast<gl::GLsync>(fence.sync));
+    }
+    // deleting the buffer object also ends a persistent mapping
+    gl.DeleteBuffers(1, &m_buffer);
+}
+
+
+std::size_t StreamingBuffer::size() const {
+    return m_size;
+}
+
+
+std::size_t StreamingBuffer::segmentSize() const {
+    return m_segmentSize;
+}
+
+
+StreamingBuffer::Mapping StreamingBuffer::mapping() const {
+    return m_mapping;
+}
+
+
+unsigned int StreamingBuffer::buffer() const {
+    return m_buffer;
+}
+
+
+bool StreamingBuffer::allocate(std::size_t size, std::size_t alignment, StreamAllocation& allocation) {
+    if (size == 0 || size > m_segmentSize) {
+        return m_context->setError(Error::INVALID_ARGUMENT, "Streaming allocations must be non-empty and fit into a segment of " + std::to_string(m_segmentSize) + " bytes");
+    }
+
+    if ((alignment & (alignment - 1)) != 0) {
+        return m_context->setError(Error::INVALID_ARGUMENT, "Streaming allocations require a power of two alignment");
+    }
+
+    try {
+        if (m_buffer == 0) {
+            create();
+        }
+
+        if (alignment == 0) {
+            alignment = m_defaultAlignment;
+        }
+
+        // fast path: bump the offset within the current segment
+        auto offset = alignUp(m_offset, alignment);
+        if (offset + size > (m_segment + 1) * m_segmentSize) {
+            advance();
+            offset = alignUp(m_offset, alignment);
+            if (offset + size > (m_segment + 1) * m_segmentSize) {
+                throw InternalException(Error::INVALID_ARGUMENT, "Streaming allocation does not fit into a segment with alignment " + std::to_string(alignment));
+            }
+        }
+
+        if (m_data == nullptr) {
+            map(offset);
+        }
+
+        m_segmentSerials[m_segment] = m_serial;
+        m_offset = offset + size;
+
+        allocation.data = m_data + (offset - m_mapOffset);
+        allocation.buffer = m_buffer;
+        allocation.offset = offset;
+        allocation.size = size;
+    } catch (InternalException& e) {
+        return m_context->setError(e.code(), e.message());
+    }
+
+    return true;
+}
+
+
+bool StreamingBuffer::upload(const void* data, std::size_t size, std::size_t alignment, StreamAllocation& allocation) {
+    if (!allocate(size, alignment, allocation)) {
+        return false;
+    }
+
+    std::memcpy(allocation.data, data, size);
+    return true;
+}
+
+
+void StreamingBuffer::flush() {
+    unmap();
+}
+
+
+bool StreamingBuffer::fence() {
+    if (m_buffer == 0) {
+        return true;
+    }
+
+    const auto& gl = m_context->functions();
+    unmap();
+
+    try {
+        insertFence();
+    } catch (InternalException& e) {
+        return m_context->setError(e.code(), e.message());
+    }
+
+    // retire signaled fences, so their number stays bounded by the frames in flight
+    while (m_fences.size() > 1) {
+        const auto status = gl.ClientWaitSync(static_cast<gl::GLsync>(m_fences.front().sync), 0, 0);
+        if (status != gl::ALREADY_SIGNALED && status != gl::CONDITION_SATISFIED) {
+            break;
+        }
+
+        m_completedSerial = m_fences.front().serial + 1;
+        gl.DeleteSync(static_cast<gl::GLsync>(m_fences.front().sync));
+        m_fences.pop_front();
+    }
+
+    return true;
+}
+
+
+void StreamingBuffer::create() {
+    const auto& gl = m_context->functions();
+    if (gl.FenceSync == nullptr || gl.MapBufferRange == nullptr) {
+        throw InternalException(Error::UNSUPPORTED_FEATURE, "Streaming buffers require OpenGL 3.2");
+    }
+
+    if (m_segmentSize == 0) {
+        throw InternalException(Error::INVALID_ARGUMENT, "Streaming buffer segments must hold at least " + std::to_string(k_segmentGranularity) + " bytes");
+    }
+
+    const auto persistentSupported = gl.BufferStorage != nullptr && gl.hasExtension("GL_ARB_buffer_storage");
+    if (m_mapping == Mapping::PERSISTENT && !persistentSupported) {
+        throw InternalException(Error::UNSUPPORTED_FEATURE, "Persistent mapping requires GL_ARB_buffer_storage");
+    }
+    if (m_mapping == Mapping::AUTOMATIC) {
+        m_mapping = persistentSupported ? Mapping::PERSISTENT : Mapping::UNSYNCHRONIZED;
+    }
+
+    gl::GLint alignment = 0;
+    gl.GetIntegerv(gl::UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    m_defaultAlignment = static_cast<std::size_t>(std::max(alignment, 1));
+
+    gl.GenBuffers(1, &m_buffer);
+    gl::BufferBinding binding(gl, gl::COPY_WRITE_BUFFER, m_buffer);
+
+    if (m_mapping == Mapping::UNSYNCHRONIZED) {
+        gl.BufferData(gl::COPY_WRITE_BUFFER, static_cast<gl::GLsizeiptr>(m_size), nullptr, gl::STREAM_DRAW);
+        return;
+    }
+
+    const auto flags = gl::MAP_WRITE_BIT | gl::MAP_PERSISTENT_BIT | gl::MAP_COHERENT_BIT;
+    gl.BufferStorage(gl::COPY_WRITE_BUFFER, static_cast<gl::GLsizeiptr>(m_size), nullptr, flags);
+    m_data = static_cast<unsigned char*>(gl.MapBufferRange(gl::COPY_WRITE_BUFFER, 0, static_cast<gl::GLsizeiptr>(m_size), flags));
+    m_mapOffset = 0;
+
+    if (m_data == nullptr) {
+        gl.DeleteBuffers(1, &m_buffer);
+        m_buffer = 0;
+        throw InternalException(Error::OPENGL_ERROR, "Mapping the streaming buffer failed");
+    }
+}
+
+
+void StreamingBuffer::advance() {
+    unmap();
+
+    m_segment = (m_segment + 1) % m_segments;
+    waitFor(m_segmentSerials[m_segment]);
+    m_offset = m_segment * m_segmentSize;
+}
+
+
+void StreamingBuffer::waitFor(std::uint64_t serial) {
+    if (serial < m_completedSerial) {
+        return;
+    }
+
+    // the segment was used since the last fence, so the commands issued so far are its consumers
+    if (serial == m_serial) {
+        insertFence();
+    }
+
+    // older fences are implied by newer ones
+    const auto& gl = m_context->functions();
+    while (m_fences.front().serial < serial) {
+        gl.DeleteSync(static_cast<gl::GLsync>(m_fences.front().sync));
+        m_fences.pop_front();
+    }
+
+    const auto sync = static_cast<gl::GLsync>(m_fences.front().sync);
+    for (;;) {
+        const auto status = gl.ClientWaitSync(sync, gl::SYNC_FLUSH_COMMANDS_BIT, k_waitTimeout);
+        if (status == gl::ALREADY_SIGNALED || status == gl::CONDITION_SATISFIED) {
+            break;
+        }
+        if (status == gl::WAIT_FAILED) {
+            throw InternalException(Error::OPENGL_ERROR, "Waiting for a streaming buffer fence failed");
+        }
+    }
+
+    m_completedSerial = m_fences.front().serial + 1;
+    gl.DeleteSync(sync);
+    m_fences.pop_front();
+}
+
+
+void StreamingBuffer::insertFence() {
+    const auto& gl = m_context->functions();
+    const auto sync = gl.FenceSync(gl::SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (sync == nullptr) {
+        throw InternalException(Error::OPENGL_ERROR, "Creating a streaming buffer fence failed");
+    }
+
+    m_fences.push_back({ sync, m_serial++ });
+}
+
+
+void StreamingBuffer::map(std::size_t offset) {
+    // the GPU does not read the rest of the current segment, so it can be written without synchronization
+    const auto& gl = m_context->functions();
+    const auto size = (m_segment + 1) * m_segmentSize - offset;
+    const auto flags = gl::MAP_WRITE_BIT | gl::MAP_INVALIDATE_RANGE_BIT | gl::MAP_UNSYNCHRONIZED_BIT;
+
+    gl::BufferBinding binding(gl, gl::COPY_WRITE_BUFFER, m_buffer);
+    m_data = static_cast<unsigned char*>(gl.MapBufferRange(gl::COPY_WRITE_BUFFER, static_cast<gl::GLintptr>(offset), static_cast<gl::GLsizeiptr>(size), flags));
+    m_mapOffset = offset;
+
+    if (m_data == nullptr) {
+        throw InternalException(Error::OPENGL_ERROR, "Mapping the streaming buffer failed");
+    }
+}
+
+
+void StreamingBuffer::unmap() {
+    if (m_mapping != Mapping::UNSYNCHRONIZED || m_data == nullptr) {
+        return;
+    }
+
+    const auto& gl = m_context->functions();
+    gl::BufferBinding binding(gl, gl::COPY_WRITE_BUFFER, m_buffer);
+    gl.UnmapBuffer(gl::COPY_WRITE_BUFFER);
+    m_data = nullptr;
+}
+
+
+}  // namespace glheadless
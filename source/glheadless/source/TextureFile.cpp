@@ -0,0 +1,503 @@
+#include <glheadless/TextureFile.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <glheadless/Context.h>
+#include <glheadless/error.h>
+
+#include "GLFunctions.h"
+#include "InternalException.h"
+#include "MappedFile.h"
+#include "StateGuard.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+// textures of at least this size are uploaded through a pixel unpack buffer by UploadPath::AUTOMATIC
+const std::size_t k_unpackBufferThreshold = 1 << 20;
+
+const unsigned char k_ktxIdentifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+const std::size_t k_ktxHeaderSize = 64;
+const std::uint32_t k_ktxEndianness = 0x04030201;
+
+const std::size_t k_ddsHeaderSize = 4 + 124;
+const std::size_t k_ddsDx10HeaderSize = 20;
+const std::uint32_t k_ddsPixelFormatFourCC = 0x4;
+const std::uint32_t k_ddsPixelFormatAlphaPixels = 0x1;
+const std::uint32_t k_ddsCaps2CubeMap = 0x200;
+const std::uint32_t k_ddsCaps2Volume = 0x200000;
+const std::uint32_t k_dx10ResourceDimensionTexture2D = 3;
+const std::uint32_t k_dx10MiscTextureCube = 0x4;
+
+
+std::uint32_t fourCC(const char (&code)[5]) {
+    return static_cast<std::uint32_t>(static_cast<unsigned char>(code[0]))
+        | static_cast<std::uint32_t>(static_cast<unsigned char>(code[1])) << 8
+        | static_cast<std::uint32_t>(static_cast<unsigned char>(code[2])) << 16
+        | static_cast<std::uint32_t>(static_cast<unsigned char>(code[3])) << 24;
+}
+
+
+std::uint32_t readLittleEndian(const unsigned char* data) {
+    return static_cast<std::uint32_t>(data[0])
+        | static_cast<std::uint32_t>(data[1]) << 8
+        | static_cast<std::uint32_t>(data[2]) << 16
+        | static_cast<std::uint32_t>(data[3]) << 24;
+}
+
+
+std::uint32_t readNative(const unsigned char* data, bool swap) {
+    std::uint32_t value = 0;
+    std::memcpy(&value, data, sizeof(value));
+    if (swap) {
+        value = (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+    }
+    return value;
+}
+
+
+unsigned int levelExtent(unsigned int extent, unsigned int level) {
+    return std::max(extent >> level, 1u);
+}
+
+
+// bytes per 4x4 block, 0 for formats not handled by the DDS parser
+std::size_t blockSize(gl::GLenum internalFormat) {
+    switch (internalFormat) {
+    case gl::COMPRESSED_RGB_S3TC_DXT1:
+    case gl::COMPRESSED_RGBA_S3TC_DXT1:
+    case gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT1:
+    case gl::COMPRESSED_RED_RGTC1:
+    case gl::COMPRESSED_SIGNED_RED_RGTC1:
+        return 8;
+    case gl::COMPRESSED_RGBA_S3TC_DXT3:
+    case gl::COMPRESSED_RGBA_S3TC_DXT5:
+    case gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT3:
+    case gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT5:
+    case gl::COMPRESSED_RG_RGTC2:
+    case gl::COMPRESSED_SIGNED_RG_RGTC2:
+    case gl::COMPRESSED_RGBA_BPTC_UNORM:
+    case gl::COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+    case gl::COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+    case gl::COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+
+gl::GLenum fourCCFormat(std::uint32_t code, bool alpha) {
+    if (code == fourCC("DXT1")) {
+        return alpha ? gl::COMPRESSED_RGBA_S3TC_DXT1 : gl::COMPRESSED_RGB_S3TC_DXT1;
+    }
+    if (code == fourCC("DXT3")) {
+        return gl::COMPRESSED_RGBA_S3TC_DXT3;
+    }
+    if (code == fourCC("DXT5")) {
+        return gl::COMPRESSED_RGBA_S3TC_DXT5;
+    }
+    if (code == fourCC("ATI1") || code == fourCC("BC4U")) {
+        return gl::COMPRESSED_RED_RGTC1;
+    }
+    if (code == fourCC("BC4S")) {
+        return gl::COMPRESSED_SIGNED_RED_RGTC1;
+    }
+    if (code == fourCC("ATI2") || code == fourCC("BC5U")) {
+        return gl::COMPRESSED_RG_RGTC2;
+    }
+    if (code == fourCC("BC5S")) {
+        return gl::COMPRESSED_SIGNED_RG_RGTC2;
+    }
+    return 0;
+}
+
+
+gl::GLenum dxgiFormat(std::uint32_t format) {
+    switch (format) {
+    case 71: return gl::COMPRESSED_RGBA_S3TC_DXT1;          // DXGI_FORMAT_BC1_UNORM
+    case 72: return gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT1;    // DXGI_FORMAT_BC1_UNORM_SRGB
+    case 74: return gl::COMPRESSED_RGBA_S3TC_DXT3;          // DXGI_FORMAT_BC2_UNORM
+    case 75: return gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT3;    // DXGI_FORMAT_BC2_UNORM_SRGB
+    case 77: return gl::COMPRESSED_RGBA_S3TC_DXT5;          // DXGI_FORMAT_BC3_UNORM
+    case 78: return gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT5;    // DXGI_FORMAT_BC3_UNORM_SRGB
+    case 80: return gl::COMPRESSED_RED_RGTC1;               // DXGI_FORMAT_BC4_UNORM
+    case 81: return gl::COMPRESSED_SIGNED_RED_RGTC1;        // DXGI_FORMAT_BC4_SNORM
+    case 83: return gl::COMPRESSED_RG_RGTC2;                // DXGI_FORMAT_BC5_UNORM
+    case 84: return gl::COMPRESSED_SIGNED_RG_RGTC2;         // DXGI_FORMAT_BC5_SNORM
+    case 95: return gl::COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT; // DXGI_FORMAT_BC6H_UF16
+    case 96: return gl::COMPRESSED_RGB_BPTC_SIGNED_FLOAT;   // DXGI_FORMAT_BC6H_SF16
+    case 98: return gl::COMPRESSED_RGBA_BPTC_UNORM;         // DXGI_FORMAT_BC7_UNORM
+    case 99: return gl::COMPRESSED_SRGB_ALPHA_BPTC_UNORM;   // DXGI_FORMAT_BC7_UNORM_SRGB
+    default: return 0;
+    }
+}
+
+
+// components of the unsigned byte formats accepted from KTX files, 0 for others
+std::size_t componentCount(gl::GLenum format) {
+    switch (format) {
+    case gl::RED:  return 1;
+    case gl::RG:   return 2;
+    case gl::RGB:
+    case gl::BGR:  return 3;
+    case gl::RGBA:
+    case gl::BGRA: return 4;
+    default:       return 0;
+    }
+}
+
+
+}  // unnamed namespace
+
+
+TextureFile::TextureFile()
+: m_container(Container::NONE)
+, m_internalFormat(0)
+, m_format(0)
+, m_type(0)
+, m_alignment(1) {
+}
+
+
+TextureFile::~TextureFile() {
+}
+
+
+bool TextureFile::open(const std::string& path) {
+    close();
+
+    try {
+        m_file.reset(new MappedFile(path));
+
+        const auto data = m_file->data();
+        const auto size = m_file->size();
+        if (size >= sizeof(k_ktxIdentifier) && std::memcmp(data, k_ktxIdentifier, sizeof(k_ktxIdentifier)) == 0) {
+            parseKtx();
+        } else if (size >= 4 && readLittleEndian(data) == fourCC("DDS ")) {
+            parseDds();
+        } else {
+            throw InternalException(Error::INVALID_ARGUMENT, path + " is neither a KTX nor a DDS file");
+        }
+    } catch (InternalException& e) {
+        close();
+        return setError(e.code(), e.message());
+    }
+
+    return true;
+}
+
+
+void TextureFile::close() {
+    m_file.reset();
+    m_container = Container::NONE;
+    m_internalFormat = 0;
+    m_format = 0;
+    m_type = 0;
+    m_alignment = 1;
+    m_levels.clear();
+}
+
+
+bool TextureFile::isOpen() const {
+    return m_file != nullptr;
+}
+
+
+TextureFile::Container TextureFile::container() const {
+    return m_container;
+}
+
+
+bool TextureFile::compressed() const {
+    return isOpen() && m_type == 0;
+}
+
+
+unsigned int TextureFile::internalFormat() const {
+    return m_internalFormat;
+}
+
+
+unsigned int TextureFile::format() const {
+    return m_format;
+}
+
+
+unsigned int TextureFile::type() const {
+    return m_type;
+}
+
+
+unsigned int TextureFile::width() const {
+    return m_levels.empty() ? 0 : m_levels.front().width;
+}
+
+
+unsigned int TextureFile::height() const {
+    return m_levels.empty() ? 0 : m_levels.front().height;
+}
+
+
+unsigned int TextureFile::levelCount() const {
+    return static_cast<unsigned int>(m_levels.size());
+}
+
+
+TextureLevel TextureFile::level(unsigned int index) const {
+    return index < m_levels.size() ? m_levels[index] : TextureLevel();
+}
+
+
+bool TextureFile::upload(Context* context, unsigned int& texture, UploadPath path) {
+    if (!isOpen()) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "No texture file is open");
+    }
+
+    const auto& gl = context->functions();
+    if (gl.CompressedTexImage2D == nullptr) {
+        return setError(make_error_code(Error::UNSUPPORTED_FEATURE), "Texture file upload requires OpenGL 1.3");
+    }
+
+    // the levels are laid out consecutively, interleaved with small headers in KTX files
+    const auto payload = m_levels.front().data;
+    const auto payloadSize = static_cast<std::size_t>(m_levels.back().data + m_levels.back().size - payload);
+
+    if (path == UploadPath::AUTOMATIC) {
+        path = payloadSize >= k_unpackBufferThreshold && gl.MapBufferRange != nullptr ? UploadPath::PIXEL_UNPACK_BUFFER : UploadPath::CLIENT_MEMORY;
+    }
+    if (path == UploadPath::PIXEL_UNPACK_BUFFER && gl.MapBufferRange == nullptr) {
+        return setError(make_error_code(Error::UNSUPPORTED_FEATURE), "Uploading through a pixel unpack buffer requires OpenGL 3.0");
+    }
+
+    gl::UnpackGuard guard(gl, static_cast<gl::GLint>(m_alignment));
+
+    // with a pixel unpack buffer bound, the data pointers are offsets into it
+    auto base = payload;
+    gl::GLuint buffer = 0;
+    if (path == UploadPath::PIXEL_UNPACK_BUFFER) {
+        gl.GenBuffers(1, &buffer);
+        gl.BindBuffer(gl::PIXEL_UNPACK_BUFFER, buffer);
+        gl.BufferData(gl::PIXEL_UNPACK_BUFFER, static_cast<gl::GLsizeiptr>(payloadSize), nullptr, gl::STREAM_DRAW);
+
+        const auto mapped = gl.MapBufferRange(gl::PIXEL_UNPACK_BUFFER, 0, static_cast<gl::GLsizeiptr>(payloadSize), gl::MAP_WRITE_BIT | gl::MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped == nullptr) {
+            gl.DeleteBuffers(1, &buffer);
+            return setError(make_error_code(Error::OPENGL_ERROR), "Mapping the pixel unpack buffer failed");
+        }
+        std::memcpy(mapped, payload, payloadSize);
+        gl.UnmapBuffer(gl::PIXEL_UNPACK_BUFFER);
+        base = nullptr;
+    }
+
+    gl::GLuint name = 0;
+    gl.GenTextures(1, &name);
+    gl.BindTexture(gl::TEXTURE_2D, name);
+
+    for (std::size_t i = 0; i < m_levels.size(); ++i) {
+        const auto& level = m_levels[i];
+        const auto pixels = static_cast<const void*>(base + (level.data - payload));
+        const auto width = static_cast<gl::GLsizei>(level.width);
+        const auto height = static_cast<gl::GLsizei>(level.height);
+        if (compressed()) {
+            gl.CompressedTexImage2D(gl::TEXTURE_2D, static_cast<gl::GLint>(i), m_internalFormat, width, height, 0, static_cast<gl::GLsizei>(level.size), pixels);
+        } else {
+            gl.TexImage2D(gl::TEXTURE_2D, static_cast<gl::GLint>(i), static_cast<gl::GLint>(m_internalFormat), width, height, 0, m_format, m_type, pixels);
+        }
+    }
+
+    const auto levels = static_cast<gl::GLint>(m_levels.size());
+    gl.TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MAX_LEVEL, levels - 1);
+    gl.TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MIN_FILTER, static_cast<gl::GLint>(levels > 1 ? gl::LINEAR_MIPMAP_LINEAR : gl::LINEAR));
+    gl.TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MAG_FILTER, static_cast<gl::GLint>(gl::LINEAR));
+
+    // the driver keeps the buffer storage alive until the transfers are done
+    if (buffer != 0) {
+        gl.DeleteBuffers(1, &buffer);
+    }
+
+    const auto glError = gl.GetError();
+    if (glError != 0) {
+        gl.DeleteTextures(1, &name);
+        return setError(make_error_code(Error::OPENGL_ERROR), "Texture upload failed with OpenGL error " + std::to_string(glError) + ", internal format " + std::to_string(m_internalFormat) + " may be unsupported");
+    }
+
+    m_file->release();
+    texture = name;
+
+    return true;
+}
+
+
+const std::error_code& TextureFile::lastErrorCode() const {
+    return m_lastErrorCode;
+}
+
+
+const std::string& TextureFile::lastErrorMessage() const {
+    return m_lastErrorMessage;
+}
+
+
+void TextureFile::parseKtx() {
+    const auto data = m_file->data();
+    const auto size = m_file->size();
+    if (size < k_ktxHeaderSize) {
+        throw InternalException(Error::INVALID_ARGUMENT, "KTX header is truncated");
+    }
+
+    const auto endianness = readNative(data + 12, false);
+    if (endianness != k_ktxEndianness && readNative(data + 12, true) != k_ktxEndianness) {
+        throw InternalException(Error::INVALID_ARGUMENT, "KTX endianness field is invalid");
+    }
+    const auto swap = endianness != k_ktxEndianness;
+    const auto field = [data, swap] (std::size_t index) {
+        return readNative(data + 16 + index * 4, swap);
+    };
+
+    const auto type = field(0);
+    const auto typeSize = field(1);
+    const auto format = field(2);
+    const auto internalFormat = field(3);
+    const auto width = field(5);
+    const auto height = field(6);
+    const auto depth = field(7);
+    const auto arrayElements = field(8);
+    const auto faces = field(9);
+    const auto levels = std::max(field(10), 1u);
+    const auto keyValueSize = field(11);
+
+    if (width == 0 || height == 0 || depth != 0 || arrayElements != 0 || faces != 1) {
+        throw InternalException(Error::UNSUPPORTED_FEATURE, "Only two-dimensional KTX textures without faces or array elements are supported");
+    }
+    if (levels > 32 || (std::max(width, height) >> (levels - 1)) == 0) {
+        throw InternalException(Error::INVALID_ARGUMENT, "KTX file has more levels than its size allows");
+    }
+
+    // uncompressed levels are validated against their size, so OpenGL never reads past the mapping
+    const auto components = componentCount(format);
+    if (type != 0 && (type != gl::UNSIGNED_BYTE || typeSize != 1 || components == 0)) {
+        throw InternalException(Error::UNSUPPORTED_FEATURE, "Uncompressed KTX textures must have unsigned byte red, RG, RGB(A) or BGR(A) components");
+    }
+
+    auto offset = k_ktxHeaderSize + static_cast<std::size_t>(keyValueSize);
+    for (auto i = 0u; i < levels; ++i) {
+        if (offset + 4 > size) {
+            throw InternalException(Error::INVALID_ARGUMENT, "KTX level table is truncated");
+        }
+
+        TextureLevel level;
+        level.width = levelExtent(width, i);
+        level.height = levelExtent(height, i);
+        level.size = readNative(data + offset, swap);
+        level.data = data + offset + 4;
+        if (level.size == 0 || level.size > size - offset - 4) {
+            throw InternalException(Error::INVALID_ARGUMENT, "KTX level " + std::to_string(i) + " is truncated");
+        }
+        if (type != 0 && level.size < ((level.width * components + 3) & ~std::size_t(3)) * level.height) {
+            throw InternalException(Error::INVALID_ARGUMENT, "KTX level " + std::to_string(i) + " is smaller than its size");
+        }
+
+        m_levels.push_back(level);
+        offset += 4 + ((level.size + 3) & ~std::size_t(3));
+    }
+
+    m_container = Container::KTX;
+    m_internalFormat = internalFormat;
+    m_format = type != 0 ? format : 0;
+    m_type = type;
+    m_alignment = 4;
+}
+
+
+void TextureFile::parseDds() {
+    const auto data = m_file->data();
+    const auto size = m_file->size();
+    if (size < k_ddsHeaderSize) {
+        throw InternalException(Error::INVALID_ARGUMENT, "DDS header is truncated");
+    }
+
+    const auto field = [data] (std::size_t offset) {
+        return readLittleEndian(data + 4 + offset);
+    };
+
+    if (field(0) != 124 || field(72) != 32) {
+        throw InternalException(Error::INVALID_ARGUMENT, "DDS header size is invalid");
+    }
+
+    const auto height = field(8);
+    const auto width = field(12);
+    const auto levels = std::max(field(24), 1u);
+    const auto pixelFormatFlags = field(76);
+    const auto code = field(80);
+    const auto caps2 = field(108);
+
+    if (width == 0 || height == 0 || (caps2 & (k_ddsCaps2CubeMap | k_ddsCaps2Volume)) != 0) {
+        throw InternalException(Error::UNSUPPORTED_FEATURE, "Only two-dimensional DDS textures are supported");
+    }
+    if (levels > 32 || (std::max(width, height) >> (levels - 1)) == 0) {
+        throw InternalException(Error::INVALID_ARGUMENT, "DDS file has more levels than its size allows");
+    }
+    if ((pixelFormatFlags & k_ddsPixelFormatFourCC) == 0) {
+        throw InternalException(Error::UNSUPPORTED_FEATURE, "Only block compressed DDS textures are supported");
+    }
+
+    auto offset = k_ddsHeaderSize;
+    gl::GLenum internalFormat = 0;
+    if (code == fourCC("DX10")) {
+        if (size < offset + k_ddsDx10HeaderSize) {
+            throw InternalException(Error::INVALID_ARGUMENT, "DDS DX10 header is truncated");
+        }
+
+        const auto dimension = readLittleEndian(data + offset + 4);
+        const auto misc = readLittleEndian(data + offset + 8);
+        const auto arraySize = readLittleEndian(data + offset + 12);
+        if (dimension != k_dx10ResourceDimensionTexture2D || (misc & k_dx10MiscTextureCube) != 0 || arraySize > 1) {
+            throw InternalException(Error::UNSUPPORTED_FEATURE, "Only two-dimensional DDS textures are supported");
+        }
+
+        internalFormat = dxgiFormat(readLittleEndian(data + offset));
+        offset += k_ddsDx10HeaderSize;
+    } else {
+        internalFormat = fourCCFormat(code, (pixelFormatFlags & k_ddsPixelFormatAlphaPixels) != 0);
+    }
+
+    const auto bytesPerBlock = blockSize(internalFormat);
+    if (bytesPerBlock == 0) {
+        throw InternalException(Error::UNSUPPORTED_FEATURE, "DDS compression format is not supported");
+    }
+
+    for (auto i = 0u; i < levels; ++i) {
+        TextureLevel level;
+        level.width = levelExtent(width, i);
+        level.height = levelExtent(height, i);
+        level.size = bytesPerBlock * ((level.width + 3) / 4) * ((level.height + 3) / 4);
+        level.data = data + offset;
+        if (level.size > size - offset) {
+            throw InternalException(Error::INVALID_ARGUMENT, "DDS level " + std::to_string(i) + " is truncated");
+        }
+
+        m_levels.push_back(level);
+        offset += level.size;
+    }
+
+    m_container = Container::DDS;
+    m_internalFormat = internalFormat;
+}
+
+
+bool TextureFile::setError(const std::error_code& code, const std::string& message) {
+    m_lastErrorCode = code;
+    m_lastErrorMessage = message;
+
+    return !m_lastErrorCode;
+}
+
+
+}  // namespace glheadless
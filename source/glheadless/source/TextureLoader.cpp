@@ -0,0 +1,508 @@
+#include <glheadless/TextureLoader.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/error.h>
+
+#include "GLFunctions.h"
+#include "InternalException.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+// number of pixel unpack buffers, which bounds the uploads in flight
+const std::size_t k_uploadBuffers = 4;
+
+// timeout of a single glClientWaitSync() call on the oldest upload; queued requests and orphans are handled in between
+const gl::GLuint64 k_pollTimeout = 1000000;
+
+
+bool textureFormat(PixelFormat format, gl::GLenum& internalFormat, gl::GLenum& pixelFormat) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        internalFormat = gl::RGBA8;
+        pixelFormat = gl::RGBA;
+        return true;
+    case PixelFormat::BGRA8:
+        internalFormat = gl::RGBA8;
+        pixelFormat = gl::BGRA;
+        return true;
+    case PixelFormat::RGB8:
+        internalFormat = gl::RGB8;
+        pixelFormat = gl::RGB;
+        return true;
+    case PixelFormat::BGR8:
+        internalFormat = gl::RGB8;
+        pixelFormat = gl::BGR;
+        return true;
+    case PixelFormat::R8:
+    case PixelFormat::LUMA8:
+        internalFormat = gl::R8;
+        pixelFormat = gl::RED;
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+bool signaled(gl::GLenum status) {
+    return status == gl::ALREADY_SIGNALED || status == gl::CONDITION_SATISFIED;
+}
+
+
+}  // unnamed namespace
+
+
+struct TextureLoader::Request {
+    Handle         handle;
+    Priority       priority;
+    DecodeFunction decode;
+    State          state;
+    bool           canceled;
+    TextureImage   image;
+    LoadedTexture  texture;
+
+    // heap order: highest priority first, then the oldest request
+    static bool lowerPriority(const std::shared_ptr<Request>& a, const std::shared_ptr<Request>& b) {
+        return a->priority != b->priority ? a->priority < b->priority : a->handle > b->handle;
+    }
+};
+
+
+struct TextureLoader::Upload {
+    gl::GLuint               buffer   = 0;
+    std::size_t              capacity = 0;
+    gl::GLsync               fence    = nullptr;
+    std::shared_ptr<Request> request;
+};
+
+
+TextureLoader::TextureLoader(const Context* shared, unsigned int decodeThreadCount, const ContextFormat& format)
+: m_nextHandle(1)
+, m_uploadFailed(false)
+, m_stopping(false) {
+    if (decodeThreadCount == 0) {
+        decodeThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    m_uploadThread = std::thread(&TextureLoader::uploadLoop, this, shared, format);
+
+    m_decodeThreads.reserve(decodeThreadCount);
+    for (auto i = 0u; i < decodeThreadCount; ++i) {
+        m_decodeThreads.emplace_back(&TextureLoader::decodeLoop, this);
+    }
+}
+
+
+TextureLoader::~TextureLoader() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_decodeQueued.notify_all();
+    m_uploadQueued.notify_all();
+    m_stateChanged.notify_all();
+
+    for (auto& thread : m_decodeThreads) {
+        thread.join();
+    }
+    m_uploadThread.join();
+}
+
+
+TextureLoader::Handle TextureLoader::load(const DecodeFunction& decode, Priority priority) {
+    auto request = std::make_shared<Request>();
+    request->priority = priority;
+    request->decode = decode;
+    request->state = State::QUEUED;
+    request->canceled = false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        request->handle = m_nextHandle++;
+        m_requests[request->handle] = request;
+        m_decodeQueue.push_back(request);
+        std::push_heap(m_decodeQueue.begin(), m_decodeQueue.end(), &Request::lowerPriority);
+    }
+    m_decodeQueued.notify_one();
+
+    return request->handle;
+}
+
+
+bool TextureLoader::cancel(Handle handle) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    const auto it = m_requests.find(handle);
+    if (it == m_requests.end()) {
+        return false;
+    }
+
+    // queued work is skipped when it is dequeued, work in progress is discarded when it finishes
+    auto& request = *it->second;
+    request.canceled = true;
+    if (request.state == State::READY) {
+        m_orphans.push_back(request.texture.texture);
+    }
+    m_requests.erase(it);
+
+    lock.unlock();
+    m_uploadQueued.notify_one();
+    m_stateChanged.notify_all();
+
+    return true;
+}
+
+
+TextureLoader::State TextureLoader::state(Handle handle) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto it = m_requests.find(handle);
+    return it != m_requests.end() ? it->second->state : State::UNKNOWN;
+}
+
+
+TextureLoader::State TextureLoader::wait(Handle handle) const {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+        const auto it = m_requests.find(handle);
+        if (it == m_requests.end()) {
+            return State::UNKNOWN;
+        }
+
+        const auto state = it->second->state;
+        if (state == State::READY || state == State::FAILED || m_stopping) {
+            return state;
+        }
+
+        m_stateChanged.wait(lock);
+    }
+}
+
+
+LoadedTexture TextureLoader::take(Handle handle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto it = m_requests.find(handle);
+    if (it == m_requests.end()) {
+        return LoadedTexture();
+    }
+
+    const auto& request = *it->second;
+    if (request.state != State::READY && request.state != State::FAILED) {
+        return LoadedTexture();
+    }
+
+    const auto texture = request.texture;
+    m_requests.erase(it);
+
+    return texture;
+}
+
+
+std::size_t TextureLoader::pendingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return static_cast<std::size_t>(std::count_if(m_requests.begin(), m_requests.end(), [] (const std::pair<const Handle, std::shared_ptr<Request>>& entry) {
+        return entry.second->state != State::READY && entry.second->state != State::FAILED;
+    }));
+}
+
+
+std::error_code TextureLoader::lastErrorCode() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastErrorCode;
+}
+
+
+std::string TextureLoader::lastErrorMessage() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastErrorMessage;
+}
+
+
+void TextureLoader::decodeLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+        m_decodeQueued.wait(lock, [this] {
+            return m_stopping || !m_decodeQueue.empty();
+        });
+        if (m_stopping) {
+            return;
+        }
+
+        std::pop_heap(m_decodeQueue.begin(), m_decodeQueue.end(), &Request::lowerPriority);
+        const auto request = std::move(m_decodeQueue.back());
+        m_decodeQueue.pop_back();
+        if (request->canceled) {
+            continue;
+        }
+
+        request->state = State::DECODING;
+        const auto decode = std::move(request->decode);
+        lock.unlock();
+
+        TextureImage image;
+        auto decoded = false;
+        try {
+            decoded = decode(image);
+        } catch (...) {
+            decoded = false;
+        }
+
+        const auto valid = decoded && image.width > 0 && image.height > 0 && bytesPerPixel(image.format) != 0
+            && image.pixels.size() >= imageSize(image.format, image.width, image.height);
+
+        lock.lock();
+        if (request->canceled || m_stopping) {
+            continue;
+        }
+
+        if (!valid) {
+            fail(*request, make_error_code(Error::INVALID_ARGUMENT), decoded
+                ? "Decoded texture image is empty, planar or smaller than its size"
+                : "Decoding texture image failed");
+            continue;
+        }
+
+        if (m_uploadFailed) {
+            fail(*request, m_lastErrorCode, m_lastErrorMessage);
+            continue;
+        }
+
+        request->image = std::move(image);
+        request->state = State::UPLOADING;
+        m_uploadQueue.push_back(request);
+        std::push_heap(m_uploadQueue.begin(), m_uploadQueue.end(), &Request::lowerPriority);
+        m_uploadQueued.notify_one();
+        m_stateChanged.notify_all();
+    }
+}
+
+
+void TextureLoader::uploadLoop(const Context* shared, ContextFormat format) {
+    // contexts must be destroyed on the thread that created them, so the upload thread owns its context
+    auto context = ContextFactory::create(shared, format);
+    auto error = std::make_pair(std::error_code(), std::string());
+    if (!context->valid() || !context->makeCurrent()) {
+        error = std::make_pair(context->lastErrorCode(), context->lastErrorMessage());
+    } else if (context->functions().FenceSync == nullptr || context->functions().MapBufferRange == nullptr) {
+        error = std::make_pair(make_error_code(Error::UNSUPPORTED_FEATURE), std::string("Texture loading requires OpenGL 3.2"));
+        context->doneCurrent();
+    }
+
+    if (error.first) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_uploadFailed = true;
+        for (const auto& request : m_uploadQueue) {
+            if (!request->canceled) {
+                fail(*request, error.first, error.second);
+            }
+        }
+        m_uploadQueue.clear();
+        m_lastErrorCode = error.first;
+        m_lastErrorMessage = error.second;
+        return;
+    }
+
+    const auto& gl = context->functions();
+    gl.PixelStorei(gl::UNPACK_ALIGNMENT, 1);
+
+    std::vector<Upload> uploads(k_uploadBuffers);
+    std::size_t oldest = 0; // slot of the upload issued first among those in flight
+    std::size_t next = 0;   // slot of the next upload, slots are used round-robin
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        if (!m_orphans.empty()) {
+            const auto orphans = std::move(m_orphans);
+            m_orphans.clear();
+            lock.unlock();
+            gl.DeleteTextures(static_cast<gl::GLsizei>(orphans.size()), orphans.data());
+            lock.lock();
+            continue;
+        }
+
+        if (!m_uploadQueue.empty() && uploads[next].request == nullptr) {
+            std::pop_heap(m_uploadQueue.begin(), m_uploadQueue.end(), &Request::lowerPriority);
+            const auto request = std::move(m_uploadQueue.back());
+            m_uploadQueue.pop_back();
+            if (request->canceled) {
+                continue;
+            }
+
+            lock.unlock();
+            try {
+                upload(*context, request, uploads[next]);
+                next = (next + 1) % uploads.size();
+                lock.lock();
+            } catch (InternalException& e) {
+                lock.lock();
+                if (!request->canceled) {
+                    fail(*request, e.code(), e.message());
+                }
+            }
+            continue;
+        }
+
+        if (uploads[oldest].request != nullptr) {
+            lock.unlock();
+            const auto retired = retire(*context, uploads[oldest], k_pollTimeout);
+            lock.lock();
+            if (retired) {
+                oldest = (oldest + 1) % uploads.size();
+            }
+            continue;
+        }
+
+        m_uploadQueued.wait(lock);
+    }
+    lock.unlock();
+
+    // the remaining textures are neither taken nor canceled; deletion is deferred by the driver until uploads finish
+    std::vector<gl::GLuint> textures;
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        textures = std::move(m_orphans);
+        for (const auto& entry : m_requests) {
+            if (entry.second->state == State::READY) {
+                textures.push_back(entry.second->texture.texture);
+            }
+        }
+    }
+
+    for (auto& upload : uploads) {
+        if (upload.request != nullptr) {
+            textures.push_back(upload.request->texture.texture);
+            gl.DeleteSync(upload.fence);
+        }
+        gl.DeleteBuffers(1, &upload.buffer);
+    }
+    gl.DeleteTextures(static_cast<gl::GLsizei>(textures.size()), textures.data());
+
+    context->doneCurrent();
+}
+
+
+void TextureLoader::upload(Context& context, const std::shared_ptr<Request>& request, Upload& upload) {
+    const auto& gl = context.functions();
+    auto& image = request->image;
+    const auto size = imageSize(image.format, image.width, image.height);
+
+    gl::GLenum internalFormat = 0;
+    gl::GLenum pixelFormat = 0;
+    textureFormat(image.format, internalFormat, pixelFormat);
+
+    // the buffer is reused only after the previous upload from it has completed, so it is not orphaned explicitly
+    if (upload.buffer == 0) {
+        gl.GenBuffers(1, &upload.buffer);
+    }
+    gl.BindBuffer(gl::PIXEL_UNPACK_BUFFER, upload.buffer);
+    if (upload.capacity < size) {
+        gl.BufferData(gl::PIXEL_UNPACK_BUFFER, static_cast<gl::GLsizeiptr>(size), nullptr, gl::STREAM_DRAW);
+        upload.capacity = size;
+    }
+
+    const auto data = gl.MapBufferRange(gl::PIXEL_UNPACK_BUFFER, 0, static_cast<gl::GLsizeiptr>(size), gl::MAP_WRITE_BIT | gl::MAP_INVALIDATE_BUFFER_BIT);
+    if (data == nullptr) {
+        gl.BindBuffer(gl::PIXEL_UNPACK_BUFFER, 0);
+        throw InternalException(Error::OPENGL_ERROR, "Mapping the texture upload buffer failed");
+    }
+    std::memcpy(data, image.pixels.data(), size);
+    const auto unmapped = gl.UnmapBuffer(gl::PIXEL_UNPACK_BUFFER);
+    std::vector<unsigned char>().swap(image.pixels);
+
+    if (unmapped == 0) {
+        gl.BindBuffer(gl::PIXEL_UNPACK_BUFFER, 0);
+        throw InternalException(Error::OPENGL_ERROR, "Texture upload buffer was corrupted");
+    }
+
+    gl::GLuint texture = 0;
+    gl.GenTextures(1, &texture);
+    gl.BindTexture(gl::TEXTURE_2D, texture);
+    gl.TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MIN_FILTER, static_cast<gl::GLint>(image.mipmaps ? gl::LINEAR_MIPMAP_LINEAR : gl::LINEAR));
+    gl.TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MAG_FILTER, static_cast<gl::GLint>(gl::LINEAR));
+    if (!image.mipmaps) {
+        gl.TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MAX_LEVEL, 0);
+    }
+    gl.TexImage2D(gl::TEXTURE_2D, 0, static_cast<gl::GLint>(internalFormat), static_cast<gl::GLsizei>(image.width), static_cast<gl::GLsizei>(image.height), 0, pixelFormat, gl::UNSIGNED_BYTE, nullptr);
+    if (image.mipmaps) {
+        gl.GenerateMipmap(gl::TEXTURE_2D);
+    }
+    gl.BindTexture(gl::TEXTURE_2D, 0);
+    gl.BindBuffer(gl::PIXEL_UNPACK_BUFFER, 0);
+
+    const auto glError = gl.GetError();
+    if (glError != 0) {
+        gl.DeleteTextures(1, &texture);
+        throw InternalException(Error::OPENGL_ERROR, "Texture upload failed with OpenGL error " + std::to_string(glError));
+    }
+
+    // flushing starts the upload and lets the fence signal without further commands from this context
+    upload.fence = gl.FenceSync(gl::SYNC_GPU_COMMANDS_COMPLETE, 0);
+    gl.Flush();
+    upload.request = request;
+
+    request->texture.texture = texture;
+    request->texture.width = image.width;
+    request->texture.height = image.height;
+}
+
+
+bool TextureLoader::retire(Context& context, Upload& upload, std::uint64_t timeout) {
+    const auto& gl = context.functions();
+    const auto status = gl.ClientWaitSync(upload.fence, 0, timeout);
+    if (!signaled(status) && status != gl::WAIT_FAILED) {
+        return false;
+    }
+
+    gl.DeleteSync(upload.fence);
+    upload.fence = nullptr;
+    const auto request = std::move(upload.request);
+    upload.request.reset();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (request->canceled) {
+        lock.unlock();
+        gl.DeleteTextures(1, &request->texture.texture);
+        return true;
+    }
+
+    if (status == gl::WAIT_FAILED) {
+        const auto texture = request->texture.texture;
+        request->texture = LoadedTexture();
+        fail(*request, make_error_code(Error::OPENGL_ERROR), "Waiting for a texture upload fence failed");
+        lock.unlock();
+        gl.DeleteTextures(1, &texture);
+        return true;
+    }
+
+    request->state = State::READY;
+    lock.unlock();
+    m_stateChanged.notify_all();
+
+    return true;
+}
+
+
+void TextureLoader::fail(Request& request, const std::error_code& code, const std::string& message) {
+    request.state = State::FAILED;
+    request.image = TextureImage();
+    m_lastErrorCode = code;
+    m_lastErrorMessage = message;
+
+    m_stateChanged.notify_all();
+}
+
+
+}  // namespace glheadless
@@ -0,0 +1,306 @@
+#include <glheadless/TiledRenderer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/Readback.h>
+#include <glheadless/error.h>
+
+#include "GLFunctions.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+/*
+ * State shared by the workers of one render() call.
+ */
+class TileQueue {
+public:
+    TileQueue(unsigned int width, unsigned int height, unsigned int tileSize)
+    : m_width(width)
+    , m_height(height)
+    , m_tileSize(tileSize)
+    , m_columns((width + tileSize - 1) / tileSize)
+    , m_count(m_columns * ((height + tileSize - 1) / tileSize))
+    , m_next(0)
+    , m_failed(false) {
+    }
+
+    bool next(Tile& tile) {
+        const auto index = m_next.fetch_add(1);
+        if (index >= m_count || m_failed.load()) {
+            return false;
+        }
+
+        tile.column = index % m_columns;
+        tile.row = index / m_columns;
+        tile.x = tile.column * m_tileSize;
+        tile.width = std::min(m_tileSize, m_width - tile.x);
+        const auto top = tile.row * m_tileSize;
+        tile.height = std::min(m_tileSize, m_height - top);
+        tile.y = m_height - top - tile.height;
+        tile.imageWidth = m_width;
+        tile.imageHeight = m_height;
+        return true;
+    }
+
+    void fail(const std::error_code& code, const std::string& message) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_failed.exchange(true)) {
+            m_errorCode = code;
+            m_errorMessage = message;
+        }
+    }
+
+    bool failed() const {
+        return m_failed.load();
+    }
+
+    const std::error_code& errorCode() const {
+        return m_errorCode;
+    }
+
+    const std::string& errorMessage() const {
+        return m_errorMessage;
+    }
+
+    std::mutex& sinkMutex() {
+        return m_sinkMutex;
+    }
+
+
+private:
+    const unsigned int        m_width;
+    const unsigned int        m_height;
+    const unsigned int        m_tileSize;
+    const unsigned int        m_columns;
+    const unsigned int        m_count;
+    std::atomic<unsigned int> m_next;
+    std::atomic<bool>         m_failed;
+
+    std::mutex      m_mutex;
+    std::error_code m_errorCode;
+    std::string     m_errorMessage;
+    std::mutex      m_sinkMutex;
+};
+
+
+void renderTiles(Context& context, TileQueue& queue, unsigned int tileSize, PixelFormat format, const TiledRenderer::RenderFunction& render, const TiledRenderer::TileSink& sink) {
+    const auto& gl = context.functions();
+    if (gl.GenFramebuffers == nullptr || gl.GenRenderbuffers == nullptr) {
+        queue.fail(make_error_code(Error::UNSUPPORTED_FEATURE), "Tiled rendering requires framebuffer objects");
+        return;
+    }
+
+    gl::GLint maxSize = 0;
+    gl.GetIntegerv(gl::MAX_RENDERBUFFER_SIZE, &maxSize);
+    if (tileSize > static_cast<unsigned int>(maxSize)) {
+        queue.fail(make_error_code(Error::INVALID_ARGUMENT), "Tile size exceeds GL_MAX_RENDERBUFFER_SIZE (" + std::to_string(maxSize) + ")");
+        return;
+    }
+
+    gl::GLuint renderbuffers[2] = { 0, 0 };
+    gl::GLuint framebuffer = 0;
+    gl.GenRenderbuffers(2, renderbuffers);
+    gl.BindRenderbuffer(gl::RENDERBUFFER, renderbuffers[0]);
+    gl.RenderbufferStorage(gl::RENDERBUFFER, gl::RGBA8, static_cast<gl::GLsizei>(tileSize), static_cast<gl::GLsizei>(tileSize));
+    gl.BindRenderbuffer(gl::RENDERBUFFER, renderbuffers[1]);
+    gl.RenderbufferStorage(gl::RENDERBUFFER, gl::DEPTH24_STENCIL8, static_cast<gl::GLsizei>(tileSize), static_cast<gl::GLsizei>(tileSize));
+    gl.GenFramebuffers(1, &framebuffer);
+    gl.BindFramebuffer(gl::FRAMEBUFFER, framebuffer);
+    gl.FramebufferRenderbuffer(gl::FRAMEBUFFER, gl::COLOR_ATTACHMENT0, gl::RENDERBUFFER, renderbuffers[0]);
+    gl.FramebufferRenderbuffer(gl::FRAMEBUFFER, gl::DEPTH_STENCIL_ATTACHMENT, gl::RENDERBUFFER, renderbuffers[1]);
+
+    if (gl.CheckFramebufferStatus(gl::FRAMEBUFFER) != gl::FRAMEBUFFER_COMPLETE) {
+        queue.fail(make_error_code(Error::UNSUPPORTED_FEATURE), "Tile framebuffer is incomplete");
+    } else {
+        Readback readback(&context);
+        readback.setFlipVertically(true);
+        std::vector<unsigned char> pixels(imageSize(format, tileSize, tileSize));
+
+        // an exception escaping the worker thread would terminate the process, so it fails the render() call instead
+        Tile tile;
+        try {
+            while (queue.next(tile)) {
+                gl.BindFramebuffer(gl::FRAMEBUFFER, framebuffer);
+                gl.Viewport(0, 0, static_cast<gl::GLsizei>(tile.width), static_cast<gl::GLsizei>(tile.height));
+                render(tile);
+
+                gl.BindFramebuffer(gl::READ_FRAMEBUFFER, framebuffer);
+                if (!readback.read(0, 0, tile.width, tile.height, format, pixels.data())) {
+                    queue.fail(context.lastErrorCode(), context.lastErrorMessage());
+                    break;
+                }
+
+                std::lock_guard<std::mutex> lock(queue.sinkMutex());
+                sink(tile, pixels.data());
+            }
+        } catch (std::exception& e) {
+            queue.fail(make_error_code(Error::INVALID_ARGUMENT), std::string("Tile callback threw: ") + e.what());
+        } catch (...) {
+            queue.fail(make_error_code(Error::INVALID_ARGUMENT), "Tile callback threw an exception");
+        }
+    }
+
+    gl.BindFramebuffer(gl::FRAMEBUFFER, 0);
+    gl.DeleteFramebuffers(1, &framebuffer);
+    gl.DeleteRenderbuffers(2, renderbuffers);
+}
+
+
+}  // unnamed namespace
+
+
+TiledRenderer::TiledRenderer(const Context* shared)
+: m_shared(shared)
+, m_tileSize(1024)
+, m_threadCount(std::max(std::thread::hardware_concurrency(), 1u)) {
+}
+
+
+void TiledRenderer::setTileSize(unsigned int tileSize) {
+    m_tileSize = tileSize;
+}
+
+
+unsigned int TiledRenderer::tileSize() const {
+    return m_tileSize;
+}
+
+
+void TiledRenderer::setThreadCount(unsigned int threadCount) {
+    m_threadCount = threadCount;
+}
+
+
+unsigned int TiledRenderer::threadCount() const {
+    return m_threadCount;
+}
+
+
+void TiledRenderer::setContextFormat(const ContextFormat& format) {
+    m_format = format;
+}
+
+
+const ContextFormat& TiledRenderer::contextFormat() const {
+    return m_format;
+}
+
+
+bool TiledRenderer::render(unsigned int width, unsigned int height, PixelFormat format, const RenderFunction& render, const TileSink& sink) {
+    if (!validate(width, height, format)) {
+        return false;
+    }
+
+    TileQueue queue(width, height, m_tileSize);
+
+    // contexts must be destroyed on the thread that created them, so each worker owns its context
+    std::vector<std::thread> workers;
+    workers.reserve(m_threadCount);
+    for (auto i = 0u; i < m_threadCount; ++i) {
+        workers.emplace_back([this, &queue, format, &render, &sink] {
+            auto context = ContextFactory::create(m_shared, m_format);
+            if (!context->valid() || !context->makeCurrent()) {
+                queue.fail(context->lastErrorCode(), context->lastErrorMessage());
+                return;
+            }
+
+            renderTiles(*context, queue, m_tileSize, format, render, sink);
+            context->doneCurrent();
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (queue.failed()) {
+        return setError(queue.errorCode(), queue.errorMessage());
+    }
+
+    return setError(std::error_code(), std::string());
+}
+
+
+bool TiledRenderer::renderToFile(unsigned int width, unsigned int height, PixelFormat format, const RenderFunction& render, const std::string& path) {
+    // before opening, which truncates an existing file
+    if (!validate(width, height, format)) {
+        return false;
+    }
+
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "Cannot open " + path + " for writing");
+    }
+
+    // reserve the whole file, so tiles can be written to their rows in any order
+    const auto rowSize = static_cast<std::streamoff>(imageSize(format, width, 1));
+    const auto fileSize = rowSize * height;
+    if (fileSize > 0) {
+        file.seekp(fileSize - 1);
+        file.put('\0');
+    }
+
+    const auto pixelSize = static_cast<std::streamoff>(bytesPerPixel(format));
+    const auto success = this->render(width, height, format, render, [&file, rowSize, pixelSize] (const Tile& tile, const unsigned char* pixels) {
+        const auto tileRowSize = pixelSize * tile.width;
+        const auto top = tile.imageHeight - tile.y - tile.height;
+
+        for (auto row = 0u; row < tile.height; ++row) {
+            file.seekp(rowSize * (top + row) + pixelSize * tile.x);
+            file.write(reinterpret_cast<const char*>(pixels) + tileRowSize * row, tileRowSize);
+        }
+    });
+
+    if (success && !file.flush()) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "Writing " + path + " failed");
+    }
+
+    return success;
+}
+
+
+const std::error_code& TiledRenderer::lastErrorCode() const {
+    return m_lastErrorCode;
+}
+
+
+const std::string& TiledRenderer::lastErrorMessage() const {
+    return m_lastErrorMessage;
+}
+
+
+bool TiledRenderer::validate(unsigned int width, unsigned int height, PixelFormat format) {
+    if (width == 0 || height == 0 || m_tileSize == 0 || m_threadCount == 0) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "Tiled rendering requires a non-empty image, tile size and thread count");
+    }
+
+    if (bytesPerPixel(format) == 0) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "Tiled rendering supports packed pixel formats only");
+    }
+
+    return true;
+}
+
+
+bool TiledRenderer::setError(const std::error_code& code, const std::string& message) {
+    m_lastErrorCode = code;
+    m_lastErrorMessage = message;
+
+    return !m_lastErrorCode;
+}
+
+
+}  // namespace glheadless
@@ -0,0 +1,93 @@
+#include <glheadless/Timeline.h>
+
+#include <glheadless/error.h>
+
+#include "InternalException.h"
+#include "TimelineWriter.h"
+
+
+namespace glheadless {
+
+
+TimelineRecorder::TimelineRecorder()
+: m_droppedCount(0) {
+}
+
+
+TimelineRecorder::~TimelineRecorder() {
+}
+
+
+bool TimelineRecorder::start(const std::string& path, std::size_t capacity) {
+    if (m_writer) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "The timeline is already being recorded");
+    }
+    if (capacity == 0) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "The capacity must not be zero");
+    }
+
+    try {
+        m_writer.reset(new TimelineWriter(path, capacity));
+    } catch (InternalException& e) {
+        return setError(e.code(), e.message());
+    }
+
+    m_droppedCount = 0;
+    return true;
+}
+
+
+bool TimelineRecorder::stop() {
+    if (!m_writer) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "No timeline is being recorded");
+    }
+
+    std::unique_ptr<TimelineWriter> writer(std::move(m_writer));
+    const auto success = writer->finish();
+    m_droppedCount = writer->droppedCount();
+    if (!success) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "Writing the timeline file failed");
+    }
+    return true;
+}
+
+
+bool TimelineRecorder::active() const {
+    return m_writer != nullptr;
+}
+
+
+std::uint64_t TimelineRecorder::droppedCount() const {
+    return m_writer ? m_writer->droppedCount() : m_droppedCount;
+}
+
+
+const std::error_code& TimelineRecorder::lastErrorCode() const {
+    return m_lastErrorCode;
+}
+
+
+const std::string& TimelineRecorder::lastErrorMessage() const {
+    return m_lastErrorMessage;
+}
+
+
+bool TimelineRecorder::setError(const std::error_code& code, const std::string& message) {
+    m_lastErrorCode = code;
+    m_lastErrorMessage = message;
+
+    return !m_lastErrorCode;
+}
+
+
+void beginTimelineSpan(const char* name) {
+    TimelineWriter::begin(name);
+}
+
+
+void endTimelineSpan() {
+    TimelineWriter::end();
+}
+
+
+}  // namespace glheadless
@@ -0,0 +1,360 @@
+#include "TimelineWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <locale>
+
+#include <glheadless/error.h>
+
+#include "InternalException.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+const auto k_writeInterval = std::chrono::milliseconds(10);
+
+
+// guards the active writer; the generation of the active writer, 0 if none, is read without it
+std::mutex                 s_writerMutex;
+TimelineWriter*            s_writer = nullptr;
+std::uint64_t              s_lastGeneration = 0;
+std::atomic<std::uint64_t> s_activeGeneration(0);
+
+
+std::uint64_t nanoseconds(TimelineWriter::Clock::time_point time) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+}
+
+
+// microseconds with three decimals, independent of the locale
+void writeMicroseconds(std::ostream& stream, std::uint64_t nanoseconds) {
+    const auto fraction = nanoseconds % 1000;
+    stream << nanoseconds / 1000 << '.' << char('0' + fraction / 100) << char('0' + fraction / 10 % 10) << char('0' + fraction % 10);
+}
+
+
+void writeEscaped(std::ostream& stream, const char* text) {
+    static const char k_hex[] = "0123456789abcdef";
+    for (; *text != '\0'; ++text) {
+        const auto c = static_cast<unsigned char>(*text);
+        if (c == '"' || c == '\\') {
+            stream << '\\' << *text;
+        } else if (c < 0x20) {
+            stream << "\\u00" << k_hex[c >> 4] << k_hex[c & 0xf];
+        } else {
+            stream << *text;
+        }
+    }
+}
+
+
+}  // unnamed namespace
+
+
+class TimelineWriter::Ring {
+public:
+    Ring(std::uint64_t generation, std::uint32_t thread, std::size_t capacity)
+    : generation(generation)
+    , thread(thread)
+    , droppedCount(0)
+    , m_events(new Event[capacity])
+    , m_mask(capacity - 1)
+    , m_head(0)
+    , m_tail(0) {
+    }
+
+    // producer
+    void push(const Event& event) {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+            droppedCount.store(droppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        m_events[tail & m_mask] = event;
+        m_tail.store(tail + 1, std::memory_order_release);
+    }
+
+    // consumer
+    bool pop(Event& event) {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        event = m_events[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_acquire);
+    }
+
+    const std::uint64_t        generation;
+    const std::uint32_t        thread;       // tid in the file
+    std::atomic<std::uint64_t> droppedCount;
+
+
+private:
+    std::unique_ptr<Event[]> m_events;
+    std::size_t              m_mask;
+    std::atomic<std::size_t> m_head;
+    std::atomic<std::size_t> m_tail;
+};
+
+
+struct TimelineWriter::ThreadState {
+    std::shared_ptr<Ring> ring;
+    const void*           current = nullptr; // context current on the thread
+    Clock::time_point     currentStart;
+};
+
+
+TimelineWriter::TimelineWriter(const std::string& path, std::size_t capacity)
+: m_generation(0)
+, m_start(nanoseconds(Clock::now()))
+, m_capacity(2)
+, m_first(true)
+, m_finished(false)
+, m_nextThread(1)
+, m_retiredDroppedCount(0)
+, m_stopping(false) {
+    while (m_capacity < capacity) {
+        m_capacity *= 2;
+    }
+
+    std::lock_guard<std::mutex> lock(s_writerMutex);
+    if (s_writer != nullptr) {
+        throw InternalException(Error::INVALID_ARGUMENT, "A timeline is already being recorded");
+    }
+
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        throw InternalException(Error::INVALID_ARGUMENT, "Cannot create timeline file " + path);
+    }
+    m_file.imbue(std::locale::classic());
+
+    // the JSON array format does not need the closing bracket, so a file is readable even if the process crashes
+    m_file << "[";
+
+    m_thread = std::thread(&TimelineWriter::writeLoop, this);
+
+    s_writer = this;
+    m_generation = ++s_lastGeneration;
+    s_activeGeneration.store(m_generation, std::memory_order_release);
+}
+
+
+TimelineWriter::~TimelineWriter() {
+    finish();
+}
+
+
+bool TimelineWriter::finish() {
+    if (m_finished) {
+        return !m_file.fail();
+    }
+    m_finished = true;
+
+    {
+        std::lock_guard<std::mutex> lock(s_writerMutex);
+        s_writer = nullptr;
+        s_activeGeneration.store(0, std::memory_order_release);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_stopRequested.notify_all();
+    m_thread.join();
+
+    m_file << "\n]\n";
+    m_file.close();
+    return !m_file.fail();
+}
+
+
+std::uint64_t TimelineWriter::droppedCount() {
+    std::lock_guard<std::mutex> lock(m_ringsMutex);
+    auto count = m_retiredDroppedCount;
+    for (const auto& ring : m_rings) {
+        count += ring->droppedCount.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+
+void TimelineWriter::contextCreated(const void* context, Clock::time_point start) {
+    record(Kind::COMPLETE, "create", start, Clock::now(), context);
+}
+
+
+void TimelineWriter::contextDestroyed(const void* context, Clock::time_point start) {
+    auto& state = threadState();
+    if (state.current == context) {
+        endCurrentSpan(state);
+    }
+    record(Kind::COMPLETE, "destroy", start, Clock::now(), context);
+}
+
+
+void TimelineWriter::contextMadeCurrent(const void* context) {
+    // the span is kept while not recording, so a recording started later shows contexts current at its start
+    auto& state = threadState();
+    if (state.current == context) {
+        return;
+    }
+    endCurrentSpan(state);
+    state.current = context;
+    state.currentStart = Clock::now();
+}
+
+
+void TimelineWriter::contextDoneCurrent(const void* /*context*/) {
+    // releases whatever context is current on the thread
+    endCurrentSpan(threadState());
+}
+
+
+void TimelineWriter::begin(const char* name) {
+    const auto now = Clock::now();
+    record(Kind::BEGIN, name, now, now, nullptr);
+}
+
+
+void TimelineWriter::end() {
+    const auto now = Clock::now();
+    record(Kind::END, "", now, now, nullptr);
+}
+
+
+TimelineWriter::ThreadState& TimelineWriter::threadState() {
+    thread_local ThreadState state;
+    return state;
+}
+
+
+void TimelineWriter::record(Kind kind, const char* name, Clock::time_point start, Clock::time_point end, const void* context) {
+    const auto generation = s_activeGeneration.load(std::memory_order_acquire);
+    if (generation == 0) {
+        return;
+    }
+
+    auto& state = threadState();
+    if (!state.ring || state.ring->generation != generation) {
+        std::lock_guard<std::mutex> lock(s_writerMutex);
+        if (s_writer == nullptr || s_writer->m_generation != generation) {
+            return;
+        }
+        state.ring = s_writer->attach();
+    }
+
+    Event event;
+    event.kind = kind;
+    event.time = nanoseconds(start);
+    event.duration = nanoseconds(end) - event.time;
+    event.context = context;
+    std::strncpy(event.name, name != nullptr ? name : "", sizeof(event.name) - 1);
+    event.name[sizeof(event.name) - 1] = '\0';
+    state.ring->push(event);
+}
+
+
+void TimelineWriter::endCurrentSpan(ThreadState& state) {
+    if (state.current == nullptr) {
+        return;
+    }
+    record(Kind::COMPLETE, "current", state.currentStart, Clock::now(), state.current);
+    state.current = nullptr;
+}
+
+
+std::shared_ptr<TimelineWriter::Ring> TimelineWriter::attach() {
+    std::lock_guard<std::mutex> lock(m_ringsMutex);
+    m_rings.push_back(std::make_shared<Ring>(m_generation, m_nextThread++, m_capacity));
+    return m_rings.back();
+}
+
+
+void TimelineWriter::drain() {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        rings = m_rings;
+    }
+
+    auto written = false;
+    Event event;
+    for (const auto& ring : rings) {
+        while (ring->pop(event)) {
+            write(event, ring->thread);
+            written = true;
+        }
+    }
+    rings.clear();
+    if (written) {
+        m_file.flush();
+    }
+
+    // a ring only the writer refers to belongs to an exited thread or one that recorded into a later writer
+    std::lock_guard<std::mutex> lock(m_ringsMutex);
+    const auto retired = std::remove_if(m_rings.begin(), m_rings.end(), [] (const std::shared_ptr<Ring>& ring) {
+        return ring.use_count() == 1 && ring->empty();
+    });
+    for (auto ring = retired; ring != m_rings.end(); ++ring) {
+        m_retiredDroppedCount += (*ring)->droppedCount.load(std::memory_order_relaxed);
+    }
+    m_rings.erase(retired, m_rings.end());
+}
+
+
+void TimelineWriter::writeLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        lock.unlock();
+        drain();
+        lock.lock();
+        m_stopRequested.wait_for(lock, k_writeInterval, [this] { return m_stopping; });
+    }
+    lock.unlock();
+
+    drain();
+}
+
+
+void TimelineWriter::write(const Event& event, std::uint32_t thread) {
+    // spans started before the recording are cut at its start
+    auto time = event.time;
+    auto duration = event.duration;
+    if (time < m_start) {
+        duration = duration > m_start - time ? duration - (m_start - time) : 0;
+        time = m_start;
+    }
+
+    m_file << (m_first ? "\n" : ",\n");
+    m_first = false;
+
+    m_file << "{\"ph\":\"" << (event.kind == Kind::BEGIN ? 'B' : event.kind == Kind::END ? 'E' : 'X') << "\"";
+    if (event.kind != Kind::END) {
+        m_file << ",\"name\":\"";
+        writeEscaped(m_file, event.name);
+        if (event.context != nullptr) {
+            m_file << " 0x" << std::hex << reinterpret_cast<std::uintptr_t>(event.context) << std::dec;
+        }
+        m_file << "\"";
+    }
+    m_file << ",\"pid\":1,\"tid\":" << thread << ",\"ts\":";
+    writeMicroseconds(m_file, time - m_start);
+    if (event.kind == Kind::COMPLETE) {
+        m_file << ",\"dur\":";
+        writeMicroseconds(m_file, duration);
+    }
+    m_file << "}";
+}
+
+
+}  // namespace glheadless
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace glheadless {
+
+
+/*
+ * Writes the timeline of TimelineRecorder. The static functions record events of the calling thread into a ring of its
+ * own, a single-producer, single-consumer queue registered with the active writer on first use; the writer's thread
+ * drains all rings into the file every few milliseconds. Rings of threads that exited or recorded into a previous
+ * writer are dropped once drained.
+ */
+class TimelineWriter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // creates the file and starts the writing thread; throws InternalException if the file cannot be created or
+    // another writer is active
+    TimelineWriter(const std::string& path, std::size_t capacity);
+
+    // calls finish() unless called before
+    ~TimelineWriter();
+
+    // stops recording, writes the remaining events and closes the file; false if writing to the file failed
+    bool finish();
+
+    std::uint64_t droppedCount();
+
+    // context lifecycle, called for any context; the context is only used as id
+    static void contextCreated(const void* context, Clock::time_point start);
+    static void contextDestroyed(const void* context, Clock::time_point start);
+    static void contextMadeCurrent(const void* context);
+    static void contextDoneCurrent(const void* context);
+
+    static void begin(const char* name);
+    static void end();
+
+
+private:
+    enum class Kind : std::uint8_t {
+        BEGIN,
+        END,
+        COMPLETE
+    };
+
+    static const std::size_t k_nameSize = 48;
+
+    struct Event {
+        Kind          kind;
+        std::uint64_t time;     // steady clock, ns
+        std::uint64_t duration; // ns, COMPLETE only
+        const void*   context;  // appended to the name if not null
+        char          name[k_nameSize];
+    };
+
+    class Ring;
+    struct ThreadState;
+
+    static ThreadState& threadState();
+    static void record(Kind kind, const char* name, Clock::time_point start, Clock::time_point end, const void* context);
+    static void endCurrentSpan(ThreadState& state);
+
+    std::shared_ptr<Ring> attach();
+    void drain();
+    void writeLoop();
+    void write(const Event& event, std::uint32_t thread);
+
+
+private:
+    std::uint64_t m_generation; // distinguishes the rings of this writer from those of previous ones
+    std::uint64_t m_start;      // steady clock, ns; events are written relative to it
+    std::size_t   m_capacity;   // of each ring, a power of two
+
+    std::ofstream m_file;
+    bool          m_first;      // no event written yet
+    bool          m_finished;
+
+    std::mutex                         m_ringsMutex;
+    std::vector<std::shared_ptr<Ring>> m_rings;
+    std::uint32_t                      m_nextThread;
+    std::uint64_t                      m_retiredDroppedCount;
+
+    std::mutex              m_mutex;
+    std::condition_variable m_stopRequested;
+    bool                    m_stopping;
+    std::thread             m_thread;
+};
+
+
+}  // namespace glheadless
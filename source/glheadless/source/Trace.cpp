@@ -0,0 +1,1494 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <tuple>
+
+#include <glheadless/error.h>
+
+#include "AppendFile.h"
+#include "InternalException.h"
+
+
+namespace glheadless {
+namespace gl {
+
+
+namespace {
+
+
+thread_local Tracer* t_current = nullptr;
+thread_local const TraceFallback* t_fallback = nullptr;
+
+
+// driver entry points last resolved by any tracer, for calls made while no context that traced is current on the
+// thread; only valid where entry points do not depend on the context (GLX, EGL), not on WGL
+std::atomic<Tracer::Address> g_fallback[FUNCTION_COUNT];
+
+
+// output buffers of getters returning a fixed number of values, e.g., glGetIntegerv()
+const std::size_t k_scratchSize = 64 << 10;
+
+
+template <std::size_t F>
+struct Traced;
+
+#define GLHEADLESS_DECLARE_TRACED_SIGNATURE(name, signature) \
+    template <> \
+    struct Traced<FUNCTION_##name> { \
+        using Signature = signature; \
+        using Function = Proc<signature>::Type; \
+    };
+GLHEADLESS_GL_FUNCTIONS(GLHEADLESS_DECLARE_TRACED_SIGNATURE)
+#undef GLHEADLESS_DECLARE_TRACED_SIGNATURE
+
+
+// the entry point passed on to by the recording entry points
+template <std::size_t F>
+typename Traced<F>::Function driverFunction(const Tracer* tracer) {
+    Tracer::Address address;
+    if (tracer != nullptr) {
+        address = tracer->driver[F];
+    } else if (t_fallback != nullptr) {
+        address = t_fallback->driver[F];
+    } else {
+        address = g_fallback[F].load(std::memory_order_relaxed);
+    }
+    return reinterpret_cast<typename Traced<F>::Function>(address);
+}
+
+
+template <std::size_t F>
+typename Traced<F>::Function replayFunction(const Replayer& replayer) {
+    return reinterpret_cast<typename Traced<F>::Function>(replayer.address(F));
+}
+
+
+class Reader {
+public:
+    Reader(const unsigned char* data, std::size_t size)
+    : m_data(data)
+    , m_end(data + size) {
+    }
+
+    template <typename T>
+    typename std::enable_if<!std::is_pointer<T>::value, T>::type get() {
+        T value;
+        std::memcpy(&value, take(sizeof(value)), sizeof(value));
+        return value;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_pointer<T>::value, T>::type get() {
+        return reinterpret_cast<T>(static_cast<std::uintptr_t>(get<std::uint64_t>()));
+    }
+
+    const unsigned char* blob(std::size_t& size) {
+        const auto length = get<std::uint64_t>();
+        if (length > static_cast<std::uint64_t>(m_end - m_data)) {
+            throw InternalException(Error::INVALID_ARGUMENT, "Trace record is truncated");
+        }
+        size = static_cast<std::size_t>(length);
+        return take(size);
+    }
+
+
+private:
+    const unsigned char* take(std::size_t size) {
+        if (size > static_cast<std::size_t>(m_end - m_data)) {
+            throw InternalException(Error::INVALID_ARGUMENT, "Trace record is truncated");
+        }
+        const auto data = m_data;
+        m_data += size;
+        return data;
+    }
+
+
+private:
+    const unsigned char* m_data;
+    const unsigned char* m_end;
+};
+
+
+// how replay translates a recorded value; the object name kinds come first, they index Replayer's name maps
+enum Kind {
+    BUFFER_NAME,
+    TEXTURE_NAME,
+    FRAMEBUFFER_NAME,
+    RENDERBUFFER_NAME,
+    VERTEX_ARRAY_NAME,
+    QUERY_NAME,
+    PROGRAM_NAME,       // programs and shaders share their names
+    UNIFORM_LOCATION,   // of the program in use
+    SYNC_OBJECT,
+    SCRATCH,            // output pointer, replaced by scratch memory
+    PLAIN
+};
+
+static_assert(PROGRAM_NAME + 1 == Replayer::k_nameKinds, "name kinds index the name maps");
+
+
+template <Kind K>
+struct Translate {
+    template <typename T>
+    static T map(Replayer&, T value) {
+        return value;
+    }
+
+    template <typename T>
+    static void learn(Replayer&, T, T) {
+    }
+};
+
+
+template <Kind K>
+struct TranslateName {
+    static GLuint map(Replayer& replayer, GLuint value) {
+        return replayer.name(K, value);
+    }
+
+    static void learn(Replayer& replayer, GLuint recorded, GLuint actual) {
+        replayer.learnName(K, recorded, actual);
+    }
+};
+
+template <> struct Translate<BUFFER_NAME> : TranslateName<BUFFER_NAME> {};
+template <> struct Translate<TEXTURE_NAME> : TranslateName<TEXTURE_NAME> {};
+template <> struct Translate<FRAMEBUFFER_NAME> : TranslateName<FRAMEBUFFER_NAME> {};
+template <> struct Translate<RENDERBUFFER_NAME> : TranslateName<RENDERBUFFER_NAME> {};
+template <> struct Translate<VERTEX_ARRAY_NAME> : TranslateName<VERTEX_ARRAY_NAME> {};
+template <> struct Translate<QUERY_NAME> : TranslateName<QUERY_NAME> {};
+template <> struct Translate<PROGRAM_NAME> : TranslateName<PROGRAM_NAME> {};
+
+
+template <>
+struct Translate<UNIFORM_LOCATION> {
+    static GLint map(Replayer& replayer, GLint value) {
+        return replayer.location(value);
+    }
+};
+
+
+template <>
+struct Translate<SYNC_OBJECT> {
+    static GLsync map(Replayer& replayer, GLsync value) {
+        return replayer.sync(value);
+    }
+
+    static void learn(Replayer& replayer, GLsync recorded, GLsync actual) {
+        replayer.learnSync(recorded, actual);
+    }
+};
+
+
+template <>
+struct Translate<SCRATCH> {
+    template <typename T>
+    static T map(Replayer& replayer, T) {
+        return static_cast<T>(replayer.scratch(k_scratchSize));
+    }
+};
+
+
+template <std::size_t... I>
+struct Indices {
+};
+
+template <std::size_t N, std::size_t... I>
+struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {
+};
+
+template <std::size_t... I>
+struct MakeIndices<0, I...> {
+    using Type = Indices<I...>;
+};
+
+
+// passes a call on and completes its record; results are recorded if replay translates them
+template <typename R, Kind RK>
+struct Result {
+    template <typename Function, typename... A>
+    static R capture(Tracer& tracer, Function function, A... arguments) {
+        const auto result = function(arguments...);
+        tracer.put(result);
+        tracer.end();
+        return result;
+    }
+
+    template <typename Function, typename Tuple, std::size_t... I>
+    static void replay(Replayer& replayer, Reader& reader, Function function, const Tuple& arguments, Indices<I...>) {
+        const auto recorded = reader.get<R>();
+        Translate<RK>::learn(replayer, recorded, function(std::get<I>(arguments)...));
+    }
+};
+
+
+template <typename R>
+struct Result<R, PLAIN> {
+    template <typename Function, typename... A>
+    static R capture(Tracer& tracer, Function function, A... arguments) {
+        const auto result = function(arguments...);
+        tracer.end();
+        return result;
+    }
+
+    template <typename Function, typename Tuple, std::size_t... I>
+    static void replay(Replayer&, Reader&, Function function, const Tuple& arguments, Indices<I...>) {
+        function(std::get<I>(arguments)...);
+    }
+};
+
+
+template <>
+struct Result<void, PLAIN> {
+    template <typename Function, typename... A>
+    static void capture(Tracer& tracer, Function function, A... arguments) {
+        function(arguments...);
+        tracer.end();
+    }
+
+    template <typename Function, typename Tuple, std::size_t... I>
+    static void replay(Replayer&, Reader&, Function function, const Tuple& arguments, Indices<I...>) {
+        function(std::get<I>(arguments)...);
+    }
+};
+
+
+/*
+ * Codec of an entry point whose arguments are all passed by value: the kind of the result, then one per argument.
+ */
+template <std::size_t F, typename Signature, Kind... Kinds>
+struct ScalarCodec;
+
+template <std::size_t F, typename R, typename... A, Kind RK, Kind... K>
+struct ScalarCodec<F, R(A...), RK, K...> {
+    static_assert(sizeof...(A) == sizeof...(K), "each argument needs a kind");
+
+    static R GLHEADLESS_APIENTRY capture(A... arguments) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<F>(tracer);
+        if (tracer == nullptr) {
+            return function(arguments...);
+        }
+
+        tracer->begin(F);
+        const int expand[] = { 0, (tracer->put(arguments), 0)... };
+        static_cast<void>(expand);
+        return Result<R, RK>::capture(*tracer, function, arguments...);
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        // braced initialization reads the arguments in order
+        const std::tuple<A...> arguments{ Translate<K>::map(replayer, reader.get<A>())... };
+        Result<R, RK>::replay(replayer, reader, replayFunction<F>(replayer), arguments, typename MakeIndices<sizeof...(A)>::Type());
+    }
+};
+
+
+template <std::size_t F, Kind... Kinds>
+struct Scalar : ScalarCodec<F, typename Traced<F>::Signature, Kinds...> {
+};
+
+
+template <std::size_t F>
+struct Codec;
+
+#define GLHEADLESS_SCALAR_CODEC(name, ...) \
+    template <> \
+    struct Codec<FUNCTION_##name> : Scalar<FUNCTION_##name, __VA_ARGS__> { \
+    };
+
+GLHEADLESS_SCALAR_CODEC(ActiveTexture,            PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(AttachShader,             PLAIN, PROGRAM_NAME, PROGRAM_NAME)
+GLHEADLESS_SCALAR_CODEC(BindBuffer,               PLAIN, PLAIN, BUFFER_NAME)
+GLHEADLESS_SCALAR_CODEC(BindBufferBase,           PLAIN, PLAIN, PLAIN, BUFFER_NAME)
+GLHEADLESS_SCALAR_CODEC(BindBufferRange,          PLAIN, PLAIN, PLAIN, BUFFER_NAME, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(BindFramebuffer,          PLAIN, PLAIN, FRAMEBUFFER_NAME)
+GLHEADLESS_SCALAR_CODEC(BindRenderbuffer,         PLAIN, PLAIN, RENDERBUFFER_NAME)
+GLHEADLESS_SCALAR_CODEC(BindTexture,              PLAIN, PLAIN, TEXTURE_NAME)
+GLHEADLESS_SCALAR_CODEC(BindVertexArray,          PLAIN, VERTEX_ARRAY_NAME)
+GLHEADLESS_SCALAR_CODEC(BlendEquation,            PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(BlendEquationSeparate,    PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(BlendFunc,                PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(BlendFuncSeparate,        PLAIN, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(BlitFramebuffer,          PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(CheckFramebufferStatus,   PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(Clear,                    PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(ClearColor,               PLAIN, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(ClientWaitSync,           PLAIN, SYNC_OBJECT, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(ColorMask,                PLAIN, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(CompileShader,            PLAIN, PROGRAM_NAME)
+GLHEADLESS_SCALAR_CODEC(CopyBufferSubData,        PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(CopyTexSubImage2D,        PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(CreateProgram,            PROGRAM_NAME)
+GLHEADLESS_SCALAR_CODEC(CreateShader,             PROGRAM_NAME, PLAIN)
+GLHEADLESS_SCALAR_CODEC(CullFace,                 PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(DeleteProgram,            PLAIN, PROGRAM_NAME)
+GLHEADLESS_SCALAR_CODEC(DeleteShader,             PLAIN, PROGRAM_NAME)
+GLHEADLESS_SCALAR_CODEC(DeleteSync,               PLAIN, SYNC_OBJECT)
+GLHEADLESS_SCALAR_CODEC(DepthFunc,                PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(DepthMask,                PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(Disable,                  PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(DisableVertexAttribArray, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(DrawArrays,               PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(DrawArraysInstanced,      PLAIN, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(DrawElements,             PLAIN, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(DrawElementsInstanced,    PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(Enable,                   PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(EnableVertexAttribArray,  PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(FenceSync,                SYNC_OBJECT, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(Finish,                   PLAIN)
+GLHEADLESS_SCALAR_CODEC(Flush,                    PLAIN)
+GLHEADLESS_SCALAR_CODEC(FramebufferRenderbuffer,  PLAIN, PLAIN, PLAIN, PLAIN, RENDERBUFFER_NAME)
+GLHEADLESS_SCALAR_CODEC(FramebufferTexture2D,     PLAIN, PLAIN, PLAIN, PLAIN, TEXTURE_NAME, PLAIN)
+GLHEADLESS_SCALAR_CODEC(FrontFace,                PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(GenerateMipmap,           PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(GetBooleanv,              PLAIN, PLAIN, SCRATCH)
+GLHEADLESS_SCALAR_CODEC(GetError,                 PLAIN)
+GLHEADLESS_SCALAR_CODEC(GetIntegerv,              PLAIN, PLAIN, SCRATCH)
+GLHEADLESS_SCALAR_CODEC(GetProgramiv,             PLAIN, PROGRAM_NAME, PLAIN, SCRATCH)
+GLHEADLESS_SCALAR_CODEC(GetQueryObjectiv,         PLAIN, QUERY_NAME, PLAIN, SCRATCH)
+GLHEADLESS_SCALAR_CODEC(GetQueryObjectui64v,      PLAIN, QUERY_NAME, PLAIN, SCRATCH)
+GLHEADLESS_SCALAR_CODEC(GetShaderiv,              PLAIN, PROGRAM_NAME, PLAIN, SCRATCH)
+GLHEADLESS_SCALAR_CODEC(GetString,                PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(GetStringi,               PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(GetTexLevelParameteriv,   PLAIN, PLAIN, PLAIN, PLAIN, SCRATCH)
+GLHEADLESS_SCALAR_CODEC(IsEnabled,                PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(LinkProgram,              PLAIN, PROGRAM_NAME)
+GLHEADLESS_SCALAR_CODEC(MaxShaderCompilerThreadsKHR, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(PixelStorei,              PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(ProgramParameteri,        PLAIN, PROGRAM_NAME, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(QueryCounter,             PLAIN, QUERY_NAME, PLAIN)
+GLHEADLESS_SCALAR_CODEC(RenderbufferStorage,      PLAIN, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(Scissor,                  PLAIN, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(TexParameteri,            PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(Uniform1f,                PLAIN, UNIFORM_LOCATION, PLAIN)
+GLHEADLESS_SCALAR_CODEC(Uniform1i,                PLAIN, UNIFORM_LOCATION, PLAIN)
+GLHEADLESS_SCALAR_CODEC(Uniform2i,                PLAIN, UNIFORM_LOCATION, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(Uniform4f,                PLAIN, UNIFORM_LOCATION, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(VertexAttribPointer,      PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(Viewport,                 PLAIN, PLAIN, PLAIN, PLAIN, PLAIN)
+GLHEADLESS_SCALAR_CODEC(WaitSync,                 PLAIN, SYNC_OBJECT, PLAIN, PLAIN)
+
+#undef GLHEADLESS_SCALAR_CODEC
+
+
+/*
+ * Codecs of entry points reading or writing memory. Pointers into buffer objects, i.e., offsets, are recorded as
+ * values; client memory read by the driver is recorded as a blob, client memory written by it is replaced by scratch
+ * memory of the same size on replay.
+ */
+
+
+enum PixelSource : std::uint8_t {
+    NO_PIXELS,
+    CLIENT_PIXELS,
+    BUFFER_OFFSET
+};
+
+
+GLint integer(const Tracer& tracer, GLenum name) {
+    GLint value = 0;
+    driverFunction<FUNCTION_GetIntegerv>(&tracer)(name, &value);
+    return value;
+}
+
+
+std::size_t bytesPerPixel(GLenum format, GLenum type) {
+    switch (type) {
+    case UNSIGNED_BYTE_3_3_2:
+    case UNSIGNED_BYTE_2_3_3_REV:
+        return 1;
+    case UNSIGNED_SHORT_4_4_4_4:
+    case UNSIGNED_SHORT_4_4_4_4_REV:
+    case UNSIGNED_SHORT_5_5_5_1:
+    case UNSIGNED_SHORT_1_5_5_5_REV:
+    case UNSIGNED_SHORT_5_6_5:
+    case UNSIGNED_SHORT_5_6_5_REV:
+        return 2;
+    case UNSIGNED_INT_8_8_8_8:
+    case UNSIGNED_INT_8_8_8_8_REV:
+    case UNSIGNED_INT_10_10_10_2:
+    case UNSIGNED_INT_2_10_10_10_REV:
+    case UNSIGNED_INT_24_8:
+    case UNSIGNED_INT_10F_11F_11F_REV:
+    case UNSIGNED_INT_5_9_9_9_REV:
+        return 4;
+    case FLOAT_32_UNSIGNED_INT_24_8_REV:
+        return 8;
+    default:
+        break;
+    }
+
+    std::size_t components = 0;
+    switch (format) {
+    case RED:
+    case GREEN:
+    case BLUE:
+    case ALPHA:
+    case RED_INTEGER:
+    case DEPTH_COMPONENT:
+    case STENCIL_INDEX:
+        components = 1;
+        break;
+    case RG:
+    case RG_INTEGER:
+        components = 2;
+        break;
+    case RGB:
+    case BGR:
+    case RGB_INTEGER:
+    case BGR_INTEGER:
+        components = 3;
+        break;
+    case RGBA:
+    case BGRA:
+    case RGBA_INTEGER:
+    case BGRA_INTEGER:
+        components = 4;
+        break;
+    default:
+        return 0;
+    }
+
+    switch (type) {
+    case UNSIGNED_BYTE:
+    case BYTE:
+        return components;
+    case UNSIGNED_SHORT:
+    case SHORT:
+    case HALF_FLOAT:
+        return components * 2;
+    case UNSIGNED_INT:
+    case INT:
+    case FLOAT:
+        return components * 4;
+    default:
+        return 0;
+    }
+}
+
+
+// bytes of client memory covered by a transfer of an image, following the pack or unpack parameters
+std::size_t imageSize(const Tracer& tracer, bool pack, GLsizei width, GLsizei height, GLenum format, GLenum type) {
+    const auto pixelSize = bytesPerPixel(format, type);
+    if (width <= 0 || height <= 0 || pixelSize == 0) {
+        return 0;
+    }
+
+    const auto alignment = static_cast<std::size_t>(std::max(1, integer(tracer, pack ? PACK_ALIGNMENT : UNPACK_ALIGNMENT)));
+    const auto rowLength = integer(tracer, pack ? PACK_ROW_LENGTH : UNPACK_ROW_LENGTH);
+    const auto skipRows = static_cast<std::size_t>(integer(tracer, pack ? PACK_SKIP_ROWS : UNPACK_SKIP_ROWS));
+    const auto skipPixels = static_cast<std::size_t>(integer(tracer, pack ? PACK_SKIP_PIXELS : UNPACK_SKIP_PIXELS));
+
+    const auto rowPixels = static_cast<std::size_t>(rowLength > 0 ? rowLength : width);
+    const auto stride = (rowPixels * pixelSize + alignment - 1) / alignment * alignment;
+    return (skipRows + static_cast<std::size_t>(height) - 1) * stride + (skipPixels + static_cast<std::size_t>(width)) * pixelSize;
+}
+
+
+// client memory read by an upload is recorded, unless a pixel unpack buffer is bound
+template <typename SizeFunction>
+void putUpload(Tracer& tracer, const void* pixels, SizeFunction size) {
+    if (integer(tracer, PIXEL_UNPACK_BUFFER_BINDING) != 0) {
+        tracer.put(static_cast<std::uint8_t>(BUFFER_OFFSET));
+        tracer.put(pixels);
+    } else if (pixels == nullptr) {
+        tracer.put(static_cast<std::uint8_t>(NO_PIXELS));
+    } else {
+        tracer.put(static_cast<std::uint8_t>(CLIENT_PIXELS));
+        tracer.putBlob(pixels, size());
+    }
+}
+
+
+const void* getUpload(Reader& reader) {
+    std::size_t size = 0;
+    switch (reader.get<std::uint8_t>()) {
+    case NO_PIXELS:
+        return nullptr;
+    case CLIENT_PIXELS:
+        return reader.blob(size);
+    case BUFFER_OFFSET:
+        return reader.get<const void*>();
+    default:
+        throw InternalException(Error::INVALID_ARGUMENT, "Trace record has an invalid pixel source");
+    }
+}
+
+
+// only the size of client memory written by a download is recorded, unless a pixel pack buffer is bound
+template <typename SizeFunction>
+void putDownload(Tracer& tracer, void* pixels, SizeFunction size) {
+    if (integer(tracer, PIXEL_PACK_BUFFER_BINDING) != 0) {
+        tracer.put(static_cast<std::uint8_t>(BUFFER_OFFSET));
+        tracer.put(pixels);
+    } else {
+        tracer.put(static_cast<std::uint8_t>(CLIENT_PIXELS));
+        tracer.put(static_cast<std::uint64_t>(size()));
+    }
+}
+
+
+void* getDownload(Replayer& replayer, Reader& reader) {
+    switch (reader.get<std::uint8_t>()) {
+    case CLIENT_PIXELS:
+        return replayer.scratch(static_cast<std::size_t>(reader.get<std::uint64_t>()));
+    case BUFFER_OFFSET:
+        return reader.get<void*>();
+    default:
+        throw InternalException(Error::INVALID_ARGUMENT, "Trace record has an invalid pixel destination");
+    }
+}
+
+
+void putData(Tracer& tracer, const void* data, GLsizeiptr size) {
+    tracer.put(static_cast<std::uint8_t>(data != nullptr));
+    if (data != nullptr) {
+        tracer.putBlob(data, static_cast<std::size_t>(size));
+    }
+}
+
+
+const void* getData(Reader& reader) {
+    std::size_t size = 0;
+    return reader.get<std::uint8_t>() != 0 ? reader.blob(size) : nullptr;
+}
+
+
+template <std::size_t F>
+struct StorageCodec {
+    static void GLHEADLESS_APIENTRY capture(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<F>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(F);
+            tracer->put(target);
+            tracer->put(size);
+            tracer->put(usage);
+            putData(*tracer, data, size);
+        }
+
+        function(target, size, data, usage);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto target = reader.get<GLenum>();
+        const auto size = reader.get<GLsizeiptr>();
+        const auto usage = reader.get<GLenum>();
+        replayFunction<F>(replayer)(target, size, getData(reader), usage);
+    }
+};
+
+template <> struct Codec<FUNCTION_BufferData> : StorageCodec<FUNCTION_BufferData> {};
+template <> struct Codec<FUNCTION_BufferStorage> : StorageCodec<FUNCTION_BufferStorage> {};
+
+
+template <>
+struct Codec<FUNCTION_BufferSubData> {
+    static void GLHEADLESS_APIENTRY capture(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_BufferSubData>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(FUNCTION_BufferSubData);
+            tracer->put(target);
+            tracer->put(offset);
+            tracer->put(size);
+            putData(*tracer, data, size);
+        }
+
+        function(target, offset, size, data);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto target = reader.get<GLenum>();
+        const auto offset = reader.get<GLintptr>();
+        const auto size = reader.get<GLsizeiptr>();
+        replayFunction<FUNCTION_BufferSubData>(replayer)(target, offset, size, getData(reader));
+    }
+};
+
+
+template <>
+struct Codec<FUNCTION_CompressedTexImage2D> {
+    static void GLHEADLESS_APIENTRY capture(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_CompressedTexImage2D>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(FUNCTION_CompressedTexImage2D);
+            tracer->put(target);
+            tracer->put(level);
+            tracer->put(internalFormat);
+            tracer->put(width);
+            tracer->put(height);
+            tracer->put(border);
+            tracer->put(imageSize);
+            putUpload(*tracer, data, [imageSize] { return static_cast<std::size_t>(std::max(0, imageSize)); });
+        }
+
+        function(target, level, internalFormat, width, height, border, imageSize, data);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto target = reader.get<GLenum>();
+        const auto level = reader.get<GLint>();
+        const auto internalFormat = reader.get<GLenum>();
+        const auto width = reader.get<GLsizei>();
+        const auto height = reader.get<GLsizei>();
+        const auto border = reader.get<GLint>();
+        const auto imageSize = reader.get<GLsizei>();
+        replayFunction<FUNCTION_CompressedTexImage2D>(replayer)(target, level, internalFormat, width, height, border, imageSize, getUpload(reader));
+    }
+};
+
+
+// glGen*(): the generated names are recorded after the call, replay maps them to the names it generates
+template <std::size_t F, Kind K>
+struct GenCodec {
+    static void GLHEADLESS_APIENTRY capture(GLsizei count, GLuint* names) {
+        const auto tracer = Tracer::current();
+        driverFunction<F>(tracer)(count, names);
+        if (tracer == nullptr) {
+            return;
+        }
+
+        tracer->begin(F);
+        tracer->put(count);
+        for (GLsizei i = 0; i < count; ++i) {
+            tracer->put(names[i]);
+        }
+        tracer->end();
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto count = reader.get<GLsizei>();
+        std::vector<GLuint> names(static_cast<std::size_t>(std::max(0, count)));
+        replayFunction<F>(replayer)(count, names.data());
+        for (auto name : names) {
+            replayer.learnName(K, reader.get<GLuint>(), name);
+        }
+    }
+};
+
+template <> struct Codec<FUNCTION_GenBuffers> : GenCodec<FUNCTION_GenBuffers, BUFFER_NAME> {};
+template <> struct Codec<FUNCTION_GenFramebuffers> : GenCodec<FUNCTION_GenFramebuffers, FRAMEBUFFER_NAME> {};
+template <> struct Codec<FUNCTION_GenQueries> : GenCodec<FUNCTION_GenQueries, QUERY_NAME> {};
+template <> struct Codec<FUNCTION_GenRenderbuffers> : GenCodec<FUNCTION_GenRenderbuffers, RENDERBUFFER_NAME> {};
+template <> struct Codec<FUNCTION_GenTextures> : GenCodec<FUNCTION_GenTextures, TEXTURE_NAME> {};
+template <> struct Codec<FUNCTION_GenVertexArrays> : GenCodec<FUNCTION_GenVertexArrays, VERTEX_ARRAY_NAME> {};
+
+
+template <std::size_t F, Kind K>
+struct DeleteCodec {
+    static void GLHEADLESS_APIENTRY capture(GLsizei count, const GLuint* names) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<F>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(F);
+            tracer->put(count);
+            for (GLsizei i = 0; i < count; ++i) {
+                tracer->put(names[i]);
+            }
+        }
+
+        function(count, names);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto count = reader.get<GLsizei>();
+        std::vector<GLuint> names(static_cast<std::size_t>(std::max(0, count)));
+        for (auto& name : names) {
+            name = replayer.name(K, reader.get<GLuint>());
+        }
+        replayFunction<F>(replayer)(count, names.data());
+    }
+};
+
+// the callback and its parameter only exist in the recording process, so installing it is not recorded
+template <>
+struct Codec<FUNCTION_DebugMessageCallback> {
+    static void GLHEADLESS_APIENTRY capture(GLDEBUGPROC callback, const void* userParam) {
+        driverFunction<FUNCTION_DebugMessageCallback>(Tracer::current())(callback, userParam);
+    }
+
+    static void replay(Replayer&, Reader&) {
+    }
+};
+
+
+template <>
+struct Codec<FUNCTION_DebugMessageControl> {
+    static void GLHEADLESS_APIENTRY capture(GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint* ids, GLboolean enabled) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_DebugMessageControl>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(FUNCTION_DebugMessageControl);
+            tracer->put(source);
+            tracer->put(type);
+            tracer->put(severity);
+            tracer->put(enabled);
+            tracer->put(count);
+            for (GLsizei i = 0; i < count; ++i) {
+                tracer->put(ids[i]);
+            }
+        }
+
+        function(source, type, severity, count, ids, enabled);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto source = reader.get<GLenum>();
+        const auto type = reader.get<GLenum>();
+        const auto severity = reader.get<GLenum>();
+        const auto enabled = reader.get<GLboolean>();
+        const auto count = reader.get<GLsizei>();
+        std::vector<GLuint> ids(static_cast<std::size_t>(std::max(0, count)));
+        for (auto& id : ids) {
+            id = reader.get<GLuint>();
+        }
+        replayFunction<FUNCTION_DebugMessageControl>(replayer)(source, type, severity, count, ids.data(), enabled);
+    }
+};
+
+
+template <>
+struct Codec<FUNCTION_DebugMessageInsert> {
+    static void GLHEADLESS_APIENTRY capture(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_DebugMessageInsert>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(FUNCTION_DebugMessageInsert);
+            tracer->put(source);
+            tracer->put(type);
+            tracer->put(id);
+            tracer->put(severity);
+            tracer->putBlob(message, length >= 0 ? static_cast<std::size_t>(length) : std::strlen(message));
+        }
+
+        function(source, type, id, severity, length, message);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto source = reader.get<GLenum>();
+        const auto type = reader.get<GLenum>();
+        const auto id = reader.get<GLuint>();
+        const auto severity = reader.get<GLenum>();
+        std::size_t length = 0;
+        const auto message = reinterpret_cast<const GLchar*>(reader.blob(length));
+        replayFunction<FUNCTION_DebugMessageInsert>(replayer)(source, type, id, severity, static_cast<GLsizei>(length), message);
+    }
+};
+
+
+template <> struct Codec<FUNCTION_DeleteBuffers> : DeleteCodec<FUNCTION_DeleteBuffers, BUFFER_NAME> {};
+template <> struct Codec<FUNCTION_DeleteFramebuffers> : DeleteCodec<FUNCTION_DeleteFramebuffers, FRAMEBUFFER_NAME> {};
+template <> struct Codec<FUNCTION_DeleteQueries> : DeleteCodec<FUNCTION_DeleteQueries, QUERY_NAME> {};
+template <> struct Codec<FUNCTION_DeleteRenderbuffers> : DeleteCodec<FUNCTION_DeleteRenderbuffers, RENDERBUFFER_NAME> {};
+template <> struct Codec<FUNCTION_DeleteTextures> : DeleteCodec<FUNCTION_DeleteTextures, TEXTURE_NAME> {};
+template <> struct Codec<FUNCTION_DeleteVertexArrays> : DeleteCodec<FUNCTION_DeleteVertexArrays, VERTEX_ARRAY_NAME> {};
+
+
+template <>
+struct Codec<FUNCTION_GetBufferSubData> {
+    static void GLHEADLESS_APIENTRY capture(GLenum target, GLintptr offset, GLsizeiptr size, void* data) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_GetBufferSubData>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(FUNCTION_GetBufferSubData);
+            tracer->put(target);
+            tracer->put(offset);
+            tracer->put(size);
+        }
+
+        function(target, offset, size, data);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto target = reader.get<GLenum>();
+        const auto offset = reader.get<GLintptr>();
+        const auto size = reader.get<GLsizeiptr>();
+        const auto data = replayer.scratch(static_cast<std::size_t>(std::max<GLsizeiptr>(0, size)));
+        replayFunction<FUNCTION_GetBufferSubData>(replayer)(target, offset, size, data);
+    }
+};
+
+
+std::size_t levelParameter(const Tracer& tracer, GLenum target, GLint level, GLenum name) {
+    GLint value = 0;
+    driverFunction<FUNCTION_GetTexLevelParameteriv>(&tracer)(target, level, name, &value);
+    return static_cast<std::size_t>(std::max(0, value));
+}
+
+
+template <>
+struct Codec<FUNCTION_GetCompressedTexImage> {
+    static void GLHEADLESS_APIENTRY capture(GLenum target, GLint level, void* data) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_GetCompressedTexImage>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(FUNCTION_GetCompressedTexImage);
+            tracer->put(target);
+            tracer->put(level);
+            putDownload(*tracer, data, [tracer, target, level] {
+                return levelParameter(*tracer, target, level, TEXTURE_COMPRESSED_IMAGE_SIZE);
+            });
+        }
+
+        function(target, level, data);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto target = reader.get<GLenum>();
+        const auto level = reader.get<GLint>();
+        replayFunction<FUNCTION_GetCompressedTexImage>(replayer)(target, level, getDownload(replayer, reader));
+    }
+};
+
+
+// the info log and binary getters write at most the given size
+template <std::size_t F>
+struct LogCodec {
+    static void GLHEADLESS_APIENTRY capture(GLuint object, GLsizei size, GLsizei* length, GLchar* log) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<F>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(F);
+            tracer->put(object);
+            tracer->put(size);
+        }
+
+        function(object, size, length, log);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto object = replayer.name(PROGRAM_NAME, reader.get<GLuint>());
+        const auto size = reader.get<GLsizei>();
+        GLsizei length = 0;
+        const auto log = static_cast<GLchar*>(replayer.scratch(static_cast<std::size_t>(std::max(0, size))));
+        replayFunction<F>(replayer)(object, size, &length, log);
+    }
+};
+
+template <> struct Codec<FUNCTION_GetProgramInfoLog> : LogCodec<FUNCTION_GetProgramInfoLog> {};
+template <> struct Codec<FUNCTION_GetShaderInfoLog> : LogCodec<FUNCTION_GetShaderInfoLog> {};
+
+
+template <>
+struct Codec<FUNCTION_GetProgramBinary> {
+    static void GLHEADLESS_APIENTRY capture(GLuint program, GLsizei size, GLsizei* length, GLenum* format, void* binary) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_GetProgramBinary>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(FUNCTION_GetProgramBinary);
+            tracer->put(program);
+            tracer->put(size);
+        }
+
+        function(program, size, length, format, binary);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto program = replayer.name(PROGRAM_NAME, reader.get<GLuint>());
+        const auto size = reader.get<GLsizei>();
+        GLsizei length = 0;
+        GLenum format = 0;
+        const auto binary = replayer.scratch(static_cast<std::size_t>(std::max(0, size)));
+        replayFunction<FUNCTION_GetProgramBinary>(replayer)(program, size, &length, &format, binary);
+    }
+};
+
+
+template <>
+struct Codec<FUNCTION_GetTexImage> {
+    static void GLHEADLESS_APIENTRY capture(GLenum target, GLint level, GLenum format, GLenum type, void* pixels) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_GetTexImage>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(FUNCTION_GetTexImage);
+            tracer->put(target);
+            tracer->put(level);
+            tracer->put(format);
+            tracer->put(type);
+            putDownload(*tracer, pixels, [tracer, target, level, format, type] {
+                const auto width = static_cast<GLsizei>(levelParameter(*tracer, target, level, TEXTURE_WIDTH));
+                const auto height = static_cast<GLsizei>(levelParameter(*tracer, target, level, TEXTURE_HEIGHT));
+                const auto depth = std::max<std::size_t>(1, levelParameter(*tracer, target, level, TEXTURE_DEPTH));
+                return imageSize(*tracer, true, width, height, format, type) * depth;
+            });
+        }
+
+        function(target, level, format, type, pixels);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto target = reader.get<GLenum>();
+        const auto level = reader.get<GLint>();
+        const auto format = reader.get<GLenum>();
+        const auto type = reader.get<GLenum>();
+        replayFunction<FUNCTION_GetTexImage>(replayer)(target, level, format, type, getDownload(replayer, reader));
+    }
+};
+
+
+template <>
+struct Codec<FUNCTION_GetUniformLocation> {
+    static GLint GLHEADLESS_APIENTRY capture(GLuint program, const GLchar* name) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_GetUniformLocation>(tracer);
+        if (tracer == nullptr) {
+            return function(program, name);
+        }
+
+        tracer->begin(FUNCTION_GetUniformLocation);
+        tracer->put(program);
+        tracer->putBlob(name, std::strlen(name) + 1);
+        const auto location = function(program, name);
+        tracer->put(location);
+        tracer->end();
+        return location;
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto program = replayer.name(PROGRAM_NAME, reader.get<GLuint>());
+        std::size_t size = 0;
+        const auto name = reinterpret_cast<const GLchar*>(reader.blob(size));
+        if (size == 0 || name[size - 1] != '\0') {
+            throw InternalException(Error::INVALID_ARGUMENT, "Trace record has an invalid uniform name");
+        }
+        const auto location = replayFunction<FUNCTION_GetUniformLocation>(replayer)(program, name);
+        replayer.learnLocation(program, reader.get<GLint>(), location);
+    }
+};
+
+
+// data written through a mapping is recorded when the buffer is unmapped; persistent mappings are not covered
+template <>
+struct Codec<FUNCTION_MapBufferRange> {
+    static void* GLHEADLESS_APIENTRY capture(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_MapBufferRange>(tracer);
+        if (tracer == nullptr) {
+            return function(target, offset, length, access);
+        }
+
+        tracer->begin(FUNCTION_MapBufferRange);
+        tracer->put(target);
+        tracer->put(offset);
+        tracer->put(length);
+        tracer->put(access);
+        const auto pointer = function(target, offset, length, access);
+        tracer->end();
+
+        auto& mappings = tracer->mappings;
+        mappings.erase(std::remove_if(mappings.begin(), mappings.end(), [target] (const Tracer::Mapping& mapping) {
+            return mapping.target == target;
+        }), mappings.end());
+        if (pointer != nullptr) {
+            mappings.push_back({ target, pointer, length, access });
+        }
+        return pointer;
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto target = reader.get<GLenum>();
+        const auto offset = reader.get<GLintptr>();
+        const auto length = reader.get<GLsizeiptr>();
+        const auto access = reader.get<GLbitfield>();
+        const auto pointer = replayFunction<FUNCTION_MapBufferRange>(replayer)(target, offset, length, access);
+
+        auto& mappings = replayer.mappings;
+        mappings.erase(std::remove_if(mappings.begin(), mappings.end(), [target] (const std::pair<GLenum, void*>& mapping) {
+            return mapping.first == target;
+        }), mappings.end());
+        mappings.push_back(std::make_pair(target, pointer));
+    }
+};
+
+
+template <>
+struct Codec<FUNCTION_UnmapBuffer> {
+    static GLboolean GLHEADLESS_APIENTRY capture(GLenum target) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_UnmapBuffer>(tracer);
+        if (tracer == nullptr) {
+            return function(target);
+        }
+
+        tracer->begin(FUNCTION_UnmapBuffer);
+        tracer->put(target);
+        auto& mappings = tracer->mappings;
+        const auto mapping = std::find_if(mappings.begin(), mappings.end(), [target] (const Tracer::Mapping& mapping) {
+            return mapping.target == target;
+        });
+        const auto written = mapping != mappings.end() && (mapping->access & MAP_WRITE_BIT) != 0 && (mapping->access & MAP_PERSISTENT_BIT) == 0;
+        putData(*tracer, written ? mapping->pointer : nullptr, written ? mapping->length : 0);
+        if (mapping != mappings.end()) {
+            mappings.erase(mapping);
+        }
+
+        const auto result = function(target);
+        tracer->end();
+        return result;
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto target = reader.get<GLenum>();
+        std::size_t size = 0;
+        const auto written = reader.get<std::uint8_t>() != 0 ? reader.blob(size) : nullptr;
+
+        auto& mappings = replayer.mappings;
+        const auto mapping = std::find_if(mappings.begin(), mappings.end(), [target] (const std::pair<GLenum, void*>& mapping) {
+            return mapping.first == target;
+        });
+        if (mapping != mappings.end()) {
+            if (written != nullptr && mapping->second != nullptr) {
+                std::memcpy(mapping->second, written, size);
+            }
+            mappings.erase(mapping);
+        }
+        replayFunction<FUNCTION_UnmapBuffer>(replayer)(target);
+    }
+};
+
+
+template <>
+struct Codec<FUNCTION_ProgramBinary> {
+    static void GLHEADLESS_APIENTRY capture(GLuint program, GLenum format, const void* binary, GLsizei length) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_ProgramBinary>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(FUNCTION_ProgramBinary);
+            tracer->put(program);
+            tracer->put(format);
+            tracer->putBlob(binary, static_cast<std::size_t>(std::max(0, length)));
+        }
+
+        function(program, format, binary, length);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto program = replayer.name(PROGRAM_NAME, reader.get<GLuint>());
+        const auto format = reader.get<GLenum>();
+        std::size_t size = 0;
+        const auto binary = reader.blob(size);
+        replayFunction<FUNCTION_ProgramBinary>(replayer)(program, format, binary, static_cast<GLsizei>(size));
+    }
+};
+
+
+template <>
+struct Codec<FUNCTION_ReadPixels> {
+    static void GLHEADLESS_APIENTRY capture(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_ReadPixels>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(FUNCTION_ReadPixels);
+            tracer->put(x);
+            tracer->put(y);
+            tracer->put(width);
+            tracer->put(height);
+            tracer->put(format);
+            tracer->put(type);
+            putDownload(*tracer, pixels, [tracer, width, height, format, type] {
+                return imageSize(*tracer, true, width, height, format, type);
+            });
+        }
+
+        function(x, y, width, height, format, type, pixels);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto x = reader.get<GLint>();
+        const auto y = reader.get<GLint>();
+        const auto width = reader.get<GLsizei>();
+        const auto height = reader.get<GLsizei>();
+        const auto format = reader.get<GLenum>();
+        const auto type = reader.get<GLenum>();
+        replayFunction<FUNCTION_ReadPixels>(replayer)(x, y, width, height, format, type, getDownload(replayer, reader));
+    }
+};
+
+
+template <>
+struct Codec<FUNCTION_ShaderSource> {
+    static void GLHEADLESS_APIENTRY capture(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_ShaderSource>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(FUNCTION_ShaderSource);
+            tracer->put(shader);
+            tracer->put(count);
+            for (GLsizei i = 0; i < count; ++i) {
+                const auto length = lengths != nullptr && lengths[i] >= 0 ? static_cast<std::size_t>(lengths[i]) : std::strlen(strings[i]);
+                tracer->putBlob(strings[i], length);
+            }
+        }
+
+        function(shader, count, strings, lengths);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto shader = replayer.name(PROGRAM_NAME, reader.get<GLuint>());
+        const auto count = reader.get<GLsizei>();
+        std::vector<const GLchar*> strings;
+        std::vector<GLint> lengths;
+        for (GLsizei i = 0; i < count; ++i) {
+            std::size_t size = 0;
+            strings.push_back(reinterpret_cast<const GLchar*>(reader.blob(size)));
+            lengths.push_back(static_cast<GLint>(size));
+        }
+        replayFunction<FUNCTION_ShaderSource>(replayer)(shader, count, strings.data(), lengths.data());
+    }
+};
+
+
+template <>
+struct Codec<FUNCTION_TexImage2D> {
+    static void GLHEADLESS_APIENTRY capture(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_TexImage2D>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(FUNCTION_TexImage2D);
+            tracer->put(target);
+            tracer->put(level);
+            tracer->put(internalFormat);
+            tracer->put(width);
+            tracer->put(height);
+            tracer->put(border);
+            tracer->put(format);
+            tracer->put(type);
+            putUpload(*tracer, pixels, [tracer, width, height, format, type] {
+                return imageSize(*tracer, false, width, height, format, type);
+            });
+        }
+
+        function(target, level, internalFormat, width, height, border, format, type, pixels);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto target = reader.get<GLenum>();
+        const auto level = reader.get<GLint>();
+        const auto internalFormat = reader.get<GLint>();
+        const auto width = reader.get<GLsizei>();
+        const auto height = reader.get<GLsizei>();
+        const auto border = reader.get<GLint>();
+        const auto format = reader.get<GLenum>();
+        const auto type = reader.get<GLenum>();
+        replayFunction<FUNCTION_TexImage2D>(replayer)(target, level, internalFormat, width, height, border, format, type, getUpload(reader));
+    }
+};
+
+
+template <>
+struct Codec<FUNCTION_TexSubImage2D> {
+    static void GLHEADLESS_APIENTRY capture(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels) {
+        const auto tracer = Tracer::current();
+        const auto function = driverFunction<FUNCTION_TexSubImage2D>(tracer);
+        if (tracer != nullptr) {
+            tracer->begin(FUNCTION_TexSubImage2D);
+            tracer->put(target);
+            tracer->put(level);
+            tracer->put(x);
+            tracer->put(y);
+            tracer->put(width);
+            tracer->put(height);
+            tracer->put(format);
+            tracer->put(type);
+            putUpload(*tracer, pixels, [tracer, width, height, format, type] {
+                return imageSize(*tracer, false, width, height, format, type);
+            });
+        }
+
+        function(target, level, x, y, width, height, format, type, pixels);
+        if (tracer != nullptr) {
+            tracer->end();
+        }
+    }
+
+    static void replay(Replayer& replayer, Reader& reader) {
+        const auto target = reader.get<GLenum>();
+        const auto level = reader.get<GLint>();
+        const auto x = reader.get<GLint>();
+        const auto y = reader.get<GLint>();
+        const auto width = reader.get<GLsizei>();
+        const auto height = reader.get<GLsizei>();
+        const auto format = reader.get<GLenum>();
+        const auto type = reader.get<GLenum>();
+        replayFunction<FUNCTION_TexSubImage2D>(replayer)(target, level, x, y, width, height, format, type, getUpload(reader));
+    }
+};
+
+
+// replay tracks the program in use, as uniform locations refer to it
+template <>
+struct Codec<FUNCTION_UseProgram> : Scalar<FUNCTION_UseProgram, PLAIN, PROGRAM_NAME> {
+    static void replay(Replayer& replayer, Reader& reader) {
+        replayer.program = replayer.name(PROGRAM_NAME, reader.get<GLuint>());
+        replayFunction<FUNCTION_UseProgram>(replayer)(replayer.program);
+    }
+};
+
+
+using ReplayFunction = void (*)(Replayer&, Reader&);
+
+const ReplayFunction k_replayFunctions[FUNCTION_COUNT] = {
+#define GLHEADLESS_REPLAY_GL_FUNCTION(name, signature) &Codec<FUNCTION_##name>::replay,
+    GLHEADLESS_GL_FUNCTIONS(GLHEADLESS_REPLAY_GL_FUNCTION)
+#undef GLHEADLESS_REPLAY_GL_FUNCTION
+};
+
+
+}  // unnamed namespace
+
+
+Tracer::Tracer(const std::string& path, const Resolver& resolver)
+: m_file(new AppendFile(path))
+, m_callCount(0) {
+    resolve(resolver);
+
+    // the function table lets replay find functions by name, so traces survive changes of the table
+    const auto count = static_cast<std::uint32_t>(FUNCTION_COUNT);
+    m_file->append(k_traceMagic, sizeof(k_traceMagic));
+    m_file->append(&k_traceVersion, sizeof(k_traceVersion));
+    m_file->append(&count, sizeof(count));
+    for (std::size_t i = 0; i < FUNCTION_COUNT; ++i) {
+        const auto name = functionName(i);
+        const auto length = static_cast<std::uint16_t>(std::strlen(name));
+        m_file->append(&length, sizeof(length));
+        m_file->append(name, length);
+    }
+}
+
+
+Tracer::~Tracer() {
+    if (t_current == this) {
+        t_current = nullptr;
+    }
+}
+
+
+void Tracer::resolve(const Resolver& resolver) {
+    for (std::size_t i = 0; i < FUNCTION_COUNT; ++i) {
+        driver[i] = resolver(functionName(i));
+        if (driver[i] != nullptr) {
+            g_fallback[i].store(driver[i], std::memory_order_relaxed);
+        }
+    }
+}
+
+
+Tracer::Address Tracer::wrap(const char* name, Address address) const {
+    if (address == nullptr || std::strncmp(name, "gl", 2) != 0) {
+        return address;
+    }
+
+#define GLHEADLESS_WRAP_TRACED_GL_FUNCTION(function, signature) \
+    if (std::strcmp(name + 2, #function) == 0) { \
+        return driver[FUNCTION_##function] != nullptr ? reinterpret_cast<Address>(static_cast<Proc<signature>::Type>(&Codec<FUNCTION_##function>::capture)) : address; \
+    }
+    GLHEADLESS_GL_FUNCTIONS(GLHEADLESS_WRAP_TRACED_GL_FUNCTION)
+#undef GLHEADLESS_WRAP_TRACED_GL_FUNCTION
+
+    return address;
+}
+
+
+void Tracer::begin(std::size_t function) {
+    const std::uint16_t header[4] = { static_cast<std::uint16_t>(function + 1), 0, 0, 0 };
+    m_record.clear();
+    write(header, sizeof(header));
+}
+
+
+void Tracer::write(const void* data, std::size_t size) {
+    const auto bytes = static_cast<const unsigned char*>(data);
+    m_record.insert(m_record.end(), bytes, bytes + size);
+}
+
+
+void Tracer::putBlob(const void* data, std::size_t size) {
+    put(static_cast<std::uint64_t>(size));
+    write(data, size);
+}
+
+
+void Tracer::end() {
+    if (failed()) {
+        return;
+    }
+
+    const auto size = static_cast<std::uint32_t>(m_record.size() - 8);
+    std::memcpy(m_record.data() + 4, &size, sizeof(size));
+
+    // the driver call already happened, so a failure cannot be reported to the caller
+    try {
+        m_file->append(m_record.data(), m_record.size());
+        ++m_callCount;
+    } catch (InternalException& e) {
+        m_errorCode = e.code();
+        m_errorMessage = e.message();
+    }
+}
+
+
+std::uint64_t Tracer::callCount() const {
+    return m_callCount;
+}
+
+
+bool Tracer::failed() const {
+    return static_cast<bool>(m_errorCode);
+}
+
+
+const std::error_code& Tracer::errorCode() const {
+    return m_errorCode;
+}
+
+
+const std::string& Tracer::errorMessage() const {
+    return m_errorMessage;
+}
+
+
+Tracer* Tracer::current() {
+    return t_current;
+}
+
+
+void Tracer::setCurrent(Tracer* tracer) {
+    t_current = tracer;
+}
+
+
+const TraceFallback* Tracer::fallback() {
+    return t_fallback;
+}
+
+
+void Tracer::setFallback(const TraceFallback* fallback) {
+    t_fallback = fallback;
+}
+
+
+void TraceFallback::resolve(const Tracer::Resolver& resolver) {
+    for (std::size_t i = 0; i < FUNCTION_COUNT; ++i) {
+        driver[i] = resolver(functionName(i));
+    }
+}
+
+
+Replayer::Replayer(const Tracer::Resolver& resolver)
+: program(0) {
+    for (std::size_t i = 0; i < FUNCTION_COUNT; ++i) {
+        m_functions[i] = resolver(functionName(i));
+    }
+}
+
+
+void Replayer::play(std::size_t function, const unsigned char* data, std::size_t size) {
+    Reader reader(data, size);
+    k_replayFunctions[function](*this, reader);
+}
+
+
+Replayer::Address Replayer::address(std::size_t function) const {
+    if (m_functions[function] == nullptr) {
+        throw InternalException(Error::UNSUPPORTED_FEATURE, std::string(functionName(function)) + " is not available in the replaying context");
+    }
+    return m_functions[function];
+}
+
+
+GLuint Replayer::name(std::size_t kind, GLuint recorded) const {
+    // names not created by the trace, e.g., 0, are passed as recorded
+    const auto& names = m_names[kind];
+    const auto name = names.find(recorded);
+    return name != names.end() ? name->second : recorded;
+}
+
+
+void Replayer::learnName(std::size_t kind, GLuint recorded, GLuint actual) {
+    m_names[kind][recorded] = actual;
+}
+
+
+GLint Replayer::location(GLint recorded) const {
+    const auto location = m_locations.find(static_cast<std::uint64_t>(program) << 32 | static_cast<std::uint32_t>(recorded));
+    return location != m_locations.end() ? location->second : recorded;
+}
+
+
+void Replayer::learnLocation(GLuint program, GLint recorded, GLint actual) {
+    m_locations[static_cast<std::uint64_t>(program) << 32 | static_cast<std::uint32_t>(recorded)] = actual;
+}
+
+
+GLsync Replayer::sync(GLsync recorded) const {
+    // unlike names, sync objects created outside the trace cannot be referred to
+    const auto sync = m_syncs.find(recorded);
+    return sync != m_syncs.end() ? sync->second : nullptr;
+}
+
+
+void Replayer::learnSync(GLsync recorded, GLsync actual) {
+    m_syncs[recorded] = actual;
+}
+
+
+void* Replayer::scratch(std::size_t size) {
+    if (m_scratch.size() < size) {
+        m_scratch.resize(size);
+    }
+    return m_scratch.data();
+}
+
+
+}  // namespace gl
+}  // namespace glheadless
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "GLFunctions.h"
+
+
+namespace glheadless {
+
+
+class AppendFile;
+
+
+namespace gl {
+
+
+/*
+ * Trace file layout, all values in native byte order:
+ *
+ *   header   "GLHTRACE", uint32 version, uint32 function count, per function uint16 length and name
+ *   records  uint16 function index + 1, uint16 0, uint32 payload size, payload
+ *
+ * A function index of 0 ends the trace. Payloads hold the arguments in order, each in its own size, pointers as
+ * uint64; blobs are a uint64 size followed by the bytes. Results that replay needs to translate names follow the
+ * arguments.
+ */
+const char          k_traceMagic[8] = { 'G', 'L', 'H', 'T', 'R', 'A', 'C', 'E' };
+const std::uint32_t k_traceVersion  = 1;
+
+
+struct TraceFallback;
+
+
+/*
+ * Records the calls of one context. Context::getProcAddress() hands out the recording entry points of Trace.cpp
+ * instead of the driver's; they look up the tracer of the context current on the calling thread, append a record and
+ * pass the call on. Records are built in memory and appended to the file as a whole after the call returned.
+ *
+ * A failure to extend the file stops recording; the error is kept for Context::stopTrace().
+ */
+class Tracer {
+public:
+    using Address = void (*)();
+    using Resolver = std::function<Address(const char*)>;
+
+    struct Mapping {
+        GLenum     target;
+        void*      pointer;
+        GLsizeiptr length;
+        GLbitfield access;
+    };
+
+    // creates the file and resolves the driver's entry points; throws InternalException
+    Tracer(const std::string& path, const Resolver& resolver);
+    ~Tracer();
+
+    // updates the entry points the recording entry points pass calls on to
+    void resolve(const Resolver& resolver);
+
+    // the recording replacement of a driver entry point, or the entry point itself if it is not traced
+    Address wrap(const char* name, Address address) const;
+
+    void begin(std::size_t function);
+    void write(const void* data, std::size_t size);
+    void end();
+
+    template <typename T>
+    typename std::enable_if<!std::is_pointer<T>::value>::type put(T value);
+    template <typename T>
+    typename std::enable_if<std::is_pointer<T>::value>::type put(T value);
+    void putBlob(const void* data, std::size_t size);
+
+    std::uint64_t callCount() const;
+    bool failed() const;
+    const std::error_code& errorCode() const;
+    const std::string& errorMessage() const;
+
+    static Tracer* current();
+    static void setCurrent(Tracer* tracer);
+
+    // the entry points passed on to while no tracer is current on the thread, set with the context they belong to
+    static const TraceFallback* fallback();
+    static void setFallback(const TraceFallback* fallback);
+
+    Address              driver[FUNCTION_COUNT];
+    std::vector<Mapping> mappings; // buffers mapped through glMapBufferRange(), by target
+
+
+private:
+    std::unique_ptr<AppendFile> m_file;
+    std::vector<unsigned char>  m_record;
+    std::uint64_t               m_callCount;
+
+    std::error_code m_errorCode;
+    std::string     m_errorMessage;
+};
+
+
+/*
+ * The driver entry points the recording entry points of a context pass calls on to once its trace was stopped. The
+ * context keeps them and makes them current with itself, as on WGL entry points are only valid for contexts of the
+ * pixel format they were resolved for.
+ */
+struct TraceFallback {
+    void resolve(const Tracer::Resolver& resolver);
+
+    Tracer::Address driver[FUNCTION_COUNT];
+};
+
+
+template <typename T>
+typename std::enable_if<!std::is_pointer<T>::value>::type Tracer::put(T value) {
+    write(&value, sizeof(value));
+}
+
+
+template <typename T>
+typename std::enable_if<std::is_pointer<T>::value>::type Tracer::put(T value) {
+    const auto bits = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(value));
+    write(&bits, sizeof(bits));
+}
+
+
+/*
+ * Plays the records of a trace on the context current on the calling thread. Object names, uniform locations and
+ * sync objects returned by the replayed calls are translated, so later records refer to the replayed objects.
+ * Output pointers receive scratch memory.
+ */
+class Replayer {
+public:
+    using Address = Tracer::Address;
+
+    static const std::size_t k_nameKinds = 7;
+
+    explicit Replayer(const Tracer::Resolver& resolver);
+
+    // throws InternalException if the record is malformed or the function is not available
+    void play(std::size_t function, const unsigned char* data, std::size_t size);
+
+    Address address(std::size_t function) const;
+
+    GLuint name(std::size_t kind, GLuint recorded) const;
+    void learnName(std::size_t kind, GLuint recorded, GLuint actual);
+
+    // locations refer to the program in use
+    GLint location(GLint recorded) const;
+    void learnLocation(GLuint program, GLint recorded, GLint actual);
+
+    GLsync sync(GLsync recorded) const;
+    void learnSync(GLsync recorded, GLsync actual);
+
+    void* scratch(std::size_t size);
+
+    GLuint                                program; // program in use, as replayed
+    std::vector<std::pair<GLenum, void*>> mappings;
+
+
+private:
+    Address                            m_functions[FUNCTION_COUNT];
+    std::unordered_map<GLuint, GLuint> m_names[k_nameKinds];
+    std::unordered_map<std::uint64_t, GLint> m_locations;
+    std::unordered_map<GLsync, GLsync> m_syncs;
+    std::vector<unsigned char>         m_scratch;
+};
+
+
+}  // namespace gl
+}  // namespace glheadless
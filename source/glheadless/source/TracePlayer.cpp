@@ -0,0 +1,198 @@
+#include <glheadless/TracePlayer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <glheadless/Context.h>
+#include <glheadless/error.h>
+
+#include "InternalException.h"
+#include "MappedFile.h"
+#include "Trace.h"
+
+
+namespace glheadless {
+
+
+namespace {
+
+
+const std::size_t k_recordHeaderSize = 8;
+
+
+template <typename T>
+T read(const unsigned char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+
+}  // unnamed namespace
+
+
+TracePlayer::TracePlayer()
+: m_recordStart(0)
+, m_callCount(0) {
+}
+
+
+TracePlayer::~TracePlayer() {
+}
+
+
+bool TracePlayer::open(const std::string& path) {
+    close();
+
+    try {
+        m_file.reset(new MappedFile(path));
+
+        const auto data = m_file->data();
+        const auto size = m_file->size();
+        if (size < sizeof(gl::k_traceMagic) + 8 || std::memcmp(data, gl::k_traceMagic, sizeof(gl::k_traceMagic)) != 0) {
+            throw InternalException(Error::INVALID_ARGUMENT, path + " is not a glheadless trace");
+        }
+        const auto version = read<std::uint32_t>(data + 8);
+        if (version != gl::k_traceVersion) {
+            throw InternalException(Error::INVALID_ARGUMENT, path + " has unsupported trace version " + std::to_string(version));
+        }
+
+        // functions of the file are matched by name, unknown ones fail only if the trace calls them
+        const auto count = read<std::uint32_t>(data + 12);
+        auto offset = std::size_t(16);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            if (size - offset < 2 || size - offset - 2 < read<std::uint16_t>(data + offset)) {
+                throw InternalException(Error::INVALID_ARGUMENT, path + " has a truncated function table");
+            }
+            const auto name = std::string(reinterpret_cast<const char*>(data + offset + 2), read<std::uint16_t>(data + offset));
+            offset += 2 + name.size();
+
+            auto function = 0u;
+            while (function < gl::FUNCTION_COUNT && name != gl::functionName(function)) {
+                ++function;
+            }
+            m_functions.push_back(function);
+        }
+        m_recordStart = offset;
+
+        while (size - offset >= k_recordHeaderSize) {
+            const auto index = read<std::uint16_t>(data + offset);
+            if (index == 0) {
+                break;
+            }
+            const auto recordSize = read<std::uint32_t>(data + offset + 4);
+            if (index > m_functions.size() || size - offset - k_recordHeaderSize < recordSize) {
+                throw InternalException(Error::INVALID_ARGUMENT, path + " has a malformed record at offset " + std::to_string(offset));
+            }
+            if (m_functions[index - 1] == gl::FUNCTION_COUNT) {
+                throw InternalException(Error::UNSUPPORTED_FEATURE, path + " calls an OpenGL function that cannot be replayed by this version");
+            }
+            offset += k_recordHeaderSize + recordSize;
+            ++m_callCount;
+        }
+    } catch (InternalException& e) {
+        close();
+        return setError(e.code(), e.message());
+    }
+
+    return true;
+}
+
+
+void TracePlayer::close() {
+    m_file.reset();
+    m_functions.clear();
+    m_recordStart = 0;
+    m_callCount = 0;
+}
+
+
+bool TracePlayer::isOpen() const {
+    return m_file != nullptr;
+}
+
+
+std::uint64_t TracePlayer::callCount() const {
+    return m_callCount;
+}
+
+
+bool TracePlayer::play(Context* context, TraceTimings& timings, bool timeFunctions) {
+    if (!isOpen()) {
+        return setError(make_error_code(Error::INVALID_ARGUMENT), "No trace is open");
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto milliseconds = [] (Clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+
+    timings = TraceTimings();
+    std::vector<TraceFunctionTiming> functions(timeFunctions ? gl::FUNCTION_COUNT : 0);
+    const auto data = m_file->data();
+    auto offset = m_recordStart;
+
+    try {
+        gl::Replayer replayer([context] (const char* name) {
+            return context->getProcAddress(name);
+        });
+
+        const auto start = Clock::now();
+        for (std::uint64_t i = 0; i < m_callCount; ++i) {
+            const auto function = m_functions[read<std::uint16_t>(data + offset) - 1];
+            const auto size = read<std::uint32_t>(data + offset + 4);
+            const auto record = data + offset + k_recordHeaderSize;
+
+            if (timeFunctions) {
+                const auto callStart = Clock::now();
+                replayer.play(function, record, size);
+                functions[function].milliseconds += milliseconds(Clock::now() - callStart);
+                ++functions[function].callCount;
+            } else {
+                replayer.play(function, record, size);
+            }
+            offset += k_recordHeaderSize + size;
+        }
+
+        // the commands are complete when the time is taken
+        reinterpret_cast<gl::Proc<void()>::Type>(replayer.address(gl::FUNCTION_Finish))();
+        timings.milliseconds = milliseconds(Clock::now() - start);
+    } catch (InternalException& e) {
+        return setError(e.code(), e.message() + " (record at offset " + std::to_string(offset) + ")");
+    }
+
+    timings.callCount = m_callCount;
+    for (std::size_t i = 0; i < functions.size(); ++i) {
+        if (functions[i].callCount > 0) {
+            functions[i].name = gl::functionName(i);
+            timings.functions.push_back(functions[i]);
+        }
+    }
+    std::sort(timings.functions.begin(), timings.functions.end(), [] (const TraceFunctionTiming& a, const TraceFunctionTiming& b) {
+        return a.milliseconds > b.milliseconds;
+    });
+
+    return true;
+}
+
+
+const std::error_code& TracePlayer::lastErrorCode() const {
+    return m_lastErrorCode;
+}
+
+
+const std::string& TracePlayer::lastErrorMessage() const {
+    return m_lastErrorMessage;
+}
+
+
+bool TracePlayer::setError(const std::error_code& code, const std::string& message) {
+    m_lastErrorCode = code;
+    m_lastErrorMessage = message;
+
+    return !m_lastErrorCode;
+}
+
+
+}  // namespace glheadless
@@ -13,6 +13,8 @@
 #include <glheadless/ContextFormat.h>
 
 #include "../InternalException.h"
+#include "../Probes.h"
+#include "../RuntimeCounters.h"
 
 
 namespace glheadless {
@@ -124,6 +126,8 @@ std::unique_ptr<Context> Implementation::getCurrent() {
 
 
 std::unique_ptr<Context> Implementation::create(const ContextFormat& format) {
+    GLHEADLESS_PROBE0(create_entry);
+
     auto context = std::unique_ptr<Context>(new Context(this));
     m_context = context.get();
 
@@ -134,11 +138,14 @@ std::unique_ptr<Context> Implementation::create(const ContextFormat& format) {
         context->setError(e.code(), e.message());
     }
 
+    GLHEADLESS_PROBE2(create_return, nativeHandle(), context->lastErrorCode().value());
     return context;
 }
 
 
 std::unique_ptr<Context> Implementation::create(const Context* shared, const ContextFormat& format) {
+    GLHEADLESS_PROBE0(create_entry);
+
     auto sharedImplementation = static_cast<const Implementation*>(shared->implementation());
     auto context = std::unique_ptr<Context>(new Context(this));
     m_context = context.get();
@@ -150,11 +157,14 @@ std::unique_ptr<Context> Implementation::create(const Context* shared, const Con
         context->setError(e.code(), e.message());
     }
 
+    GLHEADLESS_PROBE2(create_return, nativeHandle(), context->lastErrorCode().value());
     return context;
 }
 
 
 bool Implementation::destroy() {
+    GLHEADLESS_PROBE1(destroy_entry, nativeHandle());
+
     if (m_owning) {
         if (m_contextHandle != nullptr) {
             CGLReleaseContext(m_contextHandle);
@@ -167,6 +177,7 @@ bool Implementation::destroy() {
     m_contextHandle = nullptr;
     m_pixelFormatHandle = nullptr;
 
+    GLHEADLESS_PROBE0(destroy_return);
     return true;
 }
 
@@ -181,6 +192,16 @@ bool Implementation::valid() {
 }
 
 
+bool Implementation::owning() {
+    return m_owning;
+}
+
+
+bool Implementation::isCurrent() {
+    return valid() && CGLGetCurrentContext() == m_contextHandle;
+}
+
+
 bool Implementation::makeCurrent() {
     if (m_contextHandle == nullptr) {
         return m_context->setError(Error::INVALID_CONTEXT, "Context not set up");
@@ -215,7 +236,9 @@ void Implementation::setPixelFormat(const ContextFormat& format) {
     const auto pixelFormatAttributes = createPixelFormatAttributeList(format);
 
     GLint numVirtualScreens;
+    const auto start = RuntimeCounters::Clock::now();
     const auto error = CGLChoosePixelFormat(pixelFormatAttributes.data(), &m_pixelFormatHandle, &numVirtualScreens);
+    RuntimeCounters::record(RuntimeCounters::CHOOSE_CONFIG, start);
     if (error != kCGLNoError) {
         throw InternalException(Error::INVALID_CONFIGURATION, "CGLChoosePixelFormat failed");
     }
@@ -223,7 +246,9 @@ void Implementation::setPixelFormat(const ContextFormat& format) {
 
 
 void Implementation::createContext(CGLContextObj shared) {
+    const auto start = RuntimeCounters::Clock::now();
     const auto error = CGLCreateContext(m_pixelFormatHandle, shared, &m_contextHandle);
+    RuntimeCounters::record(RuntimeCounters::CREATE_CONTEXT, start);
     if (error != kCGLNoError) {
         throw InternalException(Error::INVALID_CONFIGURATION, "CGLCreateContext failed");
     }
@@ -10,6 +10,8 @@
 #include <glheadless/ContextFormat.h>
 
 #include "../InternalException.h"
+#include "../Probes.h"
+#include "../RuntimeCounters.h"
 
 #include "Platform.h"
 
@@ -136,6 +138,8 @@ std::unique_ptr<Context> Implementation::getCurrent() {
 
 
 std::unique_ptr<Context> Implementation::create(const ContextFormat& format) {
+    GLHEADLESS_PROBE0(create_entry);
+
     auto context = std::unique_ptr<Context>(new Context(this));
     m_context = context.get();
 
@@ -145,11 +149,14 @@ std::unique_ptr<Context> Implementation::create(const ContextFormat& format) {
         context->setError(e.code(), e.message());
     }
 
+    GLHEADLESS_PROBE2(create_return, nativeHandle(), context->lastErrorCode().value());
     return context;
 }
 
 
 std::unique_ptr<Context> Implementation::create(const Context* shared, const ContextFormat& format) {
+    GLHEADLESS_PROBE0(create_entry);
+
     auto sharedImplementation = static_cast<const Implementation*>(shared->implementation());
     auto context = std::unique_ptr<Context>(new Context(this));
     m_context = context.get();
@@ -160,11 +167,14 @@ std::unique_ptr<Context> Implementation::create(const Context* shared, const Con
         context->setError(e.code(), e.message());
     }
 
+    GLHEADLESS_PROBE2(create_return, nativeHandle(), context->lastErrorCode().value());
     return context;
 }
 
 
 bool Implementation::destroy() {
+    GLHEADLESS_PROBE1(destroy_entry, nativeHandle());
+
     bindApi();
 
     if (m_owning && m_contextHandle != EGL_NO_CONTEXT) {
@@ -174,6 +184,7 @@ bool Implementation::destroy() {
 
     m_contextHandle = EGL_NO_CONTEXT;
 
+    GLHEADLESS_PROBE0(destroy_return);
     return true;
 }
 
@@ -188,6 +199,17 @@ bool Implementation::valid() {
 }
 
 
+bool Implementation::owning() {
+    return m_owning;
+}
+
+
+bool Implementation::isCurrent() {
+    bindApi();
+    return valid() && eglGetCurrentContext() == m_contextHandle;
+}
+
+
 bool Implementation::makeCurrent() {
     bindApi();
 
@@ -234,7 +256,9 @@ void Implementation::createContext(EGLContext shared, const ContextFormat& forma
     };
     EGLint numConfigs;
     EGLConfig config;
+    auto start = RuntimeCounters::Clock::now();
     auto success = eglChooseConfig(display, configAttributes, &config, 1, &numConfigs);
+    RuntimeCounters::record(RuntimeCounters::CHOOSE_CONFIG, start);
     if (!success) {
         throw InternalException(Error::INVALID_CONFIGURATION, "eglChooseConfig failed: " + getErrorString());
     }
@@ -247,7 +271,9 @@ void Implementation::createContext(EGLContext shared, const ContextFormat& forma
     // Create context
     //
     const auto contextAttributes = createContextAttributeList(format);
+    start = RuntimeCounters::Clock::now();
     m_contextHandle = eglCreateContext(display, config, shared, contextAttributes.data());
+    RuntimeCounters::record(RuntimeCounters::CREATE_CONTEXT, start);
     if (m_contextHandle == EGL_NO_CONTEXT) {
         throw InternalException(Error::INVALID_CONFIGURATION, "eglCreateContext failed: " + getErrorString());
     }
@@ -6,6 +6,7 @@
 #include <glheadless/error.h>
 
 #include "../InternalException.h"
+#include "../RuntimeCounters.h"
 
 
 namespace glheadless {
@@ -27,7 +28,7 @@ Platform* Platform::instance() {
     auto tmp = g_platformInstance.load(std::memory_order_relaxed);
     std::atomic_thread_fence(std::memory_order_acquire);
     if (tmp == nullptr) {
-        std::lock_guard<std::mutex> __attribute__((unused)) lock(g_platformInstanceMutex);
+        CountedLockGuard lock(g_platformInstanceMutex, RuntimeCounters::PLATFORM_INSTANCE);
         tmp = g_platformInstance.load(std::memory_order_relaxed);
         if (tmp == nullptr) {
             tmp = new Platform();
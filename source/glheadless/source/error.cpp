@@ -14,7 +14,10 @@ namespace {
 
 const auto k_errorMessages = std::map<Error, std::string>{
     { Error::INVALID_CONFIGURATION, "invalid configuration" },
-    { Error::INVALID_CONTEXT, "invalid context" }
+    { Error::INVALID_CONTEXT, "invalid context" },
+    { Error::UNSUPPORTED_FEATURE, "unsupported feature" },
+    { Error::INVALID_ARGUMENT, "invalid argument" },
+    { Error::OPENGL_ERROR, "OpenGL error" }
 };
 
 
@@ -1,5 +1,6 @@
 #include "Implementation.h"
 
+#include <atomic>
 #include <cassert>
 #include <vector>
 #include <map>
@@ -8,6 +9,8 @@
 #include <glheadless/ContextFormat.h>
 
 #include "../InternalException.h"
+#include "../Probes.h"
+#include "../RuntimeCounters.h"
 
 #include "Platform.h"
 
@@ -92,6 +95,8 @@ public:
 
 private:
     static XErrorHandler* s_activeHandler;
+    static std::atomic<int> s_installedCount; // of all threads
+    static thread_local int t_installedCount;
     static int errorHandler(Display* display, XErrorEvent* errorEvent);
 
 
@@ -103,11 +108,18 @@ private:
 
 
 XErrorHandler* XErrorHandler::s_activeHandler = nullptr;
+std::atomic<int> XErrorHandler::s_installedCount(0);
+thread_local int XErrorHandler::t_installedCount = 0;
 
 
 XErrorHandler::XErrorHandler()
 : m_oldHandler(nullptr)
 , m_errorCode(Success) {
+    // the handler is process-wide, so installing it while another thread has one installed is counted as contention
+    const auto others = s_installedCount.fetch_add(1, std::memory_order_relaxed) - t_installedCount;
+    ++t_installedCount;
+    RuntimeCounters::record(RuntimeCounters::ERROR_HANDLER, others > 0, RuntimeCounters::Clock::time_point());
+
     s_activeHandler = this;
     m_oldHandler = XSetErrorHandler(XErrorHandler::errorHandler);
 }
@@ -116,6 +128,9 @@ XErrorHandler::XErrorHandler()
 XErrorHandler::~XErrorHandler() {
     s_activeHandler = nullptr;
     XSetErrorHandler(m_oldHandler);
+
+    --t_installedCount;
+    s_installedCount.fetch_sub(1, std::memory_order_relaxed);
 }
 
 
@@ -177,6 +192,8 @@ std::unique_ptr<Context> Implementation::getCurrent() {
 
 
 std::unique_ptr<Context> Implementation::create(const ContextFormat& format) {
+    GLHEADLESS_PROBE0(create_entry);
+
     auto context = std::unique_ptr<Context>(new Context(this));
     m_context = context.get();
 
@@ -186,11 +203,14 @@ std::unique_ptr<Context> Implementation::create(const ContextFormat& format) {
         m_context->setError(e.code(), e.message());
     }
 
+    GLHEADLESS_PROBE2(create_return, nativeHandle(), context->lastErrorCode().value());
     return context;
 }
 
 
 std::unique_ptr<Context> Implementation::create(const Context* shared, const ContextFormat& format) {
+    GLHEADLESS_PROBE0(create_entry);
+
     auto sharedImplementation = static_cast<const Implementation*>(shared->implementation());
     auto context = std::unique_ptr<Context>(new Context(this));
     m_context = context.get();
@@ -201,11 +221,14 @@ std::unique_ptr<Context> Implementation::create(const Context* shared, const Con
         m_context->setError(e.code(), e.message());
     }
 
+    GLHEADLESS_PROBE2(create_return, nativeHandle(), context->lastErrorCode().value());
     return context;
 }
 
 
 bool Implementation::destroy() {
+    GLHEADLESS_PROBE1(destroy_entry, nativeHandle());
+
     if (m_owning) {
         XErrorHandler xErrorHandler;
 
@@ -228,6 +251,7 @@ bool Implementation::destroy() {
     m_pBuffer = 0;
     m_drawable = 0;
 
+    GLHEADLESS_PROBE0(destroy_return);
     return true;
 }
 
@@ -243,6 +267,16 @@ bool Implementation::valid() {
 }
 
 
+bool Implementation::owning() {
+    return m_owning;
+}
+
+
+bool Implementation::isCurrent() {
+    return valid() && glXGetCurrentContext() == m_contextHandle;
+}
+
+
 bool Implementation::makeCurrent() {
     XErrorHandler xErrorHandler;
 
@@ -286,7 +320,9 @@ void Implementation::createContext(GLXContext shared, const ContextFormat& forma
     // Select framebuffer configuration
     //
     int fbCount;
+    auto start = RuntimeCounters::Clock::now();
     GLXFBConfig* fbConfig = glXChooseFBConfig(display, DefaultScreen(display), nullptr, &fbCount);
+    RuntimeCounters::record(RuntimeCounters::CHOOSE_CONFIG, start);
     if (fbConfig == nullptr) {
         throw InternalException(Error::INVALID_CONFIGURATION, "glXChooseFBConfig returned nullptr");
     }
@@ -297,8 +333,10 @@ void Implementation::createContext(GLXContext shared, const ContextFormat& forma
     // Create context
     //
     const auto contextAttributes = createContextAttributeList(format);
+    start = RuntimeCounters::Clock::now();
     m_contextHandle = Platform::instance()->glXCreateContextAttribsARB(display, fbConfig[0], shared, True, contextAttributes.data());
     XSync(display, false);
+    RuntimeCounters::record(RuntimeCounters::CREATE_CONTEXT, start);
     if (m_contextHandle == nullptr || xErrorHandler.errorCode() != Success) {
         throw InternalException(Error::INVALID_CONFIGURATION, "glXCreateContextAttribsARB returned nullptr (" + xErrorHandler.errorString() + ")");
     }
@@ -308,13 +346,19 @@ void Implementation::createContext(GLXContext shared, const ContextFormat& forma
         GLX_PBUFFER_HEIGHT, 1,
         None
     };
+    start = RuntimeCounters::Clock::now();
     m_pBuffer = glXCreatePbuffer(display, fbConfig[0], pBufferAttributes);
     XSync(display, false);
+    RuntimeCounters::record(RuntimeCounters::CREATE_PBUFFER, start);
 
     // check if pbuffer is supported
+    start = RuntimeCounters::Clock::now();
     const auto success = glXMakeContextCurrent(display, m_pBuffer, m_pBuffer, m_contextHandle);
     if (success) {
         glXMakeContextCurrent(display, None, None, nullptr);
+    }
+    RuntimeCounters::record(RuntimeCounters::TEST_MAKE_CURRENT, start);
+    if (success) {
         m_drawable = m_pBuffer;
     } else {
         m_drawable = DefaultRootWindow(display);
@@ -11,6 +11,8 @@
 #include <glheadless/ContextFormat.h>
 
 #include "../InternalException.h"
+#include "../Probes.h"
+#include "../RuntimeCounters.h"
 
 #include "Window.h"
 #include "Platform.h"
@@ -109,37 +111,63 @@ std::unique_ptr<Context> Implementation::getCurrent() {
 
 
 std::unique_ptr<Context> Implementation::create(const ContextFormat& format) {
+    GLHEADLESS_PROBE0(create_entry);
+
     auto context = std::unique_ptr<Context>(new Context(this));
     m_context = context.get();
 
     try {
+        // the hidden window plays the role of the pbuffer of other platforms
+        auto start = RuntimeCounters::Clock::now();
         m_window = std::make_unique<Window>();
+        RuntimeCounters::record(RuntimeCounters::CREATE_PBUFFER, start);
+
+        start = RuntimeCounters::Clock::now();
         setPixelFormat();
+        RuntimeCounters::record(RuntimeCounters::CHOOSE_CONFIG, start);
+
+        start = RuntimeCounters::Clock::now();
         createContext(nullptr, format);
+        RuntimeCounters::record(RuntimeCounters::CREATE_CONTEXT, start);
     } catch (InternalException& e) {
         context->setError(e.code(), e.message());
     }
+    GLHEADLESS_PROBE2(create_return, nativeHandle(), context->lastErrorCode().value());
     return context;
 }
 
 
 std::unique_ptr<Context> Implementation::create(const Context* shared, const ContextFormat& format) {
+    GLHEADLESS_PROBE0(create_entry);
+
     auto sharedImplementation = static_cast<const Implementation*>(shared->implementation());
     auto context = std::unique_ptr<Context>(new Context(this));
     m_context = context.get();
 
     try {
+        // the hidden window plays the role of the pbuffer of other platforms
+        auto start = RuntimeCounters::Clock::now();
         m_window = std::make_unique<Window>();
+        RuntimeCounters::record(RuntimeCounters::CREATE_PBUFFER, start);
+
+        start = RuntimeCounters::Clock::now();
         setPixelFormat();
+        RuntimeCounters::record(RuntimeCounters::CHOOSE_CONFIG, start);
+
+        start = RuntimeCounters::Clock::now();
         createContext(sharedImplementation->m_contextHandle, format);
+        RuntimeCounters::record(RuntimeCounters::CREATE_CONTEXT, start);
     } catch (InternalException& e) {
         context->setError(e.code(), e.message());
     }
+    GLHEADLESS_PROBE2(create_return, nativeHandle(), context->lastErrorCode().value());
     return context;
 }
 
 
 bool Implementation::destroy() {
+    GLHEADLESS_PROBE1(destroy_entry, nativeHandle());
+
     if (m_owning && m_contextHandle != nullptr) {
         const auto currentHandle = wglGetCurrentContext();
         if (currentHandle == m_contextHandle) {
@@ -152,6 +180,7 @@ bool Implementation::destroy() {
     m_contextHandle = nullptr;
     m_window = nullptr;
 
+    GLHEADLESS_PROBE0(destroy_return);
     return true;
 }
 
@@ -167,6 +196,16 @@ bool Implementation::valid() {
 }
 
 
+bool Implementation::owning() {
+    return m_owning;
+}
+
+
+bool Implementation::isCurrent() {
+    return valid() && wglGetCurrentContext() == m_contextHandle;
+}
+
+
 bool Implementation::makeCurrent() {
     if (m_contextHandle == nullptr) {
         return m_context->setError(Error::INVALID_CONTEXT, "Context not set up");
@@ -189,7 +228,14 @@ bool Implementation::doneCurrent() {
 
 
 void (*Implementation::getProcAddress(const char * name))() {
-    return reinterpret_cast<void(*)()>(wglGetProcAddress(name));
+    const auto address = wglGetProcAddress(name);
+    if (address != nullptr) {
+        return reinterpret_cast<void(*)()>(address);
+    }
+
+    // wglGetProcAddress does not resolve OpenGL 1.1 functions, those are exported by opengl32.dll directly
+    static const auto module = GetModuleHandleA("opengl32.dll");
+    return reinterpret_cast<void(*)()>(GetProcAddress(module, name));
 }
 
 
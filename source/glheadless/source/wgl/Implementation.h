@@ -28,6 +28,8 @@ public:
     virtual bool destroy() override;
     virtual long long nativeHandle() override;
     virtual bool valid() override;
+    virtual bool owning() override;
+    virtual bool isCurrent() override;
     virtual bool makeCurrent() override;
     virtual bool doneCurrent() override;
     virtual void(*getProcAddress(const char* name))() override;
@@ -8,6 +8,7 @@
 #include <glheadless/error.h>
 
 #include "../InternalException.h"
+#include "../RuntimeCounters.h"
 
 #include "Window.h"
 
@@ -53,7 +54,7 @@ Platform* Platform::instance() {
     auto tmp = g_platformInstance.load(std::memory_order_relaxed);
     std::atomic_thread_fence(std::memory_order_acquire);
     if (tmp == nullptr) {
-        std::lock_guard<std::mutex> lock(g_instanceMutex);
+        CountedLockGuard lock(g_instanceMutex, RuntimeCounters::PLATFORM_INSTANCE);
         tmp = g_platformInstance.load(std::memory_order_relaxed);
         if (tmp == nullptr) {
             tmp = new Platform();
@@ -0,0 +1,158 @@
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/BufferPool.h>
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class BufferPool_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        m_context = ContextFactory::create();
+        ASSERT_TRUE(m_context->valid());
+        ASSERT_TRUE(m_context->makeCurrent());
+    }
+
+    void TearDown() override {
+        m_context->doneCurrent();
+    }
+
+    std::vector<unsigned char> contents(const BufferRange& range) {
+        const auto& gl = m_context->functions();
+        std::vector<unsigned char> data(range.size);
+        gl.BindBuffer(gl::ARRAY_BUFFER, range.buffer);
+        gl.GetBufferSubData(gl::ARRAY_BUFFER, static_cast<gl::GLintptr>(range.offset), static_cast<gl::GLsizeiptr>(range.size), data.data());
+        gl.BindBuffer(gl::ARRAY_BUFFER, 0);
+        return data;
+    }
+
+    static std::vector<unsigned char> pattern(std::size_t size, int seed) {
+        std::vector<unsigned char> data(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<unsigned char>(i * 7 + seed);
+        }
+        return data;
+    }
+
+    std::unique_ptr<Context> m_context;
+};
+
+
+TEST_F(BufferPool_Test, Allocate) {
+    BufferPool pool(m_context.get(), 4096);
+
+    std::vector<BufferPool::Handle> handles;
+    for (auto i = 0; i < 20; ++i) {
+        BufferPool::Handle handle = 0;
+        ASSERT_TRUE(pool.upload(pattern(100, i).data(), 100, 64, handle));
+        handles.push_back(handle);
+    }
+
+    EXPECT_EQ(1u, pool.blockCount());
+    EXPECT_EQ(4096u, pool.reservedSize());
+    EXPECT_EQ(2000u, pool.allocatedSize());
+
+    for (std::size_t i = 0; i < handles.size(); ++i) {
+        const auto range = pool.range(handles[i]);
+        EXPECT_EQ(0u, range.offset % 64);
+        EXPECT_EQ(pattern(100, static_cast<int>(i)), contents(range));
+    }
+
+    // a freed range is reused by the next allocation of the same size
+    const auto freed = pool.range(handles[5]);
+    pool.free(handles[5]);
+    BufferPool::Handle handle = 0;
+    ASSERT_TRUE(pool.allocate(100, 64, handle));
+    EXPECT_EQ(freed.buffer, pool.range(handle).buffer);
+    EXPECT_EQ(freed.offset, pool.range(handle).offset);
+}
+
+
+TEST_F(BufferPool_Test, Dedicated) {
+    BufferPool pool(m_context.get(), 1024);
+
+    BufferPool::Handle small = 0;
+    BufferPool::Handle large = 0;
+    ASSERT_TRUE(pool.allocate(16, 0, small));
+    ASSERT_TRUE(pool.upload(pattern(5000, 1).data(), 5000, 0, large));
+    EXPECT_EQ(2u, pool.blockCount());
+    EXPECT_EQ(pattern(5000, 1), contents(pool.range(large)));
+
+    pool.free(large);
+    EXPECT_EQ(1u, pool.blockCount());
+    EXPECT_EQ(0u, pool.range(large).buffer);
+}
+
+
+TEST_F(BufferPool_Test, Defragment) {
+    BufferPool pool(m_context.get(), 4096);
+
+    std::vector<BufferPool::Handle> handles;
+    for (auto i = 0; i < 40; ++i) {
+        BufferPool::Handle handle = 0;
+        ASSERT_TRUE(pool.upload(pattern(1000, i).data(), 1000, 0, handle));
+        handles.push_back(handle);
+    }
+    EXPECT_EQ(10u, pool.blockCount());
+
+    for (std::size_t i = 0; i < handles.size(); i += 2) {
+        pool.free(handles[i]);
+    }
+    EXPECT_EQ(10u, pool.blockCount());
+
+    ASSERT_TRUE(pool.defragment());
+    EXPECT_EQ(1u, pool.generation());
+    EXPECT_EQ(5u, pool.blockCount());
+    EXPECT_EQ(20000u, pool.allocatedSize());
+
+    for (std::size_t i = 1; i < handles.size(); i += 2) {
+        EXPECT_EQ(pattern(1000, static_cast<int>(i)), contents(pool.range(handles[i])));
+    }
+
+    // the free lists of the new blocks are usable
+    BufferPool::Handle handle = 0;
+    ASSERT_TRUE(pool.allocate(50, 0, handle));
+    EXPECT_EQ(5u, pool.blockCount());
+}
+
+
+TEST_F(BufferPool_Test, SharedContext) {
+    BufferPool pool(m_context.get(), 4096);
+    BufferPool::Handle handle = 0;
+
+    std::thread worker([this, &pool, &handle] {
+        auto shared = ContextFactory::create(m_context.get());
+        ASSERT_TRUE(shared->valid());
+        ASSERT_TRUE(shared->makeCurrent());
+        EXPECT_TRUE(pool.upload(pattern(256, 3).data(), 256, 0, handle));
+        pool.flush();
+        shared->doneCurrent();
+    });
+    worker.join();
+
+    pool.synchronize();
+    EXPECT_EQ(pattern(256, 3), contents(pool.range(handle)));
+}
+
+
+TEST_F(BufferPool_Test, InvalidArguments) {
+    BufferPool pool(m_context.get(), 4096);
+    BufferPool::Handle handle = 0;
+
+    EXPECT_FALSE(pool.allocate(0, 0, handle));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), pool.lastErrorCode());
+    EXPECT_FALSE(pool.allocate(16, 12, handle));
+
+    ASSERT_TRUE(pool.allocate(16, 0, handle));
+    const unsigned char data[32] = {};
+    EXPECT_FALSE(pool.write(handle, 8, data, 16));
+    EXPECT_FALSE(pool.write(handle + 1, 0, data, 16));
+}
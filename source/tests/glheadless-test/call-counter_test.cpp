@@ -0,0 +1,132 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class CallCounter_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        m_context = ContextFactory::create();
+        ASSERT_TRUE(m_context->valid());
+        ASSERT_TRUE(m_context->makeCurrent());
+    }
+
+    void TearDown() override {
+        m_context->setCallCountingEnabled(false);
+        m_context->setStateCacheEnabled(false);
+        m_context->doneCurrent();
+    }
+
+    CallStatistics statistics(const std::string& name) const {
+        for (const auto& function : m_context->callStatistics()) {
+            if (function.name == name) {
+                return function;
+            }
+        }
+        return CallStatistics();
+    }
+
+    std::unique_ptr<Context> m_context;
+};
+
+
+TEST_F(CallCounter_Test, CountCalls) {
+    EXPECT_FALSE(m_context->callCountingEnabled());
+    EXPECT_TRUE(m_context->callStatistics().empty());
+
+    m_context->setCallCountingEnabled(true, 4);
+    EXPECT_TRUE(m_context->callCountingEnabled());
+    const auto& gl = m_context->functions();
+    for (auto i = 0; i < 10; ++i) {
+        gl.Enable(gl::BLEND);
+    }
+    gl.Finish();
+
+    const auto enable = statistics("glEnable");
+    EXPECT_EQ(10u, enable.callCount);
+    EXPECT_EQ(2u, enable.sampledCount);
+    EXPECT_GE(enable.estimatedMilliseconds, enable.sampledMilliseconds);
+
+    // the twelfth call of the thread is the third one timed
+    const auto finish = statistics("glFinish");
+    EXPECT_EQ(1u, finish.callCount);
+    EXPECT_EQ(0u, finish.sampledCount);
+    EXPECT_EQ(0.0, finish.estimatedMilliseconds);
+    EXPECT_EQ(2u, m_context->callStatistics().size());
+
+    // entry points resolved by the application are counted as well
+    const auto disable = reinterpret_cast<gl::Proc<void(gl::GLenum)>::Type>(m_context->getProcAddress("glDisable"));
+    disable(gl::BLEND);
+    EXPECT_EQ(1u, statistics("glDisable").callCount);
+    EXPECT_EQ(1u, statistics("glDisable").sampledCount);
+
+    m_context->resetCallStatistics();
+    EXPECT_TRUE(m_context->callStatistics().empty());
+    gl.Enable(gl::BLEND);
+    EXPECT_EQ(1u, statistics("glEnable").callCount);
+
+    // after disabling, the kept entry point passes calls on without counting them
+    m_context->setCallCountingEnabled(false);
+    EXPECT_TRUE(m_context->callStatistics().empty());
+    disable(gl::BLEND);
+    EXPECT_EQ(0, gl.IsEnabled(gl::BLEND));
+}
+
+
+TEST_F(CallCounter_Test, SampleInterval) {
+    m_context->setCallCountingEnabled(true, 1);
+    const auto& gl = m_context->functions();
+    gl.Flush();
+    gl.Flush();
+    EXPECT_EQ(2u, statistics("glFlush").sampledCount);
+
+    // enabling again keeps the counts
+    m_context->setCallCountingEnabled(true, 0);
+    gl.Flush();
+    gl.Flush();
+    EXPECT_EQ(4u, statistics("glFlush").callCount);
+    EXPECT_EQ(2u, statistics("glFlush").sampledCount);
+}
+
+
+TEST_F(CallCounter_Test, CountBehindStateCache) {
+    m_context->setStateCacheEnabled(true);
+    m_context->setCallCountingEnabled(true);
+    const auto& gl = m_context->functions();
+    gl.Enable(gl::DEPTH_TEST);
+    gl.Enable(gl::DEPTH_TEST);
+    EXPECT_EQ(1u, statistics("glEnable").callCount);
+}
+
+
+TEST_F(CallCounter_Test, SumThreads) {
+    m_context->setCallCountingEnabled(true);
+    const auto& gl = m_context->functions();
+    gl.Flush();
+    ASSERT_TRUE(m_context->doneCurrent());
+
+    // the other thread counts into counters of its own
+    std::thread worker([this, &gl] {
+        ASSERT_TRUE(m_context->makeCurrent());
+        gl.Flush();
+        gl.Flush();
+        EXPECT_EQ(3u, statistics("glFlush").callCount);
+        m_context->doneCurrent();
+    });
+    worker.join();
+
+    ASSERT_TRUE(m_context->makeCurrent());
+    gl.Flush();
+    EXPECT_EQ(4u, statistics("glFlush").callCount);
+}
+
@@ -0,0 +1,153 @@
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/CommandList.h>
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class CommandList_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        m_context = ContextFactory::create();
+        ASSERT_TRUE(m_context->valid());
+        ASSERT_TRUE(m_context->makeCurrent());
+
+        const auto& gl = m_context->functions();
+        gl.GenTextures(1, &m_texture);
+        gl.BindTexture(gl::TEXTURE_2D, m_texture);
+        gl.TexImage2D(gl::TEXTURE_2D, 0, gl::RGBA8, 4, 4, 0, gl::RGBA, gl::UNSIGNED_BYTE, nullptr);
+        gl.BindTexture(gl::TEXTURE_2D, 0);
+
+        gl.GenFramebuffers(1, &m_framebuffer);
+        gl.BindFramebuffer(gl::FRAMEBUFFER, m_framebuffer);
+        gl.FramebufferTexture2D(gl::FRAMEBUFFER, gl::COLOR_ATTACHMENT0, gl::TEXTURE_2D, m_texture, 0);
+        gl.BindFramebuffer(gl::FRAMEBUFFER, 0);
+
+        gl.GenBuffers(1, &m_buffer);
+        gl.BindBuffer(gl::ARRAY_BUFFER, m_buffer);
+        gl.BufferData(gl::ARRAY_BUFFER, 1 << 20, nullptr, gl::STREAM_DRAW);
+        gl.BindBuffer(gl::ARRAY_BUFFER, 0);
+    }
+
+    void TearDown() override {
+        const auto& gl = m_context->functions();
+        gl.DeleteBuffers(1, &m_buffer);
+        gl.DeleteFramebuffers(1, &m_framebuffer);
+        gl.DeleteTextures(1, &m_texture);
+        m_context->doneCurrent();
+    }
+
+    std::vector<unsigned char> pixels() {
+        const auto& gl = m_context->functions();
+        std::vector<unsigned char> data(4 * 4 * 4);
+        gl.BindFramebuffer(gl::FRAMEBUFFER, m_framebuffer);
+        gl.ReadPixels(0, 0, 4, 4, gl::RGBA, gl::UNSIGNED_BYTE, data.data());
+        gl.BindFramebuffer(gl::FRAMEBUFFER, 0);
+        return data;
+    }
+
+    std::vector<unsigned char> contents(std::size_t size) {
+        const auto& gl = m_context->functions();
+        std::vector<unsigned char> data(size);
+        gl.BindBuffer(gl::ARRAY_BUFFER, m_buffer);
+        gl.GetBufferSubData(gl::ARRAY_BUFFER, 0, static_cast<gl::GLsizeiptr>(size), data.data());
+        gl.BindBuffer(gl::ARRAY_BUFFER, 0);
+        return data;
+    }
+
+    std::unique_ptr<Context> m_context;
+    gl::GLuint m_texture = 0;
+    gl::GLuint m_framebuffer = 0;
+    gl::GLuint m_buffer = 0;
+};
+
+
+TEST_F(CommandList_Test, RecordOnOtherThreads) {
+    // the lists are recorded in parallel without a current context and replayed in order
+    CommandList clearList;
+    CommandList uploadList;
+    std::vector<unsigned char> texel = { 10, 20, 30, 40 };
+    std::vector<unsigned char> data(1000);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(i * 3);
+    }
+
+    std::thread clearThread([&] {
+        clearList.bindFramebuffer(gl::FRAMEBUFFER, m_framebuffer);
+        clearList.viewport(0, 0, 4, 4);
+        clearList.clearColor(1.0f, 0.0f, 0.0f, 1.0f);
+        clearList.clear(gl::COLOR_BUFFER_BIT);
+        clearList.bindFramebuffer(gl::FRAMEBUFFER, 0);
+    });
+    std::thread uploadThread([&] {
+        uploadList.bindTexture(gl::TEXTURE_2D, m_texture);
+        uploadList.texSubImage2D(gl::TEXTURE_2D, 0, 1, 2, 1, 1, gl::RGBA, gl::UNSIGNED_BYTE, texel.size(), texel.data());
+        uploadList.bindTexture(gl::TEXTURE_2D, 0);
+        uploadList.bindBuffer(gl::ARRAY_BUFFER, m_buffer);
+        uploadList.bufferSubData(gl::ARRAY_BUFFER, 0, data.size(), data.data());
+        uploadList.bindBuffer(gl::ARRAY_BUFFER, 0);
+    });
+    clearThread.join();
+    uploadThread.join();
+
+    // the recorded copies are independent of the client memory
+    texel.assign(4, 0);
+
+    EXPECT_EQ(5u, clearList.commandCount());
+    EXPECT_EQ(6u, uploadList.commandCount());
+    ASSERT_TRUE(clearList.execute(m_context.get())) << m_context->lastErrorMessage();
+    ASSERT_TRUE(uploadList.execute(m_context.get())) << m_context->lastErrorMessage();
+
+    const auto result = pixels();
+    EXPECT_THAT(std::vector<unsigned char>(result.begin(), result.begin() + 4), testing::ElementsAre(255, 0, 0, 255));
+    const auto offset = (2 * 4 + 1) * 4;
+    EXPECT_THAT(std::vector<unsigned char>(result.begin() + offset, result.begin() + offset + 4), testing::ElementsAre(10, 20, 30, 40));
+    EXPECT_EQ(data, contents(data.size()));
+    EXPECT_EQ(0u, m_context->functions().GetError());
+}
+
+
+TEST_F(CommandList_Test, ArenaReuse) {
+    CommandList list(1024);
+    std::vector<unsigned char> large(5000, 7);
+
+    for (auto i = 0; i < 100; ++i) {
+        list.clearColor(0.0f, 0.0f, 1.0f, 1.0f);
+    }
+    list.bindBuffer(gl::ARRAY_BUFFER, m_buffer);
+    list.bufferSubData(gl::ARRAY_BUFFER, 0, large.size(), large.data());
+    list.bindBuffer(gl::ARRAY_BUFFER, 0);
+
+    EXPECT_EQ(103u, list.commandCount());
+    EXPECT_LE(list.size(), list.capacity());
+    ASSERT_TRUE(list.execute(m_context.get()));
+    EXPECT_EQ(large, contents(large.size()));
+
+    // recording the same commands again reuses the blocks, and a list can be executed repeatedly
+    const auto capacity = list.capacity();
+    list.reset();
+    EXPECT_EQ(0u, list.commandCount());
+    EXPECT_EQ(0u, list.size());
+
+    large.assign(large.size(), 9);
+    for (auto i = 0; i < 100; ++i) {
+        list.clearColor(0.0f, 0.0f, 1.0f, 1.0f);
+    }
+    list.bindBuffer(gl::ARRAY_BUFFER, m_buffer);
+    list.bufferSubData(gl::ARRAY_BUFFER, 0, large.size(), large.data());
+    list.bindBuffer(gl::ARRAY_BUFFER, 0);
+    EXPECT_EQ(capacity, list.capacity());
+
+    ASSERT_TRUE(list.execute(m_context.get()));
+    ASSERT_TRUE(list.execute(m_context.get()));
+    EXPECT_EQ(large, contents(large.size()));
+    EXPECT_EQ(0u, m_context->functions().GetError());
+}
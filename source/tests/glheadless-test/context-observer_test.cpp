@@ -0,0 +1,112 @@
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/ContextObserver.h>
+#include <glheadless/error.h>
+
+
+using namespace glheadless;
+
+
+class ContextObserver_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        m_id = addContextObserver([this](const ContextEvent& event) {
+            m_types.push_back(event.type);
+            m_contexts.push_back(event.context);
+            if (event.type == ContextEventType::ERROR_OCCURRED) {
+                m_errorCode = event.errorCode;
+                m_errorMessage = *event.errorMessage;
+            }
+        });
+        ASSERT_NE(0u, m_id);
+    }
+
+    void TearDown() override {
+        removeContextObserver(m_id);
+    }
+
+    std::size_t m_id;
+    std::vector<ContextEventType> m_types;
+    std::vector<const Context*> m_contexts;
+    std::error_code m_errorCode;
+    std::string m_errorMessage;
+};
+
+
+TEST_F(ContextObserver_Test, Lifecycle) {
+    const Context* address = nullptr;
+    {
+        auto context = ContextFactory::create();
+        ASSERT_TRUE(context->valid());
+        address = context.get();
+        ASSERT_TRUE(context->makeCurrent());
+        EXPECT_FALSE(context->stopGpuProfiling());
+        ASSERT_TRUE(context->doneCurrent());
+    }
+
+    const std::vector<ContextEventType> expected = {
+        ContextEventType::CREATED,
+        ContextEventType::MADE_CURRENT,
+        ContextEventType::ERROR_OCCURRED,
+        ContextEventType::DONE_CURRENT,
+        ContextEventType::DESTROYING
+    };
+    EXPECT_EQ(expected, m_types);
+    for (const auto context : m_contexts) {
+        EXPECT_EQ(address, context);
+    }
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), m_errorCode);
+    EXPECT_FALSE(m_errorMessage.empty());
+}
+
+
+TEST_F(ContextObserver_Test, CreationError) {
+    ContextFormat format;
+    format.versionMajor = 123;
+    format.versionMinor = 42;
+    {
+        auto context = ContextFactory::create(format);
+        ASSERT_FALSE(context->valid());
+    }
+
+    // a context that failed to create reports its error, but is neither created nor destroyed
+    ASSERT_FALSE(m_types.empty());
+    for (const auto type : m_types) {
+        EXPECT_EQ(ContextEventType::ERROR_OCCURRED, type);
+    }
+    EXPECT_TRUE(m_errorCode);
+}
+
+
+TEST_F(ContextObserver_Test, Registration) {
+    EXPECT_EQ(0u, addContextObserver(ContextObserver()));
+    EXPECT_FALSE(removeContextObserver(0));
+
+    // observers are called in order and may remove themselves
+    std::vector<int> calls;
+    std::size_t second = 0;
+    const auto first = addContextObserver([&calls](const ContextEvent&) { calls.push_back(1); });
+    second = addContextObserver([&calls, &second](const ContextEvent&) {
+        calls.push_back(2);
+        removeContextObserver(second);
+    });
+    EXPECT_NE(first, second);
+
+    {
+        auto context = ContextFactory::create();
+        ASSERT_TRUE(context->valid());
+        ASSERT_TRUE(context->makeCurrent());
+        ASSERT_TRUE(context->doneCurrent());
+    }
+
+    const std::vector<int> expected = { 1, 2, 1, 1, 1 };
+    EXPECT_EQ(expected, calls);
+    EXPECT_FALSE(removeContextObserver(second));
+    EXPECT_TRUE(removeContextObserver(first));
+    EXPECT_EQ(4u, m_types.size());
+}
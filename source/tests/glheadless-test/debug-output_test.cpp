@@ -0,0 +1,172 @@
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/error.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class DebugOutput_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        ContextFormat format;
+        format.debug = true;
+        m_context = ContextFactory::create(format);
+        ASSERT_TRUE(m_context->valid());
+        ASSERT_TRUE(m_context->makeCurrent());
+    }
+
+    void TearDown() override {
+        m_context->doneCurrent();
+    }
+
+    DebugSink sink() {
+        return [this] (const DebugMessage& message) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_messages.push_back(message);
+            m_threads.push_back(std::this_thread::get_id());
+        };
+    }
+
+    void insert(gl::GLenum severity, const char* text) {
+        m_context->functions().DebugMessageInsert(gl::DEBUG_SOURCE_APPLICATION, gl::DEBUG_TYPE_MARKER, 7, severity, -1, text);
+    }
+
+    std::unique_ptr<Context>     m_context;
+    std::mutex                   m_mutex;
+    std::vector<DebugMessage>    m_messages;
+    std::vector<std::thread::id> m_threads;
+};
+
+
+TEST_F(DebugOutput_Test, Collect) {
+    ASSERT_TRUE(m_context->startDebugOutput(sink())) << m_context->lastErrorMessage();
+    EXPECT_TRUE(m_context->debugOutputActive());
+    insert(gl::DEBUG_SEVERITY_HIGH, "first");
+    m_context->functions().Enable(0xFFFF);
+    EXPECT_EQ(0x0500u, m_context->functions().GetError());
+    ASSERT_TRUE(m_context->stopDebugOutput());
+    EXPECT_FALSE(m_context->debugOutputActive());
+
+    ASSERT_EQ(2u, m_messages.size());
+    EXPECT_EQ(DebugSource::APPLICATION, m_messages[0].source);
+    EXPECT_EQ(DebugType::MARKER, m_messages[0].type);
+    EXPECT_EQ(DebugSeverity::HIGH, m_messages[0].severity);
+    EXPECT_EQ(7u, m_messages[0].id);
+    EXPECT_EQ(5u, m_messages[0].length);
+    EXPECT_EQ(std::string("first"), m_messages[0].text);
+    EXPECT_EQ(DebugSource::API, m_messages[1].source);
+    EXPECT_EQ(DebugType::ERROR, m_messages[1].type);
+    EXPECT_LE(m_messages[0].time, m_messages[1].time);
+
+    // the sink runs on the draining thread
+    EXPECT_NE(std::this_thread::get_id(), m_threads[0]);
+
+    // nothing is collected once stopped
+    insert(gl::DEBUG_SEVERITY_HIGH, "second");
+    EXPECT_EQ(2u, m_messages.size());
+}
+
+
+TEST_F(DebugOutput_Test, Filter) {
+    DebugFilter filter;
+    filter.sources.push_back(DebugSource::APPLICATION);
+    filter.minimumSeverity = DebugSeverity::MEDIUM;
+    ASSERT_TRUE(m_context->startDebugOutput(sink(), filter));
+    insert(gl::DEBUG_SEVERITY_LOW, "low");
+    insert(gl::DEBUG_SEVERITY_MEDIUM, "medium");
+    insert(gl::DEBUG_SEVERITY_NOTIFICATION, "notification");
+    m_context->functions().Enable(0xFFFF);
+    m_context->functions().GetError();
+    ASSERT_TRUE(m_context->stopDebugOutput());
+
+    ASSERT_EQ(1u, m_messages.size());
+    EXPECT_EQ(std::string("medium"), m_messages[0].text);
+}
+
+
+TEST_F(DebugOutput_Test, DropWhenFull) {
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    auto collected = 0u;
+    const auto blockingSink = [released, &collected] (const DebugMessage&) {
+        released.wait();
+        ++collected;
+    };
+
+    // the draining thread takes at most one message out of the ring before blocking in the sink
+    ASSERT_TRUE(m_context->startDebugOutput(blockingSink, DebugFilter(), 2));
+    const auto count = 10u;
+    for (auto i = 0u; i < count; ++i) {
+        insert(gl::DEBUG_SEVERITY_HIGH, "message");
+    }
+    const auto statistics = m_context->debugOutputStatistics();
+    EXPECT_GE(statistics.droppedCount, count - 3);
+    EXPECT_EQ(0u, statistics.collectedCount);
+
+    release.set_value();
+    ASSERT_TRUE(m_context->stopDebugOutput());
+    EXPECT_EQ(count, collected + statistics.droppedCount);
+}
+
+
+TEST_F(DebugOutput_Test, TruncateLongMessages) {
+    ASSERT_TRUE(m_context->startDebugOutput(sink()));
+    const auto text = std::string(k_maxDebugMessageLength + 100, 'x');
+    m_context->functions().DebugMessageInsert(gl::DEBUG_SOURCE_APPLICATION, gl::DEBUG_TYPE_OTHER, 0, gl::DEBUG_SEVERITY_HIGH, static_cast<gl::GLsizei>(text.size()), text.c_str());
+    ASSERT_TRUE(m_context->stopDebugOutput());
+
+    ASSERT_EQ(1u, m_messages.size());
+    EXPECT_EQ(k_maxDebugMessageLength, m_messages[0].length);
+    EXPECT_EQ(text.substr(0, k_maxDebugMessageLength), m_messages[0].text);
+}
+
+
+TEST_F(DebugOutput_Test, Errors) {
+    EXPECT_FALSE(m_context->stopDebugOutput());
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), m_context->lastErrorCode());
+    ASSERT_TRUE(m_context->startDebugOutput(sink()));
+    EXPECT_FALSE(m_context->startDebugOutput(sink()));
+    EXPECT_TRUE(m_context->debugOutputActive());
+
+    // the destructor stops the collection of a context that is still collecting
+    m_context->doneCurrent();
+    m_context.reset();
+    m_context = ContextFactory::create();
+    ASSERT_TRUE(m_context->makeCurrent());
+}
+
+
+TEST_F(DebugOutput_Test, CurrentContext) {
+    // the native context outlives the object of getCurrent(), so the driver could call a callback freed with it
+    {
+        auto current = ContextFactory::getCurrent();
+        ASSERT_TRUE(current->valid());
+        EXPECT_FALSE(current->startDebugOutput(sink()));
+        EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), current->lastErrorCode());
+        EXPECT_FALSE(current->debugOutputActive());
+    }
+    insert(gl::DEBUG_SEVERITY_HIGH, "after");
+
+    // a context destroyed while current removes its callback from the driver first
+    auto other = ContextFactory::create();
+    ASSERT_TRUE(other->makeCurrent());
+    ASSERT_TRUE(other->startDebugOutput(sink()));
+    other.reset();
+    ASSERT_TRUE(m_context->makeCurrent());
+    ASSERT_TRUE(m_context->startDebugOutput(sink()));
+    insert(gl::DEBUG_SEVERITY_HIGH, "collected");
+    ASSERT_TRUE(m_context->stopDebugOutput());
+    ASSERT_EQ(1u, m_messages.size());
+    EXPECT_EQ(std::string("collected"), m_messages[0].text);
+}
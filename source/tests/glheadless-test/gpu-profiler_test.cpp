@@ -0,0 +1,154 @@
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/error.h>
+#include <glheadless/GpuProfiling.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class GpuProfiler_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        m_context = ContextFactory::create();
+        ASSERT_TRUE(m_context->valid());
+        ASSERT_TRUE(m_context->makeCurrent());
+    }
+
+    void TearDown() override {
+        m_context->doneCurrent();
+    }
+
+    void clear() {
+        m_context->functions().ClearColor(0.5f, 0.5f, 0.5f, 1.0f);
+        m_context->functions().Clear(0x00004000);
+    }
+
+    std::unique_ptr<Context> m_context;
+};
+
+
+TEST_F(GpuProfiler_Test, NestedScopes) {
+    ASSERT_TRUE(m_context->startGpuProfiling(0)) << m_context->lastErrorMessage();
+    EXPECT_TRUE(m_context->gpuProfilingActive());
+
+    const auto frameCount = 3u;
+    for (auto frame = 0u; frame < frameCount; ++frame) {
+        {
+            GpuScope frameScope(*m_context, "frame");
+            for (auto pass = 0; pass < 3; ++pass) {
+                GpuScope passScope(*m_context, "pass");
+                clear();
+            }
+            GpuScope postScope(*m_context, "post");
+            GpuScope blurScope(*m_context, "blur");
+            clear();
+        }
+        ASSERT_TRUE(m_context->endGpuFrame()) << m_context->lastErrorMessage();
+    }
+    ASSERT_TRUE(m_context->stopGpuProfiling());
+    EXPECT_FALSE(m_context->gpuProfilingActive());
+
+    const auto frames = m_context->takeGpuFrameTimings();
+    ASSERT_EQ(frameCount, frames.size());
+    for (auto i = 0u; i < frameCount; ++i) {
+        const auto& frame = frames[i];
+        EXPECT_EQ(i, frame.frame);
+        ASSERT_EQ(4u, frame.scopes.size());
+
+        EXPECT_EQ("frame", frame.scopes[0].name);
+        EXPECT_EQ(k_noParentScope, frame.scopes[0].parent);
+        EXPECT_EQ(0u, frame.scopes[0].depth);
+        EXPECT_EQ(1u, frame.scopes[0].count);
+
+        // the passes are merged
+        EXPECT_EQ("pass", frame.scopes[1].name);
+        EXPECT_EQ(0u, frame.scopes[1].parent);
+        EXPECT_EQ(1u, frame.scopes[1].depth);
+        EXPECT_EQ(3u, frame.scopes[1].count);
+
+        EXPECT_EQ("post", frame.scopes[2].name);
+        EXPECT_EQ(0u, frame.scopes[2].parent);
+        EXPECT_EQ("blur", frame.scopes[3].name);
+        EXPECT_EQ(2u, frame.scopes[3].parent);
+        EXPECT_EQ(2u, frame.scopes[3].depth);
+
+        EXPECT_GE(frame.milliseconds, frame.scopes[0].milliseconds);
+        EXPECT_GE(frame.scopes[0].milliseconds, frame.scopes[1].milliseconds);
+        EXPECT_GE(frame.scopes[2].milliseconds, frame.scopes[3].milliseconds);
+    }
+
+    EXPECT_TRUE(m_context->takeGpuFrameTimings().empty());
+}
+
+
+TEST_F(GpuProfiler_Test, ReadLater) {
+    const auto latency = 2u;
+    ASSERT_TRUE(m_context->startGpuProfiling(latency));
+
+    const auto frameCount = 6u;
+    std::vector<GpuFrameTimings> frames;
+    for (auto frame = 0u; frame < frameCount; ++frame) {
+        ASSERT_TRUE(m_context->beginGpuScope("draw"));
+        clear();
+        ASSERT_TRUE(m_context->endGpuScope());
+        ASSERT_TRUE(m_context->endGpuFrame());
+
+        for (auto& timings : m_context->takeGpuFrameTimings()) {
+            // a frame is read once at least latency frames ended after it
+            EXPECT_LE(timings.frame + latency, frame);
+            frames.push_back(std::move(timings));
+        }
+    }
+
+    // the current frame is discarded, the ended ones are read when stopping
+    ASSERT_TRUE(m_context->beginGpuScope("unfinished"));
+    ASSERT_TRUE(m_context->stopGpuProfiling());
+    for (auto& timings : m_context->takeGpuFrameTimings()) {
+        frames.push_back(std::move(timings));
+    }
+
+    ASSERT_EQ(frameCount, frames.size());
+    for (auto i = 0u; i < frameCount; ++i) {
+        EXPECT_EQ(i, frames[i].frame);
+        ASSERT_EQ(1u, frames[i].scopes.size());
+        EXPECT_EQ("draw", frames[i].scopes[0].name);
+    }
+
+    // profiling can start again, numbering frames from 0
+    ASSERT_TRUE(m_context->startGpuProfiling(0));
+    ASSERT_TRUE(m_context->endGpuFrame());
+    ASSERT_TRUE(m_context->stopGpuProfiling());
+    const auto empty = m_context->takeGpuFrameTimings();
+    ASSERT_EQ(1u, empty.size());
+    EXPECT_EQ(0u, empty[0].frame);
+    EXPECT_TRUE(empty[0].scopes.empty());
+}
+
+
+TEST_F(GpuProfiler_Test, Errors) {
+    EXPECT_FALSE(m_context->beginGpuScope("scope"));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), m_context->lastErrorCode());
+    EXPECT_FALSE(m_context->stopGpuProfiling());
+    EXPECT_TRUE(m_context->takeGpuFrameTimings().empty());
+
+    ASSERT_TRUE(m_context->startGpuProfiling());
+    EXPECT_FALSE(m_context->startGpuProfiling());
+    EXPECT_FALSE(m_context->endGpuScope());
+
+    ASSERT_TRUE(m_context->beginGpuScope("open"));
+    EXPECT_FALSE(m_context->endGpuFrame());
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), m_context->lastErrorCode());
+    ASSERT_TRUE(m_context->endGpuScope());
+    EXPECT_TRUE(m_context->endGpuFrame());
+
+    // a context destroyed while profiling takes its query objects with it
+    m_context->doneCurrent();
+    m_context.reset();
+    m_context = ContextFactory::create();
+    ASSERT_TRUE(m_context->makeCurrent());
+}
@@ -0,0 +1,51 @@
+#include <gmock/gmock.h>
+
+#include <glheadless/ContextFormat.h>
+#include <glheadless/MemoryFootprint.h>
+
+
+using namespace glheadless;
+
+
+class MemoryFootprint_Test : public testing::Test {
+};
+
+
+#ifdef __linux__
+
+
+TEST_F(MemoryFootprint_Test, ProcessMemoryUsage) {
+    MemoryUsage usage;
+    ASSERT_TRUE(processMemoryUsage(usage));
+    EXPECT_GT(usage.rssBytes, 0u);
+    EXPECT_LE(usage.pssBytes, usage.rssBytes);
+}
+
+
+TEST_F(MemoryFootprint_Test, ApproximateFootprint) {
+    const auto standalone = approximateFootprint();
+    ASSERT_GT(standalone.sampleCount, 0u);
+
+    // the result is kept
+    const auto again = approximateFootprint();
+    EXPECT_EQ(standalone.sampleCount, again.sampleCount);
+    EXPECT_EQ(standalone.rssBytes, again.rssBytes);
+    EXPECT_EQ(standalone.pssBytes, again.pssBytes);
+
+    const auto shared = approximateFootprint(ContextFormat(), true);
+    EXPECT_GT(shared.sampleCount, 0u);
+}
+
+
+#endif
+
+
+TEST_F(MemoryFootprint_Test, InvalidFormat) {
+    ContextFormat format;
+    format.versionMajor = 123;
+    format.versionMinor = 42;
+
+    const auto footprint = approximateFootprint(format);
+    EXPECT_EQ(0u, footprint.sampleCount);
+    EXPECT_EQ(0, footprint.rssBytes);
+}
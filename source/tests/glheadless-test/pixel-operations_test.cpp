@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/PixelOperations.h>
+
+
+using namespace glheadless;
+
+
+class PixelOperations_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        m_previous = instructionSet();
+
+        m_instructionSets.push_back(InstructionSet::SCALAR);
+        for (auto candidate : { InstructionSet::SSSE3, InstructionSet::AVX2, InstructionSet::NEON }) {
+            if (setInstructionSet(candidate)) {
+                m_instructionSets.push_back(candidate);
+            }
+        }
+        setInstructionSet(m_previous);
+    }
+
+    void TearDown() override {
+        setInstructionSet(m_previous);
+    }
+
+    static std::vector<unsigned char> randomPixels(std::size_t pixels) {
+        std::vector<unsigned char> result(pixels * 4);
+        for (auto& value : result) {
+            value = static_cast<unsigned char>(std::rand());
+        }
+        return result;
+    }
+
+    static const char* name(InstructionSet instructionSet) {
+        switch (instructionSet) {
+        case InstructionSet::SSSE3:
+            return "SSSE3";
+        case InstructionSet::AVX2:
+            return "AVX2";
+        case InstructionSet::NEON:
+            return "NEON";
+        default:
+            return "scalar";
+        }
+    }
+
+    // runs an operation on all pixel counts up to 67 (covering every tail length), out of place and in place
+    void expectMatchesScalar(std::size_t outputBytesPerPixel, const std::function<void(const void*, void*, std::size_t)>& operation) {
+        for (std::size_t pixels = 0; pixels < 68; ++pixels) {
+            const auto input = randomPixels(pixels);
+
+            ASSERT_TRUE(setInstructionSet(InstructionSet::SCALAR));
+            std::vector<unsigned char> expected(pixels * outputBytesPerPixel + 1, 0xcd);
+            operation(input.data(), expected.data(), pixels);
+
+            for (auto instructionSet : m_instructionSets) {
+                SCOPED_TRACE(name(instructionSet));
+                SCOPED_TRACE(pixels);
+                ASSERT_TRUE(setInstructionSet(instructionSet));
+
+                std::vector<unsigned char> output(pixels * outputBytesPerPixel + 1, 0xcd);
+                operation(input.data(), output.data(), pixels);
+                EXPECT_EQ(expected, output);
+
+                auto inPlace = input;
+                operation(inPlace.data(), inPlace.data(), pixels);
+                EXPECT_TRUE(std::equal(expected.begin(), expected.end() - 1, inPlace.begin()));
+            }
+        }
+    }
+
+    InstructionSet              m_previous;
+    std::vector<InstructionSet> m_instructionSets;
+};
+
+
+TEST_F(PixelOperations_Test, FlipRows) {
+    const std::size_t rowSize = 4099;
+    const std::size_t rows = 7;
+    const auto input = randomPixels(rowSize * rows / 4 + 1);
+
+    std::vector<unsigned char> output(rowSize * rows);
+    flipRows(input.data(), output.data(), rowSize, rows);
+
+    auto inPlace = input;
+    flipRows(inPlace.data(), inPlace.data(), rowSize, rows);
+
+    for (std::size_t row = 0; row < rows; ++row) {
+        const auto expected = input.begin() + (rows - 1 - row) * rowSize;
+        EXPECT_TRUE(std::equal(expected, expected + rowSize, output.begin() + row * rowSize));
+        EXPECT_TRUE(std::equal(expected, expected + rowSize, inPlace.begin() + row * rowSize));
+    }
+}
+
+
+TEST_F(PixelOperations_Test, Swizzle) {
+    const unsigned char pixel[4] = { 1, 2, 3, 4 };
+    unsigned char bgra[4];
+    swizzle(pixel, bgra, 1, {{ 2, 1, 0, 3 }});
+    EXPECT_THAT(bgra, testing::ElementsAre(3, 2, 1, 4));
+
+    for (const std::array<unsigned char, 4>& order : { std::array<unsigned char, 4>{{ 2, 1, 0, 3 }}, std::array<unsigned char, 4>{{ 3, 3, 0, 1 }} }) {
+        expectMatchesScalar(4, [&order] (const void* source, void* destination, std::size_t pixels) {
+            swizzle(source, destination, pixels, order);
+        });
+    }
+}
+
+
+TEST_F(PixelOperations_Test, PackRGB) {
+    const unsigned char pixels[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    unsigned char rgb[6];
+    packRGB(pixels, rgb, 2);
+    EXPECT_THAT(rgb, testing::ElementsAre(1, 2, 3, 5, 6, 7));
+    packRGB(pixels, rgb, 2, true);
+    EXPECT_THAT(rgb, testing::ElementsAre(3, 2, 1, 7, 6, 5));
+
+    for (auto swapRedBlue : { false, true }) {
+        expectMatchesScalar(3, [swapRedBlue] (const void* source, void* destination, std::size_t pixels) {
+            packRGB(source, destination, pixels, swapRedBlue);
+        });
+    }
+}
+
+
+TEST_F(PixelOperations_Test, PremultiplyAlpha) {
+    // every color and alpha combination, compared against the exactly rounded result
+    std::vector<unsigned char> input;
+    for (auto alpha = 0; alpha < 256; ++alpha) {
+        for (auto color = 0; color < 256; ++color) {
+            input.insert(input.end(), { static_cast<unsigned char>(color), 0, 255, static_cast<unsigned char>(alpha) });
+        }
+    }
+
+    for (auto instructionSet : m_instructionSets) {
+        SCOPED_TRACE(name(instructionSet));
+        ASSERT_TRUE(setInstructionSet(instructionSet));
+
+        std::vector<unsigned char> output(input.size());
+        premultiplyAlpha(input.data(), output.data(), input.size() / 4);
+
+        for (std::size_t i = 0; i < input.size(); i += 4) {
+            const auto alpha = input[i + 3];
+            ASSERT_EQ((input[i] * alpha * 2 + 255) / 510, output[i]) << "color " << int(input[i]) << ", alpha " << int(alpha);
+            ASSERT_EQ(0, output[i + 1]);
+            ASSERT_EQ(alpha, output[i + 2]);
+            ASSERT_EQ(alpha, output[i + 3]);
+        }
+    }
+
+    expectMatchesScalar(4, premultiplyAlpha);
+}
+
+
+TEST_F(PixelOperations_Test, UnpremultiplyAlpha) {
+    std::vector<unsigned char> input;
+    for (auto alpha = 0; alpha < 256; ++alpha) {
+        for (auto color = 0; color < 256; ++color) {
+            input.insert(input.end(), { static_cast<unsigned char>(color), 0, static_cast<unsigned char>(alpha), static_cast<unsigned char>(alpha) });
+        }
+    }
+
+    for (auto instructionSet : m_instructionSets) {
+        SCOPED_TRACE(name(instructionSet));
+        ASSERT_TRUE(setInstructionSet(instructionSet));
+
+        std::vector<unsigned char> output(input.size());
+        unpremultiplyAlpha(input.data(), output.data(), input.size() / 4);
+
+        for (std::size_t i = 0; i < input.size(); i += 4) {
+            const unsigned int alpha = input[i + 3];
+            const auto expected = alpha == 0 ? 0u : std::min(255u, (input[i] * 255u + alpha / 2) / alpha);
+            ASSERT_EQ(expected, output[i]) << "color " << int(input[i]) << ", alpha " << alpha;
+            ASSERT_EQ(0, output[i + 1]);
+            ASSERT_EQ(alpha == 0 ? 0 : 255, output[i + 2]);
+            ASSERT_EQ(alpha, output[i + 3]);
+        }
+    }
+
+    expectMatchesScalar(4, unpremultiplyAlpha);
+}
+
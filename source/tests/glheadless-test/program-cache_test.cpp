@@ -0,0 +1,150 @@
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/ProgramCache.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class ProgramCache_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        m_context = ContextFactory::create();
+        ASSERT_TRUE(m_context->valid());
+        ASSERT_TRUE(m_context->makeCurrent());
+
+        ProgramCache(k_directory).clear();
+    }
+
+    void TearDown() override {
+        ProgramCache(k_directory).clear();
+        std::remove(k_directory);
+        m_context->doneCurrent();
+    }
+
+    bool binariesSupported() {
+        gl::GLint formats = 0;
+        m_context->functions().GetIntegerv(gl::NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }
+
+    void expectUsable(unsigned int program) {
+        const auto& gl = m_context->functions();
+        gl::GLint status = 0;
+        gl.GetProgramiv(program, gl::LINK_STATUS, &status);
+        EXPECT_EQ(1, status);
+        EXPECT_LE(0, gl.GetUniformLocation(program, "color"));
+        gl.DeleteProgram(program);
+    }
+
+    static const char* const k_directory;
+    static const char* const k_vertexSource;
+    static const char* const k_fragmentSource;
+
+    std::unique_ptr<Context> m_context;
+};
+
+
+const char* const ProgramCache_Test::k_directory = "program-cache_test";
+
+const char* const ProgramCache_Test::k_vertexSource = R"(
+#version 330
+void main() {
+    gl_Position = vec4(float(gl_VertexID % 2), float(gl_VertexID / 2), 0.0, 1.0);
+}
+)";
+
+const char* const ProgramCache_Test::k_fragmentSource = R"(
+#version 330
+uniform vec4 color;
+out vec4 fragColor;
+void main() {
+    fragColor = color;
+}
+)";
+
+
+TEST_F(ProgramCache_Test, Reload) {
+    unsigned int program = 0;
+    {
+        ProgramCache cache(k_directory);
+        ASSERT_TRUE(cache.createProgram(m_context.get(), k_vertexSource, k_fragmentSource, program)) << cache.lastErrorMessage();
+        EXPECT_EQ(0u, cache.hitCount());
+        EXPECT_EQ(1u, cache.missCount());
+        expectUsable(program);
+    }
+
+    // a new instance stands in for a later launch of the process
+    ProgramCache cache(k_directory);
+    ASSERT_TRUE(cache.createProgram(m_context.get(), k_vertexSource, k_fragmentSource, program)) << cache.lastErrorMessage();
+    expectUsable(program);
+    if (!binariesSupported()) {
+        EXPECT_EQ(1u, cache.missCount());
+        return;
+    }
+    EXPECT_EQ(1u, cache.hitCount());
+    EXPECT_EQ(0u, cache.missCount());
+
+    // a different source is a different entry
+    ASSERT_TRUE(cache.createProgram(m_context.get(), k_vertexSource, std::string(k_fragmentSource) + "\n", program));
+    expectUsable(program);
+    EXPECT_EQ(1u, cache.missCount());
+}
+
+
+TEST_F(ProgramCache_Test, OtherDriver) {
+    if (!binariesSupported()) {
+        return;
+    }
+
+    unsigned int program = 0;
+    ASSERT_TRUE(ProgramCache(k_directory).createProgram(m_context.get(), k_vertexSource, k_fragmentSource, program));
+    expectUsable(program);
+
+    // an entry of a different driver sharing the directory is kept
+    const auto otherDirectory = std::string(k_directory) + "/0000000000000000";
+    const auto other = otherDirectory + "/0000000000000000.glbin";
+#ifdef _WIN32
+    ASSERT_EQ(0, _mkdir(otherDirectory.c_str()));
+#else
+    ASSERT_EQ(0, mkdir(otherDirectory.c_str(), 0755));
+#endif
+    std::ofstream(other) << "other";
+
+    ProgramCache cache(k_directory);
+    ASSERT_TRUE(cache.createProgram(m_context.get(), k_vertexSource, k_fragmentSource, program));
+    expectUsable(program);
+    EXPECT_EQ(1u, cache.hitCount());
+    EXPECT_TRUE(std::ifstream(other).good());
+
+    // clear() deletes the entries of all drivers
+    EXPECT_TRUE(cache.clear());
+    EXPECT_FALSE(std::ifstream(other).good());
+}
+
+
+TEST_F(ProgramCache_Test, CompileError) {
+    ProgramCache cache(k_directory);
+    unsigned int program = 0;
+
+    EXPECT_FALSE(cache.createProgram(m_context.get(), k_vertexSource, "#version 330\nvoid main() { undefined(); }\n", program));
+    EXPECT_EQ(make_error_code(Error::OPENGL_ERROR), cache.lastErrorCode());
+    EXPECT_THAT(cache.lastErrorMessage(), testing::HasSubstr("shader compilation failed"));
+
+    EXPECT_FALSE(cache.createProgram(m_context.get(), std::vector<ShaderSource>(), program));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), cache.lastErrorCode());
+}
@@ -0,0 +1,279 @@
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/Readback.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class Readback_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        m_context = ContextFactory::create();
+        ASSERT_TRUE(m_context->valid());
+        ASSERT_TRUE(m_context->makeCurrent());
+
+        const auto& gl = m_context->functions();
+        gl.GenRenderbuffers(1, &m_renderbuffer);
+        gl.BindRenderbuffer(gl::RENDERBUFFER, m_renderbuffer);
+        gl.RenderbufferStorage(gl::RENDERBUFFER, gl::RGBA8, k_width, k_height);
+        gl.GenFramebuffers(1, &m_framebuffer);
+        gl.BindFramebuffer(gl::FRAMEBUFFER, m_framebuffer);
+        gl.FramebufferRenderbuffer(gl::FRAMEBUFFER, gl::COLOR_ATTACHMENT0, gl::RENDERBUFFER, m_renderbuffer);
+        ASSERT_EQ(gl::FRAMEBUFFER_COMPLETE, gl.CheckFramebufferStatus(gl::FRAMEBUFFER));
+    }
+
+    void TearDown() override {
+        const auto& gl = m_context->functions();
+        gl.DeleteFramebuffers(1, &m_framebuffer);
+        gl.DeleteRenderbuffers(1, &m_renderbuffer);
+        m_context->doneCurrent();
+    }
+
+    void clear(float red, float green, float blue, float alpha) {
+        const auto& gl = m_context->functions();
+        gl.ClearColor(red, green, blue, alpha);
+        gl.Clear(gl::COLOR_BUFFER_BIT);
+    }
+
+    static const int k_width = 8;
+    static const int k_height = 4;
+
+    std::unique_ptr<Context> m_context;
+    unsigned int m_renderbuffer = 0;
+    unsigned int m_framebuffer = 0;
+};
+
+
+TEST_F(Readback_Test, ImageSize) {
+    EXPECT_EQ(8u * 4u * 4u, imageSize(PixelFormat::RGBA8, 8, 4));
+    EXPECT_EQ(8u * 4u * 3u, imageSize(PixelFormat::BGR8, 8, 4));
+    EXPECT_EQ(8u * 4u, imageSize(PixelFormat::LUMA8, 8, 4));
+    EXPECT_EQ(8u * 4u * 3u / 2u, imageSize(PixelFormat::I420, 8, 4));
+    EXPECT_EQ(8u * 4u * 3u / 2u, imageSize(PixelFormat::NV12, 8, 4));
+}
+
+
+TEST_F(Readback_Test, Direct) {
+    clear(1.0f, 0.0f, 0.0f, 1.0f);
+
+    Readback readback(m_context.get());
+    std::vector<unsigned char> pixels(imageSize(PixelFormat::RGBA8, k_width, k_height));
+    ASSERT_TRUE(readback.read(0, 0, k_width, k_height, PixelFormat::RGBA8, pixels.data()));
+
+    EXPECT_THAT(std::vector<unsigned char>(pixels.begin(), pixels.begin() + 4), testing::ElementsAre(255, 0, 0, 255));
+    EXPECT_THAT(std::vector<unsigned char>(pixels.end() - 4, pixels.end()), testing::ElementsAre(255, 0, 0, 255));
+}
+
+
+TEST_F(Readback_Test, PackedFormats) {
+    clear(1.0f, 0.0f, 0.2f, 1.0f);
+
+    Readback readback(m_context.get());
+
+    std::vector<unsigned char> bgr(imageSize(PixelFormat::BGR8, k_width, k_height));
+    ASSERT_TRUE(readback.read(0, 0, k_width, k_height, PixelFormat::BGR8, bgr.data()));
+    EXPECT_THAT(std::vector<unsigned char>(bgr.end() - 3, bgr.end()), testing::ElementsAre(51, 0, 255));
+
+    std::vector<unsigned char> bgra(imageSize(PixelFormat::BGRA8, k_width, k_height));
+    ASSERT_TRUE(readback.read(0, 0, k_width, k_height, PixelFormat::BGRA8, bgra.data()));
+    EXPECT_THAT(std::vector<unsigned char>(bgra.begin(), bgra.begin() + 4), testing::ElementsAre(51, 0, 255, 255));
+
+    std::vector<unsigned char> red(imageSize(PixelFormat::R8, k_width, k_height));
+    ASSERT_TRUE(readback.read(0, 0, k_width, k_height, PixelFormat::R8, red.data()));
+    EXPECT_THAT(red, testing::Each(255));
+}
+
+
+TEST_F(Readback_Test, PlanarFormats) {
+    clear(1.0f, 0.0f, 0.0f, 1.0f);
+
+    Readback readback(m_context.get());
+    const auto lumaSize = static_cast<std::size_t>(k_width * k_height);
+
+    std::vector<unsigned char> i420(imageSize(PixelFormat::I420, k_width, k_height));
+    ASSERT_TRUE(readback.read(0, 0, k_width, k_height, PixelFormat::I420, i420.data()));
+    EXPECT_EQ(81, i420.front());
+    EXPECT_EQ(90, i420[lumaSize]);
+    EXPECT_EQ(240, i420.back());
+
+    std::vector<unsigned char> nv12(imageSize(PixelFormat::NV12, k_width, k_height));
+    ASSERT_TRUE(readback.read(0, 0, k_width, k_height, PixelFormat::NV12, nv12.data()));
+    EXPECT_EQ(81, nv12.front());
+    EXPECT_EQ(90, nv12[lumaSize]);
+    EXPECT_EQ(240, nv12[lumaSize + 1]);
+}
+
+
+TEST_F(Readback_Test, FlipVertically) {
+    clear(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // paint the bottom row white
+    const auto& gl = m_context->functions();
+    gl.Enable(gl::SCISSOR_TEST);
+    gl.Scissor(0, 0, k_width, 1);
+    clear(1.0f, 1.0f, 1.0f, 1.0f);
+    gl.Disable(gl::SCISSOR_TEST);
+
+    Readback readback(m_context.get());
+    std::vector<unsigned char> pixels(imageSize(PixelFormat::R8, k_width, k_height));
+
+    ASSERT_TRUE(readback.read(0, 0, k_width, k_height, PixelFormat::R8, pixels.data()));
+    EXPECT_EQ(255, pixels.front());
+    EXPECT_EQ(0, pixels.back());
+
+    readback.setFlipVertically(true);
+    ASSERT_TRUE(readback.read(0, 0, k_width, k_height, PixelFormat::R8, pixels.data()));
+    EXPECT_EQ(0, pixels.front());
+    EXPECT_EQ(255, pixels.back());
+}
+
+
+
+TEST_F(Readback_Test, UnpackBufferBound) {
+    clear(1.0f, 0.0f, 0.0f, 1.0f);
+
+    // too small for the internal textures, which would fail if it was used as their source
+    const auto& gl = m_context->functions();
+    gl::GLuint buffer = 0;
+    gl.GenBuffers(1, &buffer);
+    gl.BindBuffer(gl::PIXEL_UNPACK_BUFFER, buffer);
+    gl.BufferData(gl::PIXEL_UNPACK_BUFFER, 16, nullptr, gl::STREAM_DRAW);
+
+    Readback readback(m_context.get());
+    std::vector<unsigned char> i420(imageSize(PixelFormat::I420, k_width, k_height));
+    ASSERT_TRUE(readback.read(0, 0, k_width, k_height, PixelFormat::I420, i420.data())) << m_context->lastErrorMessage();
+    EXPECT_EQ(81, i420.front());
+    EXPECT_EQ(240, i420.back());
+    EXPECT_EQ(0x0000u, gl.GetError());
+
+    gl::GLint bound = 0;
+    gl.GetIntegerv(gl::PIXEL_UNPACK_BUFFER_BINDING, &bound);
+    EXPECT_EQ(static_cast<gl::GLint>(buffer), bound);
+
+    gl.BindBuffer(gl::PIXEL_UNPACK_BUFFER, 0);
+    gl.DeleteBuffers(1, &buffer);
+}
+
+TEST_F(Readback_Test, PyramidLayout) {
+    const auto layout = Readback::pyramidLayout(PixelFormat::RGB8, 8, 4, { 0, 2, 3 });
+    ASSERT_EQ(3u, layout.size());
+
+    EXPECT_EQ(0u, layout[0].offset);
+    EXPECT_EQ(8u * 4u * 3u, layout[0].size);
+    EXPECT_EQ(layout[0].size, layout[1].offset);
+    EXPECT_EQ(2u, layout[1].width);
+    EXPECT_EQ(1u, layout[1].height);
+    EXPECT_EQ(1u, layout[2].width);
+    EXPECT_EQ(1u, layout[2].height);
+    EXPECT_EQ(layout[1].offset + layout[1].size, layout[2].offset);
+}
+
+
+TEST_F(Readback_Test, Pyramid) {
+    clear(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // paint the left half white
+    const auto& gl = m_context->functions();
+    gl.Enable(gl::SCISSOR_TEST);
+    gl.Scissor(0, 0, k_width / 2, k_height);
+    clear(1.0f, 1.0f, 1.0f, 1.0f);
+    gl.Disable(gl::SCISSOR_TEST);
+
+    Readback readback(m_context.get());
+    const std::vector<unsigned int> levels = { 0, 2, 3 };
+    const auto layout = Readback::pyramidLayout(PixelFormat::R8, k_width, k_height, levels);
+    std::vector<unsigned char> pixels(layout.back().offset + layout.back().size);
+
+    ASSERT_TRUE(readback.readPyramid(0, 0, k_width, k_height, PixelFormat::R8, levels, pixels.data()));
+    EXPECT_EQ(255, pixels[layout[0].offset]);
+    EXPECT_EQ(0, pixels[layout[0].offset + k_width - 1]);
+    EXPECT_EQ(255, pixels[layout[1].offset]);
+    EXPECT_EQ(0, pixels[layout[1].offset + 1]);
+    EXPECT_NEAR(128, pixels[layout[2].offset], 1);
+
+    EXPECT_FALSE(readback.readPyramid(0, 0, k_width, k_height, PixelFormat::R8, { 4 }, pixels.data()));
+    EXPECT_EQ(static_cast<int>(Error::INVALID_ARGUMENT), m_context->lastErrorCode().value());
+}
+
+
+TEST_F(Readback_Test, MergeRegions) {
+    const auto merged = Readback::mergeRegions({ Region(4, 0, 2, 2), Region(0, 0, 2, 2), Region(1, 1, 2, 2), Region(7, 3, 0, 1) });
+    ASSERT_EQ(2u, merged.size());
+
+    EXPECT_EQ(0, merged[0].x);
+    EXPECT_EQ(0, merged[0].y);
+    EXPECT_EQ(3u, merged[0].width);
+    EXPECT_EQ(3u, merged[0].height);
+    EXPECT_EQ(4, merged[1].x);
+    EXPECT_EQ(2u, merged[1].width);
+
+    const auto layout = Readback::regionLayout(PixelFormat::NV12, { Region(1, 1, 1, 1) });
+    ASSERT_EQ(1u, layout.size());
+    EXPECT_EQ(0, layout[0].region.x);
+    EXPECT_EQ(2u, layout[0].region.width);
+    EXPECT_EQ(imageSize(PixelFormat::NV12, 2, 2), layout[0].size);
+}
+
+
+TEST_F(Readback_Test, Regions) {
+    clear(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // paint the top right pixel white
+    const auto& gl = m_context->functions();
+    gl.Enable(gl::SCISSOR_TEST);
+    gl.Scissor(k_width - 1, k_height - 1, 1, 1);
+    clear(1.0f, 1.0f, 1.0f, 1.0f);
+    gl.Disable(gl::SCISSOR_TEST);
+
+    Readback readback(m_context.get());
+    const std::vector<Region> regions = { Region(0, 0, 2, 1), Region(k_width - 2, k_height - 1, 2, 1) };
+
+    for (const auto format : { PixelFormat::RGBA8, PixelFormat::R8 }) {
+        const auto layout = Readback::regionLayout(format, regions);
+        ASSERT_EQ(2u, layout.size());
+
+        std::vector<unsigned char> pixels(layout.back().offset + layout.back().size);
+        ASSERT_TRUE(readback.readRegions(regions, format, pixels.data()));
+        EXPECT_EQ(0, pixels[layout[0].offset]);
+        EXPECT_EQ(0, pixels[layout[1].offset]);
+        EXPECT_EQ(255, pixels.back());
+    }
+}
+
+
+TEST_F(Readback_Test, DirtyScissor) {
+    clear(0.0f, 0.0f, 0.0f, 1.0f);
+
+    Readback readback(m_context.get());
+
+    const auto& gl = m_context->functions();
+    gl.Enable(gl::SCISSOR_TEST);
+    gl.Scissor(2, 1, 2, 2);
+    clear(1.0f, 1.0f, 1.0f, 1.0f);
+    readback.addDirtyScissor();
+    gl.Disable(gl::SCISSOR_TEST);
+
+    ASSERT_EQ(1u, readback.dirtyRegions().size());
+    const auto layout = Readback::regionLayout(PixelFormat::R8, readback.dirtyRegions());
+    std::vector<unsigned char> pixels(layout.back().offset + layout.back().size);
+
+    ASSERT_TRUE(readback.readDirtyRegions(PixelFormat::R8, pixels.data()));
+    EXPECT_THAT(pixels, testing::ElementsAre(255, 255, 255, 255));
+    EXPECT_TRUE(readback.dirtyRegions().empty());
+}
+
+
+TEST_F(Readback_Test, InvalidArguments) {
+    Readback readback(m_context.get());
+    std::vector<unsigned char> pixels(imageSize(PixelFormat::I420, k_width, k_height));
+
+    EXPECT_FALSE(readback.read(0, 0, 3, 3, PixelFormat::I420, pixels.data()));
+    EXPECT_EQ(static_cast<int>(Error::INVALID_ARGUMENT), m_context->lastErrorCode().value());
+}
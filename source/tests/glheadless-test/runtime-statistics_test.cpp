@@ -0,0 +1,119 @@
+#include <string>
+#include <thread>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/RuntimeStatistics.h>
+#include <glheadless/error.h>
+
+
+using namespace glheadless;
+
+
+class RuntimeStatistics_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        resetRuntimeStatistics();
+    }
+};
+
+
+TEST_F(RuntimeStatistics_Test, CountOperations) {
+    {
+        auto context = ContextFactory::create();
+        ASSERT_TRUE(context->valid());
+        ASSERT_TRUE(context->makeCurrent());
+        ASSERT_TRUE(context->doneCurrent());
+        ASSERT_TRUE(context->makeCurrent());
+        ASSERT_TRUE(context->doneCurrent());
+    }
+
+    const auto statistics = runtimeStatistics();
+    EXPECT_EQ(1u, statistics.create.callCount);
+    EXPECT_EQ(2u, statistics.makeCurrent.callCount);
+    EXPECT_EQ(2u, statistics.doneCurrent.callCount);
+    EXPECT_EQ(1u, statistics.destroy.callCount);
+    EXPECT_EQ(0u, statistics.makeCurrent.errorCounts[static_cast<int>(Error::INVALID_CONTEXT)]);
+
+    EXPECT_EQ(2u, statistics.makeCurrent.latency.count);
+    std::uint64_t bucketSum = 0;
+    for (const auto count : statistics.makeCurrent.latency.bucketCounts) {
+        bucketSum += count;
+    }
+    EXPECT_EQ(2u, bucketSum);
+    EXPECT_GT(statistics.create.latency.totalSeconds, 0.0);
+
+    // every platform chooses a configuration and creates a native context
+    EXPECT_EQ(1u, statistics.chooseConfig.count);
+    EXPECT_EQ(1u, statistics.createContext.count);
+
+    resetRuntimeStatistics();
+    EXPECT_EQ(0u, runtimeStatistics().create.callCount);
+}
+
+
+TEST_F(RuntimeStatistics_Test, CountErrors) {
+    ContextFormat format;
+    format.versionMajor = 123;
+    format.versionMinor = 42;
+
+    {
+        auto context = ContextFactory::create(format);
+        ASSERT_FALSE(context->valid());
+        EXPECT_FALSE(context->makeCurrent());
+    }
+
+    const auto statistics = runtimeStatistics();
+    EXPECT_EQ(1u, statistics.create.callCount);
+    EXPECT_EQ(1u, statistics.create.errorCounts[static_cast<int>(Error::INVALID_CONFIGURATION)]);
+    EXPECT_EQ(1u, statistics.makeCurrent.callCount);
+    EXPECT_EQ(1u, statistics.makeCurrent.errorCounts[static_cast<int>(Error::INVALID_CONTEXT)]);
+    EXPECT_EQ(0u, statistics.makeCurrent.errorCounts[0]);
+}
+
+
+TEST_F(RuntimeStatistics_Test, SumThreads) {
+    auto context = ContextFactory::create();
+    ASSERT_TRUE(context->valid());
+
+    // the counters of the exited thread are kept
+    std::thread thread([&context] {
+        context->makeCurrent();
+        context->doneCurrent();
+    });
+    thread.join();
+    ASSERT_TRUE(context->makeCurrent());
+    ASSERT_TRUE(context->doneCurrent());
+
+    const auto statistics = runtimeStatistics();
+    EXPECT_EQ(2u, statistics.makeCurrent.callCount);
+    EXPECT_EQ(2u, statistics.doneCurrent.callCount);
+}
+
+
+TEST_F(RuntimeStatistics_Test, PrometheusText) {
+    RuntimeStatistics statistics;
+    statistics.create.callCount = 3;
+    statistics.create.errorCounts[static_cast<int>(Error::INVALID_CONFIGURATION)] = 1;
+    statistics.create.latency.count = 3;
+    statistics.create.latency.totalSeconds = 0.5;
+    statistics.create.latency.bucketCounts[0] = 2;
+    statistics.create.latency.bucketCounts[k_latencyBucketCount - 1] = 1;
+
+    const auto text = toPrometheusText(statistics);
+    EXPECT_NE(std::string::npos, text.find("# TYPE glheadless_operations_total counter\n"));
+    EXPECT_NE(std::string::npos, text.find("glheadless_operations_total{operation=\"create\"} 3\n"));
+    EXPECT_NE(std::string::npos, text.find("glheadless_operation_errors_total{operation=\"create\",error=\"invalid_configuration\"} 1\n"));
+    EXPECT_NE(std::string::npos, text.find("# TYPE glheadless_operation_duration_seconds histogram\n"));
+    EXPECT_NE(std::string::npos, text.find("glheadless_operation_duration_seconds_bucket{operation=\"create\",le=\"1e-06\"} 2\n"));
+    EXPECT_NE(std::string::npos, text.find("glheadless_operation_duration_seconds_bucket{operation=\"create\",le=\"2e-06\"} 2\n"));
+    EXPECT_NE(std::string::npos, text.find("glheadless_operation_duration_seconds_bucket{operation=\"create\",le=\"+Inf\"} 3\n"));
+    EXPECT_NE(std::string::npos, text.find("glheadless_operation_duration_seconds_sum{operation=\"create\"} 0.5\n"));
+    EXPECT_NE(std::string::npos, text.find("glheadless_operation_duration_seconds_count{operation=\"create\"} 3\n"));
+    EXPECT_NE(std::string::npos, text.find("glheadless_creation_phase_duration_seconds_count{phase=\"create_pbuffer\"} 0\n"));
+    EXPECT_NE(std::string::npos, text.find("glheadless_lock_acquisitions_total{lock=\"platform_instance\"} 0\n"));
+    EXPECT_NE(std::string::npos, text.find("glheadless_lock_contended_total{lock=\"error_handler\"} 0\n"));
+    EXPECT_NE(std::string::npos, text.find("glheadless_lock_wait_seconds_count{lock=\"platform_instance\"} 0\n"));
+}
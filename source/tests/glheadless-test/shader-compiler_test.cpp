@@ -0,0 +1,134 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/error.h>
+#include <glheadless/ShaderCompiler.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class ShaderCompiler_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        m_context = ContextFactory::create();
+        ASSERT_TRUE(m_context->valid());
+    }
+
+    // distinct sources, so drivers cannot serve programs from their own caches
+    static std::string fragmentSource(int index) {
+        return "#version 330\nout vec4 fragColor;\nvoid main() {\n    fragColor = vec4(" + std::to_string(index) + ".0 / 256.0);\n}\n";
+    }
+
+    // compiles a batch of programs and waits for all of them
+    void warmUp(ShaderCompiler& compiler, int first, int count, std::vector<unsigned int>& programs) {
+        std::vector<std::future<CompileResult>> futures;
+        for (auto i = first; i < first + count; ++i) {
+            futures.push_back(compiler.compile(k_vertexSource, fragmentSource(i)));
+        }
+        for (auto& future : futures) {
+            const auto result = future.get();
+            EXPECT_FALSE(result.errorCode) << result.errorMessage;
+            programs.push_back(result.program);
+        }
+    }
+
+    // the programs are linked and usable in the calling thread's current context
+    static void expectLinked(const gl::Functions& gl, const std::vector<unsigned int>& programs) {
+        for (const auto program : programs) {
+            ASSERT_NE(0u, program);
+            gl::GLint status = 0;
+            gl.GetProgramiv(program, gl::LINK_STATUS, &status);
+            EXPECT_EQ(1, status);
+        }
+    }
+
+    static const char* const k_vertexSource;
+
+    std::unique_ptr<Context> m_context;
+};
+
+
+const char* const ShaderCompiler_Test::k_vertexSource = R"(
+#version 330
+void main() {
+    gl_Position = vec4(float(gl_VertexID % 2), float(gl_VertexID / 2), 0.0, 1.0);
+}
+)";
+
+
+TEST_F(ShaderCompiler_Test, CompileShared) {
+    std::vector<unsigned int> programs;
+    {
+        ShaderCompiler compiler(m_context.get(), 4);
+        EXPECT_EQ(4u, compiler.threadCount());
+        warmUp(compiler, 0, 32, programs);
+    }
+
+    // the programs were linked by the workers and are complete in the share group
+    ASSERT_TRUE(m_context->makeCurrent());
+    const auto& gl = m_context->functions();
+    expectLinked(gl, programs);
+    for (const auto program : programs) {
+        gl.DeleteProgram(program);
+    }
+    m_context->doneCurrent();
+}
+
+
+TEST_F(ShaderCompiler_Test, Errors) {
+    ShaderCompiler compiler(m_context.get(), 2);
+
+    auto result = compiler.compile(k_vertexSource, "#version 330\nvoid main() { undefined(); }\n").get();
+    EXPECT_EQ(0u, result.program);
+    EXPECT_EQ(make_error_code(Error::OPENGL_ERROR), result.errorCode);
+    EXPECT_THAT(result.errorMessage, testing::HasSubstr("shader compilation failed"));
+
+    result = compiler.compile(std::vector<ShaderSource>()).get();
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), result.errorCode);
+
+    // a failed job does not affect the following ones
+    result = compiler.compile(k_vertexSource, fragmentSource(0)).get();
+    EXPECT_FALSE(result.errorCode) << result.errorMessage;
+    EXPECT_NE(0u, result.program);
+}
+
+
+TEST_F(ShaderCompiler_Test, WarmUpShareGroup) {
+    std::vector<unsigned int> programs;
+    {
+        ShaderCompiler serial(m_context.get(), 1);
+        warmUp(serial, 0, 48, programs);
+
+        ShaderCompiler parallel(m_context.get());
+        EXPECT_GE(parallel.threadCount(), 1u);
+        EXPECT_LE(parallel.parallelWorkerCount(), parallel.threadCount());
+        warmUp(parallel, 48, 48, programs);
+    }
+    ASSERT_EQ(96u, programs.size());
+
+    // programs of both compilers are complete in every context of the share group, including one created afterwards
+    std::thread other([this, &programs] {
+        auto shared = ContextFactory::create(m_context.get());
+        ASSERT_TRUE(shared->valid());
+        ASSERT_TRUE(shared->makeCurrent());
+        expectLinked(shared->functions(), programs);
+        shared->doneCurrent();
+    });
+    other.join();
+
+    ASSERT_TRUE(m_context->makeCurrent());
+    const auto& gl = m_context->functions();
+    expectLinked(gl, programs);
+    for (const auto program : programs) {
+        gl.DeleteProgram(program);
+    }
+    m_context->doneCurrent();
+}
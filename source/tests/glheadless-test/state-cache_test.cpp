@@ -0,0 +1,137 @@
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class StateCache_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        m_context = ContextFactory::create();
+        ASSERT_TRUE(m_context->valid());
+        ASSERT_TRUE(m_context->makeCurrent());
+        m_context->setStateCacheEnabled(true);
+    }
+
+    void TearDown() override {
+        m_context->setStateCacheEnabled(false);
+        m_context->doneCurrent();
+    }
+
+    gl::GLint integer(gl::GLenum name) {
+        gl::GLint value = 0;
+        m_context->functions().GetIntegerv(name, &value);
+        return value;
+    }
+
+    std::unique_ptr<Context> m_context;
+};
+
+
+TEST_F(StateCache_Test, DropRedundantCalls) {
+    EXPECT_TRUE(m_context->stateCacheEnabled());
+    const auto& gl = m_context->functions();
+
+    gl.Enable(gl::BLEND);
+    gl.Enable(gl::BLEND);
+    gl.Viewport(0, 0, 16, 16);
+    gl.Viewport(0, 0, 16, 16);
+    gl.Viewport(0, 0, 32, 16);
+
+    auto statistics = m_context->stateCacheStatistics();
+    EXPECT_EQ(3u, statistics.forwardedCount);
+    EXPECT_EQ(2u, statistics.droppedCount);
+    EXPECT_EQ(1, gl.IsEnabled(gl::BLEND));
+    gl::GLint viewport[4] = {};
+    gl.GetIntegerv(gl::VIEWPORT, viewport);
+    EXPECT_EQ(32, viewport[2]);
+
+    // entry points resolved by the application are filtered as well
+    const auto disable = reinterpret_cast<gl::Proc<void(gl::GLenum)>::Type>(m_context->getProcAddress("glDisable"));
+    ASSERT_NE(nullptr, disable);
+    disable(gl::BLEND);
+    disable(gl::BLEND);
+    statistics = m_context->stateCacheStatistics();
+    EXPECT_EQ(4u, statistics.forwardedCount);
+    EXPECT_EQ(3u, statistics.droppedCount);
+    EXPECT_EQ(0, gl.IsEnabled(gl::BLEND));
+
+    m_context->invalidateStateCache();
+    gl.Disable(gl::BLEND);
+    EXPECT_EQ(5u, m_context->stateCacheStatistics().forwardedCount);
+    EXPECT_EQ(0u, gl.GetError());
+}
+
+
+TEST_F(StateCache_Test, Bindings) {
+    const auto& gl = m_context->functions();
+    gl::GLuint textures[2] = {};
+    gl.GenTextures(2, textures);
+
+    gl.ActiveTexture(gl::TEXTURE0 + 1);
+    gl.BindTexture(gl::TEXTURE_2D, textures[0]);
+    gl.ActiveTexture(gl::TEXTURE0);
+    gl.BindTexture(gl::TEXTURE_2D, textures[1]);
+    EXPECT_EQ(textures[1], static_cast<gl::GLuint>(integer(gl::TEXTURE_BINDING_2D)));
+
+    // bindings are tracked per texture unit
+    gl.ActiveTexture(gl::TEXTURE0 + 1);
+    gl.BindTexture(gl::TEXTURE_2D, textures[0]);
+    EXPECT_EQ(textures[0], static_cast<gl::GLuint>(integer(gl::TEXTURE_BINDING_2D)));
+    EXPECT_EQ(1u, m_context->stateCacheStatistics().droppedCount);
+
+    // deleting the bound texture resets the binding, so binding a new texture of the same name is not dropped
+    gl.DeleteTextures(1, &textures[0]);
+    EXPECT_EQ(0, integer(gl::TEXTURE_BINDING_2D));
+    gl::GLuint texture = 0;
+    gl.GenTextures(1, &texture);
+    gl.BindTexture(gl::TEXTURE_2D, texture);
+    EXPECT_EQ(texture, static_cast<gl::GLuint>(integer(gl::TEXTURE_BINDING_2D)));
+
+    gl.BindTexture(gl::TEXTURE_2D, 0);
+    gl.ActiveTexture(gl::TEXTURE0);
+    gl.BindTexture(gl::TEXTURE_2D, 0);
+    gl.DeleteTextures(1, &texture);
+    gl.DeleteTextures(1, &textures[1]);
+    EXPECT_EQ(0u, gl.GetError());
+}
+
+
+TEST_F(StateCache_Test, OtherContexts) {
+    const auto& gl = m_context->functions();
+    gl.Enable(gl::DEPTH_TEST);
+
+    // the filtering entry points pass calls of contexts without a cache through
+    auto other = ContextFactory::create();
+    ASSERT_TRUE(other->valid());
+    ASSERT_TRUE(other->makeCurrent());
+    const auto before = m_context->stateCacheStatistics();
+    gl.Enable(gl::DEPTH_TEST);
+    EXPECT_EQ(1, gl.IsEnabled(gl::DEPTH_TEST));
+    gl.Disable(gl::DEPTH_TEST);
+    EXPECT_EQ(before.forwardedCount, m_context->stateCacheStatistics().forwardedCount);
+    EXPECT_EQ(before.droppedCount, m_context->stateCacheStatistics().droppedCount);
+    other->doneCurrent();
+    other.reset();
+
+    ASSERT_TRUE(m_context->makeCurrent());
+    EXPECT_EQ(1, gl.IsEnabled(gl::DEPTH_TEST));
+    gl.Enable(gl::DEPTH_TEST);
+    EXPECT_EQ(before.droppedCount + 1, m_context->stateCacheStatistics().droppedCount);
+
+    m_context->setStateCacheEnabled(false);
+    gl.Disable(gl::DEPTH_TEST);
+    EXPECT_EQ(0, gl.IsEnabled(gl::DEPTH_TEST));
+    EXPECT_EQ(0u, m_context->stateCacheStatistics().forwardedCount);
+
+    // once disabled, they pass calls on to the entry points of the context, which are made current with it
+    m_context->doneCurrent();
+    ASSERT_TRUE(m_context->makeCurrent());
+    gl.Enable(gl::DEPTH_TEST);
+    EXPECT_EQ(1, gl.IsEnabled(gl::DEPTH_TEST));
+}
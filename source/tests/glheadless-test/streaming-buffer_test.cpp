@@ -0,0 +1,134 @@
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/StreamingBuffer.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class StreamingBuffer_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        m_context = ContextFactory::create();
+        ASSERT_TRUE(m_context->valid());
+        ASSERT_TRUE(m_context->makeCurrent());
+    }
+
+    void TearDown() override {
+        m_context->doneCurrent();
+    }
+
+    std::vector<unsigned char> bufferContents(unsigned int buffer, std::size_t offset, std::size_t size) {
+        const auto& gl = m_context->functions();
+        std::vector<unsigned char> contents(size);
+        gl.BindBuffer(gl::ARRAY_BUFFER, buffer);
+        gl.GetBufferSubData(gl::ARRAY_BUFFER, static_cast<gl::GLintptr>(offset), static_cast<gl::GLsizeiptr>(size), contents.data());
+        gl.BindBuffer(gl::ARRAY_BUFFER, 0);
+        return contents;
+    }
+
+    void uploadAndVerify(StreamingBuffer::Mapping mapping) {
+        StreamingBuffer streamingBuffer(m_context.get(), 1024, 4, mapping);
+        EXPECT_EQ(256u, streamingBuffer.segmentSize());
+
+        auto wrapped = false;
+        for (auto i = 0; i < 64; ++i) {
+            const std::vector<unsigned char> data(40, static_cast<unsigned char>(i));
+            StreamAllocation allocation;
+            ASSERT_TRUE(streamingBuffer.upload(data.data(), data.size(), 16, allocation)) << m_context->lastErrorMessage();
+            EXPECT_EQ(mapping, streamingBuffer.mapping());
+            EXPECT_EQ(streamingBuffer.buffer(), allocation.buffer);
+            EXPECT_EQ(0u, allocation.offset % 16);
+            EXPECT_LE(allocation.offset + allocation.size, streamingBuffer.size());
+            wrapped = wrapped || (i > 0 && allocation.offset == 0);
+
+            streamingBuffer.flush();
+            EXPECT_EQ(data, bufferContents(allocation.buffer, allocation.offset, allocation.size));
+
+            if (i % 5 == 4) {
+                ASSERT_TRUE(streamingBuffer.fence());
+            }
+        }
+        EXPECT_TRUE(wrapped);
+    }
+
+    std::unique_ptr<Context> m_context;
+};
+
+
+TEST_F(StreamingBuffer_Test, Persistent) {
+    StreamingBuffer probe(m_context.get(), 1024, 4, StreamingBuffer::Mapping::PERSISTENT);
+    StreamAllocation allocation;
+    if (!probe.allocate(16, 0, allocation)) {
+        EXPECT_EQ(make_error_code(Error::UNSUPPORTED_FEATURE), m_context->lastErrorCode());
+        return;
+    }
+
+    uploadAndVerify(StreamingBuffer::Mapping::PERSISTENT);
+}
+
+
+TEST_F(StreamingBuffer_Test, Unsynchronized) {
+    uploadAndVerify(StreamingBuffer::Mapping::UNSYNCHRONIZED);
+}
+
+
+TEST_F(StreamingBuffer_Test, DefaultAlignment) {
+    StreamingBuffer streamingBuffer(m_context.get());
+
+    gl::GLint alignment = 0;
+    m_context->functions().GetIntegerv(gl::UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+    StreamAllocation first;
+    StreamAllocation second;
+    ASSERT_TRUE(streamingBuffer.allocate(3, 0, first));
+    ASSERT_TRUE(streamingBuffer.allocate(3, 0, second));
+    EXPECT_NE(StreamingBuffer::Mapping::AUTOMATIC, streamingBuffer.mapping());
+    EXPECT_EQ(0u, second.offset % static_cast<std::size_t>(alignment));
+    EXPECT_GE(second.offset, first.offset + first.size);
+}
+
+
+TEST_F(StreamingBuffer_Test, RestoresBinding) {
+    const auto& gl = m_context->functions();
+    gl::GLuint buffer = 0;
+    gl.GenBuffers(1, &buffer);
+    gl.BindBuffer(gl::COPY_WRITE_BUFFER, buffer);
+
+    {
+        StreamingBuffer streamingBuffer(m_context.get(), 1024, 2, StreamingBuffer::Mapping::UNSYNCHRONIZED);
+        StreamAllocation allocation;
+        for (auto i = 0; i < 20; ++i) {
+            ASSERT_TRUE(streamingBuffer.allocate(100, 4, allocation));
+        }
+        ASSERT_TRUE(streamingBuffer.fence());
+    }
+
+    gl::GLint binding = 0;
+    gl.GetIntegerv(gl::COPY_WRITE_BUFFER, &binding);
+    EXPECT_EQ(buffer, static_cast<gl::GLuint>(binding));
+    gl.DeleteBuffers(1, &buffer);
+}
+
+
+TEST_F(StreamingBuffer_Test, InvalidArguments) {
+    StreamingBuffer streamingBuffer(m_context.get(), 1024, 4);
+    StreamAllocation allocation;
+
+    EXPECT_FALSE(streamingBuffer.allocate(0, 0, allocation));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), m_context->lastErrorCode());
+    EXPECT_FALSE(streamingBuffer.allocate(257, 0, allocation));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), m_context->lastErrorCode());
+    EXPECT_FALSE(streamingBuffer.allocate(16, 3, allocation));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), m_context->lastErrorCode());
+
+    StreamingBuffer tooSmall(m_context.get(), 512, 4);
+    EXPECT_FALSE(tooSmall.allocate(16, 0, allocation));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), m_context->lastErrorCode());
+}
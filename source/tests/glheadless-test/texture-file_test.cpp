@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/TextureFile.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class TextureFile_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        m_context = ContextFactory::create();
+        ASSERT_TRUE(m_context->valid());
+        ASSERT_TRUE(m_context->makeCurrent());
+    }
+
+    void TearDown() override {
+        m_context->doneCurrent();
+        for (const auto& path : m_paths) {
+            std::remove(path.c_str());
+        }
+    }
+
+    static void append(std::vector<unsigned char>& data, std::uint32_t value) {
+        for (auto i = 0; i < 4; ++i) {
+            data.push_back(static_cast<unsigned char>(value >> (i * 8)));
+        }
+    }
+
+    static std::vector<unsigned char> pattern(std::size_t size, int seed) {
+        std::vector<unsigned char> data(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<unsigned char>(i * 13 + seed);
+        }
+        return data;
+    }
+
+    // KTX file with the given levels, each padded to 4 bytes, and 8 bytes of key/value data
+    static std::vector<unsigned char> ktx(gl::GLenum type, gl::GLenum format, gl::GLenum internalFormat, unsigned int width, unsigned int height, const std::vector<std::vector<unsigned char>>& levels) {
+        std::vector<unsigned char> data = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+        const std::uint32_t header[] = { 0x04030201, type, type != 0 ? 1u : 0u, format, internalFormat, format, width, height, 0, 0, 1, static_cast<std::uint32_t>(levels.size()), 8 };
+        for (const auto value : header) {
+            append(data, value);
+        }
+        data.resize(data.size() + 8, 0);
+
+        for (const auto& level : levels) {
+            append(data, static_cast<std::uint32_t>(level.size()));
+            data.insert(data.end(), level.begin(), level.end());
+            data.resize((data.size() + 3) & ~std::size_t(3), 0);
+        }
+        return data;
+    }
+
+    // DDS file with a FourCC code, or a DX10 header if dxgiFormat is not 0
+    static std::vector<unsigned char> dds(const char* fourCC, std::uint32_t dxgiFormat, unsigned int width, unsigned int height, const std::vector<std::vector<unsigned char>>& levels) {
+        std::vector<unsigned char> data = { 'D', 'D', 'S', ' ' };
+        std::uint32_t header[31] = {};
+        header[0] = 124;
+        header[1] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000; // caps, height, width, pixel format, mipmap count
+        header[2] = height;
+        header[3] = width;
+        header[6] = static_cast<std::uint32_t>(levels.size());
+        header[18] = 32;
+        header[19] = 0x4;
+        header[20] = static_cast<std::uint32_t>(fourCC[0]) | fourCC[1] << 8 | fourCC[2] << 16 | static_cast<std::uint32_t>(fourCC[3]) << 24;
+        header[26] = 0x1000;
+        for (const auto value : header) {
+            append(data, value);
+        }
+
+        if (dxgiFormat != 0) {
+            const std::uint32_t dx10[] = { dxgiFormat, 3, 0, 1, 0 };
+            for (const auto value : dx10) {
+                append(data, value);
+            }
+        }
+
+        for (const auto& level : levels) {
+            data.insert(data.end(), level.begin(), level.end());
+        }
+        return data;
+    }
+
+    std::string write(const std::vector<unsigned char>& data) {
+        const auto path = "texture-file_test_" + std::to_string(m_paths.size()) + ".bin";
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        m_paths.push_back(path);
+        return path;
+    }
+
+    std::vector<unsigned char> compressedLevel(unsigned int texture, int level, std::size_t size) {
+        const auto& gl = m_context->functions();
+        std::vector<unsigned char> data(size);
+        gl.BindTexture(gl::TEXTURE_2D, texture);
+        gl.GetCompressedTexImage(gl::TEXTURE_2D, level, data.data());
+        gl.BindTexture(gl::TEXTURE_2D, 0);
+        return data;
+    }
+
+    std::unique_ptr<Context> m_context;
+    std::vector<std::string> m_paths;
+};
+
+
+TEST_F(TextureFile_Test, KtxCompressed) {
+    // RGTC1 blocks are 8 bytes for 4x4 pixels: 8x8, 4x4, 2x2
+    const std::vector<std::vector<unsigned char>> levels = { pattern(32, 1), pattern(8, 2), pattern(8, 3) };
+    const auto path = write(ktx(0, 0, gl::COMPRESSED_RED_RGTC1, 8, 8, levels));
+
+    TextureFile file;
+    ASSERT_TRUE(file.open(path)) << file.lastErrorMessage();
+    EXPECT_EQ(TextureFile::Container::KTX, file.container());
+    EXPECT_TRUE(file.compressed());
+    EXPECT_EQ(gl::COMPRESSED_RED_RGTC1, file.internalFormat());
+    EXPECT_EQ(8u, file.width());
+    EXPECT_EQ(3u, file.levelCount());
+    EXPECT_EQ(2u, file.level(2).width);
+
+    for (const auto uploadPath : { TextureFile::UploadPath::CLIENT_MEMORY, TextureFile::UploadPath::PIXEL_UNPACK_BUFFER }) {
+        unsigned int texture = 0;
+        ASSERT_TRUE(file.upload(m_context.get(), texture, uploadPath)) << file.lastErrorMessage();
+        for (std::size_t i = 0; i < levels.size(); ++i) {
+            EXPECT_EQ(levels[i], compressedLevel(texture, static_cast<int>(i), levels[i].size()));
+        }
+        m_context->functions().DeleteTextures(1, &texture);
+    }
+
+    // the level data still points into the mapping after the pages were released
+    EXPECT_EQ(levels[0], std::vector<unsigned char>(file.level(0).data, file.level(0).data + file.level(0).size));
+}
+
+
+TEST_F(TextureFile_Test, KtxUncompressed) {
+    // 3x2 RGB rows are padded to 12 bytes
+    const auto level = pattern(24, 5);
+    const auto path = write(ktx(gl::UNSIGNED_BYTE, gl::RGB, gl::RGB8, 3, 2, { level }));
+
+    TextureFile file;
+    ASSERT_TRUE(file.open(path)) << file.lastErrorMessage();
+    EXPECT_FALSE(file.compressed());
+    EXPECT_EQ(gl::RGB, file.format());
+
+    const auto& gl = m_context->functions();
+    gl::GLuint previous = 0;
+    gl.GenTextures(1, &previous);
+    gl.BindTexture(gl::TEXTURE_2D, previous);
+
+    unsigned int texture = 0;
+    ASSERT_TRUE(file.upload(m_context.get(), texture)) << file.lastErrorMessage();
+
+    gl::GLint binding = 0;
+    gl.GetIntegerv(gl::TEXTURE_BINDING_2D, &binding);
+    EXPECT_EQ(previous, static_cast<gl::GLuint>(binding));
+
+    std::vector<unsigned char> pixels(24);
+    gl.BindTexture(gl::TEXTURE_2D, texture);
+    gl.GetTexImage(gl::TEXTURE_2D, 0, gl::RGB, gl::UNSIGNED_BYTE, pixels.data());
+    for (auto row = 0u; row < 2; ++row) {
+        EXPECT_TRUE(std::equal(level.begin() + row * 12, level.begin() + row * 12 + 9, pixels.begin() + row * 12));
+    }
+
+    gl.DeleteTextures(1, &texture);
+    gl.DeleteTextures(1, &previous);
+}
+
+
+TEST_F(TextureFile_Test, Dds) {
+    const std::vector<std::vector<unsigned char>> bc4 = { pattern(32, 7), pattern(8, 8), pattern(8, 9), pattern(8, 10) };
+    const std::vector<std::vector<unsigned char>> bc5 = { pattern(32, 11) };
+
+    TextureFile file;
+    ASSERT_TRUE(file.open(write(dds("ATI1", 0, 5, 8, bc4)))) << file.lastErrorMessage();
+    EXPECT_EQ(TextureFile::Container::DDS, file.container());
+    EXPECT_EQ(gl::COMPRESSED_RED_RGTC1, file.internalFormat());
+    EXPECT_EQ(4u, file.levelCount());
+    EXPECT_EQ(1u, file.level(3).width);
+
+    unsigned int texture = 0;
+    ASSERT_TRUE(file.upload(m_context.get(), texture)) << file.lastErrorMessage();
+    EXPECT_EQ(bc4[3], compressedLevel(texture, 3, 8));
+    m_context->functions().DeleteTextures(1, &texture);
+
+    ASSERT_TRUE(file.open(write(dds("DX10", 83, 7, 2, bc5)))) << file.lastErrorMessage();
+    EXPECT_EQ(gl::COMPRESSED_RG_RGTC2, file.internalFormat());
+    ASSERT_TRUE(file.upload(m_context.get(), texture, TextureFile::UploadPath::PIXEL_UNPACK_BUFFER)) << file.lastErrorMessage();
+    EXPECT_EQ(bc5[0], compressedLevel(texture, 0, 32));
+    m_context->functions().DeleteTextures(1, &texture);
+}
+
+
+TEST_F(TextureFile_Test, InvalidFiles) {
+    TextureFile file;
+    unsigned int texture = 0;
+
+    EXPECT_FALSE(file.open("texture-file_test_missing.ktx"));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), file.lastErrorCode());
+    EXPECT_FALSE(file.isOpen());
+    EXPECT_FALSE(file.upload(m_context.get(), texture));
+
+    EXPECT_FALSE(file.open(write(pattern(100, 0))));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), file.lastErrorCode());
+
+    auto truncated = ktx(0, 0, gl::COMPRESSED_RED_RGTC1, 8, 8, { pattern(32, 1), pattern(8, 2) });
+    truncated.resize(truncated.size() - 4);
+    EXPECT_FALSE(file.open(write(truncated)));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), file.lastErrorCode());
+
+    EXPECT_FALSE(file.open(write(dds("DXT5", 0, 8, 8, { pattern(60, 0) }))));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), file.lastErrorCode());
+
+    EXPECT_FALSE(file.open(write(ktx(gl::UNSIGNED_BYTE, gl::RGB, gl::RGB8, 3, 2, { pattern(20, 0) }))));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), file.lastErrorCode());
+}
@@ -0,0 +1,166 @@
+#include <future>
+#include <mutex>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/TextureLoader.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class TextureLoader_Test : public testing::Test {
+protected:
+    void SetUp() override {
+        m_context = ContextFactory::create();
+        ASSERT_TRUE(m_context->valid());
+    }
+
+    static TextureLoader::DecodeFunction decodePattern(unsigned int size, int seed) {
+        return [size, seed] (TextureImage& image) {
+            image.width = size;
+            image.height = size;
+            image.format = PixelFormat::RGBA8;
+            image.pixels.resize(size * size * 4);
+            for (std::size_t i = 0; i < image.pixels.size(); ++i) {
+                image.pixels[i] = static_cast<unsigned char>(i * 3 + seed);
+            }
+            return true;
+        };
+    }
+
+    std::vector<unsigned char> contents(const LoadedTexture& texture) {
+        const auto& gl = m_context->functions();
+        gl::GLuint framebuffer = 0;
+        gl.GenFramebuffers(1, &framebuffer);
+        gl.BindFramebuffer(gl::FRAMEBUFFER, framebuffer);
+        gl.FramebufferTexture2D(gl::FRAMEBUFFER, gl::COLOR_ATTACHMENT0, gl::TEXTURE_2D, texture.texture, 0);
+
+        std::vector<unsigned char> pixels(texture.width * texture.height * 4);
+        gl.ReadPixels(0, 0, static_cast<gl::GLsizei>(texture.width), static_cast<gl::GLsizei>(texture.height), gl::RGBA, gl::UNSIGNED_BYTE, pixels.data());
+
+        gl.BindFramebuffer(gl::FRAMEBUFFER, 0);
+        gl.DeleteFramebuffers(1, &framebuffer);
+        return pixels;
+    }
+
+    std::unique_ptr<Context> m_context;
+};
+
+
+TEST_F(TextureLoader_Test, Load) {
+    TextureLoader loader(m_context.get(), 2);
+
+    std::vector<TextureLoader::Handle> handles;
+    for (auto i = 0; i < 6; ++i) {
+        handles.push_back(loader.load(decodePattern(16 + i, i)));
+    }
+
+    ASSERT_TRUE(m_context->makeCurrent());
+    for (std::size_t i = 0; i < handles.size(); ++i) {
+        ASSERT_EQ(TextureLoader::State::READY, loader.wait(handles[i])) << loader.lastErrorMessage();
+        const auto texture = loader.take(handles[i]);
+        ASSERT_NE(0u, texture.texture);
+        EXPECT_EQ(16u + i, texture.width);
+
+        TextureImage expected;
+        decodePattern(16 + static_cast<unsigned int>(i), static_cast<int>(i))(expected);
+        EXPECT_EQ(expected.pixels, contents(texture));
+
+        m_context->functions().DeleteTextures(1, &texture.texture);
+        EXPECT_EQ(TextureLoader::State::UNKNOWN, loader.state(handles[i]));
+    }
+    EXPECT_EQ(0u, loader.pendingCount());
+    m_context->doneCurrent();
+}
+
+
+TEST_F(TextureLoader_Test, Priority) {
+    TextureLoader loader(m_context.get(), 1);
+
+    // occupy the only decode thread, so the following requests queue up
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    const auto blocker = loader.load([released] (TextureImage& image) {
+        released.wait();
+        return decodePattern(4, 0)(image);
+    });
+
+    std::mutex mutex;
+    std::vector<int> order;
+    const auto record = [&mutex, &order] (int index) {
+        return [&mutex, &order, index] (TextureImage& image) {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(index);
+            return decodePattern(4, index)(image);
+        };
+    };
+
+    const auto low = loader.load(record(0), TextureLoader::Priority::LOW);
+    const auto normal = loader.load(record(1));
+    const auto high = loader.load(record(2), TextureLoader::Priority::HIGH);
+    release.set_value();
+
+    EXPECT_EQ(TextureLoader::State::READY, loader.wait(blocker));
+    EXPECT_EQ(TextureLoader::State::READY, loader.wait(low));
+    EXPECT_EQ(TextureLoader::State::READY, loader.wait(normal));
+    EXPECT_EQ(TextureLoader::State::READY, loader.wait(high));
+    EXPECT_EQ(std::vector<int>({ 2, 1, 0 }), order);
+}
+
+
+TEST_F(TextureLoader_Test, Cancel) {
+    TextureLoader loader(m_context.get(), 1);
+
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    const auto blocker = loader.load([released] (TextureImage& image) {
+        released.wait();
+        return decodePattern(4, 0)(image);
+    });
+
+    auto decoded = false;
+    const auto canceled = loader.load([&decoded] (TextureImage& image) {
+        decoded = true;
+        return decodePattern(4, 1)(image);
+    });
+    EXPECT_EQ(TextureLoader::State::QUEUED, loader.state(canceled));
+    EXPECT_TRUE(loader.cancel(canceled));
+    EXPECT_FALSE(loader.cancel(canceled));
+    EXPECT_EQ(TextureLoader::State::UNKNOWN, loader.state(canceled));
+
+    release.set_value();
+    ASSERT_EQ(TextureLoader::State::READY, loader.wait(blocker));
+    EXPECT_FALSE(decoded);
+
+    // canceling a finished request deletes its texture
+    EXPECT_TRUE(loader.cancel(blocker));
+    EXPECT_EQ(0u, loader.take(blocker).texture);
+}
+
+
+TEST_F(TextureLoader_Test, DecodeFailure) {
+    TextureLoader loader(m_context.get(), 1);
+
+    const auto failing = loader.load([] (TextureImage&) {
+        return false;
+    });
+    const auto planar = loader.load([] (TextureImage& image) {
+        image.width = 4;
+        image.height = 4;
+        image.format = PixelFormat::I420;
+        image.pixels.resize(24);
+        return true;
+    });
+
+    EXPECT_EQ(TextureLoader::State::FAILED, loader.wait(failing));
+    EXPECT_EQ(TextureLoader::State::FAILED, loader.wait(planar));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), loader.lastErrorCode());
+    EXPECT_EQ(0u, loader.take(failing).texture);
+    EXPECT_EQ(TextureLoader::State::UNKNOWN, loader.state(failing));
+}
@@ -0,0 +1,140 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/TiledRenderer.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class TiledRenderer_Test : public testing::Test {
+protected:
+    // encodes the tile position in the red and green channel
+    static void renderTile(const Tile& tile) {
+        const auto context = ContextFactory::getCurrent();
+        const auto& gl = context->functions();
+        gl.ClearColor(tile.column / 255.0f, tile.row / 255.0f, 0.0f, 1.0f);
+        gl.Clear(gl::COLOR_BUFFER_BIT);
+    }
+
+    static const unsigned int k_width = 10;
+    static const unsigned int k_height = 7;
+    static const unsigned int k_tileSize = 4;
+};
+
+
+TEST_F(TiledRenderer_Test, Render) {
+    auto context = ContextFactory::create();
+    ASSERT_TRUE(context->valid());
+
+    TiledRenderer renderer(context.get());
+    renderer.setTileSize(k_tileSize);
+    renderer.setThreadCount(3);
+
+    std::vector<unsigned char> image(imageSize(PixelFormat::RGB8, k_width, k_height));
+    auto tiles = 0u;
+    const auto success = renderer.render(k_width, k_height, PixelFormat::RGB8, &TiledRenderer_Test::renderTile, [&] (const Tile& tile, const unsigned char* pixels) {
+        const auto top = tile.imageHeight - tile.y - tile.height;
+        for (auto row = 0u; row < tile.height; ++row) {
+            std::copy(pixels + row * tile.width * 3, pixels + (row + 1) * tile.width * 3, image.begin() + ((top + row) * k_width + tile.x) * 3);
+        }
+        ++tiles;
+    });
+
+    ASSERT_TRUE(success);
+    EXPECT_FALSE(renderer.lastErrorCode());
+    EXPECT_EQ(6u, tiles);
+
+    for (auto y = 0u; y < k_height; ++y) {
+        for (auto x = 0u; x < k_width; ++x) {
+            EXPECT_EQ(x / k_tileSize, image[(y * k_width + x) * 3]);
+            EXPECT_EQ(y / k_tileSize, image[(y * k_width + x) * 3 + 1]);
+        }
+    }
+}
+
+
+TEST_F(TiledRenderer_Test, RenderToFile) {
+    auto context = ContextFactory::create();
+    ASSERT_TRUE(context->valid());
+
+    TiledRenderer renderer(context.get());
+    renderer.setTileSize(k_tileSize);
+    renderer.setThreadCount(2);
+
+    const auto path = std::string("tiled-renderer_test.raw");
+    ASSERT_TRUE(renderer.renderToFile(k_width, k_height, PixelFormat::RGBA8, &TiledRenderer_Test::renderTile, path));
+
+    std::ifstream file(path, std::ios::binary);
+    const auto image = std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    file.close();
+    std::remove(path.c_str());
+
+    ASSERT_EQ(imageSize(PixelFormat::RGBA8, k_width, k_height), image.size());
+    EXPECT_EQ(0, image[0]);
+    EXPECT_EQ(2, image[(k_width - 1) * 4]);
+    EXPECT_EQ(1, image[(k_height - 1) * k_width * 4 + 1]);
+    EXPECT_EQ(255, image.back());
+}
+
+
+TEST_F(TiledRenderer_Test, InvalidFormat) {
+    auto context = ContextFactory::create();
+    ASSERT_TRUE(context->valid());
+
+    TiledRenderer renderer(context.get());
+    EXPECT_FALSE(renderer.render(k_width, k_height, PixelFormat::NV12, &TiledRenderer_Test::renderTile, [] (const Tile&, const unsigned char*) {}));
+    EXPECT_EQ(static_cast<int>(Error::INVALID_ARGUMENT), renderer.lastErrorCode().value());
+}
+
+
+TEST_F(TiledRenderer_Test, CallbackThrows) {
+    auto context = ContextFactory::create();
+    ASSERT_TRUE(context->valid());
+
+    TiledRenderer renderer(context.get());
+    renderer.setTileSize(k_tileSize);
+    renderer.setThreadCount(3);
+    EXPECT_FALSE(renderer.render(k_width, k_height, PixelFormat::RGBA8, [] (const Tile& tile) {
+        if (tile.row == 1) {
+            throw std::runtime_error("render failed");
+        }
+        renderTile(tile);
+    }, [] (const Tile&, const unsigned char*) {}));
+    EXPECT_EQ(static_cast<int>(Error::INVALID_ARGUMENT), renderer.lastErrorCode().value());
+    EXPECT_THAT(renderer.lastErrorMessage(), testing::HasSubstr("render failed"));
+
+    EXPECT_FALSE(renderer.render(k_width, k_height, PixelFormat::RGBA8, &TiledRenderer_Test::renderTile, [] (const Tile&, const unsigned char*) {
+        throw 1;
+    }));
+    EXPECT_EQ(static_cast<int>(Error::INVALID_ARGUMENT), renderer.lastErrorCode().value());
+}
+
+
+TEST_F(TiledRenderer_Test, InvalidArgumentsKeepFile) {
+    auto context = ContextFactory::create();
+    ASSERT_TRUE(context->valid());
+
+    const auto path = std::string("tiled-renderer_test.keep");
+    std::ofstream(path) << "existing";
+
+    TiledRenderer renderer(context.get());
+    EXPECT_FALSE(renderer.renderToFile(k_width, k_height, PixelFormat::NV12, &TiledRenderer_Test::renderTile, path));
+    EXPECT_FALSE(renderer.renderToFile(0, k_height, PixelFormat::RGBA8, &TiledRenderer_Test::renderTile, path));
+
+    std::ifstream file(path);
+    const auto contents = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    file.close();
+    std::remove(path.c_str());
+    EXPECT_EQ("existing", contents);
+}
@@ -0,0 +1,162 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/error.h>
+#include <glheadless/Timeline.h>
+
+
+using namespace glheadless;
+
+
+class Timeline_Test : public testing::Test {
+protected:
+    void TearDown() override {
+        std::remove(k_path);
+    }
+
+    static std::string read() {
+        std::ifstream file(k_path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // event lines containing all parts
+    static std::vector<std::string> events(const std::string& text, const std::vector<std::string>& parts) {
+        std::vector<std::string> result;
+        std::size_t start = 0;
+        while (start < text.size()) {
+            auto end = text.find('\n', start);
+            end = end == std::string::npos ? text.size() : end;
+            const auto line = text.substr(start, end - start);
+            auto matches = true;
+            for (const auto& part : parts) {
+                matches = matches && line.find(part) != std::string::npos;
+            }
+            if (matches) {
+                result.push_back(line);
+            }
+            start = end + 1;
+        }
+        return result;
+    }
+
+    static std::string contextName(const Context* context) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), " 0x%llx", static_cast<unsigned long long>(reinterpret_cast<std::uintptr_t>(context)));
+        return buffer;
+    }
+
+    static const char* const k_path;
+};
+
+
+const char* const Timeline_Test::k_path = "timeline_test.json";
+
+
+TEST_F(Timeline_Test, Record) {
+    TimelineRecorder recorder;
+    ASSERT_TRUE(recorder.start(k_path)) << recorder.lastErrorMessage();
+    EXPECT_TRUE(recorder.active());
+
+    std::string name;
+    std::string workerName;
+    {
+        auto context = ContextFactory::create();
+        ASSERT_TRUE(context->valid());
+        name = contextName(context.get());
+        ASSERT_TRUE(context->makeCurrent());
+        {
+            TimelineSpan span("frame \"1\"");
+        }
+        ASSERT_TRUE(context->doneCurrent());
+
+        std::thread worker([&workerName] {
+            auto context = ContextFactory::create();
+            workerName = contextName(context.get());
+            context->makeCurrent();
+            beginTimelineSpan("job");
+            endTimelineSpan();
+
+            // destroying the context ends the span of the context being current
+        });
+        worker.join();
+    }
+    ASSERT_TRUE(recorder.stop()) << recorder.lastErrorMessage();
+    EXPECT_FALSE(recorder.active());
+    EXPECT_EQ(0u, recorder.droppedCount());
+
+    const auto text = read();
+    ASSERT_GE(text.size(), 4u);
+    EXPECT_EQ("[\n", text.substr(0, 2));
+    EXPECT_EQ("\n]\n", text.substr(text.size() - 3));
+
+    EXPECT_EQ(1u, events(text, { "\"ph\":\"X\"", "\"name\":\"create" + name + "\"", "\"dur\":" }).size());
+    EXPECT_EQ(1u, events(text, { "\"ph\":\"X\"", "\"name\":\"current" + name + "\"" }).size());
+    EXPECT_EQ(1u, events(text, { "\"ph\":\"X\"", "\"name\":\"destroy" + name + "\"" }).size());
+    EXPECT_EQ(1u, events(text, { "\"ph\":\"B\"", "\"name\":\"frame \\\"1\\\"\"", "\"tid\":" }).size());
+
+    const auto current = events(text, { "\"name\":\"current" + workerName + "\"" });
+    ASSERT_EQ(1u, current.size());
+    const auto job = events(text, { "\"ph\":\"B\"", "\"name\":\"job\"" });
+    ASSERT_EQ(1u, job.size());
+    EXPECT_EQ(2u, events(text, { "\"ph\":\"E\"" }).size());
+
+    // the worker's events are on a timeline of their own
+    const auto tid = [] (const std::string& line) {
+        const auto start = line.find("\"tid\":");
+        return line.substr(start, line.find(',', start) - start);
+    };
+    EXPECT_EQ(tid(current[0]), tid(job[0]));
+    EXPECT_NE(tid(current[0]), tid(events(text, { "\"name\":\"current" + name + "\"" })[0]));
+}
+
+
+TEST_F(Timeline_Test, DropWhenFull) {
+    TimelineRecorder recorder;
+    ASSERT_TRUE(recorder.start(k_path, 2));
+    const auto count = 1000u;
+    for (auto i = 0u; i < count; ++i) {
+        beginTimelineSpan("span");
+        endTimelineSpan();
+    }
+    ASSERT_TRUE(recorder.stop());
+
+    const auto text = read();
+    const auto written = events(text, { "\"ph\":\"B\"" }).size() + events(text, { "\"ph\":\"E\"" }).size();
+    EXPECT_GT(recorder.droppedCount(), 0u);
+    EXPECT_EQ(2 * count, written + recorder.droppedCount());
+}
+
+
+TEST_F(Timeline_Test, Errors) {
+    TimelineRecorder recorder;
+    EXPECT_FALSE(recorder.stop());
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), recorder.lastErrorCode());
+
+    EXPECT_FALSE(recorder.start("no/such/directory/timeline.json"));
+    EXPECT_FALSE(recorder.active());
+
+    // one timeline at a time
+    ASSERT_TRUE(recorder.start(k_path));
+    TimelineRecorder other;
+    EXPECT_FALSE(other.start("timeline_test_other.json"));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), other.lastErrorCode());
+
+    // spans are not recorded once stopped
+    ASSERT_TRUE(recorder.stop());
+    {
+        TimelineSpan span("after");
+    }
+    EXPECT_EQ(std::string::npos, read().find("after"));
+
+    ASSERT_TRUE(other.start("timeline_test_other.json"));
+    ASSERT_TRUE(other.stop());
+    std::remove("timeline_test_other.json");
+}
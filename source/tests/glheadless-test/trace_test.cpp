@@ -0,0 +1,219 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/error.h>
+#include <glheadless/TracePlayer.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+
+
+class Trace_Test : public testing::Test {
+protected:
+    void TearDown() override {
+        std::remove(k_path);
+    }
+
+    static std::unique_ptr<Context> createContext() {
+        auto context = ContextFactory::create();
+        EXPECT_TRUE(context->valid());
+        EXPECT_TRUE(context->makeCurrent());
+        return context;
+    }
+
+    static gl::GLuint compile(const gl::Functions& gl, gl::GLenum type, const char* source) {
+        const auto shader = gl.CreateShader(type);
+        gl.ShaderSource(shader, 1, &source, nullptr);
+        gl.CompileShader(shader);
+        return shader;
+    }
+
+    // draws the lower left half of a 4x4 texture with pixel data over it, leaving the framebuffer bound
+    static std::vector<unsigned char> render(const gl::Functions& gl) {
+        std::vector<unsigned char> pattern(4 * 4 * 4);
+        for (std::size_t i = 0; i < pattern.size(); ++i) {
+            pattern[i] = static_cast<unsigned char>(i * 7);
+        }
+
+        gl::GLuint texture = 0;
+        gl.GenTextures(1, &texture);
+        gl.BindTexture(gl::TEXTURE_2D, texture);
+        gl.TexImage2D(gl::TEXTURE_2D, 0, gl::RGBA8, 4, 4, 0, gl::RGBA, gl::UNSIGNED_BYTE, pattern.data());
+        gl::GLuint framebuffer = 0;
+        gl.GenFramebuffers(1, &framebuffer);
+        gl.BindFramebuffer(gl::FRAMEBUFFER, framebuffer);
+        gl.FramebufferTexture2D(gl::FRAMEBUFFER, gl::COLOR_ATTACHMENT0, gl::TEXTURE_2D, texture, 0);
+        gl.Viewport(0, 0, 4, 4);
+
+        const float vertices[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f };
+        gl::GLuint vertexArray = 0;
+        gl.GenVertexArrays(1, &vertexArray);
+        gl.BindVertexArray(vertexArray);
+        gl::GLuint buffer = 0;
+        gl.GenBuffers(1, &buffer);
+        gl.BindBuffer(gl::ARRAY_BUFFER, buffer);
+        gl.BufferData(gl::ARRAY_BUFFER, sizeof(vertices), nullptr, gl::STATIC_DRAW);
+        const auto mapped = gl.MapBufferRange(gl::ARRAY_BUFFER, 0, sizeof(vertices), gl::MAP_WRITE_BIT | gl::MAP_INVALIDATE_BUFFER_BIT);
+        std::memcpy(mapped, vertices, sizeof(vertices));
+        gl.UnmapBuffer(gl::ARRAY_BUFFER);
+        gl.VertexAttribPointer(0, 2, gl::FLOAT, 0, 0, nullptr);
+        gl.EnableVertexAttribArray(0);
+
+        const auto program = gl.CreateProgram();
+        const auto vertexShader = compile(gl, gl::VERTEX_SHADER, "#version 330\nlayout(location = 0) in vec2 position;\nvoid main() {\n    gl_Position = vec4(position, 0.0, 1.0);\n}\n");
+        const auto fragmentShader = compile(gl, gl::FRAGMENT_SHADER, "#version 330\nuniform vec4 color;\nout vec4 fragColor;\nvoid main() {\n    fragColor = color;\n}\n");
+        gl.AttachShader(program, vertexShader);
+        gl.AttachShader(program, fragmentShader);
+        gl.LinkProgram(program);
+        gl.DeleteShader(vertexShader);
+        gl.DeleteShader(fragmentShader);
+        gl.UseProgram(program);
+        gl.Uniform4f(gl.GetUniformLocation(program, "color"), 0.0f, 1.0f, 0.0f, 1.0f);
+        gl.DrawArrays(gl::TRIANGLES, 0, 3);
+
+        return pixels(gl);
+    }
+
+    static std::vector<unsigned char> pixels(const gl::Functions& gl) {
+        std::vector<unsigned char> data(4 * 4 * 4);
+        gl.ReadPixels(0, 0, 4, 4, gl::RGBA, gl::UNSIGNED_BYTE, data.data());
+        return data;
+    }
+
+    static const char* const k_path;
+};
+
+
+const char* const Trace_Test::k_path = "trace_test.trace";
+
+
+TEST_F(Trace_Test, RecordAndReplay) {
+    std::vector<unsigned char> recorded;
+    {
+        auto context = createContext();
+        ASSERT_TRUE(context->startTrace(k_path)) << context->lastErrorMessage();
+        EXPECT_TRUE(context->tracing());
+        recorded = render(context->functions());
+        EXPECT_EQ(0u, context->functions().GetError());
+        ASSERT_TRUE(context->stopTrace()) << context->lastErrorMessage();
+        EXPECT_FALSE(context->tracing());
+        context->doneCurrent();
+    }
+
+    // the draw covered the lower left pixel, the pattern uploaded with the texture is left in the upper right
+    EXPECT_THAT(std::vector<unsigned char>(recorded.begin(), recorded.begin() + 4), testing::ElementsAre(0, 255, 0, 255));
+    EXPECT_THAT(std::vector<unsigned char>(recorded.end() - 4, recorded.end()), testing::ElementsAre(60 * 7 % 256, 61 * 7 % 256, 62 * 7 % 256, 63 * 7 % 256));
+
+    TracePlayer player;
+    ASSERT_TRUE(player.open(k_path)) << player.lastErrorMessage();
+    EXPECT_EQ(34u, player.callCount());
+
+    // the replay creates its own objects in a fresh context and leaves the framebuffer bound
+    auto context = createContext();
+    TraceTimings timings;
+    ASSERT_TRUE(player.play(context.get(), timings)) << player.lastErrorMessage();
+    EXPECT_EQ(player.callCount(), timings.callCount);
+    EXPECT_GT(timings.milliseconds, 0.0);
+    EXPECT_TRUE(timings.functions.empty());
+    EXPECT_EQ(recorded, pixels(context->functions()));
+    context->doneCurrent();
+    context.reset();
+
+    context = createContext();
+    ASSERT_TRUE(player.play(context.get(), timings, true)) << player.lastErrorMessage();
+    EXPECT_EQ(recorded, pixels(context->functions()));
+    std::uint64_t callCount = 0;
+    auto drawCount = 0u;
+    for (const auto& function : timings.functions) {
+        callCount += function.callCount;
+        if (function.name == "glDrawArrays") {
+            drawCount = static_cast<unsigned int>(function.callCount);
+        }
+    }
+    EXPECT_EQ(timings.callCount, callCount);
+    EXPECT_EQ(1u, drawCount);
+    context->doneCurrent();
+}
+
+
+TEST_F(Trace_Test, StateCacheFiltersFirst) {
+    auto context = createContext();
+    context->setStateCacheEnabled(true);
+    ASSERT_TRUE(context->startTrace(k_path));
+    const auto& gl = context->functions();
+    gl.Enable(gl::BLEND);
+    gl.Enable(gl::BLEND);
+
+    // entry points resolved by the application are recorded as well
+    const auto disable = reinterpret_cast<gl::Proc<void(gl::GLenum)>::Type>(context->getProcAddress("glDisable"));
+    disable(gl::BLEND);
+    ASSERT_TRUE(context->stopTrace());
+    EXPECT_FALSE(context->stopTrace());
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), context->lastErrorCode());
+
+    // after stopping, the kept entry point passes calls on without recording them
+    disable(gl::BLEND);
+    EXPECT_EQ(0, gl.IsEnabled(gl::BLEND));
+    context->setStateCacheEnabled(false);
+    context->doneCurrent();
+
+    TracePlayer player;
+    ASSERT_TRUE(player.open(k_path));
+    EXPECT_EQ(2u, player.callCount());
+}
+
+
+TEST_F(Trace_Test, StoppedTraceFallsBackPerContext) {
+    auto traced = createContext();
+    ASSERT_TRUE(traced->startTrace(k_path));
+    const auto disable = reinterpret_cast<gl::Proc<void(gl::GLenum)>::Type>(traced->getProcAddress("glDisable"));
+    ASSERT_TRUE(traced->stopTrace());
+
+    // the kept entry point passes calls on to the entry points of its context, which is made current with them
+    auto other = createContext();
+    other->doneCurrent();
+    ASSERT_TRUE(traced->makeCurrent());
+    const auto& gl = traced->functions();
+    gl.Enable(gl::BLEND);
+    disable(gl::BLEND);
+    EXPECT_EQ(0, gl.IsEnabled(gl::BLEND));
+    traced->doneCurrent();
+}
+
+
+TEST_F(Trace_Test, Errors) {
+    auto context = createContext();
+    ASSERT_TRUE(context->startTrace(k_path));
+    EXPECT_FALSE(context->startTrace(k_path));
+    EXPECT_TRUE(context->stopTrace());
+    EXPECT_FALSE(context->startTrace("no-such-directory/trace_test.trace"));
+    EXPECT_FALSE(context->tracing());
+    context->doneCurrent();
+
+    TracePlayer player;
+    TraceTimings timings;
+    EXPECT_FALSE(player.play(context.get(), timings));
+    EXPECT_FALSE(player.open("no-such-file.trace"));
+    EXPECT_EQ(make_error_code(Error::INVALID_ARGUMENT), player.lastErrorCode());
+
+    std::ofstream(k_path, std::ios::binary) << "GLHTRACX and more";
+    EXPECT_FALSE(player.open(k_path));
+    EXPECT_FALSE(player.isOpen());
+
+    // a trace without calls is valid
+    ASSERT_TRUE(context->makeCurrent());
+    ASSERT_TRUE(context->startTrace(k_path));
+    ASSERT_TRUE(context->stopTrace());
+    context->doneCurrent();
+    ASSERT_TRUE(player.open(k_path)) << player.lastErrorMessage();
+    EXPECT_EQ(0u, player.callCount());
+}
@@ -0,0 +1,573 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/PixelOperations.h>
+#include <glheadless/ShaderCompiler.h>
+
+
+using namespace glheadless;
+
+
+namespace {
+
+
+#ifdef _WIN32
+#define BENCH_APIENTRY __stdcall
+#else
+#define BENCH_APIENTRY
+#endif
+
+using GetStringFunction = const unsigned char* (BENCH_APIENTRY*)(unsigned int name);
+using IsEnabledFunction = unsigned char (BENCH_APIENTRY*)(unsigned int capability);
+using DeleteProgramFunction = void (BENCH_APIENTRY*)(unsigned int program);
+
+const unsigned int k_renderer = 0x1F01;
+const unsigned int k_version  = 0x1F02;
+const unsigned int k_blend    = 0x0BE2;
+
+// calls of an entry point per sample of gl_call, as a single call is too short for the clock
+const std::size_t k_callsPerSample = 1000;
+
+// image of the pixel kernel benchmarks, and at most as many samples, as each pass takes milliseconds
+const std::size_t k_imageWidth = 1920;
+const std::size_t k_imageHeight = 1080;
+const std::size_t k_maxPixelIterations = 20;
+
+// programs per sample of shader_warm_up, and at most as many samples, as compiling takes milliseconds
+const std::size_t k_programsPerSample = 16;
+const std::size_t k_maxWarmUpIterations = 20;
+
+const char* const k_vertexSource = R"(
+#version 330
+void main() {
+    gl_Position = vec4(float(gl_VertexID % 2), float(gl_VertexID / 2), 0.0, 1.0);
+}
+)";
+
+// looked up in turn by get_proc_address; core and extension functions, as drivers resolve them differently
+const char* const k_procNames[] = {
+    "glClear", "glClearColor", "glViewport", "glGetString", "glGetIntegerv", "glDrawArrays", "glBindBuffer",
+    "glBufferData", "glBindTexture", "glTexImage2D", "glUseProgram", "glUniform4f", "glBindFramebuffer",
+    "glDebugMessageCallback", "glQueryCounter", "glBufferStorage"
+};
+const std::size_t k_procNameCount = sizeof(k_procNames) / sizeof(k_procNames[0]);
+
+
+using Clock = std::chrono::steady_clock;
+
+
+struct Result {
+    std::string name;
+    std::size_t iterations = 0;
+    double      minNs = 0;
+    double      medianNs = 0;
+    double      p90Ns = 0;
+    double      maxNs = 0;
+    double      meanNs = 0;
+    double      pixelsPerSecond = 0; //!< median throughput of the pixel kernels, 0 for other benchmarks
+};
+
+
+struct Options {
+    std::size_t iterations = 200;
+    std::size_t warmup = 10;
+    std::string filter;
+    std::string output;
+    std::string baseline;
+    double      threshold = 10.0;
+};
+
+
+void printUsage() {
+    std::cerr << "Usage: glheadless-bench [options]" << std::endl
+              << "       glheadless-bench --compare <baseline> <results> [--threshold <percent>]" << std::endl
+              << std::endl
+              << "Measures the context lifecycle of the compiled backend and the CPU pixel kernels per instruction set" << std::endl
+              << "and writes the results as JSON. Run it against Mesa llvmpipe, e.g., with EGL_PLATFORM=surfaceless" << std::endl
+              << "(EGL builds) or under Xvfb (GLX builds), for comparable numbers. With a baseline, benchmarks whose median is slower by more than the" << std::endl
+              << "threshold are reported as regressions and the exit code is 1." << std::endl
+              << std::endl
+              << "Options:" << std::endl
+              << "  --iterations <n>       measured iterations per benchmark, default: 200" << std::endl
+              << "  --warmup <n>           unmeasured iterations before, default: 10" << std::endl
+              << "  --filter <text>        only run benchmarks whose name contains the text" << std::endl
+              << "  --output <file>        write the JSON to the file instead of stdout" << std::endl
+              << "  --baseline <file>      compare the results to a file written before" << std::endl
+              << "  --threshold <percent>  allowed slowdown of the median, default: 10" << std::endl;
+}
+
+
+const char* backendName() {
+#if defined(GLHEADLESS_BENCH_BACKEND)
+    return GLHEADLESS_BENCH_BACKEND;
+#else
+    return "unknown";
+#endif
+}
+
+
+bool fail(const Context& context) {
+    std::cerr << context.lastErrorCode().message() << ": " << context.lastErrorMessage() << std::endl;
+    return false;
+}
+
+
+// nearest-rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double fraction) {
+    const auto rank = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+
+/*
+ * Runs a benchmark. Each call of the body is one sample, which may consist of several operations, e.g., lookups; the
+ * reported times are per operation. The body returns false on errors, which end the benchmark.
+ */
+bool run(const Options& options, const std::string& name, std::size_t operationsPerSample, const std::function<bool()>& body, std::vector<Result>& results) {
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos) {
+        return true;
+    }
+
+    for (std::size_t i = 0; i < options.warmup; ++i) {
+        if (!body()) {
+            return false;
+        }
+    }
+
+    std::vector<double> samples;
+    samples.reserve(options.iterations);
+    for (std::size_t i = 0; i < options.iterations; ++i) {
+        const auto start = Clock::now();
+        if (!body()) {
+            return false;
+        }
+        const auto duration = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        samples.push_back(duration / static_cast<double>(operationsPerSample));
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = name;
+    result.iterations = samples.size();
+    if (!samples.empty()) {
+        result.minNs = samples.front();
+        result.medianNs = percentile(samples, 0.5);
+        result.p90Ns = percentile(samples, 0.9);
+        result.maxNs = samples.back();
+        for (const auto sample : samples) {
+            result.meanNs += sample;
+        }
+        result.meanNs /= static_cast<double>(samples.size());
+    }
+    results.push_back(result);
+    return true;
+}
+
+
+std::string quote(const std::string& text) {
+    std::string quoted = "\"";
+    for (const auto c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+
+void writeJson(std::ostream& stream, const std::string& renderer, const std::string& version, const std::vector<Result>& results) {
+    stream << std::fixed << std::setprecision(1);
+    stream << "{" << std::endl
+           << "  \"backend\": " << quote(backendName()) << "," << std::endl
+           << "  \"renderer\": " << quote(renderer) << "," << std::endl
+           << "  \"version\": " << quote(version) << "," << std::endl
+           << "  \"benchmarks\": [" << std::endl;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& result = results[i];
+        stream << "    { \"name\": " << quote(result.name)
+               << ", \"iterations\": " << result.iterations
+               << ", \"min_ns\": " << result.minNs
+               << ", \"median_ns\": " << result.medianNs
+               << ", \"p90_ns\": " << result.p90Ns
+               << ", \"max_ns\": " << result.maxNs
+               << ", \"mean_ns\": " << result.meanNs;
+        if (result.pixelsPerSecond > 0) {
+            stream << ", \"pixels_per_second\": " << result.pixelsPerSecond;
+        }
+        stream
+               << " }" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    stream << "  ]" << std::endl
+           << "}" << std::endl;
+}
+
+
+// value of a string or number field of the object starting at begin; reads the files written by writeJson() only
+std::string field(const std::string& json, std::size_t begin, std::size_t end, const std::string& key) {
+    const auto position = json.find("\"" + key + "\"", begin);
+    if (position == std::string::npos || position >= end) {
+        return std::string();
+    }
+
+    auto value = json.find(':', position);
+    value = json.find_first_not_of(" \t\r\n", value + 1);
+    if (value >= end) {
+        return std::string();
+    }
+    if (json[value] == '"') {
+        const auto close = json.find('"', value + 1);
+        return json.substr(value + 1, close - value - 1);
+    }
+    const auto close = json.find_first_of(",} \t\r\n", value);
+    return json.substr(value, close - value);
+}
+
+
+bool readJson(const std::string& path, std::vector<Result>& results, std::string& backend) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Cannot read " << path << std::endl;
+        return false;
+    }
+    const std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    backend = field(json, 0, json.size(), "backend");
+    auto position = json.find("\"benchmarks\"");
+    if (position == std::string::npos) {
+        std::cerr << path << " contains no benchmarks" << std::endl;
+        return false;
+    }
+
+    while ((position = json.find('{', position)) != std::string::npos) {
+        const auto end = json.find('}', position);
+        Result result;
+        result.name = field(json, position, end, "name");
+        result.medianNs = std::atof(field(json, position, end, "median_ns").c_str());
+        if (!result.name.empty()) {
+            results.push_back(result);
+        }
+        position = end;
+    }
+    return true;
+}
+
+
+// returns the number of regressions
+std::size_t compare(std::ostream& stream, const std::vector<Result>& baseline, const std::string& baselineBackend, const std::vector<Result>& results, const std::string& resultsBackend, double threshold) {
+    if (baselineBackend != resultsBackend) {
+        stream << "warning: comparing backend " << resultsBackend << " to a baseline of " << baselineBackend << std::endl;
+    }
+
+    std::size_t regressions = 0;
+    stream << std::fixed << std::setprecision(1);
+    for (const auto& result : results) {
+        const auto match = std::find_if(baseline.begin(), baseline.end(), [&result](const Result& candidate) {
+            return candidate.name == result.name;
+        });
+        if (match == baseline.end() || match->medianNs <= 0) {
+            stream << std::left << std::setw(28) << result.name << "  not in baseline" << std::endl;
+            continue;
+        }
+
+        const auto change = (result.medianNs / match->medianNs - 1.0) * 100.0;
+        const auto regression = change > threshold;
+        regressions += regression ? 1 : 0;
+        stream << std::left << std::setw(28) << result.name
+               << std::right << std::setw(12) << match->medianNs << " ns"
+               << std::setw(12) << result.medianNs << " ns"
+               << std::showpos << std::setw(9) << change << "%" << std::noshowpos
+               << (regression ? "  REGRESSION" : "") << std::endl;
+    }
+    for (const auto& entry : baseline) {
+        const auto match = std::find_if(results.begin(), results.end(), [&entry](const Result& candidate) {
+            return candidate.name == entry.name;
+        });
+        if (match == results.end()) {
+            stream << std::left << std::setw(28) << entry.name << "  missing in results" << std::endl;
+        }
+    }
+    return regressions;
+}
+
+
+/*
+ * Compiles batches of programs with one worker and with the default number of workers, so the scaling of the warm-up
+ * shows in the ratio of the two; each program is distinct, so drivers cannot serve them from their caches.
+ */
+bool warmUpShaders(const Options& options, Context& main, std::vector<Result>& results) {
+    auto warmUpOptions = options;
+    warmUpOptions.iterations = std::min(options.iterations, k_maxWarmUpIterations);
+    warmUpOptions.warmup = std::min<std::size_t>(options.warmup, 1);
+
+    ShaderCompiler serial(&main, 1);
+    ShaderCompiler parallel(&main);
+    if (!main.makeCurrent()) {
+        return fail(main);
+    }
+    const auto deleteProgram = reinterpret_cast<DeleteProgramFunction>(main.getProcAddress("glDeleteProgram"));
+
+    auto index = 0;
+    const auto batch = [&index, deleteProgram](ShaderCompiler& compiler) {
+        return [&index, &compiler, deleteProgram] {
+            std::vector<std::future<CompileResult>> futures;
+            for (std::size_t i = 0; i < k_programsPerSample; ++i, ++index) {
+                const auto fragmentSource = "#version 330\nout vec4 fragColor;\nvoid main() {\n    fragColor = vec4(" + std::to_string(index) + ".0);\n}\n";
+                futures.push_back(compiler.compile(k_vertexSource, fragmentSource));
+            }
+
+            auto success = true;
+            for (auto& future : futures) {
+                const auto result = future.get();
+                if (result.errorCode) {
+                    std::cerr << result.errorCode.message() << ": " << result.errorMessage << std::endl;
+                    success = false;
+                }
+                deleteProgram(result.program);
+            }
+            return success;
+        };
+    };
+
+    auto success = deleteProgram != nullptr;
+    success = success && run(warmUpOptions, "shader_warm_up_serial", k_programsPerSample, batch(serial), results);
+    success = success && run(warmUpOptions, "shader_warm_up_parallel", k_programsPerSample, batch(parallel), results);
+    main.doneCurrent();
+    return success;
+}
+
+
+const char* instructionSetName(InstructionSet instructionSet) {
+    switch (instructionSet) {
+    case InstructionSet::SSSE3:
+        return "ssse3";
+    case InstructionSet::AVX2:
+        return "avx2";
+    case InstructionSet::NEON:
+        return "neon";
+    default:
+        return "scalar";
+    }
+}
+
+
+// runs the CPU pixel kernels on a full HD RGBA image with each instruction set the build and CPU support
+bool runPixelKernels(const Options& options, std::vector<Result>& results) {
+    auto pixelOptions = options;
+    pixelOptions.iterations = std::min(options.iterations, k_maxPixelIterations);
+    pixelOptions.warmup = std::min<std::size_t>(options.warmup, 1);
+
+    const auto pixels = k_imageWidth * k_imageHeight;
+    std::vector<unsigned char> input(pixels * 4);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<unsigned char>(i * 7 + i / 4);
+    }
+    std::vector<unsigned char> output(input.size());
+
+    const std::pair<const char*, std::function<void()>> kernels[] = {
+        { "flip_rows",     [&] { flipRows(input.data(), output.data(), k_imageWidth * 4, k_imageHeight); } },
+        { "swizzle",       [&] { swizzle(input.data(), output.data(), pixels, {{ 2, 1, 0, 3 }}); } },
+        { "pack_rgb",      [&] { packRGB(input.data(), output.data(), pixels); } },
+        { "premultiply",   [&] { premultiplyAlpha(input.data(), output.data(), pixels); } },
+        { "unpremultiply", [&] { unpremultiplyAlpha(input.data(), output.data(), pixels); } }
+    };
+
+    const auto previous = instructionSet();
+    volatile unsigned int checksum = 0;
+    auto success = true;
+    for (const auto candidate : { InstructionSet::SCALAR, InstructionSet::SSSE3, InstructionSet::AVX2, InstructionSet::NEON }) {
+        if (!setInstructionSet(candidate)) {
+            continue;
+        }
+        for (const auto& kernel : kernels) {
+            const auto name = std::string("pixels_") + kernel.first + "_" + instructionSetName(candidate);
+            const auto count = results.size();
+            success = success && run(pixelOptions, name, pixels, [&kernel, &output, &checksum] {
+                kernel.second();
+                // the output is used, so the pass cannot be optimized away
+                checksum = checksum + output[output.size() / 2];
+                return true;
+            }, results);
+            if (results.size() > count && results.back().medianNs > 0) {
+                results.back().pixelsPerSecond = 1.0e9 / results.back().medianNs;
+            }
+        }
+    }
+    setInstructionSet(previous);
+    return success;
+}
+
+
+bool runAll(const Options& options, std::vector<Result>& results, std::string& renderer, std::string& version) {
+    // the context used by all benchmarks that need one current
+    auto main = ContextFactory::create();
+    if (!main->valid() || !main->makeCurrent()) {
+        return fail(*main);
+    }
+
+    const auto getString = reinterpret_cast<GetStringFunction>(main->getProcAddress("glGetString"));
+    if (getString != nullptr) {
+        const auto rendererString = getString(k_renderer);
+        const auto versionString = getString(k_version);
+        renderer = rendererString != nullptr ? reinterpret_cast<const char*>(rendererString) : "";
+        version = versionString != nullptr ? reinterpret_cast<const char*>(versionString) : "";
+    }
+
+    auto success = run(options, "create_destroy", 1, [] {
+        auto context = ContextFactory::create();
+        return context->valid() || fail(*context);
+    }, results);
+
+    success = success && run(options, "create_shared_destroy", 1, [&main] {
+        auto context = ContextFactory::create(main.get());
+        return context->valid() || fail(*context);
+    }, results);
+
+    // a second context, so that switching between two contexts can be measured
+    auto other = ContextFactory::create(main.get());
+    if (!other->valid()) {
+        return fail(*other);
+    }
+    success = success && run(options, "make_done_current", 1, [&other] {
+        return (other->makeCurrent() && other->doneCurrent()) || fail(*other);
+    }, results);
+    success = success && run(options, "switch_current", 2, [&main, &other] {
+        return (other->makeCurrent() || fail(*other)) && (main->makeCurrent() || fail(*main));
+    }, results);
+    other.reset();
+
+    if (!main->makeCurrent()) {
+        return fail(*main);
+    }
+    success = success && run(options, "get_proc_address", k_procNameCount, [&main] {
+        // the results are used, so the lookups cannot be optimized away
+        std::size_t found = 0;
+        for (const auto name : k_procNames) {
+            found += main->getProcAddress(name) != nullptr ? 1 : 0;
+        }
+        if (found == 0) {
+            std::cerr << "getProcAddress() found no function" << std::endl;
+        }
+        return found > 0;
+    }, results);
+
+    success = success && run(options, "get_current", 1, [] {
+        auto context = ContextFactory::getCurrent();
+        return context->valid() || fail(*context);
+    }, results);
+
+    // a cheap entry point, so the overhead of counting calls dominates
+    const auto isEnabled = reinterpret_cast<IsEnabledFunction>(main->getProcAddress("glIsEnabled"));
+    const auto callLoop = [](IsEnabledFunction function) {
+        return [function] {
+            std::size_t enabled = 0;
+            for (std::size_t i = 0; i < k_callsPerSample; ++i) {
+                enabled += function(k_blend);
+            }
+            return enabled < k_callsPerSample;
+        };
+    };
+    success = success && isEnabled != nullptr && run(options, "gl_call", k_callsPerSample, callLoop(isEnabled), results);
+
+    main->setCallCountingEnabled(true);
+    const auto countedIsEnabled = reinterpret_cast<IsEnabledFunction>(main->getProcAddress("glIsEnabled"));
+    success = success && run(options, "gl_call_counted", k_callsPerSample, callLoop(countedIsEnabled), results);
+    main->setCallCountingEnabled(false);
+
+    // some platforms cannot create the worker contexts while the shared context is current
+    main->doneCurrent();
+    success = success && warmUpShaders(options, *main, results);
+    success = success && runPixelKernels(options, results);
+
+    return success;
+}
+
+
+}  // unnamed namespace
+
+
+int main(int argc, char* argv[]) {
+    Options options;
+    std::vector<std::string> comparePaths;
+
+    for (auto i = 1; i < argc; ++i) {
+        const auto argument = std::string(argv[i]);
+        if (argument == "--iterations" && i + 1 < argc) {
+            options.iterations = static_cast<std::size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (argument == "--warmup" && i + 1 < argc) {
+            options.warmup = static_cast<std::size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (argument == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (argument == "--output" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (argument == "--baseline" && i + 1 < argc) {
+            options.baseline = argv[++i];
+        } else if (argument == "--threshold" && i + 1 < argc) {
+            options.threshold = std::atof(argv[++i]);
+        } else if (argument == "--compare" && i + 2 < argc) {
+            comparePaths.push_back(argv[++i]);
+            comparePaths.push_back(argv[++i]);
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    // comparing two files does not need a context
+    if (!comparePaths.empty()) {
+        std::vector<Result> baseline;
+        std::vector<Result> results;
+        std::string baselineBackend;
+        std::string resultsBackend;
+        if (!readJson(comparePaths[0], baseline, baselineBackend) || !readJson(comparePaths[1], results, resultsBackend)) {
+            return EXIT_FAILURE;
+        }
+        return compare(std::cout, baseline, baselineBackend, results, resultsBackend, options.threshold) > 0 ? 1 : EXIT_SUCCESS;
+    }
+
+    std::vector<Result> results;
+    std::string renderer;
+    std::string version;
+    if (!runAll(options, results, renderer, version)) {
+        return EXIT_FAILURE;
+    }
+
+    if (options.output.empty()) {
+        writeJson(std::cout, renderer, version, results);
+    } else {
+        std::ofstream file(options.output);
+        writeJson(file, renderer, version, results);
+        if (!file) {
+            std::cerr << "Cannot write " << options.output << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (options.baseline.empty()) {
+        return EXIT_SUCCESS;
+    }
+
+    std::vector<Result> baseline;
+    std::string baselineBackend;
+    if (!readJson(options.baseline, baseline, baselineBackend)) {
+        return EXIT_FAILURE;
+    }
+    // the JSON may be on stdout
+    auto& report = options.output.empty() ? std::cerr : std::cout;
+    return compare(report, baseline, baselineBackend, results, backendName(), options.threshold) > 0 ? 1 : EXIT_SUCCESS;
+}
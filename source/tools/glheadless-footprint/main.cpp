@@ -0,0 +1,278 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/MemoryFootprint.h>
+
+
+using namespace glheadless;
+
+
+namespace {
+
+
+struct Options {
+    std::vector<std::string>  formats = { "default", "3.3core", "4.5core" };
+    std::vector<unsigned int> steps = { 1, 2, 4, 8, 16, 32, 64 };
+    std::string               json;
+};
+
+
+void printUsage() {
+    std::cerr << "Usage: glheadless-footprint [options]" << std::endl
+              << std::endl
+              << "Creates contexts in steps, standalone and shared with the first one, and reports the RSS and PSS" << std::endl
+              << "of the process from /proc/self/smaps_rollup after each step. Each format and mode is measured in a" << std::endl
+              << "child process of its own, so that memory kept by the allocator does not carry over." << std::endl
+              << std::endl
+              << "Options:" << std::endl
+              << "  --formats <f,...>   formats as default or <major>.<minor>[core|compat][debug]," << std::endl
+              << "                      default: default,3.3core,4.5core" << std::endl
+              << "  --steps <n,...>     numbers of live contexts to measure at, default: 1,2,4,8,16,32,64" << std::endl
+              << "  --json <file>       also write the results as JSON" << std::endl;
+}
+
+
+const char* backendName() {
+#if defined(GLHEADLESS_FOOTPRINT_BACKEND)
+    return GLHEADLESS_FOOTPRINT_BACKEND;
+#else
+    return "unknown";
+#endif
+}
+
+
+std::vector<std::string> split(const std::string& text) {
+    std::vector<std::string> parts;
+    std::istringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, ',')) {
+        if (!part.empty()) {
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+
+bool parseFormat(const std::string& text, ContextFormat& format) {
+    format = ContextFormat();
+    if (text == "default") {
+        return true;
+    }
+
+    unsigned int major = 0;
+    unsigned int minor = 0;
+    auto consumed = 0;
+    if (std::sscanf(text.c_str(), "%u.%u%n", &major, &minor, &consumed) != 2) {
+        return false;
+    }
+    format.versionMajor = major;
+    format.versionMinor = minor;
+
+    auto rest = text.substr(static_cast<std::size_t>(consumed));
+    if (rest.compare(0, 4, "core") == 0) {
+        format.profile = ContextProfile::CORE;
+        rest = rest.substr(4);
+    } else if (rest.compare(0, 6, "compat") == 0) {
+        format.profile = ContextProfile::COMPATIBILITY;
+        rest = rest.substr(6);
+    }
+    if (rest == "debug") {
+        format.debug = true;
+        rest.clear();
+    }
+    return rest.empty();
+}
+
+
+double mebibytes(double bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+
+/*
+ * Measures one format and mode; runs in the child process. Prints a table to stdout and returns the JSON object of the
+ * results, empty on errors.
+ */
+std::string measure(const std::string& name, const ContextFormat& format, bool shared, const std::vector<unsigned int>& steps) {
+    std::cout << name << (shared ? ", shared" : ", standalone") << ":" << std::endl;
+
+    MemoryUsage baseline;
+    if (!processMemoryUsage(baseline)) {
+        std::cerr << "Cannot read the memory of the process" << std::endl;
+        return std::string();
+    }
+
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(0);
+    json << "{ \"format\": \"" << name << "\", \"shared\": " << (shared ? "true" : "false")
+         << ", \"baseline_rss_bytes\": " << baseline.rssBytes << ", \"baseline_pss_bytes\": " << baseline.pssBytes
+         << ", \"steps\": [";
+
+    std::cout << "  contexts    RSS MiB    PSS MiB   RSS KiB/context   PSS KiB/context" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(10) << 0 << std::setw(11) << mebibytes(baseline.rssBytes) << std::setw(11) << mebibytes(baseline.pssBytes) << std::endl;
+
+    std::vector<std::unique_ptr<Context>> contexts;
+    MemoryUsage first;
+    for (std::size_t i = 0; i < steps.size(); ++i) {
+        while (contexts.size() < steps[i]) {
+            auto context = contexts.empty() || !shared ? ContextFactory::create(format) : ContextFactory::create(contexts.front().get(), format);
+
+            // drivers allocate some memory only when a context is first made current
+            if (!context->valid() || !context->makeCurrent()) {
+                std::cerr << context->lastErrorCode().message() << ": " << context->lastErrorMessage() << std::endl;
+                return std::string();
+            }
+            context->doneCurrent();
+            contexts.push_back(std::move(context));
+        }
+
+        MemoryUsage usage;
+        processMemoryUsage(usage);
+        if (contexts.size() == 1) {
+            first = usage;
+        }
+
+        // the growth per context after the first one, which also takes the one-time allocations of the driver
+        const auto additional = static_cast<double>(contexts.size() - 1);
+        const auto rssPerContext = additional > 0 ? (static_cast<double>(usage.rssBytes) - static_cast<double>(first.rssBytes)) / additional : 0.0;
+        const auto pssPerContext = additional > 0 ? (static_cast<double>(usage.pssBytes) - static_cast<double>(first.pssBytes)) / additional : 0.0;
+
+        std::cout << std::setw(10) << contexts.size()
+                  << std::setw(11) << mebibytes(usage.rssBytes) << std::setw(11) << mebibytes(usage.pssBytes);
+        if (additional > 0) {
+            std::cout << std::setw(18) << rssPerContext / 1024.0 << std::setw(18) << pssPerContext / 1024.0;
+        }
+        std::cout << std::endl;
+
+        json << (i > 0 ? ", " : "") << "{ \"contexts\": " << contexts.size()
+             << ", \"rss_bytes\": " << usage.rssBytes << ", \"pss_bytes\": " << usage.pssBytes
+             << ", \"rss_bytes_per_context\": " << rssPerContext << ", \"pss_bytes_per_context\": " << pssPerContext << " }";
+    }
+    contexts.clear();
+
+    const auto footprint = approximateFootprint(format, shared);
+    std::cout << "  approximateFootprint(): " << footprint.rssBytes / 1024 << " KiB RSS, " << footprint.pssBytes / 1024 << " KiB PSS per context" << std::endl
+              << std::endl;
+    json << "], \"approximate_rss_bytes\": " << footprint.rssBytes << ", \"approximate_pss_bytes\": " << footprint.pssBytes << " }";
+    return json.str();
+}
+
+
+// runs measure() in a child process, so that each measurement starts from a process without contexts
+std::string measureInChild(const std::string& name, const ContextFormat& format, bool shared, const std::vector<unsigned int>& steps) {
+    int channel[2];
+    if (pipe(channel) != 0) {
+        return std::string();
+    }
+
+    std::cout.flush();
+    const auto child = fork();
+    if (child < 0) {
+        close(channel[0]);
+        close(channel[1]);
+        return std::string();
+    }
+    if (child == 0) {
+        close(channel[0]);
+        const auto json = measure(name, format, shared, steps);
+        std::cout.flush();
+        const auto written = write(channel[1], json.data(), json.size());
+        _exit(!json.empty() && written == static_cast<ssize_t>(json.size()) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(channel[1]);
+    std::string json;
+    char buffer[4096];
+    ssize_t count = 0;
+    while ((count = read(channel[0], buffer, sizeof(buffer))) > 0) {
+        json.append(buffer, static_cast<std::size_t>(count));
+    }
+    close(channel[0]);
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS ? json : std::string();
+}
+
+
+}  // unnamed namespace
+
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (auto i = 1; i < argc; ++i) {
+        const auto argument = std::string(argv[i]);
+        if (argument == "--formats" && i + 1 < argc) {
+            options.formats = split(argv[++i]);
+        } else if (argument == "--steps" && i + 1 < argc) {
+            options.steps.clear();
+            for (const auto& step : split(argv[++i])) {
+                const auto value = std::atoi(step.c_str());
+                if (value > 0 && (options.steps.empty() || static_cast<unsigned int>(value) > options.steps.back())) {
+                    options.steps.push_back(static_cast<unsigned int>(value));
+                }
+            }
+        } else if (argument == "--json" && i + 1 < argc) {
+            options.json = argv[++i];
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.formats.empty() || options.steps.empty()) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    // no context may exist in this process before forking, so that each child starts without one
+    std::cout << "backend " << backendName() << std::endl << std::endl;
+    std::vector<std::string> results;
+    auto failed = false;
+    for (const auto& name : options.formats) {
+        ContextFormat format;
+        if (!parseFormat(name, format)) {
+            std::cerr << "Invalid format " << name << std::endl;
+            return EXIT_FAILURE;
+        }
+        for (const auto shared : { false, true }) {
+            const auto json = measureInChild(name, format, shared, options.steps);
+            if (json.empty()) {
+                failed = true;
+                continue;
+            }
+            results.push_back(json);
+        }
+    }
+
+    if (!options.json.empty()) {
+        std::ofstream file(options.json);
+        file << "{" << std::endl
+             << "  \"backend\": \"" << backendName() << "\"," << std::endl
+             << "  \"measurements\": [" << std::endl;
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            file << "    " << results[i] << (i + 1 < results.size() ? "," : "") << std::endl;
+        }
+        file << "  ]" << std::endl
+             << "}" << std::endl;
+        if (!file) {
+            std::cerr << "Cannot write " << options.json << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
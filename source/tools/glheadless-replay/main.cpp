@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/TracePlayer.h>
+
+
+using namespace glheadless;
+
+
+namespace {
+
+
+const std::size_t k_functionRows = 20;
+
+
+void printUsage() {
+    std::cerr << "Usage: glheadless-replay [options] <trace>" << std::endl
+              << std::endl
+              << "Replays a trace recorded by glheadless::Context::startTrace() on a fresh context per iteration and" << std::endl
+              << "reports the time each replay took, including a final glFinish()." << std::endl
+              << std::endl
+              << "Options:" << std::endl
+              << "  --iterations <n>     number of replays, default: 5" << std::endl
+              << "  --version <m.n>      OpenGL version of the context, default: no preference" << std::endl
+              << "  --per-function       time each call and list the slowest entry points of the last replay" << std::endl;
+}
+
+
+}  // unnamed namespace
+
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    auto iterations = 5;
+    auto perFunction = false;
+    ContextFormat format;
+
+    for (auto i = 1; i < argc; ++i) {
+        const auto argument = std::string(argv[i]);
+        if (argument == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (argument == "--version" && i + 1 < argc) {
+            const auto version = std::string(argv[++i]);
+            const auto dot = version.find('.');
+            format.versionMajor = static_cast<unsigned int>(std::atoi(version.substr(0, dot).c_str()));
+            format.versionMinor = dot != std::string::npos ? static_cast<unsigned int>(std::atoi(version.substr(dot + 1).c_str())) : 0;
+        } else if (argument == "--per-function") {
+            perFunction = true;
+        } else if (path.empty() && !argument.empty() && argument[0] != '-') {
+            path = argument;
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (path.empty()) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    TracePlayer player;
+    if (!player.open(path)) {
+        std::cerr << player.lastErrorCode().message() << ": " << player.lastErrorMessage() << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << path << ": " << player.callCount() << " calls" << std::endl;
+
+    std::vector<double> times;
+    TraceTimings timings;
+    for (auto i = 0; i < iterations; ++i) {
+        // each replay starts from a fresh context, so it issues the same commands as the recorded run
+        auto context = ContextFactory::create(format);
+        if (!context->valid() || !context->makeCurrent()) {
+            std::cerr << context->lastErrorCode().message() << ": " << context->lastErrorMessage() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        const auto timeFunctions = perFunction && i + 1 == iterations;
+        if (!player.play(context.get(), timings, timeFunctions)) {
+            std::cerr << player.lastErrorCode().message() << ": " << player.lastErrorMessage() << std::endl;
+            return EXIT_FAILURE;
+        }
+        context->doneCurrent();
+
+        // the timed replay is left out of the summary, as timing each call slows it down
+        if (!timeFunctions) {
+            times.push_back(timings.milliseconds);
+        }
+        std::cout << "replay " << i + 1 << ": " << std::fixed << std::setprecision(3) << timings.milliseconds << " ms"
+                  << (timeFunctions ? " (timing each call)" : "") << std::endl;
+    }
+
+    if (!times.empty()) {
+        std::sort(times.begin(), times.end());
+        const auto median = times[times.size() / 2];
+        std::cout << "min " << times.front() << " ms, median " << median << " ms, max " << times.back() << " ms, "
+                  << std::setprecision(0) << (median > 0.0 ? static_cast<double>(player.callCount()) / median * 1000.0 : 0.0)
+                  << " calls/s at the median" << std::endl;
+    }
+
+    if (perFunction) {
+        std::cout << std::endl << std::left << std::setw(32) << "function" << std::right << std::setw(12) << "calls"
+                  << std::setw(14) << "ms" << std::setw(14) << "us/call" << std::endl;
+        for (std::size_t i = 0; i < timings.functions.size() && i < k_functionRows; ++i) {
+            const auto& function = timings.functions[i];
+            std::cout << std::left << std::setw(32) << function.name << std::right << std::setw(12) << function.callCount
+                      << std::setw(14) << std::setprecision(3) << function.milliseconds
+                      << std::setw(14) << function.milliseconds * 1000.0 / static_cast<double>(function.callCount) << std::endl;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
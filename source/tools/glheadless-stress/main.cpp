@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+#include <glheadless/RuntimeStatistics.h>
+
+
+using namespace glheadless;
+
+
+namespace {
+
+
+using Clock = std::chrono::steady_clock;
+
+
+enum Operation {
+    CREATE,
+    MAKE_CURRENT,
+    DESTROY,
+    OPERATION_COUNT
+};
+
+const char* const k_operationNames[OPERATION_COUNT] = { "create", "make_current", "destroy" };
+
+
+struct Options {
+    std::vector<unsigned int> threadCounts = { 1, 2, 4, 8, 16, 32, 64 };
+    double                    seconds = 1.0;
+    std::string               json;
+};
+
+
+struct Latencies {
+    double p50Us = 0;
+    double p99Us = 0;
+    double p999Us = 0;
+    double maxUs = 0;
+};
+
+
+struct Step {
+    unsigned int      threadCount = 0;
+    std::uint64_t     cycles = 0;
+    std::uint64_t     errors = 0;
+    double            seconds = 0;
+    Latencies         latencies[OPERATION_COUNT];
+    RuntimeStatistics statistics;
+};
+
+
+// samples of one thread, merged after the step
+struct ThreadSamples {
+    std::vector<double> microseconds[OPERATION_COUNT];
+    std::uint64_t       cycles = 0;
+    std::uint64_t       errors = 0;
+};
+
+
+void printUsage() {
+    std::cerr << "Usage: glheadless-stress [options]" << std::endl
+              << std::endl
+              << "Runs threads that create a context, make it current, release it and destroy it in a loop, for each" << std::endl
+              << "thread count, and reports the throughput, latency percentiles and contention on internal locks." << std::endl
+              << std::endl
+              << "Options:" << std::endl
+              << "  --threads <n,m,...>  thread counts to sweep, default: 1,2,4,8,16,32,64" << std::endl
+              << "  --seconds <s>        duration of each thread count, default: 1" << std::endl
+              << "  --json <file>        also write the results as JSON" << std::endl;
+}
+
+
+std::vector<unsigned int> parseList(const std::string& text) {
+    std::vector<unsigned int> values;
+    std::size_t position = 0;
+    while (position < text.size()) {
+        auto comma = text.find(',', position);
+        if (comma == std::string::npos) {
+            comma = text.size();
+        }
+        const auto value = std::atoi(text.substr(position, comma - position).c_str());
+        if (value > 0) {
+            values.push_back(static_cast<unsigned int>(value));
+        }
+        position = comma + 1;
+    }
+    return values;
+}
+
+
+double microsecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+
+// nearest-rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const auto rank = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+
+void cycle(ThreadSamples& samples) {
+    auto start = Clock::now();
+    auto context = ContextFactory::create();
+    samples.microseconds[CREATE].push_back(microsecondsSince(start));
+    if (!context->valid()) {
+        ++samples.errors;
+        return;
+    }
+
+    start = Clock::now();
+    const auto current = context->makeCurrent();
+    samples.microseconds[MAKE_CURRENT].push_back(microsecondsSince(start));
+    if (!current || !context->doneCurrent()) {
+        ++samples.errors;
+    }
+
+    start = Clock::now();
+    context.reset();
+    samples.microseconds[DESTROY].push_back(microsecondsSince(start));
+    ++samples.cycles;
+}
+
+
+Step runStep(unsigned int threadCount, double seconds) {
+    std::vector<ThreadSamples> samples(threadCount);
+    std::vector<std::thread> threads;
+
+    // the threads start together, so that the first contexts contend as well
+    std::mutex mutex;
+    std::condition_variable started;
+    auto go = false;
+    std::atomic<bool> stop(false);
+
+    resetRuntimeStatistics();
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([&, i] {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                started.wait(lock, [&go] { return go; });
+            }
+            while (!stop.load(std::memory_order_relaxed)) {
+                cycle(samples[i]);
+            }
+        });
+    }
+
+    const auto start = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        go = true;
+    }
+    started.notify_all();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    Step step;
+    step.threadCount = threadCount;
+    step.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    step.statistics = runtimeStatistics();
+    for (auto operation = 0; operation < OPERATION_COUNT; ++operation) {
+        std::vector<double> merged;
+        for (const auto& thread : samples) {
+            merged.insert(merged.end(), thread.microseconds[operation].begin(), thread.microseconds[operation].end());
+        }
+        std::sort(merged.begin(), merged.end());
+
+        auto& latencies = step.latencies[operation];
+        latencies.p50Us = percentile(merged, 0.5);
+        latencies.p99Us = percentile(merged, 0.99);
+        latencies.p999Us = percentile(merged, 0.999);
+        latencies.maxUs = merged.empty() ? 0.0 : merged.back();
+    }
+    for (const auto& thread : samples) {
+        step.cycles += thread.cycles;
+        step.errors += thread.errors;
+    }
+    return step;
+}
+
+
+double waitMilliseconds(const LockStatistics& lock) {
+    return lock.wait.totalSeconds * 1.0e3;
+}
+
+
+void print(std::ostream& stream, const Step& step) {
+    stream << std::fixed << std::setprecision(1);
+    stream << std::setw(4) << step.threadCount << " threads: "
+           << std::setw(9) << static_cast<double>(step.cycles) / step.seconds << " cycles/s, "
+           << step.errors << " errors" << std::endl;
+    for (auto operation = 0; operation < OPERATION_COUNT; ++operation) {
+        const auto& latencies = step.latencies[operation];
+        stream << "      " << std::left << std::setw(14) << k_operationNames[operation] << std::right
+               << "p50 " << std::setw(9) << latencies.p50Us << " us   "
+               << "p99 " << std::setw(9) << latencies.p99Us << " us   "
+               << "p999 " << std::setw(9) << latencies.p999Us << " us   "
+               << "max " << std::setw(9) << latencies.maxUs << " us" << std::endl;
+    }
+
+    const auto& instance = step.statistics.platformInstanceLock;
+    const auto& handler = step.statistics.errorHandlerSwap;
+    stream << std::setprecision(3)
+           << "      platform instance lock: " << instance.acquisitionCount << " acquisitions, " << instance.contendedCount
+           << " contended, " << waitMilliseconds(instance) << " ms waited" << std::endl
+           << "      X error handler swaps:  " << handler.acquisitionCount << " installs, " << handler.contendedCount
+           << " overlapping another thread's" << std::endl;
+}
+
+
+void writeJson(std::ostream& stream, const std::vector<Step>& steps) {
+    stream << std::fixed << std::setprecision(3);
+    stream << "{" << std::endl
+           << "  \"steps\": [" << std::endl;
+    for (std::size_t i = 0; i < steps.size(); ++i) {
+        const auto& step = steps[i];
+        stream << "    {" << std::endl
+               << "      \"threads\": " << step.threadCount << "," << std::endl
+               << "      \"cycles_per_second\": " << static_cast<double>(step.cycles) / step.seconds << "," << std::endl
+               << "      \"errors\": " << step.errors << "," << std::endl;
+        for (auto operation = 0; operation < OPERATION_COUNT; ++operation) {
+            const auto& latencies = step.latencies[operation];
+            stream << "      \"" << k_operationNames[operation] << "\": { "
+                   << "\"p50_us\": " << latencies.p50Us << ", "
+                   << "\"p99_us\": " << latencies.p99Us << ", "
+                   << "\"p999_us\": " << latencies.p999Us << ", "
+                   << "\"max_us\": " << latencies.maxUs << " }," << std::endl;
+        }
+        const auto& instance = step.statistics.platformInstanceLock;
+        const auto& handler = step.statistics.errorHandlerSwap;
+        stream << "      \"platform_instance_lock\": { \"acquisitions\": " << instance.acquisitionCount
+               << ", \"contended\": " << instance.contendedCount << ", \"wait_ms\": " << waitMilliseconds(instance) << " }," << std::endl
+               << "      \"error_handler_swaps\": { \"installs\": " << handler.acquisitionCount
+               << ", \"overlapping\": " << handler.contendedCount << " }" << std::endl
+               << "    }" << (i + 1 < steps.size() ? "," : "") << std::endl;
+    }
+    stream << "  ]" << std::endl
+           << "}" << std::endl;
+}
+
+
+}  // unnamed namespace
+
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (auto i = 1; i < argc; ++i) {
+        const auto argument = std::string(argv[i]);
+        if (argument == "--threads" && i + 1 < argc) {
+            options.threadCounts = parseList(argv[++i]);
+        } else if (argument == "--seconds" && i + 1 < argc) {
+            options.seconds = std::max(0.01, std::atof(argv[++i]));
+        } else if (argument == "--json" && i + 1 < argc) {
+            options.json = argv[++i];
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.threadCounts.empty()) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Step> steps;
+    for (const auto threadCount : options.threadCounts) {
+        steps.push_back(runStep(threadCount, options.seconds));
+        print(std::cout, steps.back());
+    }
+
+    if (!options.json.empty()) {
+        std::ofstream file(options.json);
+        writeJson(file, steps);
+        if (!file) {
+            std::cerr << "Cannot write " << options.json << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (const auto& step : steps) {
+        if (step.errors > 0) {
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,596 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glheadless/Context.h>
+#include <glheadless/ContextFactory.h>
+
+#include "GLFunctions.h"
+
+
+using namespace glheadless;
+using namespace glheadless::gl;
+
+
+namespace {
+
+
+using Clock = std::chrono::steady_clock;
+
+// GL_NO_ERROR, which windows.h defines as a macro
+const GLenum k_noError = 0;
+
+
+struct TransferFormat {
+    const char* name;
+    GLenum      internalFormat;
+    GLenum      format;
+    GLenum      type;
+    std::size_t bytesPerPixel;
+};
+
+const TransferFormat k_formats[] = {
+    { "rgba8",   RGBA8,   RGBA, UNSIGNED_BYTE, 4 },
+    { "bgra8",   RGBA8,   BGRA, UNSIGNED_BYTE, 4 },
+    { "r8",      R8,      RED,  UNSIGNED_BYTE, 1 },
+    { "rgba32f", RGBA32F, RGBA, FLOAT,         16 }
+};
+
+
+struct Resolution {
+    unsigned int width;
+    unsigned int height;
+};
+
+
+struct Options {
+    std::vector<Resolution>   resolutions = { { 256, 256 }, { 1024, 1024 }, { 1920, 1080 } };
+    std::vector<std::string>  formats = { "rgba8", "bgra8", "r8", "rgba32f" };
+    std::vector<unsigned int> depths = { 1, 2, 3, 4 };
+    unsigned int              frames = 16;
+    unsigned int              warmup = 2;
+    std::string               output;
+};
+
+
+struct Result {
+    std::string  direction;
+    std::string  path;
+    std::string  format;
+    Resolution   resolution;
+    unsigned int depth;
+    unsigned int frames;
+    double       seconds;
+    double       megabytesPerSecond;
+};
+
+
+/*
+ * A measured transfer path. run() transfers frames images of the setup's size and format, returning false on errors;
+ * it includes the time until the GPU finished, so asynchronous paths are not favored.
+ */
+struct Path {
+    const char* direction;
+    const char* name;
+    bool        ringed;
+    std::function<bool(unsigned int frames, unsigned int depth)> run;
+};
+
+
+void printUsage() {
+    std::cerr << "Usage: glheadless-transfer-bench [options]" << std::endl
+              << std::endl
+              << "Measures the throughput of readback (glReadPixels directly, into a ring of pixel pack buffers read" << std::endl
+              << "asynchronously, and into a pixel pack buffer mapped right away) and upload (glTexSubImage2D from" << std::endl
+              << "memory and from a ring of pixel unpack buffers, glBufferSubData and mapped buffers) and writes the" << std::endl
+              << "results as JSON. Run it on Mesa llvmpipe, e.g., with EGL_PLATFORM=surfaceless, for comparable numbers." << std::endl
+              << std::endl
+              << "Options:" << std::endl
+              << "  --resolutions <WxH,...>  default: 256x256,1024x1024,1920x1080" << std::endl
+              << "  --formats <f,...>        of rgba8, bgra8, r8, rgba32f, default: all" << std::endl
+              << "  --depths <n,...>         ring depths of the buffer rings, default: 1,2,3,4" << std::endl
+              << "  --frames <n>             measured frames per run, default: 16" << std::endl
+              << "  --warmup <n>             unmeasured frames before, default: 2" << std::endl
+              << "  --output <file>          write the JSON to the file instead of stdout" << std::endl;
+}
+
+
+std::vector<std::string> split(const std::string& text) {
+    std::vector<std::string> parts;
+    std::istringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, ',')) {
+        if (!part.empty()) {
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+
+std::string quote(const char* text) {
+    std::string quoted = "\"";
+    for (auto c = text; c != nullptr && *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') {
+            quoted += '\\';
+        }
+        if (static_cast<unsigned char>(*c) >= 0x20) {
+            quoted += *c;
+        }
+    }
+    return quoted + "\"";
+}
+
+
+std::string timestamp() {
+    const auto now = std::time(nullptr);
+    std::tm utc;
+#ifdef _WIN32
+    gmtime_s(&utc, &now);
+#else
+    gmtime_r(&now, &utc);
+#endif
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return buffer;
+}
+
+
+/*
+ * GL objects of one resolution and format: a framebuffer to read from, a texture to upload to, and client memory for
+ * both directions.
+ */
+class Setup {
+public:
+    Setup(const Functions& gl, const Resolution& resolution, const TransferFormat& format)
+    : m_gl(gl)
+    , m_resolution(resolution)
+    , m_format(format)
+    , m_size(static_cast<std::size_t>(resolution.width) * resolution.height * format.bytesPerPixel)
+    , m_framebufferTexture(0)
+    , m_framebuffer(0)
+    , m_texture(0)
+    , m_memory(m_size, 0x5a)
+    , m_checksum(0) {
+        gl.PixelStorei(PACK_ALIGNMENT, 1);
+        gl.PixelStorei(UNPACK_ALIGNMENT, 1);
+
+        gl.GenTextures(1, &m_framebufferTexture);
+        gl.BindTexture(TEXTURE_2D, m_framebufferTexture);
+        gl.TexImage2D(TEXTURE_2D, 0, static_cast<GLint>(format.internalFormat), static_cast<GLsizei>(resolution.width), static_cast<GLsizei>(resolution.height), 0, format.format, format.type, nullptr);
+        gl.GenFramebuffers(1, &m_framebuffer);
+        gl.BindFramebuffer(FRAMEBUFFER, m_framebuffer);
+        gl.FramebufferTexture2D(FRAMEBUFFER, COLOR_ATTACHMENT0, TEXTURE_2D, m_framebufferTexture, 0);
+        gl.Viewport(0, 0, static_cast<GLsizei>(resolution.width), static_cast<GLsizei>(resolution.height));
+
+        gl.GenTextures(1, &m_texture);
+        gl.BindTexture(TEXTURE_2D, m_texture);
+        gl.TexImage2D(TEXTURE_2D, 0, static_cast<GLint>(format.internalFormat), static_cast<GLsizei>(resolution.width), static_cast<GLsizei>(resolution.height), 0, format.format, format.type, nullptr);
+    }
+
+    ~Setup() {
+        m_gl.BindFramebuffer(FRAMEBUFFER, 0);
+        m_gl.DeleteFramebuffers(1, &m_framebuffer);
+        m_gl.DeleteTextures(1, &m_framebufferTexture);
+        m_gl.DeleteTextures(1, &m_texture);
+    }
+
+    bool complete() const {
+        return m_gl.CheckFramebufferStatus(FRAMEBUFFER) == FRAMEBUFFER_COMPLETE && m_gl.GetError() == k_noError;
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+
+    // the rendering the readback paths read, a clear to keep the driver from skipping work
+    void render(unsigned int frame) {
+        m_gl.ClearColor(static_cast<GLfloat>(frame % 2), 0.5f, 0.25f, 1.0f);
+        m_gl.Clear(COLOR_BUFFER_BIT);
+    }
+
+    void readPixels(void* destination) {
+        m_gl.ReadPixels(0, 0, static_cast<GLsizei>(m_resolution.width), static_cast<GLsizei>(m_resolution.height), m_format.format, m_format.type, destination);
+    }
+
+    void texSubImage(const void* source) {
+        m_gl.TexSubImage2D(TEXTURE_2D, 0, 0, 0, static_cast<GLsizei>(m_resolution.width), static_cast<GLsizei>(m_resolution.height), m_format.format, m_format.type, source);
+    }
+
+    // copies read pixels to client memory, as an application would, and uses them
+    void consume(const void* pixels) {
+        std::memcpy(m_memory.data(), pixels, m_size);
+        m_checksum += m_memory[m_size / 2];
+    }
+
+    // fills client memory for an upload
+    void produce(void* pixels, unsigned int frame) {
+        m_memory[frame % m_size] = static_cast<unsigned char>(frame);
+        std::memcpy(pixels, m_memory.data(), m_size);
+    }
+
+    unsigned char* memory() {
+        return m_memory.data();
+    }
+
+    unsigned long long checksum() const {
+        return m_checksum;
+    }
+
+
+private:
+    const Functions&           m_gl;
+    Resolution                 m_resolution;
+    TransferFormat             m_format;
+    std::size_t                m_size;
+    GLuint                     m_framebufferTexture;
+    GLuint                     m_framebuffer;
+    GLuint                     m_texture;
+    std::vector<unsigned char> m_memory;
+    unsigned long long         m_checksum;
+};
+
+
+// a ring of buffers for one target, each with the fence of its last use
+class BufferRing {
+public:
+    BufferRing(const Functions& gl, GLenum target, GLenum usage, std::size_t size, unsigned int depth)
+    : m_gl(gl)
+    , m_target(target)
+    , m_buffers(depth, 0)
+    , m_fences(depth, nullptr) {
+        gl.GenBuffers(static_cast<GLsizei>(depth), m_buffers.data());
+        for (const auto buffer : m_buffers) {
+            gl.BindBuffer(target, buffer);
+            gl.BufferData(target, static_cast<GLsizeiptr>(size), nullptr, usage);
+        }
+        gl.BindBuffer(target, 0);
+    }
+
+    ~BufferRing() {
+        for (auto& fence : m_fences) {
+            wait(fence);
+        }
+        m_gl.DeleteBuffers(static_cast<GLsizei>(m_buffers.size()), m_buffers.data());
+    }
+
+    unsigned int depth() const {
+        return static_cast<unsigned int>(m_buffers.size());
+    }
+
+    GLuint bind(unsigned int slot) {
+        m_gl.BindBuffer(m_target, m_buffers[slot]);
+        return m_buffers[slot];
+    }
+
+    void fence(unsigned int slot) {
+        wait(m_fences[slot]);
+        m_fences[slot] = m_gl.FenceSync(SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // waits for the last use of the slot, if still pending
+    void wait(unsigned int slot) {
+        wait(m_fences[slot]);
+    }
+
+
+private:
+    void wait(GLsync& fence) {
+        if (fence != nullptr) {
+            m_gl.ClientWaitSync(fence, SYNC_FLUSH_COMMANDS_BIT, TIMEOUT_IGNORED);
+            m_gl.DeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+
+private:
+    const Functions&    m_gl;
+    GLenum              m_target;
+    std::vector<GLuint> m_buffers;
+    std::vector<GLsync> m_fences;
+};
+
+
+std::vector<Path> paths(const Functions& gl, Setup& setup) {
+    std::vector<Path> paths;
+
+    paths.push_back({ "readback", "read_pixels", false, [&setup](unsigned int frames, unsigned int) {
+        for (unsigned int frame = 0; frame < frames; ++frame) {
+            setup.render(frame);
+            setup.readPixels(setup.memory());
+        }
+        return true;
+    } });
+
+    // reads into a pixel pack buffer and maps it right away, which waits for the read
+    paths.push_back({ "readback", "pbo_map", false, [&gl, &setup](unsigned int frames, unsigned int) {
+        BufferRing ring(gl, PIXEL_PACK_BUFFER, STREAM_READ, setup.size(), 1);
+        for (unsigned int frame = 0; frame < frames; ++frame) {
+            setup.render(frame);
+            ring.bind(0);
+            setup.readPixels(nullptr);
+            const auto pixels = gl.MapBufferRange(PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(setup.size()), MAP_READ_BIT);
+            if (pixels == nullptr) {
+                return false;
+            }
+            setup.consume(pixels);
+            gl.UnmapBuffer(PIXEL_PACK_BUFFER);
+        }
+        gl.BindBuffer(PIXEL_PACK_BUFFER, 0);
+        return true;
+    } });
+
+    // reads into the next buffer of the ring and maps the one read depth - 1 frames before
+    paths.push_back({ "readback", "pbo_async", true, [&gl, &setup](unsigned int frames, unsigned int depth) {
+        BufferRing ring(gl, PIXEL_PACK_BUFFER, STREAM_READ, setup.size(), depth);
+        const auto consume = [&gl, &setup, &ring](unsigned int slot) {
+            ring.wait(slot);
+            ring.bind(slot);
+            const auto pixels = gl.MapBufferRange(PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(setup.size()), MAP_READ_BIT);
+            if (pixels == nullptr) {
+                return false;
+            }
+            setup.consume(pixels);
+            gl.UnmapBuffer(PIXEL_PACK_BUFFER);
+            return true;
+        };
+
+        for (unsigned int frame = 0; frame < frames; ++frame) {
+            setup.render(frame);
+            const auto slot = frame % depth;
+            ring.bind(slot);
+            setup.readPixels(nullptr);
+            ring.fence(slot);
+
+            if (frame + 1 >= depth && !consume((frame + 1) % depth)) {
+                return false;
+            }
+        }
+        for (auto frame = frames; frame < frames + depth - 1; ++frame) {
+            if (frame + 1 >= depth && !consume((frame + 1) % depth)) {
+                return false;
+            }
+        }
+        gl.BindBuffer(PIXEL_PACK_BUFFER, 0);
+        return true;
+    } });
+
+    paths.push_back({ "upload", "tex_sub_image", false, [&setup](unsigned int frames, unsigned int) {
+        for (unsigned int frame = 0; frame < frames; ++frame) {
+            setup.memory()[frame % setup.size()] = static_cast<unsigned char>(frame);
+            setup.texSubImage(setup.memory());
+        }
+        return true;
+    } });
+
+    // fills the next buffer of the ring, waiting until the upload depth frames before is done, and uploads from it
+    paths.push_back({ "upload", "tex_sub_image_pbo", true, [&gl, &setup](unsigned int frames, unsigned int depth) {
+        BufferRing ring(gl, PIXEL_UNPACK_BUFFER, STREAM_DRAW, setup.size(), depth);
+        for (unsigned int frame = 0; frame < frames; ++frame) {
+            const auto slot = frame % depth;
+            ring.wait(slot);
+            ring.bind(slot);
+            const auto pixels = gl.MapBufferRange(PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(setup.size()), MAP_WRITE_BIT | MAP_INVALIDATE_BUFFER_BIT);
+            if (pixels == nullptr) {
+                return false;
+            }
+            setup.produce(pixels, frame);
+            gl.UnmapBuffer(PIXEL_UNPACK_BUFFER);
+            setup.texSubImage(nullptr);
+            ring.fence(slot);
+        }
+        gl.BindBuffer(PIXEL_UNPACK_BUFFER, 0);
+        return true;
+    } });
+
+    paths.push_back({ "upload", "buffer_sub_data", false, [&gl, &setup](unsigned int frames, unsigned int) {
+        BufferRing ring(gl, ARRAY_BUFFER, STREAM_DRAW, setup.size(), 1);
+        ring.bind(0);
+        for (unsigned int frame = 0; frame < frames; ++frame) {
+            setup.memory()[frame % setup.size()] = static_cast<unsigned char>(frame);
+            gl.BufferSubData(ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(setup.size()), setup.memory());
+        }
+        gl.BindBuffer(ARRAY_BUFFER, 0);
+        return true;
+    } });
+
+    paths.push_back({ "upload", "buffer_map", false, [&gl, &setup](unsigned int frames, unsigned int) {
+        BufferRing ring(gl, ARRAY_BUFFER, STREAM_DRAW, setup.size(), 1);
+        ring.bind(0);
+        for (unsigned int frame = 0; frame < frames; ++frame) {
+            const auto data = gl.MapBufferRange(ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(setup.size()), MAP_WRITE_BIT | MAP_INVALIDATE_BUFFER_BIT);
+            if (data == nullptr) {
+                return false;
+            }
+            setup.produce(data, frame);
+            gl.UnmapBuffer(ARRAY_BUFFER);
+        }
+        gl.BindBuffer(ARRAY_BUFFER, 0);
+        return true;
+    } });
+
+    return paths;
+}
+
+
+void writeJson(std::ostream& stream, const Context& context, const std::vector<Result>& results) {
+    const auto& gl = context.functions();
+    const auto renderer = reinterpret_cast<const char*>(gl.GetString(RENDERER));
+    const auto version = reinterpret_cast<const char*>(gl.GetString(VERSION));
+
+    stream << std::fixed << std::setprecision(3);
+    stream << "{" << std::endl
+           << "  \"timestamp\": \"" << timestamp() << "\"," << std::endl
+           << "  \"renderer\": " << quote(renderer) << "," << std::endl
+           << "  \"version\": " << quote(version) << "," << std::endl
+           << "  \"results\": [" << std::endl;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& result = results[i];
+        stream << "    { \"direction\": \"" << result.direction << "\""
+               << ", \"path\": \"" << result.path << "\""
+               << ", \"format\": \"" << result.format << "\""
+               << ", \"width\": " << result.resolution.width
+               << ", \"height\": " << result.resolution.height
+               << ", \"depth\": " << result.depth
+               << ", \"frames\": " << result.frames
+               << ", \"seconds\": " << std::setprecision(6) << result.seconds
+               << ", \"megabytes_per_second\": " << std::setprecision(3) << result.megabytesPerSecond
+               << " }" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    stream << "  ]" << std::endl
+           << "}" << std::endl;
+}
+
+
+}  // unnamed namespace
+
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (auto i = 1; i < argc; ++i) {
+        const auto argument = std::string(argv[i]);
+        if (argument == "--resolutions" && i + 1 < argc) {
+            options.resolutions.clear();
+            for (const auto& text : split(argv[++i])) {
+                Resolution resolution = { 0, 0 };
+                const auto x = text.find('x');
+                if (x != std::string::npos) {
+                    resolution.width = static_cast<unsigned int>(std::atoi(text.substr(0, x).c_str()));
+                    resolution.height = static_cast<unsigned int>(std::atoi(text.substr(x + 1).c_str()));
+                }
+                if (resolution.width == 0 || resolution.height == 0) {
+                    printUsage();
+                    return EXIT_FAILURE;
+                }
+                options.resolutions.push_back(resolution);
+            }
+        } else if (argument == "--formats" && i + 1 < argc) {
+            options.formats = split(argv[++i]);
+        } else if (argument == "--depths" && i + 1 < argc) {
+            options.depths.clear();
+            for (const auto& text : split(argv[++i])) {
+                options.depths.push_back(static_cast<unsigned int>(std::max(1, std::atoi(text.c_str()))));
+            }
+        } else if (argument == "--frames" && i + 1 < argc) {
+            options.frames = static_cast<unsigned int>(std::max(1, std::atoi(argv[++i])));
+        } else if (argument == "--warmup" && i + 1 < argc) {
+            options.warmup = static_cast<unsigned int>(std::max(0, std::atoi(argv[++i])));
+        } else if (argument == "--output" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<TransferFormat> formats;
+    for (const auto& name : options.formats) {
+        const auto format = std::find_if(std::begin(k_formats), std::end(k_formats), [&name](const TransferFormat& candidate) {
+            return name == candidate.name;
+        });
+        if (format == std::end(k_formats)) {
+            std::cerr << "Unknown format " << name << std::endl;
+            return EXIT_FAILURE;
+        }
+        formats.push_back(*format);
+    }
+    if (options.resolutions.empty() || formats.empty() || options.depths.empty()) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    // buffer mapping and fences require OpenGL 3.2
+    ContextFormat contextFormat;
+    contextFormat.versionMajor = 3;
+    contextFormat.versionMinor = 2;
+    contextFormat.profile = ContextProfile::CORE;
+    auto context = ContextFactory::create(contextFormat);
+    if (!context->valid() || !context->makeCurrent()) {
+        std::cerr << context->lastErrorCode().message() << ": " << context->lastErrorMessage() << std::endl;
+        return EXIT_FAILURE;
+    }
+    const auto& gl = context->functions();
+
+    std::vector<Result> results;
+    auto failed = false;
+    unsigned long long checksum = 0;
+    for (const auto& resolution : options.resolutions) {
+        for (const auto& format : formats) {
+            Setup setup(gl, resolution, format);
+            if (!setup.complete()) {
+                std::cerr << format.name << " at " << resolution.width << "x" << resolution.height << " is not supported" << std::endl;
+                failed = true;
+                continue;
+            }
+
+            for (const auto& path : paths(gl, setup)) {
+                const auto depths = path.ringed ? options.depths : std::vector<unsigned int>(1, 1);
+                for (const auto depth : depths) {
+                    if (!path.run(options.warmup, depth)) {
+                        failed = true;
+                        continue;
+                    }
+                    gl.Finish();
+
+                    const auto start = Clock::now();
+                    const auto success = path.run(options.frames, depth);
+                    gl.Finish();
+                    const auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                    if (!success || gl.GetError() != k_noError) {
+                        std::cerr << path.name << " failed for " << format.name << std::endl;
+                        failed = true;
+                        continue;
+                    }
+
+                    Result result;
+                    result.direction = path.direction;
+                    result.path = path.name;
+                    result.format = format.name;
+                    result.resolution = resolution;
+                    result.depth = depth;
+                    result.frames = options.frames;
+                    result.seconds = seconds;
+                    result.megabytesPerSecond = static_cast<double>(setup.size()) * options.frames / seconds / 1.0e6;
+                    results.push_back(result);
+
+                    std::cerr << std::fixed << std::setprecision(1)
+                              << std::left << std::setw(9) << result.direction << std::setw(18) << result.path
+                              << std::setw(8) << result.format << std::right
+                              << std::setw(5) << resolution.width << "x" << std::left << std::setw(5) << resolution.height << std::right
+                              << " depth " << depth
+                              << std::setw(10) << result.megabytesPerSecond << " MB/s" << std::endl;
+                }
+            }
+            checksum += setup.checksum();
+        }
+    }
+
+    // keeps the reads from being optimized away
+    if (checksum == 1) {
+        std::cerr << std::endl;
+    }
+
+    if (options.output.empty()) {
+        writeJson(std::cout, *context, results);
+    } else {
+        std::ofstream file(options.output);
+        writeJson(file, *context, results);
+        if (!file) {
+            std::cerr << "Cannot write " << options.output << std::endl;
+            failed = true;
+        }
+    }
+
+    context->doneCurrent();
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}